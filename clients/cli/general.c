@@ -325,15 +325,86 @@ static const NmcMetaGenericInfo *const metagen_general_logging[_NMC_GENERIC_INFO
 
 /*****************************************************************************/
 
+typedef struct {
+	const char *operation;
+	GVariant *statistics;
+} GetGeneralLatencyData;
+
+static char *
+_latency_usec_to_string (guint64 usec)
+{
+	return g_strdup_printf ("%"G_GUINT64_FORMAT".%03u",
+	                        usec / 1000u,
+	                        (guint) (usec % 1000u));
+}
+
+static gconstpointer
+_metagen_general_latency_get_fcn (NMC_META_GENERIC_INFO_GET_FCN_ARGS)
+{
+	const GetGeneralLatencyData *d = target;
+	guint64 count = 0;
+	guint64 v = 0;
+
+	nm_assert (info->info_type < _NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_NUM);
+
+	NMC_HANDLE_COLOR (NM_META_COLOR_NONE);
+
+	g_variant_lookup (d->statistics, "count", "t", &count);
+
+	switch (info->info_type) {
+	case NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_OPERATION:
+		return d->operation;
+	case NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_COUNT:
+		return (*out_to_free = g_strdup_printf ("%"G_GUINT64_FORMAT, count));
+	case NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_AVG:
+		if (g_variant_lookup (d->statistics, "sum-usec", "t", &v) && count)
+			v /= count;
+		else
+			v = 0;
+		break;
+	case NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_P50:
+		g_variant_lookup (d->statistics, "p50-usec", "t", &v);
+		break;
+	case NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_P90:
+		g_variant_lookup (d->statistics, "p90-usec", "t", &v);
+		break;
+	case NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_P99:
+		g_variant_lookup (d->statistics, "p99-usec", "t", &v);
+		break;
+	case NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_MAX:
+		g_variant_lookup (d->statistics, "max-usec", "t", &v);
+		break;
+	default:
+		g_return_val_if_reached (NULL);
+	}
+
+	return (*out_to_free = _latency_usec_to_string (v));
+}
+
+static const NmcMetaGenericInfo *const metagen_general_latency[_NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_NUM + 1] = {
+#define _METAGEN_GENERAL_LATENCY(type, name) \
+	[type] = NMC_META_GENERIC(name, .info_type = type, .get_fcn = _metagen_general_latency_get_fcn)
+	_METAGEN_GENERAL_LATENCY (NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_OPERATION, "OPERATION"),
+	_METAGEN_GENERAL_LATENCY (NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_COUNT,     "COUNT"),
+	_METAGEN_GENERAL_LATENCY (NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_AVG,       "AVG-MS"),
+	_METAGEN_GENERAL_LATENCY (NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_P50,       "P50-MS"),
+	_METAGEN_GENERAL_LATENCY (NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_P90,       "P90-MS"),
+	_METAGEN_GENERAL_LATENCY (NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_P99,       "P99-MS"),
+	_METAGEN_GENERAL_LATENCY (NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_MAX,       "MAX-MS"),
+};
+
+/*****************************************************************************/
+
 static void
 usage_general (void)
 {
 	g_printerr (_("Usage: nmcli general { COMMAND | help }\n\n"
-	              "COMMAND := { status | hostname | permissions | logging }\n\n"
+	              "COMMAND := { status | hostname | permissions | logging | latency }\n\n"
 	              "  status\n\n"
 	              "  hostname [<hostname>]\n\n"
 	              "  permissions\n\n"
-	              "  logging [level <log level>] [domains <log domains>]\n\n"));
+	              "  logging [level <log level>] [domains <log domains>]\n\n"
+	              "  latency\n\n"));
 }
 
 static void
@@ -378,6 +449,17 @@ usage_general_logging (void)
 	              "for the list of possible logging domains.\n\n"));
 }
 
+static void
+usage_general_latency (void)
+{
+	g_printerr (_("Usage: nmcli general latency { help }\n"
+	              "\n"
+	              "Show how long NetworkManager's internal operations took, like netlink\n"
+	              "requests, committing IP configuration, updating DNS, running dispatcher\n"
+	              "scripts and the intermediate device states during activation.\n"
+	              "All durations are in milliseconds.\n\n"));
+}
+
 static void
 usage_networking (void)
 {
@@ -733,6 +815,65 @@ do_general_logging (NmCli *nmc, int argc, char **argv)
 	return nmc->return_value;
 }
 
+static NMCResultCode
+do_general_latency (NmCli *nmc, int argc, char **argv)
+{
+	gs_free_error GError *error = NULL;
+	gs_unref_variant GVariant *statistics = NULL;
+	gs_free GetGeneralLatencyData *data = NULL;
+	gs_free gpointer *targets = NULL;
+	const char *fields_str = NULL;
+	GVariantIter iter;
+	gsize n, i;
+
+	next_arg (nmc, &argc, &argv, NULL);
+	if (nmc->complete)
+		return nmc->return_value;
+
+	if (argc > 0) {
+		g_string_printf (nmc->return_text, _("Error: too many arguments."));
+		return NMC_RESULT_ERROR_USER_INPUT;
+	}
+
+	statistics = nm_client_get_latency_statistics (nmc->client, NULL, &error);
+	if (!statistics) {
+		g_string_printf (nmc->return_text, _("Error: 'general latency': %s"),
+		                 nmc_error_get_simple_message (error));
+		return NMC_RESULT_ERROR_UNKNOWN;
+	}
+
+	if (!nmc->required_fields || strcasecmp (nmc->required_fields, "common") == 0) {
+	} else if (strcasecmp (nmc->required_fields, "all") == 0) {
+	} else
+		fields_str = nmc->required_fields;
+
+	n = g_variant_n_children (statistics);
+	data = g_new (GetGeneralLatencyData, n);
+	targets = g_new (gpointer, n + 1);
+	g_variant_iter_init (&iter, statistics);
+	for (i = 0; i < n; i++) {
+		g_variant_iter_next (&iter, "{&s@a{sv}}", &data[i].operation, &data[i].statistics);
+		targets[i] = &data[i];
+	}
+	targets[n] = NULL;
+
+	if (!nmc_print (&nmc->nmc_config,
+	                targets,
+	                NULL,
+	                _("NetworkManager latency"),
+	                (const NMMetaAbstractInfo *const*) metagen_general_latency,
+	                fields_str,
+	                &error)) {
+		g_string_printf (nmc->return_text, _("Error: 'general latency': %s"), error->message);
+		nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+	}
+
+	for (i = 0; i < n; i++)
+		g_variant_unref (data[i].statistics);
+
+	return nmc->return_value;
+}
+
 static void
 save_hostname_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
@@ -784,6 +925,7 @@ static const NMCCommand general_cmds[] = {
 	{ "hostname",     do_general_hostname,     usage_general_hostname,     TRUE,   TRUE },
 	{ "permissions",  do_general_permissions,  usage_general_permissions,  TRUE,   TRUE },
 	{ "logging",      do_general_logging,      usage_general_logging,      TRUE,   TRUE },
+	{ "latency",      do_general_latency,      usage_general_latency,      TRUE,   TRUE },
 	{ NULL,           do_general_status,       usage_general,              TRUE,   TRUE },
 };
 
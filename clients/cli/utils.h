@@ -106,6 +106,15 @@ typedef enum {
 	NMC_GENERIC_INFO_TYPE_GENERAL_LOGGING_DOMAINS,
 	_NMC_GENERIC_INFO_TYPE_GENERAL_LOGGING_NUM,
 
+	NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_OPERATION = 0,
+	NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_COUNT,
+	NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_AVG,
+	NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_P50,
+	NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_P90,
+	NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_P99,
+	NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_MAX,
+	_NMC_GENERIC_INFO_TYPE_GENERAL_LATENCY_NUM,
+
 	NMC_GENERIC_INFO_TYPE_IP4_CONFIG_ADDRESS = 0,
 	NMC_GENERIC_INFO_TYPE_IP4_CONFIG_GATEWAY,
 	NMC_GENERIC_INFO_TYPE_IP4_CONFIG_ROUTE,
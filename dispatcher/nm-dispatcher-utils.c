@@ -581,3 +581,77 @@ done:
 	g_ptr_array_add (items, NULL);
 	return (char **) g_ptr_array_free (g_steal_pointer (&items), FALSE);
 }
+
+/*****************************************************************************/
+
+void
+nm_dispatcher_slots_init (NMDispatcherSlots *slots, int max_running)
+{
+	slots->max_running = max_running;
+	slots->num_running = 0;
+	g_queue_init (&slots->pending);
+}
+
+static gboolean
+_slots_available (NMDispatcherSlots *slots)
+{
+	return    slots->max_running <= 0
+	       || slots->num_running < slots->max_running;
+}
+
+/**
+ * nm_dispatcher_slots_acquire:
+ * @slots: the #NMDispatcherSlots
+ * @item: the script that wants to run
+ *
+ * Returns: %TRUE if @item got a slot and can run right away. Otherwise,
+ *   @item is queued and later returned by nm_dispatcher_slots_next().
+ *   An @item never overtakes scripts that are already waiting, even if
+ *   a slot is free at the moment.
+ */
+gboolean
+nm_dispatcher_slots_acquire (NMDispatcherSlots *slots, gpointer item)
+{
+	g_return_val_if_fail (item, FALSE);
+
+	if (   _slots_available (slots)
+	    && g_queue_is_empty (&slots->pending)) {
+		slots->num_running++;
+		return TRUE;
+	}
+
+	g_queue_push_tail (&slots->pending, item);
+	return FALSE;
+}
+
+/**
+ * nm_dispatcher_slots_release:
+ * @slots: the #NMDispatcherSlots
+ *
+ * Releases the slot of a script that completed or failed to start.
+ */
+void
+nm_dispatcher_slots_release (NMDispatcherSlots *slots)
+{
+	g_return_if_fail (slots->num_running > 0);
+
+	slots->num_running--;
+}
+
+/**
+ * nm_dispatcher_slots_next:
+ * @slots: the #NMDispatcherSlots
+ *
+ * Returns: the longest waiting script, which now holds a slot. %NULL if
+ *   no script waits or there is no free slot.
+ */
+gpointer
+nm_dispatcher_slots_next (NMDispatcherSlots *slots)
+{
+	if (   !_slots_available (slots)
+	    || g_queue_is_empty (&slots->pending))
+		return NULL;
+
+	slots->num_running++;
+	return g_queue_pop_head (&slots->pending);
+}
@@ -39,5 +39,24 @@ nm_dispatcher_utils_construct_envp (const char *action,
                                     char **out_iface,
                                     const char **out_error_message);
 
+/*****************************************************************************/
+
+/* Limits the number of scripts that run at the same time. Scripts that
+ * don't get a slot wait and are started in the order they arrived. */
+typedef struct {
+	/* the maximum number of running scripts. Unlimited if <= 0. */
+	int max_running;
+	int num_running;
+	GQueue pending;
+} NMDispatcherSlots;
+
+void nm_dispatcher_slots_init (NMDispatcherSlots *slots, int max_running);
+
+gboolean nm_dispatcher_slots_acquire (NMDispatcherSlots *slots, gpointer item);
+
+void nm_dispatcher_slots_release (NMDispatcherSlots *slots);
+
+gpointer nm_dispatcher_slots_next (NMDispatcherSlots *slots);
+
 #endif  /* __NETWORKMANAGER_DISPATCHER_UTILS_H__ */
 
@@ -41,20 +41,35 @@
 static GMainLoop *loop = NULL;
 static gboolean debug = FALSE;
 static gboolean persist = FALSE;
+static int max_parallel = 0;
 static guint quit_id;
 static guint request_id_counter = 0;
 
 typedef struct Request Request;
 
+/* Requests with "wait" scripts are run one after another. Normally, there
+ * is only one such queue. With --parallel, there is one queue per
+ * interface, so that a slow script for one interface doesn't hold up the
+ * events for the others. */
+typedef struct {
+	char *iface;
+	Request *current_request;
+	GQueue requests_waiting;
+} RequestQueue;
+
 typedef struct {
 	GObject parent;
 
 	/* Private data */
 	NMDBusDispatcher *dbus_dispatcher;
 
-	Request *current_request;
-	GQueue *requests_waiting;
+	RequestQueue queue;
+	GHashTable *queues;
 	int num_requests_pending;
+
+	/* with --parallel, at most @max_parallel scripts run at the same
+	 * time. The others wait for a free slot. */
+	NMDispatcherSlots slots;
 } Handler;
 
 typedef struct {
@@ -89,10 +104,25 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
                gboolean request_debug,
                gpointer user_data);
 
+static void
+request_queue_free (gpointer ptr)
+{
+	RequestQueue *q = ptr;
+
+	nm_assert (!q->current_request);
+	nm_assert (g_queue_is_empty (&q->requests_waiting));
+
+	g_free (q->iface);
+	g_slice_free (RequestQueue, q);
+}
+
 static void
 handler_init (Handler *h)
 {
-	h->requests_waiting = g_queue_new ();
+	g_queue_init (&h->queue.requests_waiting);
+	h->queues = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                   NULL, request_queue_free);
+	nm_dispatcher_slots_init (&h->slots, max_parallel);
 	h->dbus_dispatcher = nmdbus_dispatcher_skeleton_new ();
 	g_signal_connect (h->dbus_dispatcher, "handle-action",
 	                  G_CALLBACK (handle_action), h);
@@ -120,6 +150,7 @@ typedef struct {
 
 struct Request {
 	Handler *handler;
+	RequestQueue *queue;
 
 	guint request_id;
 
@@ -226,10 +257,38 @@ quit_timeout_reschedule (void)
 	}
 }
 
+static RequestQueue *
+request_queue_get (Handler *h, const char *iface)
+{
+	RequestQueue *q;
+
+	if (max_parallel <= 0)
+		return &h->queue;
+
+	iface = iface ?: "";
+	q = g_hash_table_lookup (h->queues, iface);
+	if (!q) {
+		q = g_slice_new0 (RequestQueue);
+		q->iface = g_strdup (iface);
+		g_queue_init (&q->requests_waiting);
+		g_hash_table_insert (h->queues, q->iface, q);
+	}
+	return q;
+}
+
+static void
+request_queue_release (Handler *h, RequestQueue *q)
+{
+	if (   q != &h->queue
+	    && !q->current_request
+	    && g_queue_is_empty (&q->requests_waiting))
+		g_hash_table_remove (h->queues, q->iface);
+}
+
 /**
  * next_request:
  *
- * @h: the handler
+ * @q: the request queue
  * @request: (allow-none): the request to set as next. If %NULL, dequeue the next
  * waiting request. Otherwise, try to set the given request.
  *
@@ -242,27 +301,27 @@ quit_timeout_reschedule (void)
  * a new request as current.
  */
 static gboolean
-next_request (Handler *h, Request *request)
+next_request (RequestQueue *q, Request *request)
 {
 	if (request) {
-		if (h->current_request) {
-			g_queue_push_tail (h->requests_waiting, request);
+		if (q->current_request) {
+			g_queue_push_tail (&q->requests_waiting, request);
 			return FALSE;
 		}
 	} else {
 		/* when calling next_request() without explicit @request, we always
 		 * forcefully clear @current_request. That one is certainly
 		 * handled already. */
-		h->current_request = NULL;
+		q->current_request = NULL;
 
-		request = g_queue_pop_head (h->requests_waiting);
+		request = g_queue_pop_head (&q->requests_waiting);
 		if (!request)
 			return FALSE;
 	}
 
 	_LOG_R_I (request, "start running ordered scripts...");
 
-	h->current_request = request;
+	q->current_request = request;
 
 	return TRUE;
 }
@@ -305,14 +364,15 @@ complete_request (Request *request)
 
 	_LOG_R_D (request, "completed (%u scripts)", request->scripts->len);
 
-	if (handler->current_request == request)
-		handler->current_request = NULL;
+	if (   request->queue
+	    && request->queue->current_request == request)
+		request->queue->current_request = NULL;
 
 	request_free (request);
 
 	g_assert_cmpuint (handler->num_requests_pending, >, 0);
 	if (--handler->num_requests_pending <= 0) {
-		nm_assert (!handler->current_request && !g_queue_peek_head (handler->requests_waiting));
+		nm_assert (!handler->queue.current_request && g_queue_is_empty (&handler->queue.requests_waiting));
 		quit_timeout_reschedule ();
 	}
 }
@@ -322,6 +382,7 @@ complete_script (ScriptInfo *script)
 {
 	Handler *handler;
 	Request *request;
+	RequestQueue *q;
 	gboolean wait = script->wait;
 
 	request = script->request;
@@ -334,8 +395,9 @@ complete_script (ScriptInfo *script)
 	}
 
 	handler = request->handler;
+	q = request->queue;
 
-	nm_assert (!wait || handler->current_request == request);
+	nm_assert (!wait || q->current_request == request);
 
 	/* Try to complete the request. @request will be possibly free'd,
 	 * making @script and @request a dangling pointer. */
@@ -348,13 +410,14 @@ complete_script (ScriptInfo *script)
 		 * requests. However, if this was the last "no-wait" script and
 		 * there are "wait" scripts ready to run, launch them.
 		 */
-		if (   handler->current_request == request
-		    && handler->current_request->num_scripts_nowait == 0) {
+		if (   q
+		    && q->current_request == request
+		    && q->current_request->num_scripts_nowait == 0) {
 
-			if (dispatch_one_script (handler->current_request))
+			if (dispatch_one_script (q->current_request))
 				return;
 
-			complete_request (handler->current_request);
+			complete_request (q->current_request);
 		} else
 			return;
 	} else {
@@ -367,11 +430,11 @@ complete_script (ScriptInfo *script)
 		 * processed because only requests with "wait" scripts can become
 		 * @current_request. As there can only be one "wait" script running
 		 * at any time, it means complete_request() above completed @request. */
-		nm_assert (!handler->current_request);
+		nm_assert (!q->current_request);
 	}
 
-	while (next_request (handler, NULL)) {
-		request = handler->current_request;
+	while (next_request (q, NULL)) {
+		request = q->current_request;
 
 		if (dispatch_one_script (request))
 			return;
@@ -384,18 +447,43 @@ complete_script (ScriptInfo *script)
 		 * @request has obviously no more "wait" scripts either.
 		 * Repeat... */
 	}
+
+	request_queue_release (handler, q);
+}
+
+static gboolean script_spawn (ScriptInfo *script);
+
+/* start scripts that waited for a free slot, in the order they were
+ * dispatched. */
+static void
+scripts_pending_run (Handler *h)
+{
+	ScriptInfo *script;
+
+	while ((script = nm_dispatcher_slots_next (&h->slots))) {
+		if (script_spawn (script))
+			continue;
+
+		/* failed to execute. Complete it like a script that exited. */
+		nm_dispatcher_slots_release (&h->slots);
+		if (!script->wait)
+			script->request->num_scripts_nowait--;
+		complete_script (script);
+	}
 }
 
 static void
 script_watch_cb (GPid pid, int status, gpointer user_data)
 {
 	ScriptInfo *script = user_data;
+	Handler *h = script->request->handler;
 	guint err;
 
 	g_assert (pid == script->pid);
 
 	script->watch_id = 0;
 	nm_clear_g_source (&script->timeout_id);
+	nm_dispatcher_slots_release (&h->slots);
 	script->request->num_scripts_done++;
 	if (!script->wait)
 		script->request->num_scripts_nowait--;
@@ -429,15 +517,18 @@ script_watch_cb (GPid pid, int status, gpointer user_data)
 	g_spawn_close_pid (script->pid);
 
 	complete_script (script);
+	scripts_pending_run (h);
 }
 
 static gboolean
 script_timeout_cb (gpointer user_data)
 {
 	ScriptInfo *script = user_data;
+	Handler *h = script->request->handler;
 
 	script->timeout_id = 0;
 	nm_clear_g_source (&script->watch_id);
+	nm_dispatcher_slots_release (&h->slots);
 	script->request->num_scripts_done++;
 	if (!script->wait)
 		script->request->num_scripts_nowait--;
@@ -457,6 +548,7 @@ again:
 	g_spawn_close_pid (script->pid);
 
 	complete_script (script);
+	scripts_pending_run (h);
 
 	return FALSE;
 }
@@ -525,17 +617,12 @@ check_filename (const char *file_name)
 #define SCRIPT_TIMEOUT 600  /* 10 minutes */
 
 static gboolean
-script_dispatch (ScriptInfo *script)
+script_spawn (ScriptInfo *script)
 {
 	GError *error = NULL;
 	char *argv[4];
 	Request *request = script->request;
 
-	if (script->dispatched)
-		return FALSE;
-
-	script->dispatched = TRUE;
-
 	argv[0] = script->script;
 	argv[1] = request->iface ?: (!strcmp(request->action, NMD_ACTION_HOSTNAME) ? "none" : "");
 	argv[2] = request->action;
@@ -546,8 +633,6 @@ script_dispatch (ScriptInfo *script)
 	if (g_spawn_async ("/", argv, request->envp, G_SPAWN_DO_NOT_REAP_CHILD, NULL, NULL, &script->pid, &error)) {
 		script->watch_id = g_child_watch_add (script->pid, (GChildWatchFunc) script_watch_cb, script);
 		script->timeout_id = g_timeout_add_seconds (SCRIPT_TIMEOUT, script_timeout_cb, script);
-		if (!script->wait)
-			request->num_scripts_nowait++;
 		return TRUE;
 	} else {
 		_LOG_S_W (script, "complete: failed to execute script: %s", error->message);
@@ -559,6 +644,32 @@ script_dispatch (ScriptInfo *script)
 	}
 }
 
+static gboolean
+script_dispatch (ScriptInfo *script)
+{
+	Request *request = script->request;
+	Handler *h = request->handler;
+
+	if (script->dispatched)
+		return FALSE;
+
+	script->dispatched = TRUE;
+
+	/* @script is queued behind the scripts that already wait for a slot.
+	 * Otherwise, a script dispatched by complete_script() would take the slot
+	 * that was just freed, before scripts_pending_run() starts the waiting ones. */
+	if (!nm_dispatcher_slots_acquire (&h->slots, script))
+		_LOG_S_D (script, "wait for one of %d running scripts to complete", h->slots.num_running);
+	else if (!script_spawn (script)) {
+		nm_dispatcher_slots_release (&h->slots);
+		return FALSE;
+	}
+
+	if (!script->wait)
+		request->num_scripts_nowait++;
+	return TRUE;
+}
+
 static gboolean
 dispatch_one_script (Request *request)
 {
@@ -760,11 +871,14 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 	}
 
 	if (num_nowait < request->scripts->len) {
+		RequestQueue *q = request_queue_get (h, request->iface);
+
 		/* The request has at least one wait script.
 		 * Try next_request() to schedule the request for
 		 * execution. This either enqueues the request or
-		 * sets it as h->current_request. */
-		if (next_request (h, request)) {
+		 * sets it as q->current_request. */
+		request->queue = q;
+		if (next_request (q, request)) {
 			/* @request is now @current_request. Go ahead and
 			 * schedule the first wait script. */
 			if (!dispatch_one_script (request)) {
@@ -772,12 +886,13 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 				 * request. Try complete_request(). */
 				complete_request (request);
 
-				if (next_request (h, NULL)) {
+				if (next_request (q, NULL)) {
 					/* As @request was successfully scheduled as next_request(), there is no
 					 * other request in queue that can be scheduled afterwards. Assert against
 					 * that, but call next_request() to clear current_request. */
 					g_assert_not_reached ();
 				}
+				request_queue_release (h, q);
 			}
 		}
 	} else {
@@ -785,7 +900,7 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 		 * the request right away (we might have failed to schedule any
 		 * of the scripts). It will be either completed now, or later
 		 * when the pending scripts return.
-		 * We don't enqueue it to h->requests_waiting.
+		 * We don't enqueue it to a request queue.
 		 * There is no need to handle next_request(), because @request is
 		 * not the current request anyway and does not interfere with requests
 		 * that have any "wait" scripts. */
@@ -898,6 +1013,7 @@ main (int argc, char **argv)
 	GOptionEntry entries[] = {
 		{ "debug", 0, 0, G_OPTION_ARG_NONE, &debug, "Output to console rather than syslog", NULL },
 		{ "persist", 0, 0, G_OPTION_ARG_NONE, &persist, "Don't quit after a short timeout", NULL },
+		{ "parallel", 0, 0, G_OPTION_ARG_INT, &max_parallel, "Handle events for different interfaces in parallel, running at most N scripts at a time", "N" },
 		{ NULL }
 	};
 
@@ -960,7 +1076,7 @@ main (int argc, char **argv)
 
 	g_main_loop_run (loop);
 
-	g_queue_free (handler->requests_waiting);
+	g_hash_table_unref (handler->queues);
 	g_object_unref (handler);
 
 	if (!debug)
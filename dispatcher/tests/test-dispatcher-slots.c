@@ -0,0 +1,106 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ */
+
+#include "nm-default.h"
+
+#include "nm-dispatcher-utils.h"
+
+#include "nm-utils/nm-test-utils.h"
+
+/*****************************************************************************/
+
+static void
+test_unlimited (void)
+{
+	NMDispatcherSlots slots;
+	int items[10];
+	guint i;
+
+	/* without --parallel, every script runs right away. */
+	nm_dispatcher_slots_init (&slots, 0);
+
+	for (i = 0; i < G_N_ELEMENTS (items); i++)
+		g_assert (nm_dispatcher_slots_acquire (&slots, &items[i]));
+	g_assert_cmpint (slots.num_running, ==, G_N_ELEMENTS (items));
+	g_assert (!nm_dispatcher_slots_next (&slots));
+
+	for (i = 0; i < G_N_ELEMENTS (items); i++)
+		nm_dispatcher_slots_release (&slots);
+	g_assert_cmpint (slots.num_running, ==, 0);
+}
+
+static void
+test_parallel_fifo (void)
+{
+	NMDispatcherSlots slots;
+	int running[2];
+	int waiting[3];
+	int late;
+
+	nm_dispatcher_slots_init (&slots, 2);
+
+	g_assert (nm_dispatcher_slots_acquire (&slots, &running[0]));
+	g_assert (nm_dispatcher_slots_acquire (&slots, &running[1]));
+	g_assert (!nm_dispatcher_slots_acquire (&slots, &waiting[0]));
+	g_assert (!nm_dispatcher_slots_acquire (&slots, &waiting[1]));
+	g_assert (!nm_dispatcher_slots_acquire (&slots, &waiting[2]));
+	g_assert (!nm_dispatcher_slots_next (&slots));
+
+	/* a script completes. Like complete_script(), dispatch the next script
+	 * of its request before the waiting scripts get started. It must not
+	 * take the freed slot. */
+	nm_dispatcher_slots_release (&slots);
+	g_assert (!nm_dispatcher_slots_acquire (&slots, &late));
+
+	g_assert (nm_dispatcher_slots_next (&slots) == &waiting[0]);
+	g_assert (!nm_dispatcher_slots_next (&slots));
+	g_assert_cmpint (slots.num_running, ==, 2);
+
+	nm_dispatcher_slots_release (&slots);
+	nm_dispatcher_slots_release (&slots);
+	g_assert (nm_dispatcher_slots_next (&slots) == &waiting[1]);
+	g_assert (nm_dispatcher_slots_next (&slots) == &waiting[2]);
+	g_assert (!nm_dispatcher_slots_next (&slots));
+
+	/* a script that failed to spawn releases its slot right away. */
+	nm_dispatcher_slots_release (&slots);
+	g_assert (nm_dispatcher_slots_next (&slots) == &late);
+	g_assert (g_queue_is_empty (&slots.pending));
+
+	/* with nothing waiting, a free slot is taken right away. */
+	nm_dispatcher_slots_release (&slots);
+	g_assert (nm_dispatcher_slots_acquire (&slots, &late));
+	g_assert_cmpint (slots.num_running, ==, 2);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init (&argc, &argv, TRUE);
+
+	g_test_add_func ("/dispatcher/slots/unlimited", test_unlimited);
+	g_test_add_func ("/dispatcher/slots/parallel-fifo", test_parallel_fifo);
+
+	return g_test_run ();
+}
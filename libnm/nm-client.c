@@ -602,6 +602,35 @@ nm_client_set_logging (NMClient *client, const char *level, const char *domains,
 	                               level, domains, error);
 }
 
+/**
+ * nm_client_get_latency_statistics:
+ * @client: a #NMClient
+ * @cancellable: (allow-none): a #GCancellable
+ * @error: (allow-none): return location for a #GError, or %NULL
+ *
+ * Gets NetworkManager's latency histograms for internal operations. See
+ * the GetLatencyStatistics() D-Bus method for the format.
+ *
+ * Returns: (transfer full): a "a{sa{sv}}" #GVariant with the statistics,
+ *   or %NULL on error.
+ *
+ * Since: 1.16
+ **/
+GVariant *
+nm_client_get_latency_statistics (NMClient *client,
+                                  GCancellable *cancellable,
+                                  GError **error)
+{
+	g_return_val_if_fail (NM_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	if (!_nm_client_check_nm_running (client, error))
+		return NULL;
+
+	return nm_manager_get_latency_statistics (NM_CLIENT_GET_PRIVATE (client)->manager,
+	                                          cancellable, error);
+}
+
 /**
  * nm_client_get_permission_result:
  * @client: a #NMClient
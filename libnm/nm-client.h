@@ -273,6 +273,11 @@ gboolean nm_client_set_logging (NMClient *client,
                                 const char *domains,
                                 GError **error);
 
+NM_AVAILABLE_IN_1_16
+GVariant *nm_client_get_latency_statistics (NMClient *client,
+                                           GCancellable *cancellable,
+                                           GError **error);
+
 NMClientPermissionResult nm_client_get_permission_result (NMClient *client,
                                                           NMClientPermission permission);
 
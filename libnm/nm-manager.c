@@ -651,6 +651,26 @@ nm_manager_set_logging (NMManager *manager, const char *level, const char *domai
 	return ret;
 }
 
+GVariant *
+nm_manager_get_latency_statistics (NMManager *manager,
+                                   GCancellable *cancellable,
+                                   GError **error)
+{
+	GVariant *statistics = NULL;
+
+	g_return_val_if_fail (NM_IS_MANAGER (manager), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	if (!nmdbus_manager_call_get_latency_statistics_sync (NM_MANAGER_GET_PRIVATE (manager)->proxy,
+	                                                      &statistics,
+	                                                      cancellable, error)) {
+		if (error && *error)
+			g_dbus_error_strip_remote_error (*error);
+		return NULL;
+	}
+	return statistics;
+}
+
 NMClientPermissionResult
 nm_manager_get_permission_result (NMManager *manager, NMClientPermission permission)
 {
@@ -118,6 +118,10 @@ gboolean nm_manager_set_logging (NMManager *manager,
                                  const char *domains,
                                  GError **error);
 
+GVariant *nm_manager_get_latency_statistics (NMManager *manager,
+                                            GCancellable *cancellable,
+                                            GError **error);
+
 NMClientPermissionResult nm_manager_get_permission_result (NMManager *manager,
                                                            NMClientPermission permission);
 
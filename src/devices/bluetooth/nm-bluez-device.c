@@ -407,11 +407,13 @@ static void
 load_connections (NMBluezDevice *self)
 {
 	NMBluezDevicePrivate *priv = NM_BLUEZ_DEVICE_GET_PRIVATE (self);
-	NMSettingsConnection *const*connections;
+	gs_free NMSettingsConnection **connections = NULL;
 	guint i;
 	gboolean changed = FALSE;
 
-	connections = nm_settings_get_connections (priv->settings, NULL);
+	connections = nm_settings_get_connections_clone_for_type (priv->settings,
+	                                                          NM_SETTING_BLUETOOTH_SETTING_NAME,
+	                                                          NULL, NULL, NULL, NULL, NULL);
 	for (i = 0; connections[i]; i++) {
 		if (connection_compatible (self, connections[i]))
 			changed |= _internal_track_connection (self, connections[i], TRUE);
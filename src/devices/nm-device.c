@@ -84,6 +84,8 @@
 #include "nm-device-generic.h"
 #include "nm-device-vlan.h"
 #include "nm-device-wireguard.h"
+#include "nm-latency.h"
+#include "nm-trace.h"
 
 #include "nm-device-logging.h"
 _LOG_DECLARE_SELF (NMDevice);
@@ -254,6 +256,7 @@ typedef struct _NMDevicePrivate {
 
 	NMDeviceState state;
 	NMDeviceStateReason state_reason;
+	gint64 state_start_ns;
 	struct {
 		guint id;
 
@@ -577,7 +580,10 @@ typedef struct _NMDevicePrivate {
 	guint check_delete_unrealized_id;
 
 	struct {
-		guint timeout_id;
+		/* the shared poller, while the device is registered for
+		 * periodic refreshes. */
+		gpointer poller;
+		gint64 next_ms;
 		guint refresh_rate_ms;
 		guint64 tx_bytes;
 		guint64 rx_bytes;
@@ -1797,22 +1803,6 @@ _stats_update_counters_from_pllink (NMDevice *self, const NMPlatformLink *pllink
 	_stats_update_counters (self, pllink->tx_bytes, pllink->rx_bytes);
 }
 
-static gboolean
-_stats_timeout_cb (gpointer user_data)
-{
-	NMDevice *self = user_data;
-	int ifindex;
-
-	ifindex = nm_device_get_ip_ifindex (self);
-
-	_LOGT (LOGD_DEVICE, "stats: refresh %d", ifindex);
-
-	if (ifindex > 0)
-		nm_platform_link_refresh (nm_device_get_platform (self), ifindex);
-
-	return G_SOURCE_CONTINUE;
-}
-
 static guint
 _stats_refresh_rate_real (guint refresh_rate_ms)
 {
@@ -1830,6 +1820,187 @@ _stats_refresh_rate_real (guint refresh_rate_ms)
 	return refresh_rate_ms;
 }
 
+/* Devices don't arm their own timers to refresh the statistics. Instead,
+ * all devices of one platform instance share a poller. Deadlines are
+ * aligned to multiples of the refresh rate, so that devices with the
+ * same (or a multiple) rate become due together, and all due links are
+ * refreshed at once. */
+
+typedef struct {
+	NMPlatform *platform;
+	GHashTable *devices;
+	gint64 timeout_at_ms;
+	guint timeout_id;
+} StatsPoller;
+
+/* a dump returns all links, also those of devices that are not due. Refresh
+ * all links with one dump, if at least 1/STATS_POLLER_DUMP_RATIO of them are
+ * due. Otherwise, request the due links individually. */
+#define STATS_POLLER_DUMP_RATIO 4
+
+static NM_CACHED_QUARK_FCN ("nm-device-stats-poller", _stats_poller_quark)
+
+static void _stats_poller_reschedule (StatsPoller *poller);
+
+static gint64
+_stats_deadline_next (gint64 now_ms, guint refresh_rate_ms)
+{
+	return ((now_ms / refresh_rate_ms) + 1) * refresh_rate_ms;
+}
+
+static gboolean
+_stats_poller_timeout_cb (gpointer user_data)
+{
+	StatsPoller *poller = user_data;
+	gs_unref_ptrarray GPtrArray *due = NULL;
+	GHashTableIter iter;
+	NMDevice *self;
+	gint64 now_ms;
+	guint i;
+
+	poller->timeout_id = 0;
+
+	now_ms = nm_utils_get_monotonic_timestamp_ms ();
+
+	due = g_ptr_array_new_with_free_func (g_object_unref);
+	g_hash_table_iter_init (&iter, poller->devices);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &self, NULL)) {
+		NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+
+		if (priv->stats.next_ms > now_ms)
+			continue;
+		priv->stats.next_ms = _stats_deadline_next (now_ms, _stats_refresh_rate_real (priv->stats.refresh_rate_ms));
+		g_ptr_array_add (due, g_object_ref (self));
+	}
+
+	/* refreshing the links emits platform signals, which might
+	 * unregister devices or even free the poller. Hold a reference
+	 * on the platform and recheck the devices afterwards. */
+	{
+		gs_unref_object NMPlatform *platform = g_object_ref (poller->platform);
+		const NMDedupMultiHeadEntry *head_entry;
+		guint n_links;
+
+		head_entry = nm_platform_lookup_obj_type (platform, NMP_OBJECT_TYPE_LINK);
+		n_links = head_entry ? head_entry->len : 0;
+
+		if (   due->len > 1
+		    && due->len * STATS_POLLER_DUMP_RATIO >= n_links) {
+			nm_log_trace (LOGD_DEVICE, "stats: refresh all %u links for %u devices", n_links, (guint) due->len);
+			nm_platform_refresh_all (platform, NMP_OBJECT_TYPE_LINK);
+		} else {
+			for (i = 0; i < due->len; i++) {
+				int ifindex;
+
+				self = due->pdata[i];
+				ifindex = nm_device_get_ip_ifindex (self);
+				_LOGT (LOGD_DEVICE, "stats: refresh %d", ifindex);
+				if (ifindex > 0)
+					nm_platform_link_refresh (platform, ifindex);
+			}
+		}
+
+		for (i = 0; i < due->len; i++) {
+			const NMPlatformLink *pllink;
+			int ifindex;
+
+			self = due->pdata[i];
+			if (!NM_DEVICE_GET_PRIVATE (self)->stats.poller)
+				continue;
+			ifindex = nm_device_get_ip_ifindex (self);
+			if (ifindex <= 0)
+				continue;
+			pllink = nm_platform_link_get (platform, ifindex);
+			if (pllink)
+				_stats_update_counters_from_pllink (self, pllink);
+		}
+
+		poller = g_object_get_qdata (G_OBJECT (platform), _stats_poller_quark ());
+		if (poller)
+			_stats_poller_reschedule (poller);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_stats_poller_reschedule (StatsPoller *poller)
+{
+	GHashTableIter iter;
+	NMDevice *self;
+	gint64 next_ms = G_MAXINT64;
+	gint64 now_ms;
+
+	nm_clear_g_source (&poller->timeout_id);
+
+	g_hash_table_iter_init (&iter, poller->devices);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &self, NULL))
+		next_ms = MIN (next_ms, NM_DEVICE_GET_PRIVATE (self)->stats.next_ms);
+
+	if (next_ms == G_MAXINT64)
+		return;
+
+	now_ms = nm_utils_get_monotonic_timestamp_ms ();
+	poller->timeout_at_ms = next_ms;
+	poller->timeout_id = g_timeout_add (next_ms > now_ms ? (guint) (next_ms - now_ms) : 0,
+	                                    _stats_poller_timeout_cb,
+	                                    poller);
+}
+
+static void
+_stats_poller_add (NMDevice *self, guint refresh_rate_ms)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	NMPlatform *platform = nm_device_get_platform (self);
+	StatsPoller *poller;
+	gint64 next_ms;
+
+	nm_assert (!priv->stats.poller);
+	nm_assert (refresh_rate_ms > 0);
+
+	poller = g_object_get_qdata (G_OBJECT (platform), _stats_poller_quark ());
+	if (!poller) {
+		poller = g_slice_new0 (StatsPoller);
+		poller->platform = platform;
+		poller->devices = g_hash_table_new (nm_direct_hash, NULL);
+		g_object_set_qdata (G_OBJECT (platform), _stats_poller_quark (), poller);
+	}
+
+	next_ms = _stats_deadline_next (nm_utils_get_monotonic_timestamp_ms (), refresh_rate_ms);
+
+	priv->stats.poller = poller;
+	priv->stats.next_ms = next_ms;
+	g_hash_table_add (poller->devices, self);
+
+	if (   !poller->timeout_id
+	    || next_ms < poller->timeout_at_ms)
+		_stats_poller_reschedule (poller);
+}
+
+static void
+_stats_poller_remove (NMDevice *self)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	StatsPoller *poller = priv->stats.poller;
+
+	if (!poller)
+		return;
+
+	priv->stats.poller = NULL;
+	if (!g_hash_table_remove (poller->devices, self))
+		nm_assert_not_reached ();
+
+	if (g_hash_table_size (poller->devices) > 0) {
+		/* the timer might fire a bit early now, that is harmless. */
+		return;
+	}
+
+	nm_clear_g_source (&poller->timeout_id);
+	g_object_set_qdata (G_OBJECT (poller->platform), _stats_poller_quark (), NULL);
+	g_hash_table_unref (poller->devices);
+	g_slice_free (StatsPoller, poller);
+}
+
 static void
 _stats_set_refresh_rate (NMDevice *self, guint refresh_rate_ms)
 {
@@ -1855,7 +2026,7 @@ _stats_set_refresh_rate (NMDevice *self, guint refresh_rate_ms)
 	if (_stats_refresh_rate_real (old_rate) == refresh_rate_ms)
 		return;
 
-	nm_clear_g_source (&priv->stats.timeout_id);
+	_stats_poller_remove (self);
 
 	if (!refresh_rate_ms)
 		return;
@@ -1867,7 +2038,7 @@ _stats_set_refresh_rate (NMDevice *self, guint refresh_rate_ms)
 	if (ifindex > 0)
 		nm_platform_link_refresh (nm_device_get_platform (self), ifindex);
 
-	priv->stats.timeout_id = g_timeout_add (refresh_rate_ms, _stats_timeout_cb, self);
+	_stats_poller_add (self, refresh_rate_ms);
 }
 
 /*****************************************************************************/
@@ -3690,8 +3861,8 @@ ndisc_set_router_config (NMNDisc *ndisc, NMDevice *self)
 	g_array_unref (dns_domains);
 }
 
-static gboolean
-device_link_changed (NMDevice *self)
+static void
+_device_link_changed (NMDevice *self)
 {
 	NMDeviceClass *klass = NM_DEVICE_GET_CLASS (self);
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
@@ -3710,10 +3881,10 @@ device_link_changed (NMDevice *self)
 
 	ifindex = nm_device_get_ifindex (self);
 	if (ifindex <= 0)
-		return G_SOURCE_REMOVE;
+		return;
 	pllink = nm_platform_link_get (nm_device_get_platform (self), ifindex);
 	if (!pllink)
-		return G_SOURCE_REMOVE;
+		return;
 
 	pllink_keep_alive = nmp_object_ref (NMP_OBJECT_UP_CAST (pllink));
 
@@ -3847,7 +4018,19 @@ device_link_changed (NMDevice *self)
 		                                   NM_DEVICE_STATE_REASON_NONE,
 		                                   NM_DEVICE_STATE_REASON_NONE);
 	}
+}
 
+static gboolean
+device_link_changed (NMDevice *self)
+{
+	const gint64 trace_start_ns = nm_trace_start ();
+
+	_device_link_changed (self);
+
+	nm_trace (NM_TRACE_EVENT_DEVICE_LINK_CHANGED,
+	          nm_device_get_ifindex (self),
+	          0, 0, 0, 0,
+	          trace_start_ns);
 	return G_SOURCE_REMOVE;
 }
 
@@ -4300,10 +4483,10 @@ realize_start_setup (NMDevice *self,
 
 	nm_device_set_carrier_from_platform (self);
 
-	nm_assert (!priv->stats.timeout_id);
+	nm_assert (!priv->stats.poller);
 	real_rate = _stats_refresh_rate_real (priv->stats.refresh_rate_ms);
 	if (real_rate)
-		priv->stats.timeout_id = g_timeout_add (real_rate, _stats_timeout_cb, self);
+		_stats_poller_add (self, real_rate);
 
 	klass->realize_start_notify (self, plink);
 
@@ -4491,7 +4674,7 @@ nm_device_unrealize (NMDevice *self, gboolean remove_resources, GError **error)
 		_notify (self, PROP_PHYSICAL_PORT_ID);
 	}
 
-	nm_clear_g_source (&priv->stats.timeout_id);
+	_stats_poller_remove (self);
 	_stats_update_counters (self, 0, 0);
 
 	priv->hw_addr_len_ = 0;
@@ -14713,6 +14896,22 @@ _set_state_full (NMDevice *self,
 
 	priv->in_state_changed = TRUE;
 
+	nm_trace (NM_TRACE_EVENT_DEVICE_STATE,
+	          nm_device_get_ifindex (self),
+	          0,
+	          state,
+	          0,
+	          ((guint32) old_state & 0xFFFFu) | ((guint32) reason << 16),
+	          priv->state_start_ns);
+
+	/* only the intermediate states tell where activation and
+	 * deactivation spend their time. */
+	if (   (   old_state > NM_DEVICE_STATE_DISCONNECTED
+	        && old_state < NM_DEVICE_STATE_ACTIVATED)
+	    || old_state == NM_DEVICE_STATE_DEACTIVATING)
+		nm_latency_record (NM_LATENCY_DEVICE_STATE, priv->state_start_ns);
+	priv->state_start_ns = nm_latency_start ();
+
 	priv->state = state;
 	priv->state_reason = reason;
 
@@ -16186,7 +16385,7 @@ dispose (GObject *object)
 
 	nm_clear_g_source (&priv->check_delete_unrealized_id);
 
-	nm_clear_g_source (&priv->stats.timeout_id);
+	_stats_poller_remove (self);
 
 	carrier_disconnected_action_cancel (self);
 
@@ -204,6 +204,15 @@ struct _NMDevice {
 	NMDBusObject parent;
 	struct _NMDevicePrivate *_priv;
 	CList devices_lst;
+
+	/* the lookup keys under which NMManager indexes the device. Owned
+	 * and only to be touched by NMManager. */
+	struct {
+		int ifindex;
+		char *iface;
+		char *ip_iface;
+		char *perm_hw_addr;
+	} _manager_idx;
 };
 
 /* The flags have an relaxing meaning, that means, specifying more flags, can make
@@ -63,6 +63,19 @@ _LOG_DECLARE_SELF(NMDeviceWifi);
 #define SCAN_INTERVAL_STEP 20
 #define SCAN_INTERVAL_MAX 120
 
+/* At most this many devices do a periodic scan at the same time. Further
+ * periodic scans wait until one of them is done. Scans requested by the
+ * user are not limited. */
+#define PERIODIC_SCAN_BUDGET 2
+
+/* A slot of the budget is given up after this many seconds, even if the
+ * scan did not complete. */
+#define PERIODIC_SCAN_BUDGET_TIMEOUT_SEC 30
+
+/* While scanning, AP list changes are collected until the scan is done,
+ * but not longer than this. */
+#define AP_BATCH_SCAN_TIMEOUT_SEC 5
+
 #define SCAN_RAND_MAC_ADDRESS_EXPIRE_MIN 5
 
 /*****************************************************************************/
@@ -89,6 +102,7 @@ typedef struct {
 	gint8             invalid_strength_counter;
 
 	CList             aps_lst_head;
+	NMWifiAPIndex     aps_idx;
 
 	NMWifiAP *        current_ap;
 	guint32           rate;
@@ -103,6 +117,14 @@ typedef struct {
 	guint8            scan_interval; /* seconds */
 	guint             pending_scan_id;
 	guint             ap_dump_id;
+	guint             ap_batch_id;
+
+	CList             scan_budget_lst;
+	guint             scan_budget_timeout_id;
+	bool              scan_budget_held:1;
+
+	bool              ap_batch_pending:1;
+	bool              ap_batch_recheck_available:1;
 
 	NMSupplicantManager   *sup_mgr;
 	NMSupplicantInterface *sup_iface;
@@ -174,6 +196,9 @@ static void supplicant_iface_scan_done_cb (NMSupplicantInterface * iface,
                                            gboolean success,
                                            NMDeviceWifi * self);
 
+static void supplicant_iface_scan_request_failed_cb (NMSupplicantInterface *iface,
+                                                     NMDeviceWifi *self);
+
 static void supplicant_iface_wps_credentials_cb (NMSupplicantInterface *iface,
                                                  GVariant *credentials,
                                                  NMDeviceWifi *self);
@@ -198,6 +223,80 @@ static void ap_add_remove (NMDeviceWifi *self,
 
 static void _hw_addr_set_scanning (NMDeviceWifi *self, gboolean do_reset);
 
+static gboolean request_wireless_scan_periodic (gpointer user_data);
+
+/*****************************************************************************/
+
+/* The global budget of periodic scans, shared by all Wi-Fi devices. */
+static guint scan_budget_used;
+static CList scan_budget_waiting_lst_head = C_LIST_INIT (scan_budget_waiting_lst_head);
+
+static void _scan_budget_release (NMDeviceWifi *self);
+
+static gboolean
+_scan_budget_timeout_cb (gpointer user_data)
+{
+	NMDeviceWifi *self = user_data;
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	priv->scan_budget_timeout_id = 0;
+	_LOGD (LOGD_WIFI, "wifi-scan: periodic scan did not complete in time, give up its slot");
+	_scan_budget_release (self);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+_scan_budget_acquire (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	if (priv->scan_budget_held)
+		return TRUE;
+
+	if (scan_budget_used >= PERIODIC_SCAN_BUDGET) {
+		if (c_list_is_empty (&priv->scan_budget_lst))
+			c_list_link_tail (&scan_budget_waiting_lst_head, &priv->scan_budget_lst);
+		return FALSE;
+	}
+
+	c_list_unlink (&priv->scan_budget_lst);
+	scan_budget_used++;
+	priv->scan_budget_held = TRUE;
+
+	/* don't let a scan that never completes block the other devices. */
+	priv->scan_budget_timeout_id = g_timeout_add_seconds (PERIODIC_SCAN_BUDGET_TIMEOUT_SEC,
+	                                                      _scan_budget_timeout_cb,
+	                                                      self);
+	return TRUE;
+}
+
+static void
+_scan_budget_release (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	NMDeviceWifi *next;
+
+	c_list_unlink (&priv->scan_budget_lst);
+
+	if (!priv->scan_budget_held)
+		return;
+
+	nm_assert (scan_budget_used > 0);
+	scan_budget_used--;
+	priv->scan_budget_held = FALSE;
+	nm_clear_g_source (&priv->scan_budget_timeout_id);
+
+	/* hand the slot to the device that waits longest. */
+	next = c_list_first_entry (&scan_budget_waiting_lst_head, NMDeviceWifi, _priv.scan_budget_lst);
+	if (next) {
+		NMDeviceWifiPrivate *priv_next = NM_DEVICE_WIFI_GET_PRIVATE (next);
+
+		c_list_unlink (&priv_next->scan_budget_lst);
+		nm_clear_g_source (&priv_next->pending_scan_id);
+		priv_next->pending_scan_id = g_idle_add (request_wireless_scan_periodic, next);
+	}
+}
+
 /*****************************************************************************/
 
 static void
@@ -279,6 +378,10 @@ supplicant_interface_acquire (NMDeviceWifi *self)
 	                  NM_SUPPLICANT_INTERFACE_SCAN_DONE,
 	                  G_CALLBACK (supplicant_iface_scan_done_cb),
 	                  self);
+	g_signal_connect (priv->sup_iface,
+	                  NM_SUPPLICANT_INTERFACE_SCAN_REQUEST_FAILED,
+	                  G_CALLBACK (supplicant_iface_scan_request_failed_cb),
+	                  self);
 	g_signal_connect (priv->sup_iface,
 	                  NM_SUPPLICANT_INTERFACE_WPS_CREDENTIALS,
 	                  G_CALLBACK (supplicant_iface_wps_credentials_cb),
@@ -312,6 +415,7 @@ _requested_scan_set (NMDeviceWifi *self, gboolean value)
 	if (value)
 		nm_device_add_pending_action ((NMDevice *) self, NM_PENDING_ACTION_WIFI_SCAN, TRUE);
 	else {
+		_scan_budget_release (self);
 		nm_device_emit_recheck_auto_activate (NM_DEVICE (self));
 		nm_device_remove_pending_action ((NMDevice *) self, NM_PENDING_ACTION_WIFI_SCAN, TRUE);
 	}
@@ -329,6 +433,7 @@ supplicant_interface_release (NMDeviceWifi *self)
 	_requested_scan_set (self, FALSE);
 
 	nm_clear_g_source (&priv->pending_scan_id);
+	_scan_budget_release (self);
 
 	/* Reset the scan interval to be pretty frequent when disconnected */
 	priv->scan_interval = SCAN_INTERVAL_MIN + SCAN_INTERVAL_STEP;
@@ -461,6 +566,57 @@ periodic_update_cb (gpointer user_data)
 	return TRUE;
 }
 
+static void
+_ap_batch_flush (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	nm_clear_g_source (&priv->ap_batch_id);
+
+	if (!priv->ap_batch_pending)
+		return;
+
+	priv->ap_batch_pending = FALSE;
+	_notify (self, PROP_ACCESS_POINTS);
+
+	nm_device_emit_recheck_auto_activate (NM_DEVICE (self));
+	if (priv->ap_batch_recheck_available) {
+		priv->ap_batch_recheck_available = FALSE;
+		nm_device_recheck_available_connections (NM_DEVICE (self));
+	}
+}
+
+static gboolean
+_ap_batch_flush_cb (gpointer user_data)
+{
+	NMDeviceWifi *self = user_data;
+
+	NM_DEVICE_WIFI_GET_PRIVATE (self)->ap_batch_id = 0;
+	_ap_batch_flush (self);
+	return G_SOURCE_REMOVE;
+}
+
+/* Each BSS of a scan result adds, updates or removes an AP. Instead of
+ * sending the whole AccessPoints list on D-Bus and rechecking the
+ * connections for every single AP, collect the changes. While scanning
+ * they are flushed when the scan is done, otherwise on idle. */
+static void
+_ap_batch_add (NMDeviceWifi *self, gboolean recheck_available_connections)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	priv->ap_batch_pending = TRUE;
+	if (recheck_available_connections)
+		priv->ap_batch_recheck_available = TRUE;
+
+	if (!priv->ap_batch_id) {
+		if (priv->is_scanning)
+			priv->ap_batch_id = g_timeout_add_seconds (AP_BATCH_SCAN_TIMEOUT_SEC, _ap_batch_flush_cb, self);
+		else
+			priv->ap_batch_id = g_idle_add (_ap_batch_flush_cb, self);
+	}
+}
+
 static void
 ap_add_remove (NMDeviceWifi *self,
                gboolean is_adding, /* or else removing */
@@ -473,25 +629,20 @@ ap_add_remove (NMDeviceWifi *self,
 		g_object_ref (ap);
 		ap->wifi_device = NM_DEVICE (self);
 		c_list_link_tail (&priv->aps_lst_head, &ap->aps_lst);
+		nm_wifi_ap_index_add (&priv->aps_idx, ap);
 		nm_dbus_object_export (NM_DBUS_OBJECT (ap));
 		_ap_dump (self, LOGL_DEBUG, ap, "added", 0);
 		nm_device_wifi_emit_signal_access_point (NM_DEVICE (self), ap, TRUE);
 	} else {
 		ap->wifi_device = NULL;
 		c_list_unlink (&ap->aps_lst);
+		nm_wifi_ap_index_remove (&priv->aps_idx, ap);
 		_ap_dump (self, LOGL_DEBUG, ap, "removed", 0);
-	}
-
-	_notify (self, PROP_ACCESS_POINTS);
-
-	if (!is_adding) {
 		nm_device_wifi_emit_signal_access_point (NM_DEVICE (self), ap, FALSE);
 		nm_dbus_object_clear_and_unexport (&ap);
 	}
 
-	nm_device_emit_recheck_auto_activate (NM_DEVICE (self));
-	if (recheck_available_connections)
-		nm_device_recheck_available_connections (NM_DEVICE (self));
+	_ap_batch_add (self, recheck_available_connections);
 }
 
 static void
@@ -742,7 +893,7 @@ check_connection_available (NMDevice *device,
 	    || NM_FLAGS_HAS (flags, _NM_DEVICE_CHECK_CON_AVAILABLE_FOR_USER_REQUEST_IGNORE_AP))
 		return TRUE;
 
-	if (!nm_wifi_aps_find_first_compatible (&priv->aps_lst_head, connection)) {
+	if (!nm_wifi_ap_index_find_first_compatible (&priv->aps_idx, connection)) {
 		nm_utils_error_set_literal (error, NM_UTILS_ERROR_CONNECTION_AVAILABLE_TEMPORARY,
 		                            "no compatible access point found");
 		return FALSE;
@@ -795,7 +946,7 @@ complete_connection (NMDevice *device,
 
 		if (!nm_streq0 (mode, NM_SETTING_WIRELESS_MODE_AP)) {
 			/* Find a compatible AP in the scan list */
-			ap = nm_wifi_aps_find_first_compatible (&priv->aps_lst_head, connection);
+			ap = nm_wifi_ap_index_find_first_compatible (&priv->aps_idx, connection);
 
 			/* If we still don't have an AP, then the WiFI settings needs to be
 			 * fully specified by the client.  Might not be able to find an AP
@@ -986,7 +1137,7 @@ can_auto_connect (NMDevice *device,
 			return FALSE;
 	}
 
-	ap = nm_wifi_aps_find_first_compatible (&priv->aps_lst_head, connection);
+	ap = nm_wifi_ap_index_find_first_compatible (&priv->aps_idx, connection);
 	if (ap) {
 		/* All good; connection is usable */
 		NM_SET_OUT (specific_object, g_strdup (nm_dbus_object_get_path (NM_DBUS_OBJECT (ap))));
@@ -1262,8 +1413,6 @@ hidden_filter_func (NMSettings *settings,
 	NMConnection *connection = nm_settings_connection_get_connection (set_con);
 	NMSettingWireless *s_wifi;
 
-	if (!nm_connection_is_type (connection, NM_SETTING_WIRELESS_SETTING_NAME))
-		return FALSE;
 	s_wifi = nm_connection_get_setting_wireless (connection);
 	if (!s_wifi)
 		return FALSE;
@@ -1286,15 +1435,14 @@ build_hidden_probe_list (NMDeviceWifi *self)
 	if (max_scan_ssids < 2)
 		return NULL;
 
-	connections = nm_settings_get_connections_clone (nm_device_get_settings ((NMDevice *) self),
-	                                                 &len,
-	                                                 hidden_filter_func, NULL,
-	                                                 NULL, NULL);
+	connections = nm_settings_get_connections_clone_for_type (nm_device_get_settings ((NMDevice *) self),
+	                                                          NM_SETTING_WIRELESS_SETTING_NAME,
+	                                                          &len,
+	                                                          hidden_filter_func, NULL,
+	                                                          nm_settings_connection_cmp_timestamp_p_with_data, NULL);
 	if (!connections[0])
 		return NULL;
 
-	g_qsort_with_data (connections, len, sizeof (NMSettingsConnection *), nm_settings_connection_cmp_timestamp_p_with_data, NULL);
-
 	ssids = g_ptr_array_new_full (max_scan_ssids, (GDestroyNotify) g_bytes_unref);
 
 	/* Add wildcard SSID using a static wildcard SSID used for every scan */
@@ -1374,6 +1522,9 @@ request_wireless_scan (NMDeviceWifi *self,
 		                                      ssids ? (GBytes *const*) ssids->pdata : NULL,
 		                                      ssids ? ssids->len : 0u);
 		request_started = TRUE;
+
+		/* no longer waiting for a periodic scan. */
+		c_list_unlink (&priv->scan_budget_lst);
 	} else
 		_LOGD (LOGD_WIFI, "wifi-scan: scanning requested but not allowed at this time");
 
@@ -1389,7 +1540,21 @@ request_wireless_scan_periodic (gpointer user_data)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
 	priv->pending_scan_id = 0;
+
+	if (   !priv->requested_scan
+	    && !_scan_budget_acquire (self)) {
+		/* _scan_budget_release() of another device starts the scan
+		 * once it's our turn. Still retry on our own in case that takes
+		 * too long. */
+		_LOGD (LOGD_WIFI, "wifi-scan: periodic scan deferred, too many devices scanning");
+		schedule_scan (self, FALSE);
+		return G_SOURCE_REMOVE;
+	}
+
 	request_wireless_scan (self, TRUE, FALSE, NULL);
+
+	if (!priv->requested_scan)
+		_scan_budget_release (self);
 	return G_SOURCE_REMOVE;
 }
 
@@ -1450,6 +1615,8 @@ supplicant_iface_scan_done_cb (NMSupplicantInterface *iface,
 
 	_LOGD (LOGD_WIFI, "wifi-scan: scan-done callback: %s", success ? "successful" : "failed");
 
+	_ap_batch_flush (self);
+
 	priv->last_scan = nm_utils_get_monotonic_timestamp_ms ();
 	_notify (self, PROP_LAST_SCAN);
 	schedule_scan (self, success);
@@ -1457,6 +1624,18 @@ supplicant_iface_scan_done_cb (NMSupplicantInterface *iface,
 	_requested_scan_set (self, FALSE);
 }
 
+static void
+supplicant_iface_scan_request_failed_cb (NMSupplicantInterface *iface,
+                                         NMDeviceWifi *self)
+{
+	_LOGD (LOGD_WIFI, "wifi-scan: scan request failed");
+
+	/* the supplicant might still be busy with another scan, whose ScanDone
+	 * completes our request. Only give up the slot of the periodic scan
+	 * budget, so that the other devices don't wait for us. */
+	_scan_budget_release (self);
+}
+
 /****************************************************************************
  * WPA Supplicant control stuff
  *
@@ -1499,7 +1678,7 @@ try_fill_ssid_for_hidden_ap (NMDeviceWifi *self,
                              NMWifiAP *ap)
 {
 	const char *bssid;
-	NMSettingsConnection *const*connections;
+	gs_free NMSettingsConnection **connections = NULL;
 	guint i;
 
 	g_return_if_fail (nm_wifi_ap_get_ssid (ap) == NULL);
@@ -1508,8 +1687,12 @@ try_fill_ssid_for_hidden_ap (NMDeviceWifi *self,
 	g_return_if_fail (bssid);
 
 	/* Look for this AP's BSSID in the seen-bssids list of a connection,
-	 * and if a match is found, copy over the SSID */
-	connections = nm_settings_get_connections (nm_device_get_settings ((NMDevice *) self), NULL);
+	 * and if a match is found, copy over the SSID. The most recently
+	 * used connection wins. */
+	connections = nm_settings_get_connections_clone_for_type (nm_device_get_settings ((NMDevice *) self),
+	                                                          NM_SETTING_WIRELESS_SETTING_NAME,
+	                                                          NULL, NULL, NULL,
+	                                                          nm_settings_connection_cmp_timestamp_p_with_data, NULL);
 	for (i = 0; connections[i]; i++) {
 		NMSettingsConnection *sett_conn = connections[i];
 		NMSettingWireless *s_wifi;
@@ -1546,7 +1729,7 @@ supplicant_iface_bss_updated_cb (NMSupplicantInterface *iface,
 	if (NM_DEVICE_WIFI_GET_PRIVATE (self)->mode == NM_802_11_MODE_AP)
 		return;
 
-	found_ap = nm_wifi_aps_find_by_supplicant_path (&priv->aps_lst_head, object_path);
+	found_ap = nm_wifi_ap_index_find_by_supplicant_path (&priv->aps_idx, object_path);
 	if (found_ap) {
 		if (!nm_wifi_ap_update_from_properties (found_ap, object_path, properties))
 			return;
@@ -1606,7 +1789,7 @@ supplicant_iface_bss_removed_cb (NMSupplicantInterface *iface,
 	g_return_if_fail (object_path != NULL);
 
 	priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
-	ap = nm_wifi_aps_find_by_supplicant_path (&priv->aps_lst_head, object_path);
+	ap = nm_wifi_ap_index_find_by_supplicant_path (&priv->aps_idx, object_path);
 	if (!ap)
 		return;
 
@@ -2167,7 +2350,7 @@ supplicant_iface_notify_current_bss (NMSupplicantInterface *iface,
 
 	current_bss = nm_supplicant_interface_get_current_bss (iface);
 	if (current_bss)
-		new_ap = nm_wifi_aps_find_by_supplicant_path (&priv->aps_lst_head, current_bss);
+		new_ap = nm_wifi_ap_index_find_by_supplicant_path (&priv->aps_idx, current_bss);
 
 	if (new_ap != priv->current_ap) {
 		const char *new_bssid = NULL;
@@ -2580,7 +2763,7 @@ act_stage1_prepare (NMDevice *device, NMDeviceStateReason *out_failure_reason)
 		if (ap)
 			goto done;
 
-		ap = nm_wifi_aps_find_first_compatible (&priv->aps_lst_head, connection);
+		ap = nm_wifi_ap_index_find_first_compatible (&priv->aps_idx, connection);
 	}
 
 	if (ap) {
@@ -3262,6 +3445,8 @@ nm_device_wifi_init (NMDeviceWifi *self)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
 	c_list_init (&priv->aps_lst_head);
+	nm_wifi_ap_index_init (&priv->aps_idx);
+	c_list_init (&priv->scan_budget_lst);
 
 	priv->hidden_probe_scan_warn = TRUE;
 	priv->mode = NM_802_11_MODE_INFRA;
@@ -3313,6 +3498,7 @@ dispose (GObject *object)
 	g_clear_object (&priv->sup_mgr);
 
 	remove_all_aps (self);
+	nm_clear_g_source (&priv->ap_batch_id);
 
 	G_OBJECT_CLASS (nm_device_wifi_parent_class)->dispose (object);
 }
@@ -3324,6 +3510,11 @@ finalize (GObject *object)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
 	nm_assert (c_list_is_empty (&priv->aps_lst_head));
+	nm_assert (c_list_is_empty (&priv->scan_budget_lst));
+	nm_assert (!priv->scan_budget_held);
+	nm_assert (!priv->scan_budget_timeout_id);
+
+	nm_wifi_ap_index_clear (&priv->aps_idx);
 
 	G_OBJECT_CLASS (nm_device_wifi_parent_class)->finalize (object);
 }
@@ -54,27 +54,33 @@ NM_GOBJECT_PROPERTIES_DEFINE (NMWifiAP,
 	PROP_LAST_SEEN,
 );
 
+/* The fields are ordered and sized so that the struct packs tightly;
+ * hundreds of APs are not unusual. */
 struct _NMWifiAPPrivate {
 	char *supplicant_path;   /* D-Bus object path of this AP from wpa_supplicant */
 
 	/* Scanned or cached values */
-	GBytes *           ssid;
-	char *             address;
-	NM80211Mode        mode;
-	guint8             strength;
-	guint32            freq;        /* Frequency in MHz; ie 2412 (== 2.412 GHz) */
+	GBytes *           ssid;        /* interned, see _ssid_intern_ref() */
 	guint32            max_bitrate; /* Maximum bitrate of the AP in Kbit/s (ie 54000 Kb/s == 54Mbit/s) */
+	gint32             last_seen;   /* Timestamp when the AP was seen lastly (obtained via nm_utils_get_monotonic_timestamp_s()) */
+	guint16            freq;        /* Frequency in MHz; ie 2412 (== 2.412 GHz) */
 
-	NM80211ApFlags         flags;      /* General flags */
-	NM80211ApSecurityFlags wpa_flags;  /* WPA-related flags */
-	NM80211ApSecurityFlags rsn_flags;  /* RSN (WPA2) -related flags */
+	guint16            wpa_flags;   /* NM80211ApSecurityFlags, WPA-related flags */
+	guint16            rsn_flags;   /* NM80211ApSecurityFlags, RSN (WPA2) -related flags */
+	guint8             flags;       /* NM80211ApFlags, general flags */
+	guint8             mode;        /* NM80211Mode */
+	guint8             strength;
 
 	/* Non-scanned attributes */
 	bool                fake:1;       /* Whether or not the AP is from a scan */
 	bool                hotspot:1;    /* Whether the AP is a local device's hotspot network */
-	gint32              last_seen;    /* Timestamp when the AP was seen lastly (obtained via nm_utils_get_monotonic_timestamp_s()) */
+
+	char               address[sizeof ("00:00:00:00:00:00")]; /* empty if unset */
 };
 
+G_STATIC_ASSERT (NM_802_11_AP_SEC_KEY_MGMT_802_1X <= G_MAXUINT16);
+G_STATIC_ASSERT (NM_802_11_AP_FLAGS_WPS_PIN <= G_MAXUINT8);
+
 typedef struct _NMWifiAPPrivate NMWifiAPPrivate;
 
 struct _NMWifiAPClass {
@@ -87,6 +93,131 @@ G_DEFINE_TYPE (NMWifiAP, nm_wifi_ap, NM_TYPE_DBUS_OBJECT)
 
 /*****************************************************************************/
 
+/* APs of the same network (and of the same network seen on several radios)
+ * share one GBytes instance for the SSID. */
+
+typedef struct {
+	GBytes *ssid;
+	guint ref_count;
+} InternedSsid;
+
+static GHashTable *ssid_intern_table;
+
+static void
+_interned_ssid_free (gpointer data)
+{
+	InternedSsid *interned = data;
+
+	g_bytes_unref (interned->ssid);
+	g_slice_free (InternedSsid, interned);
+}
+
+/* Returns the interned instance equal to @ssid (or @arr/@len if @ssid is
+ * %NULL). The returned instance is owned by the intern table and must be
+ * released with _ssid_intern_unref(). */
+static GBytes *
+_ssid_intern_ref (GBytes *ssid, const guint8 *arr, gsize len)
+{
+	gs_unref_bytes GBytes *ssid_tmp = NULL;
+	InternedSsid *interned;
+
+	if (G_UNLIKELY (!ssid_intern_table))
+		ssid_intern_table = g_hash_table_new_full (g_bytes_hash, g_bytes_equal, NULL, _interned_ssid_free);
+
+	if (!ssid)
+		ssid = ssid_tmp = g_bytes_new_static (arr, len);
+
+	interned = g_hash_table_lookup (ssid_intern_table, ssid);
+	if (interned) {
+		interned->ref_count++;
+		return interned->ssid;
+	}
+
+	interned = g_slice_new (InternedSsid);
+	interned->ref_count = 1;
+	interned->ssid = ssid_tmp
+	                 ? g_bytes_new (arr, len)
+	                 : g_bytes_ref (ssid);
+	g_hash_table_insert (ssid_intern_table, interned->ssid, interned);
+	return interned->ssid;
+}
+
+static void
+_ssid_intern_unref (GBytes *ssid)
+{
+	InternedSsid *interned;
+
+	interned = g_hash_table_lookup (ssid_intern_table, ssid);
+	nm_assert (interned && interned->ssid == ssid);
+	if (--interned->ref_count == 0)
+		g_hash_table_remove (ssid_intern_table, ssid);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GBytes *ssid;
+	CList lst_head;
+} SsidBucket;
+
+static void
+_ssid_bucket_free (gpointer data)
+{
+	SsidBucket *bucket = data;
+
+	nm_assert (c_list_is_empty (&bucket->lst_head));
+
+	g_bytes_unref (bucket->ssid);
+	g_slice_free (SsidBucket, bucket);
+}
+
+static void
+_aps_idx_ssid_link (NMWifiAP *ap)
+{
+	NMWifiAPIndex *idx = ap->aps_idx;
+	NMWifiAPPrivate *priv = NM_WIFI_AP_GET_PRIVATE (ap);
+	SsidBucket *bucket;
+
+	if (!idx)
+		return;
+
+	if (!priv->ssid) {
+		c_list_link_tail (&idx->no_ssid_lst_head, &ap->aps_ssid_lst);
+		return;
+	}
+
+	bucket = g_hash_table_lookup (idx->by_ssid, priv->ssid);
+	if (!bucket) {
+		bucket = g_slice_new (SsidBucket);
+		bucket->ssid = g_bytes_ref (priv->ssid);
+		c_list_init (&bucket->lst_head);
+		g_hash_table_insert (idx->by_ssid, bucket->ssid, bucket);
+	}
+	c_list_link_tail (&bucket->lst_head, &ap->aps_ssid_lst);
+}
+
+static void
+_aps_idx_ssid_unlink (NMWifiAP *ap)
+{
+	NMWifiAPIndex *idx = ap->aps_idx;
+	NMWifiAPPrivate *priv = NM_WIFI_AP_GET_PRIVATE (ap);
+	SsidBucket *bucket;
+
+	if (!idx)
+		return;
+
+	c_list_unlink (&ap->aps_ssid_lst);
+	if (!priv->ssid)
+		return;
+
+	bucket = g_hash_table_lookup (idx->by_ssid, priv->ssid);
+	nm_assert (bucket);
+	if (c_list_is_empty (&bucket->lst_head))
+		g_hash_table_remove (idx->by_ssid, priv->ssid);
+}
+
+/*****************************************************************************/
+
 const char *
 nm_wifi_ap_get_supplicant_path (NMWifiAP *ap)
 {
@@ -120,9 +251,11 @@ nm_wifi_ap_set_ssid_arr (NMWifiAP *ap,
 	if (nm_utils_gbytes_equal_mem (priv->ssid, ssid, ssid_len))
 		return FALSE;
 
-	nm_clear_pointer (&priv->ssid, g_bytes_unref);
+	_aps_idx_ssid_unlink (ap);
+	nm_clear_pointer (&priv->ssid, _ssid_intern_unref);
 	if (ssid_len > 0)
-		priv->ssid = g_bytes_new (ssid, ssid_len);
+		priv->ssid = _ssid_intern_ref (NULL, ssid, ssid_len);
+	_aps_idx_ssid_link (ap);
 
 	_notify (ap, PROP_SSID);
 	return TRUE;
@@ -151,9 +284,11 @@ nm_wifi_ap_set_ssid (NMWifiAP *ap, GBytes *ssid)
 	    && g_bytes_equal (ssid, priv->ssid))
 		return FALSE;
 
-	nm_clear_pointer (&priv->ssid, g_bytes_unref);
+	_aps_idx_ssid_unlink (ap);
+	nm_clear_pointer (&priv->ssid, _ssid_intern_unref);
 	if (ssid)
-		priv->ssid = g_bytes_ref (ssid);
+		priv->ssid = _ssid_intern_ref (ssid, NULL, 0);
+	_aps_idx_ssid_link (ap);
 
 	_notify (ap, PROP_SSID);
 	return TRUE;
@@ -213,7 +348,9 @@ nm_wifi_ap_get_address (const NMWifiAP *ap)
 {
 	g_return_val_if_fail (NM_IS_WIFI_AP (ap), NULL);
 
-	return NM_WIFI_AP_GET_PRIVATE (ap)->address;
+	return NM_WIFI_AP_GET_PRIVATE (ap)->address[0]
+	       ? NM_WIFI_AP_GET_PRIVATE (ap)->address
+	       : NULL;
 }
 
 static gboolean
@@ -223,10 +360,9 @@ nm_wifi_ap_set_address_bin (NMWifiAP *ap, const guint8 *addr /* ETH_ALEN bytes *
 
 	priv = NM_WIFI_AP_GET_PRIVATE (ap);
 
-	if (   !priv->address
+	if (   !priv->address[0]
 	    || !nm_utils_hwaddr_matches (addr, ETH_ALEN, priv->address, -1)) {
-		g_free (priv->address);
-		priv->address = nm_utils_hwaddr_ntoa (addr, ETH_ALEN);
+		nm_utils_hwaddr_ntoa_buf (addr, ETH_ALEN, TRUE, priv->address, sizeof (priv->address));
 		_notify (ap, PROP_HW_ADDRESS);
 		return TRUE;
 	}
@@ -321,6 +457,7 @@ nm_wifi_ap_set_freq (NMWifiAP *ap,
 	NMWifiAPPrivate *priv;
 
 	g_return_val_if_fail (NM_IS_WIFI_AP (ap), FALSE);
+	g_return_val_if_fail (freq <= G_MAXUINT16, FALSE);
 
 	priv = NM_WIFI_AP_GET_PRIVATE (ap);
 
@@ -770,120 +907,136 @@ get_max_rate (const guint8 *bytes, gsize len)
 
 /*****************************************************************************/
 
+/**
+ * nm_wifi_ap_update_from_properties:
+ * @ap: the AP
+ * @supplicant_path: the D-Bus path of the BSS
+ * @properties: the BSS properties from the supplicant
+ *
+ * Updates @ap from @properties. Only the keys present in @properties
+ * are looked at, so it can be the full property set of a new BSS
+ * or just the properties that changed. The dictionary is walked once.
+ *
+ * Returns: whether anything in @ap changed.
+ */
 gboolean
 nm_wifi_ap_update_from_properties (NMWifiAP *ap,
                                    const char *supplicant_path,
                                    GVariant *properties)
 {
 	NMWifiAPPrivate *priv;
-	const guint8 *bytes;
+	GVariantIter iter;
+	const char *key;
 	GVariant *v;
+	const guint8 *bytes;
 	gsize len;
 	gsize i;
-	gboolean b = FALSE;
 	const char *s;
-	gint16 i16;
-	guint16 u16;
 	gboolean changed = FALSE;
-	guint32 max_rate;
+	NM80211ApFlags flags;
+	NM80211ApSecurityFlags wpa_flags;
+	NM80211ApSecurityFlags rsn_flags;
+	guint32 max_rate = 0;
 
 	g_return_val_if_fail (NM_IS_WIFI_AP (ap), FALSE);
 	g_return_val_if_fail (properties, FALSE);
 
 	priv = NM_WIFI_AP_GET_PRIVATE (ap);
 
-	g_object_freeze_notify (G_OBJECT (ap));
-
-	if (g_variant_lookup (properties, "Privacy", "b", &b) && b)
-		changed |= nm_wifi_ap_set_flags (ap, priv->flags | NM_802_11_AP_FLAGS_PRIVACY);
-
-	v = g_variant_lookup_value (properties, "WPS", G_VARIANT_TYPE_VARDICT);
-	if (v) {
-		if (g_variant_lookup (v, "Type", "&s", &s)) {
-			changed |= nm_wifi_ap_set_flags (ap, priv->flags | NM_802_11_AP_FLAGS_WPS);
-			if (strcmp (s, "pbc") == 0)
-				changed |= nm_wifi_ap_set_flags (ap, priv->flags | NM_802_11_AP_FLAGS_WPS_PBC);
-			else if (strcmp (s, "pin") == 0)
-				changed |= nm_wifi_ap_set_flags (ap, priv->flags | NM_802_11_AP_FLAGS_WPS_PIN);
-		}
-		g_variant_unref (v);
-	}
-
-	if (g_variant_lookup (properties, "Mode", "&s", &s)) {
-		if (!g_strcmp0 (s, "infrastructure"))
-			changed |= nm_wifi_ap_set_mode (ap, NM_802_11_MODE_INFRA);
-		else if (!g_strcmp0 (s, "ad-hoc"))
-			changed |= nm_wifi_ap_set_mode (ap, NM_802_11_MODE_ADHOC);
-	}
+	/* the flags only ever get added; collect them first so that each
+	 * is set (and notified) at most once. */
+	flags = priv->flags;
+	wpa_flags = priv->wpa_flags;
+	rsn_flags = priv->rsn_flags;
 
-	if (g_variant_lookup (properties, "Signal", "n", &i16))
-		changed |= nm_wifi_ap_set_strength (ap, nm_wifi_utils_level_to_quality (i16));
-
-	if (g_variant_lookup (properties, "Frequency", "q", &u16))
-		changed |= nm_wifi_ap_set_freq (ap, u16);
-
-	v = g_variant_lookup_value (properties, "SSID", G_VARIANT_TYPE_BYTESTRING);
-	if (v) {
-		bytes = g_variant_get_fixed_array (v, &len, 1);
-		len = MIN (32, len);
-
-		/* Stupid ieee80211 layer uses <hidden> */
-		if (   bytes
-		    && len
-		    && !(   NM_IN_SET (len, 8, 9)
-		         && memcmp (bytes, "<hidden>", len) == 0)
-		    && !nm_utils_is_empty_ssid (bytes, len)) {
-			/* good */
-		} else
-			len = 0;
-
-		changed |= nm_wifi_ap_set_ssid_arr (ap, bytes, len);
+	g_object_freeze_notify (G_OBJECT (ap));
 
-		g_variant_unref (v);
-	}
+	g_variant_iter_init (&iter, properties);
+	while (g_variant_iter_next (&iter, "{&sv}", &key, &v)) {
+		if (nm_streq (key, "Privacy")) {
+			if (   g_variant_is_of_type (v, G_VARIANT_TYPE_BOOLEAN)
+			    && g_variant_get_boolean (v))
+				flags |= NM_802_11_AP_FLAGS_PRIVACY;
+		} else if (nm_streq (key, "WPS")) {
+			if (   g_variant_is_of_type (v, G_VARIANT_TYPE_VARDICT)
+			    && g_variant_lookup (v, "Type", "&s", &s)) {
+				flags |= NM_802_11_AP_FLAGS_WPS;
+				if (strcmp (s, "pbc") == 0)
+					flags |= NM_802_11_AP_FLAGS_WPS_PBC;
+				else if (strcmp (s, "pin") == 0)
+					flags |= NM_802_11_AP_FLAGS_WPS_PIN;
+			}
+		} else if (nm_streq (key, "Mode")) {
+			if (g_variant_is_of_type (v, G_VARIANT_TYPE_STRING)) {
+				s = g_variant_get_string (v, NULL);
+				if (nm_streq (s, "infrastructure"))
+					changed |= nm_wifi_ap_set_mode (ap, NM_802_11_MODE_INFRA);
+				else if (nm_streq (s, "ad-hoc"))
+					changed |= nm_wifi_ap_set_mode (ap, NM_802_11_MODE_ADHOC);
+			}
+		} else if (nm_streq (key, "Signal")) {
+			if (g_variant_is_of_type (v, G_VARIANT_TYPE_INT16))
+				changed |= nm_wifi_ap_set_strength (ap, nm_wifi_utils_level_to_quality (g_variant_get_int16 (v)));
+		} else if (nm_streq (key, "Frequency")) {
+			if (g_variant_is_of_type (v, G_VARIANT_TYPE_UINT16))
+				changed |= nm_wifi_ap_set_freq (ap, g_variant_get_uint16 (v));
+		} else if (nm_streq (key, "SSID")) {
+			if (g_variant_is_of_type (v, G_VARIANT_TYPE_BYTESTRING)) {
+				bytes = g_variant_get_fixed_array (v, &len, 1);
+				len = MIN (32, len);
+
+				/* Stupid ieee80211 layer uses <hidden> */
+				if (   bytes
+				    && len
+				    && !(   NM_IN_SET (len, 8, 9)
+				         && memcmp (bytes, "<hidden>", len) == 0)
+				    && !nm_utils_is_empty_ssid (bytes, len)) {
+					/* good */
+				} else
+					len = 0;
+
+				changed |= nm_wifi_ap_set_ssid_arr (ap, bytes, len);
+			}
+		} else if (nm_streq (key, "BSSID")) {
+			if (g_variant_is_of_type (v, G_VARIANT_TYPE_BYTESTRING)) {
+				bytes = g_variant_get_fixed_array (v, &len, 1);
+				if (   len == ETH_ALEN
+				    && memcmp (bytes, nm_ip_addr_zero.addr_eth, ETH_ALEN) != 0
+				    && memcmp (bytes, (char[ETH_ALEN]) { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF }, ETH_ALEN) != 0)
+					changed |= nm_wifi_ap_set_address_bin (ap, bytes);
+			}
+		} else if (nm_streq (key, "Rates")) {
+			if (g_variant_is_of_type (v, G_VARIANT_TYPE ("au"))) {
+				const guint32 *rates = g_variant_get_fixed_array (v, &len, sizeof (guint32));
 
-	v = g_variant_lookup_value (properties, "BSSID", G_VARIANT_TYPE_BYTESTRING);
-	if (v) {
-		bytes = g_variant_get_fixed_array (v, &len, 1);
-		if (   len == ETH_ALEN
-		    && memcmp (bytes, nm_ip_addr_zero.addr_eth, ETH_ALEN) != 0
-		    && memcmp (bytes, (char[ETH_ALEN]) { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF }, ETH_ALEN) != 0)
-			changed |= nm_wifi_ap_set_address_bin (ap, bytes);
+				for (i = 0; i < len; i++)
+					max_rate = NM_MAX (max_rate, rates[i]);
+			}
+		} else if (nm_streq (key, "IEs")) {
+			if (g_variant_is_of_type (v, G_VARIANT_TYPE_BYTESTRING)) {
+				bytes = g_variant_get_fixed_array (v, &len, 1);
+				max_rate = NM_MAX (max_rate, get_max_rate (bytes, len));
+			}
+		} else if (nm_streq (key, "WPA")) {
+			if (g_variant_is_of_type (v, G_VARIANT_TYPE_VARDICT))
+				wpa_flags |= security_from_vardict (v);
+		} else if (nm_streq (key, "RSN")) {
+			if (g_variant_is_of_type (v, G_VARIANT_TYPE_VARDICT))
+				rsn_flags |= security_from_vardict (v);
+		}
 		g_variant_unref (v);
 	}
 
-	max_rate = 0;
-	v = g_variant_lookup_value (properties, "Rates", G_VARIANT_TYPE ("au"));
-	if (v) {
-		const guint32 *rates = g_variant_get_fixed_array (v, &len, sizeof (guint32));
-
-		for (i = 0; i < len; i++)
-			max_rate = NM_MAX (max_rate, rates[i]);
-		g_variant_unref (v);
-	}
-	v = g_variant_lookup_value (properties, "IEs", G_VARIANT_TYPE_BYTESTRING);
-	if (v) {
-		bytes = g_variant_get_fixed_array (v, &len, 1);
-		max_rate = NM_MAX (max_rate, get_max_rate (bytes, len));
-		g_variant_unref (v);
-	}
+	changed |= nm_wifi_ap_set_flags (ap, flags);
+	changed |= nm_wifi_ap_set_wpa_flags (ap, wpa_flags);
+	changed |= nm_wifi_ap_set_rsn_flags (ap, rsn_flags);
 	if (max_rate)
 		changed |= nm_wifi_ap_set_max_bitrate (ap, max_rate / 1000);
 
-	v = g_variant_lookup_value (properties, "WPA", G_VARIANT_TYPE_VARDICT);
-	if (v) {
-		changed |= nm_wifi_ap_set_wpa_flags (ap, priv->wpa_flags | security_from_vardict (v));
-		g_variant_unref (v);
-	}
-
-	v = g_variant_lookup_value (properties, "RSN", G_VARIANT_TYPE_VARDICT);
-	if (v) {
-		changed |= nm_wifi_ap_set_rsn_flags (ap, priv->rsn_flags | security_from_vardict (v));
-		g_variant_unref (v);
-	}
-
 	if (!priv->supplicant_path) {
 		priv->supplicant_path = g_strdup (supplicant_path);
+		if (ap->aps_idx)
+			g_hash_table_insert (ap->aps_idx->by_supplicant_path, priv->supplicant_path, ap);
 		changed = TRUE;
 	}
 
@@ -998,7 +1151,7 @@ nm_wifi_ap_to_string (const NMWifiAP *self,
 
 	g_snprintf (str_buf, buf_len,
 	            "%17s %-35s [ %c %3u %3u%% %c W:%04X R:%04X ] %3us sup:%s [nm:%s]",
-	            priv->address ?: "(none)",
+	            priv->address[0] ? priv->address : "(none)",
 	            (ssid_to_free = _nm_utils_ssid_to_string (priv->ssid)),
 	            (priv->mode == NM_802_11_MODE_ADHOC
 	                 ? '*'
@@ -1059,7 +1212,7 @@ nm_wifi_ap_check_compatible (NMWifiAP *self,
 	}
 
 	bssid = nm_setting_wireless_get_bssid (s_wireless);
-	if (bssid && (!priv->address || !nm_utils_hwaddr_matches (bssid, -1, priv->address, -1)))
+	if (bssid && (!priv->address[0] || !nm_utils_hwaddr_matches (bssid, -1, priv->address, -1)))
 		return FALSE;
 
 	mode = nm_setting_wireless_get_mode (s_wireless);
@@ -1112,7 +1265,7 @@ nm_wifi_ap_complete_connection (NMWifiAP *self,
 	g_return_val_if_fail (connection != NULL, FALSE);
 
 	return nm_wifi_utils_complete_connection (priv->ssid,
-	                                          priv->address,
+	                                          nm_wifi_ap_get_address (self),
 	                                          priv->mode,
 	                                          priv->flags,
 	                                          priv->wpa_flags,
@@ -1149,7 +1302,7 @@ get_property (GObject *object, guint prop_id,
 		g_value_set_uint (value, priv->freq);
 		break;
 	case PROP_HW_ADDRESS:
-		g_value_set_string (value, priv->address);
+		g_value_set_string (value, nm_wifi_ap_get_address (self));
 		break;
 	case PROP_MODE:
 		g_value_set_uint (value, priv->mode);
@@ -1184,6 +1337,7 @@ nm_wifi_ap_init (NMWifiAP *self)
 	self->_priv = priv;
 
 	c_list_init (&self->aps_lst);
+	c_list_init (&self->aps_ssid_lst);
 
 	priv->mode = NM_802_11_MODE_INFRA;
 	priv->flags = NM_802_11_AP_FLAGS_NONE;
@@ -1345,11 +1499,11 @@ finalize (GObject *object)
 
 	nm_assert (!self->wifi_device);
 	nm_assert (c_list_is_empty (&self->aps_lst));
+	nm_assert (!self->aps_idx);
 
 	g_free (priv->supplicant_path);
 	if (priv->ssid)
-		g_bytes_unref (priv->ssid);
-	g_free (priv->address);
+		_ssid_intern_unref (priv->ssid);
 
 	G_OBJECT_CLASS (nm_wifi_ap_parent_class)->finalize (object);
 }
@@ -1527,6 +1681,110 @@ nm_wifi_aps_find_by_supplicant_path (const CList *aps_lst_head, const char *path
 
 /*****************************************************************************/
 
+void
+nm_wifi_ap_index_init (NMWifiAPIndex *idx)
+{
+	idx->by_supplicant_path = g_hash_table_new (nm_str_hash, g_str_equal);
+	idx->by_ssid = g_hash_table_new_full (g_bytes_hash, g_bytes_equal, NULL, _ssid_bucket_free);
+	c_list_init (&idx->no_ssid_lst_head);
+}
+
+void
+nm_wifi_ap_index_clear (NMWifiAPIndex *idx)
+{
+	nm_assert (!idx->by_ssid || g_hash_table_size (idx->by_ssid) == 0);
+	nm_assert (c_list_is_empty (&idx->no_ssid_lst_head));
+
+	nm_clear_pointer (&idx->by_supplicant_path, g_hash_table_destroy);
+	nm_clear_pointer (&idx->by_ssid, g_hash_table_destroy);
+}
+
+/**
+ * nm_wifi_ap_index_add:
+ * @idx: the index
+ * @ap: the AP to add
+ *
+ * Adds @ap to @idx. The index follows later changes of the AP's SSID and
+ * supplicant path until the AP is removed again with
+ * nm_wifi_ap_index_remove(). It does not take a reference.
+ */
+void
+nm_wifi_ap_index_add (NMWifiAPIndex *idx, NMWifiAP *ap)
+{
+	NMWifiAPPrivate *priv;
+
+	g_return_if_fail (NM_IS_WIFI_AP (ap));
+	g_return_if_fail (!ap->aps_idx);
+
+	priv = NM_WIFI_AP_GET_PRIVATE (ap);
+
+	ap->aps_idx = idx;
+	if (priv->supplicant_path)
+		g_hash_table_insert (idx->by_supplicant_path, priv->supplicant_path, ap);
+	_aps_idx_ssid_link (ap);
+}
+
+void
+nm_wifi_ap_index_remove (NMWifiAPIndex *idx, NMWifiAP *ap)
+{
+	NMWifiAPPrivate *priv;
+
+	g_return_if_fail (NM_IS_WIFI_AP (ap));
+	g_return_if_fail (ap->aps_idx == idx);
+
+	priv = NM_WIFI_AP_GET_PRIVATE (ap);
+
+	if (   priv->supplicant_path
+	    && g_hash_table_lookup (idx->by_supplicant_path, priv->supplicant_path) == ap)
+		g_hash_table_remove (idx->by_supplicant_path, priv->supplicant_path);
+	_aps_idx_ssid_unlink (ap);
+	ap->aps_idx = NULL;
+}
+
+/* Same as nm_wifi_aps_find_first_compatible(), but only checks the APs
+ * with the connection's SSID. */
+NMWifiAP *
+nm_wifi_ap_index_find_first_compatible (const NMWifiAPIndex *idx,
+                                        NMConnection *connection)
+{
+	NMSettingWireless *s_wifi;
+	const CList *head;
+	SsidBucket *bucket;
+	GBytes *ssid;
+	NMWifiAP *ap;
+
+	g_return_val_if_fail (connection, NULL);
+
+	s_wifi = nm_connection_get_setting_wireless (connection);
+	if (!s_wifi)
+		return NULL;
+
+	ssid = nm_setting_wireless_get_ssid (s_wifi);
+	if (ssid) {
+		bucket = g_hash_table_lookup (idx->by_ssid, ssid);
+		if (!bucket)
+			return NULL;
+		head = &bucket->lst_head;
+	} else
+		head = &idx->no_ssid_lst_head;
+
+	c_list_for_each_entry (ap, head, aps_ssid_lst) {
+		if (nm_wifi_ap_check_compatible (ap, connection))
+			return ap;
+	}
+	return NULL;
+}
+
+NMWifiAP *
+nm_wifi_ap_index_find_by_supplicant_path (const NMWifiAPIndex *idx, const char *path)
+{
+	g_return_val_if_fail (path != NULL, NULL);
+
+	return g_hash_table_lookup (idx->by_supplicant_path, path);
+}
+
+/*****************************************************************************/
+
 NMWifiAP *
 nm_wifi_ap_lookup_for_device (NMDevice *device, const char *exported_path)
 {
@@ -44,10 +44,19 @@
 #define NM_WIFI_AP_STRENGTH             "strength"
 #define NM_WIFI_AP_LAST_SEEN            "last-seen"
 
+/* Lookup index over the APs of a device, see nm_wifi_ap_index_add(). */
+typedef struct {
+	GHashTable *by_supplicant_path;
+	GHashTable *by_ssid;
+	CList no_ssid_lst_head;
+} NMWifiAPIndex;
+
 typedef struct {
 	NMDBusObject parent;
 	NMDevice *wifi_device;
 	CList aps_lst;
+	NMWifiAPIndex *aps_idx;
+	CList aps_ssid_lst;
 	struct _NMWifiAPPrivate *_priv;
 } NMWifiAP;
 
@@ -110,6 +119,17 @@ NMWifiAP         *nm_wifi_aps_find_first_compatible (const CList *aps_lst_head,
 
 NMWifiAP         *nm_wifi_aps_find_by_supplicant_path (const CList *aps_lst_head, const char *path);
 
+void              nm_wifi_ap_index_init   (NMWifiAPIndex *idx);
+void              nm_wifi_ap_index_clear  (NMWifiAPIndex *idx);
+void              nm_wifi_ap_index_add    (NMWifiAPIndex *idx, NMWifiAP *ap);
+void              nm_wifi_ap_index_remove (NMWifiAPIndex *idx, NMWifiAP *ap);
+
+NMWifiAP         *nm_wifi_ap_index_find_first_compatible (const NMWifiAPIndex *idx,
+                                                          NMConnection *connection);
+
+NMWifiAP         *nm_wifi_ap_index_find_by_supplicant_path (const NMWifiAPIndex *idx,
+                                                            const char *path);
+
 NMWifiAP         *nm_wifi_ap_lookup_for_device (NMDevice *device, const char *exported_path);
 
 #endif /* __NM_WIFI_AP_H__ */
@@ -21,7 +21,11 @@
 #include "nm-default.h"
 
 #include <string.h>
+#if defined (__GLIBC__)
+#include <malloc.h>
+#endif
 
+#include "devices/wifi/nm-wifi-ap.h"
 #include "devices/wifi/nm-wifi-utils.h"
 
 #include "nm-core-internal.h"
@@ -1354,6 +1358,128 @@ test_strength_all (void)
 
 /*****************************************************************************/
 
+static NMWifiAP *
+_ap_new (const char *supplicant_path, const char *ssid, guint8 bssid_last)
+{
+	const guint8 bssid[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, bssid_last };
+	gs_unref_variant GVariant *properties = NULL;
+	GVariantBuilder builder;
+	NMWifiAP *ap;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&builder, "{sv}", "BSSID",
+	                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, bssid, sizeof (bssid), 1));
+	if (ssid) {
+		g_variant_builder_add (&builder, "{sv}", "SSID",
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, ssid, strlen (ssid), 1));
+	}
+
+	properties = g_variant_ref_sink (g_variant_builder_end (&builder));
+	ap = nm_wifi_ap_new_from_properties (supplicant_path, properties);
+	g_assert (ap);
+	return ap;
+}
+
+static void
+test_ap_index (void)
+{
+	gs_unref_object NMWifiAP *ap1 = NULL;
+	gs_unref_object NMWifiAP *ap2 = NULL;
+	gs_unref_object NMWifiAP *ap3 = NULL;
+	gs_unref_object NMConnection *con_a = NULL;
+	gs_unref_object NMConnection *con_b = NULL;
+	gs_unref_bytes GBytes *ssid_b = NULL;
+	NMWifiAPIndex idx;
+
+	nm_wifi_ap_index_init (&idx);
+
+	ap1 = _ap_new ("/bss/1", "net-a", 1);
+	ap2 = _ap_new ("/bss/2", "net-a", 2);
+	ap3 = _ap_new ("/bss/3", NULL, 3);
+	nm_wifi_ap_index_add (&idx, ap1);
+	nm_wifi_ap_index_add (&idx, ap2);
+	nm_wifi_ap_index_add (&idx, ap3);
+
+	con_a = create_basic ("net-a", NULL, NM_802_11_MODE_INFRA);
+	con_b = create_basic ("net-b", NULL, NM_802_11_MODE_INFRA);
+
+	g_assert (nm_wifi_ap_index_find_by_supplicant_path (&idx, "/bss/1") == ap1);
+	g_assert (nm_wifi_ap_index_find_by_supplicant_path (&idx, "/bss/3") == ap3);
+	g_assert (!nm_wifi_ap_index_find_by_supplicant_path (&idx, "/bss/4"));
+
+	g_assert (nm_wifi_ap_index_find_first_compatible (&idx, con_a) == ap1);
+	g_assert (!nm_wifi_ap_index_find_first_compatible (&idx, con_b));
+
+	/* the index follows SSID changes of indexed APs. */
+	ssid_b = g_bytes_new_static ("net-b", 5);
+	nm_wifi_ap_set_ssid (ap3, ssid_b);
+	g_assert (nm_wifi_ap_index_find_first_compatible (&idx, con_b) == ap3);
+	nm_wifi_ap_set_ssid (ap1, ssid_b);
+	g_assert (nm_wifi_ap_index_find_first_compatible (&idx, con_a) == ap2);
+
+	nm_wifi_ap_index_remove (&idx, ap2);
+	g_assert (!nm_wifi_ap_index_find_first_compatible (&idx, con_a));
+	g_assert (!nm_wifi_ap_index_find_by_supplicant_path (&idx, "/bss/2"));
+
+	nm_wifi_ap_index_remove (&idx, ap1);
+	nm_wifi_ap_index_remove (&idx, ap3);
+	nm_wifi_ap_index_clear (&idx);
+}
+
+static gsize
+_heap_in_use (void)
+{
+#if defined (__GLIBC__)
+	struct mallinfo mi;
+
+	G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+	mi = mallinfo ();
+	G_GNUC_END_IGNORE_DEPRECATIONS
+	return (gsize) (guint) mi.uordblks + (gsize) (guint) mi.hblkhd;
+#else
+	return 0;
+#endif
+}
+
+static void
+test_ap_memory (void)
+{
+	const guint n_aps = 512;
+	const guint n_ssids = 16;
+	NMWifiAP **aps;
+	gsize before, after;
+	guint i;
+
+	aps = g_new0 (NMWifiAP *, n_aps);
+
+	before = _heap_in_use ();
+	for (i = 0; i < n_aps; i++) {
+		char path[64];
+		char ssid[32];
+
+		nm_sprintf_buf (path, "/bss/%u", i);
+		nm_sprintf_buf (ssid, "network-%u", i % n_ssids);
+		aps[i] = _ap_new (path, ssid, i % 256);
+	}
+	after = _heap_in_use ();
+
+	/* APs of the same network share the SSID. */
+	for (i = n_ssids; i < n_aps; i++)
+		g_assert (nm_wifi_ap_get_ssid (aps[i]) == nm_wifi_ap_get_ssid (aps[i % n_ssids]));
+	g_assert (nm_wifi_ap_get_ssid (aps[0]) != nm_wifi_ap_get_ssid (aps[1]));
+
+	if (before && after > before) {
+		g_test_message ("%u APs with %u SSIDs: %" G_GSIZE_FORMAT " bytes per AP",
+		                n_aps, n_ssids, (after - before) / n_aps);
+	}
+
+	for (i = 0; i < n_aps; i++)
+		g_object_unref (aps[i]);
+	g_free (aps);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -1518,5 +1644,10 @@ main (int argc, char **argv)
 	g_test_add_func ("/wifi/strength/all",
 	                 test_strength_all);
 
+	g_test_add_func ("/wifi/ap-index",
+	                 test_ap_index);
+	g_test_add_func ("/wifi/ap-memory",
+	                 test_ap_memory);
+
 	return g_test_run ();
 }
@@ -365,6 +365,21 @@ nm_dhcp_client_stop_pid (pid_t pid, const char *iface)
 	g_free (name);
 }
 
+static void
+pid_set (NMDhcpClient *self, pid_t pid)
+{
+	NMDhcpClientPrivate *priv = NM_DHCP_CLIENT_GET_PRIVATE (self);
+	NMDhcpClientClass *klass = NM_DHCP_CLIENT_GET_CLASS (self);
+	pid_t old_pid = priv->pid;
+
+	if (old_pid == pid)
+		return;
+
+	priv->pid = pid;
+	if (klass->pid_changed)
+		klass->pid_changed (self, old_pid, pid);
+}
+
 static void
 stop (NMDhcpClient *self, gboolean release)
 {
@@ -379,7 +394,7 @@ stop (NMDhcpClient *self, gboolean release)
 		watch_cleanup (self);
 		nm_dhcp_client_stop_pid (priv->pid, priv->iface);
 	}
-	priv->pid = -1;
+	pid_set (self, -1);
 }
 
 void
@@ -468,7 +483,7 @@ daemon_watch_cb (GPid pid, int status, gpointer user_data)
 	else
 		_LOGW ("client died abnormally");
 
-	priv->pid = -1;
+	pid_set (self, -1);
 
 	nm_dhcp_client_set_state (self, NM_DHCP_STATE_TERMINATED, NULL, NULL);
 }
@@ -495,7 +510,7 @@ nm_dhcp_client_watch_child (NMDhcpClient *self, pid_t pid)
 	NMDhcpClientPrivate *priv = NM_DHCP_CLIENT_GET_PRIVATE (self);
 
 	g_return_if_fail (priv->pid == -1);
-	priv->pid = pid;
+	pid_set (self, pid);
 
 	nm_dhcp_client_start_timeout (self);
 
@@ -655,121 +670,33 @@ nm_dhcp_client_stop (NMDhcpClient *self, gboolean release)
 
 /*****************************************************************************/
 
-static char *
-bytearray_variant_to_string (NMDhcpClient *self, GVariant *value, const char *key)
-{
-	const guint8 *array;
-	gsize length;
-	GString *str;
-	int i;
-	unsigned char c;
-	char *converted = NULL;
-
-	g_return_val_if_fail (value != NULL, NULL);
-
-	array = g_variant_get_fixed_array (value, &length, 1);
-
-	/* Since the DHCP options come through environment variables, they should
-	 * already be UTF-8 safe, but just make sure.
-	 */
-	str = g_string_sized_new (length);
-	for (i = 0; i < length; i++) {
-		c = array[i];
-
-		/* Convert NULLs to spaces and non-ASCII characters to ? */
-		if (c == '\0')
-			c = ' ';
-		else if (c > 127)
-			c = '?';
-		str = g_string_append_c (str, c);
-	}
-	str = g_string_append_c (str, '\0');
-
-	converted = str->str;
-	if (!g_utf8_validate (converted, -1, NULL))
-		_LOGW ("option '%s' couldn't be converted to UTF-8", key);
-	g_string_free (str, FALSE);
-	return converted;
-}
-
-#define OLD_TAG "old_"
-#define NEW_TAG "new_"
-
-static void
-maybe_add_option (NMDhcpClient *self,
-                  GHashTable *hash,
-                  const char *key,
-                  GVariant *value)
-{
-	char *str_value = NULL;
-
-	g_return_if_fail (g_variant_is_of_type (value, G_VARIANT_TYPE_BYTESTRING));
-
-	if (g_str_has_prefix (key, OLD_TAG))
-		return;
-
-	/* Filter out stuff that's not actually new DHCP options */
-	if (NM_IN_STRSET (key, "interface",
-	                       "pid",
-	                       "reason",
-	                       "dhcp_message_type"))
-		return;
-
-	if (g_str_has_prefix (key, NEW_TAG))
-		key += NM_STRLEN (NEW_TAG);
-	if (!key[0])
-		return;
-
-	str_value = bytearray_variant_to_string (self, value, key);
-	if (str_value)
-		g_hash_table_insert (hash, g_strdup (key), str_value);
-}
-
-gboolean
-nm_dhcp_client_handle_event (gpointer unused,
-                             const char *iface,
-                             int pid,
-                             GVariant *options,
-                             const char *reason,
-                             NMDhcpClient *self)
+void
+nm_dhcp_client_handle_event (NMDhcpClient *self,
+                             const NMDhcpEvent *event)
 {
 	NMDhcpClientPrivate *priv;
 	guint32 old_state;
 	guint32 new_state;
-	gs_unref_hashtable GHashTable *str_options = NULL;
+	GHashTable *str_options = NULL;
 	gs_unref_object NMIPConfig *ip_config = NULL;
 	NMPlatformIP6Address prefix = { 0, };
 
-	g_return_val_if_fail (NM_IS_DHCP_CLIENT (self), FALSE);
-	g_return_val_if_fail (iface != NULL, FALSE);
-	g_return_val_if_fail (pid > 0, FALSE);
-	g_return_val_if_fail (g_variant_is_of_type (options, G_VARIANT_TYPE_VARDICT), FALSE);
-	g_return_val_if_fail (reason != NULL, FALSE);
+	g_return_if_fail (NM_IS_DHCP_CLIENT (self));
+	g_return_if_fail (event);
+	g_return_if_fail (event->reason);
+	g_return_if_fail (event->options);
 
 	priv = NM_DHCP_CLIENT_GET_PRIVATE (self);
 
-	if (g_strcmp0 (priv->iface, iface) != 0)
-		return FALSE;
-	if (priv->pid != pid)
-		return FALSE;
+	nm_assert (nm_streq0 (priv->iface, event->iface));
 
 	old_state = priv->state;
-	new_state = reason_to_state (self, priv->iface, reason);
+	new_state = reason_to_state (self, priv->iface, event->reason);
 	_LOGD ("DHCP state '%s' -> '%s' (reason: '%s')",
-	       state_to_string (old_state), state_to_string (new_state), reason);
+	       state_to_string (old_state), state_to_string (new_state), event->reason);
 
 	if (new_state == NM_DHCP_STATE_BOUND) {
-		GVariantIter iter;
-		const char *name;
-		GVariant *value;
-
-		/* Copy options */
-		str_options = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, g_free);
-		g_variant_iter_init (&iter, options);
-		while (g_variant_iter_next (&iter, "{&sv}", &name, &value)) {
-			maybe_add_option (self, str_options, name, value);
-			g_variant_unref (value);
-		}
+		str_options = event->options;
 
 		if (nm_logging_enabled (LOGL_DEBUG, LOGD_DHCP6)) {
 			GHashTableIter hash_iter;
@@ -814,13 +741,11 @@ nm_dhcp_client_handle_event (gpointer unused,
 		    && !ip_config) {
 			_LOGW ("client bound but IP config not received");
 			new_state = NM_DHCP_STATE_FAIL;
-			g_clear_pointer (&str_options, g_hash_table_unref);
+			str_options = NULL;
 		}
 
 		nm_dhcp_client_set_state (self, new_state, ip_config, str_options);
 	}
-
-	return TRUE;
 }
 
 /*****************************************************************************/
@@ -93,6 +93,12 @@ typedef struct {
 	void (*stop)              (NMDhcpClient *self,
 	                           gboolean release);
 
+	/* Called when the DHCP client process is started or goes away. The
+	 * PID is -1 when there is no process. */
+	void (*pid_changed)       (NMDhcpClient *self,
+	                           pid_t old_pid,
+	                           pid_t new_pid);
+
 	/**
 	 * get_duid:
 	 * @self: the #NMDhcpClient
@@ -172,12 +178,18 @@ void nm_dhcp_client_set_state (NMDhcpClient *self,
                                NMIPConfig *ip_config,
                                GHashTable *options); /* str:str hash */
 
-gboolean nm_dhcp_client_handle_event (gpointer unused,
-                                      const char *iface,
-                                      int pid,
-                                      GVariant *options,
-                                      const char *reason,
-                                      NMDhcpClient *self);
+/* An event reported by the DHCP helper, as decoded by NMDhcpListener.
+ * @options maps the lease options (with the "new_" prefix stripped) to
+ * their string values. */
+typedef struct {
+	const char *iface;
+	const char *reason;
+	GHashTable *options;
+	int pid;
+} NMDhcpEvent;
+
+void nm_dhcp_client_handle_event (NMDhcpClient *self,
+                                  const NMDhcpEvent *event);
 
 void nm_dhcp_client_set_client_id (NMDhcpClient *self,
                                    GBytes *client_id);
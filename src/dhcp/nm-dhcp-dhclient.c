@@ -662,6 +662,21 @@ get_duid (NMDhcpClient *client)
 	return duid;
 }
 
+static void
+pid_changed (NMDhcpClient *client, pid_t old_pid, pid_t new_pid)
+{
+	NMDhcpDhclientPrivate *priv = NM_DHCP_DHCLIENT_GET_PRIVATE ((NMDhcpDhclient *) client);
+	const char *iface = nm_dhcp_client_get_iface (client);
+
+	if (!priv->dhcp_listener)
+		return;
+
+	if (old_pid > 0)
+		nm_dhcp_listener_unregister (priv->dhcp_listener, client, iface, old_pid);
+	if (new_pid > 0)
+		nm_dhcp_listener_register (priv->dhcp_listener, client, iface, new_pid);
+}
+
 /*****************************************************************************/
 
 static void
@@ -683,22 +698,22 @@ nm_dhcp_dhclient_init (NMDhcpDhclient *self)
 		}
 	}
 
+	/* make sure the helper's socket exists before the first client is spawned */
 	priv->dhcp_listener = g_object_ref (nm_dhcp_listener_get ());
-	g_signal_connect (priv->dhcp_listener,
-	                  NM_DHCP_LISTENER_EVENT,
-	                  G_CALLBACK (nm_dhcp_client_handle_event),
-	                  self);
 }
 
 static void
 dispose (GObject *object)
 {
+	NMDhcpClient *client = NM_DHCP_CLIENT (object);
 	NMDhcpDhclientPrivate *priv = NM_DHCP_DHCLIENT_GET_PRIVATE ((NMDhcpDhclient *) object);
+	pid_t pid;
 
 	if (priv->dhcp_listener) {
-		g_signal_handlers_disconnect_by_func (priv->dhcp_listener,
-		                                      G_CALLBACK (nm_dhcp_client_handle_event),
-		                                      NM_DHCP_DHCLIENT (object));
+		/* the process may outlive us, but its events must not reach us anymore */
+		pid = nm_dhcp_client_get_pid (client);
+		if (pid > 0)
+			nm_dhcp_listener_unregister (priv->dhcp_listener, client, nm_dhcp_client_get_iface (client), pid);
 		g_clear_object (&priv->dhcp_listener);
 	}
 
@@ -720,6 +735,7 @@ nm_dhcp_dhclient_class_init (NMDhcpDhclientClass *dhclient_class)
 	client_class->ip4_start = ip4_start;
 	client_class->ip6_start = ip6_start;
 	client_class->stop = stop;
+	client_class->pid_changed = pid_changed;
 	client_class->get_duid = get_duid;
 }
 
@@ -216,6 +216,21 @@ stop (NMDhcpClient *client, gboolean release)
 	}
 }
 
+static void
+pid_changed (NMDhcpClient *client, pid_t old_pid, pid_t new_pid)
+{
+	NMDhcpDhcpcanonPrivate *priv = NM_DHCP_DHCPCANON_GET_PRIVATE ((NMDhcpDhcpcanon *) client);
+	const char *iface = nm_dhcp_client_get_iface (client);
+
+	if (!priv->dhcp_listener)
+		return;
+
+	if (old_pid > 0)
+		nm_dhcp_listener_unregister (priv->dhcp_listener, client, iface, old_pid);
+	if (new_pid > 0)
+		nm_dhcp_listener_register (priv->dhcp_listener, client, iface, new_pid);
+}
+
 /*****************************************************************************/
 
 static void
@@ -223,22 +238,22 @@ nm_dhcp_dhcpcanon_init (NMDhcpDhcpcanon *self)
 {
 	NMDhcpDhcpcanonPrivate *priv = NM_DHCP_DHCPCANON_GET_PRIVATE (self);
 
+	/* make sure the helper's socket exists before the first client is spawned */
 	priv->dhcp_listener = g_object_ref (nm_dhcp_listener_get ());
-	g_signal_connect (priv->dhcp_listener,
-	                  NM_DHCP_LISTENER_EVENT,
-	                  G_CALLBACK (nm_dhcp_client_handle_event),
-	                  self);
 }
 
 static void
 dispose (GObject *object)
 {
+	NMDhcpClient *client = NM_DHCP_CLIENT (object);
 	NMDhcpDhcpcanonPrivate *priv = NM_DHCP_DHCPCANON_GET_PRIVATE ((NMDhcpDhcpcanon *) object);
+	pid_t pid;
 
 	if (priv->dhcp_listener) {
-		g_signal_handlers_disconnect_by_func (priv->dhcp_listener,
-		                                      G_CALLBACK (nm_dhcp_client_handle_event),
-		                                      NM_DHCP_DHCPCANON (object));
+		/* the process may outlive us, but its events must not reach us anymore */
+		pid = nm_dhcp_client_get_pid (client);
+		if (pid > 0)
+			nm_dhcp_listener_unregister (priv->dhcp_listener, client, nm_dhcp_client_get_iface (client), pid);
 		g_clear_object (&priv->dhcp_listener);
 	}
 
@@ -258,6 +273,7 @@ nm_dhcp_dhcpcanon_class_init (NMDhcpDhcpcanonClass *dhcpcanon_class)
 	client_class->ip4_start = ip4_start;
 	client_class->ip6_start = ip6_start;
 	client_class->stop = stop;
+	client_class->pid_changed = pid_changed;
 }
 
 const NMDhcpClientFactory _nm_dhcp_client_factory_dhcpcanon = {
@@ -64,6 +64,8 @@ typedef struct {
 	gulong              new_conn_id;
 	gulong              dis_conn_id;
 	GHashTable *        connections;
+	GHashTable *        clients;
+	bool                private_server:1;
 } NMDhcpListenerPrivate;
 
 struct _NMDhcpListener {
@@ -75,11 +77,9 @@ struct _NMDhcpListenerClass {
 	GObjectClass parent;
 };
 
-enum {
-	EVENT,
-	LAST_SIGNAL
-};
-static guint signals[LAST_SIGNAL] = { 0 };
+NM_GOBJECT_PROPERTIES_DEFINE_BASE (
+	PROP_PRIVATE_SERVER,
+);
 
 G_DEFINE_TYPE (NMDhcpListener, nm_dhcp_listener, G_TYPE_OBJECT)
 
@@ -106,17 +106,112 @@ NM_DEFINE_SINGLETON_GETTER (NMDhcpListener, nm_dhcp_listener_get, NM_TYPE_DHCP_L
 
 /*****************************************************************************/
 
+typedef struct {
+	char *iface;
+	int pid;
+	NMDhcpClient *client;
+} ClientRegistration;
+
+static guint
+_client_registration_hash (gconstpointer ptr)
+{
+	const ClientRegistration *reg = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 1873032089u);
+	nm_hash_update_val (&h, reg->pid);
+	nm_hash_update_str (&h, reg->iface);
+	return nm_hash_complete (&h);
+}
+
+static gboolean
+_client_registration_equal (gconstpointer a, gconstpointer b)
+{
+	const ClientRegistration *reg_a = a;
+	const ClientRegistration *reg_b = b;
+
+	return    reg_a->pid == reg_b->pid
+	       && nm_streq (reg_a->iface, reg_b->iface);
+}
+
+static void
+_client_registration_free (gpointer ptr)
+{
+	ClientRegistration *reg = ptr;
+
+	g_free (reg->iface);
+	g_slice_free (ClientRegistration, reg);
+}
+
+/**
+ * nm_dhcp_listener_register:
+ * @self: the #NMDhcpListener
+ * @client: the #NMDhcpClient that spawned the DHCP client process
+ * @iface: the interface name the process runs on
+ * @pid: the process id of the DHCP client
+ *
+ * Events that the helper reports for @iface and @pid are passed to
+ * nm_dhcp_client_handle_event() of @client, until the client unregisters
+ * with nm_dhcp_listener_unregister(). The listener does not take a
+ * reference on @client.
+ */
+void
+nm_dhcp_listener_register (NMDhcpListener *self,
+                           NMDhcpClient *client,
+                           const char *iface,
+                           int pid)
+{
+	NMDhcpListenerPrivate *priv;
+	ClientRegistration *reg;
+
+	g_return_if_fail (NM_IS_DHCP_LISTENER (self));
+	g_return_if_fail (NM_IS_DHCP_CLIENT (client));
+	g_return_if_fail (iface);
+	g_return_if_fail (pid > 0);
+
+	priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+
+	reg = g_slice_new (ClientRegistration);
+	reg->iface = g_strdup (iface);
+	reg->pid = pid;
+	reg->client = client;
+
+	/* a stale entry can only be left if the PID got reused. Replace it. */
+	g_hash_table_add (priv->clients, reg);
+}
+
+void
+nm_dhcp_listener_unregister (NMDhcpListener *self,
+                             NMDhcpClient *client,
+                             const char *iface,
+                             int pid)
+{
+	NMDhcpListenerPrivate *priv;
+	ClientRegistration needle = {
+		.iface = (char *) iface,
+		.pid = pid,
+	};
+	ClientRegistration *reg;
+
+	g_return_if_fail (NM_IS_DHCP_LISTENER (self));
+	g_return_if_fail (iface);
+
+	priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+
+	reg = g_hash_table_lookup (priv->clients, &needle);
+	if (reg && reg->client == client)
+		g_hash_table_remove (priv->clients, reg);
+}
+
+/*****************************************************************************/
+
 static char *
-get_option (GVariant *options, const char *key)
+bytestring_to_str (GVariant *value)
 {
-	GVariant *value;
 	const guchar *bytes, *s;
 	gsize len;
 	char *converted, *d;
 
-	if (!g_variant_lookup (options, key, "@ay", &value))
-		return NULL;
-
 	bytes = g_variant_get_fixed_array (value, &len, 1);
 
 	/* Since the DHCP options come through environment variables, they should
@@ -133,51 +228,134 @@ get_option (GVariant *options, const char *key)
 			*d = *s;
 	}
 	*d = '\0';
-	g_variant_unref (value);
 
 	return converted;
 }
 
-static void
-_method_call_handle (NMDhcpListener *self,
-                     GVariant *parameters)
+#define OLD_TAG "old_"
+#define NEW_TAG "new_"
+
+/**
+ * nm_dhcp_listener_dispatch:
+ * @self: the #NMDhcpListener
+ * @options: the "a{sv}" dictionary sent by the DHCP helper
+ *
+ * Decodes @options and passes the event to the client registered
+ * for its interface and PID.
+ *
+ * Returns: whether a registered client handled the event.
+ */
+gboolean
+nm_dhcp_listener_dispatch (NMDhcpListener *self,
+                           GVariant *options)
 {
+	NMDhcpListenerPrivate *priv;
 	gs_free char *iface = NULL;
 	gs_free char *pid_str = NULL;
 	gs_free char *reason = NULL;
-	gs_unref_variant GVariant *options = NULL;
+	gs_unref_hashtable GHashTable *str_options = NULL;
+	gs_unref_object NMDhcpClient *client = NULL;
+	ClientRegistration needle;
+	ClientRegistration *reg;
+	NMDhcpEvent event;
+	GVariantIter iter;
+	const char *key;
+	GVariant *value;
 	int pid;
-	gboolean handled = FALSE;
 
-	g_variant_get (parameters, "(@a{sv})", &options);
+	g_return_val_if_fail (NM_IS_DHCP_LISTENER (self), FALSE);
+	g_return_val_if_fail (g_variant_is_of_type (options, G_VARIANT_TYPE_VARDICT), FALSE);
+
+	priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+
+	/* Decode all options in a single pass. The helper sends the
+	 * environment of the DHCP client, with the lease options next to
+	 * "interface", "pid" and "reason". */
+	str_options = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, g_free);
+	g_variant_iter_init (&iter, options);
+	while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+		char **target = NULL;
+
+		if (!g_variant_is_of_type (value, G_VARIANT_TYPE_BYTESTRING))
+			goto next;
+
+		if (nm_streq (key, "interface"))
+			target = &iface;
+		else if (nm_streq (key, "pid"))
+			target = &pid_str;
+		else if (nm_streq (key, "reason"))
+			target = &reason;
+		else if (   g_str_has_prefix (key, OLD_TAG)
+		         || nm_streq (key, "dhcp_message_type")) {
+			/* Filter out stuff that's not actually new DHCP options */
+			goto next;
+		}
+
+		if (target) {
+			g_free (*target);
+			*target = bytestring_to_str (value);
+		} else {
+			if (g_str_has_prefix (key, NEW_TAG))
+				key += NM_STRLEN (NEW_TAG);
+			if (key[0]) {
+				g_hash_table_insert (str_options,
+				                     g_strdup (key),
+				                     bytestring_to_str (value));
+			}
+		}
+next:
+		g_variant_unref (value);
+	}
 
-	iface = get_option (options, "interface");
 	if (iface == NULL) {
 		_LOGW ("dhcp-event: didn't have associated interface.");
-		return;
+		return FALSE;
 	}
 
-	pid_str = get_option (options, "pid");
 	pid = _nm_utils_ascii_str_to_int64 (pid_str, 10, 0, G_MAXINT32, -1);
 	if (pid == -1) {
 		_LOGW ("dhcp-event: couldn't convert PID '%s' to an integer", pid_str ?: "(null)");
-		return;
+		return FALSE;
 	}
 
-	reason = get_option (options, "reason");
 	if (reason == NULL) {
 		_LOGW ("dhcp-event: (pid %d) DHCP event didn't have a reason", pid);
-		return;
+		return FALSE;
 	}
 
-	g_signal_emit (self, signals[EVENT], 0, iface, pid, options, reason, &handled);
-	if (!handled) {
+	needle.iface = iface;
+	needle.pid = pid;
+	reg = g_hash_table_lookup (priv->clients, &needle);
+	if (!reg) {
 		if (g_ascii_strcasecmp (reason, "RELEASE") == 0) {
 			/* Ignore event when the dhcp client gets killed and we receive its last message */
 			_LOGD ("dhcp-event: (pid %d) unhandled RELEASE DHCP event for interface %s", pid, iface);
 		} else
 			_LOGW ("dhcp-event: (pid %d) unhandled DHCP event for interface %s", pid, iface);
+		return FALSE;
 	}
+
+	/* the client may unregister (or go away) while handling the event. */
+	client = g_object_ref (reg->client);
+
+	event = (NMDhcpEvent) {
+		.iface = iface,
+		.pid = pid,
+		.reason = reason,
+		.options = str_options,
+	};
+	nm_dhcp_client_handle_event (client, &event);
+	return TRUE;
+}
+
+static void
+_method_call_handle (NMDhcpListener *self,
+                     GVariant *parameters)
+{
+	gs_unref_variant GVariant *options = NULL;
+
+	g_variant_get (parameters, "(@a{sv})", &options);
+	nm_dhcp_listener_dispatch (self, options);
 }
 
 static void
@@ -276,14 +454,53 @@ dis_connection_cb (NMDBusManager *mgr,
 
 /*****************************************************************************/
 
+static void
+set_property (GObject *object, guint prop_id,
+              const GValue *value, GParamSpec *pspec)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE ((NMDhcpListener *) object);
+
+	switch (prop_id) {
+	case PROP_PRIVATE_SERVER:
+		/* construct-only */
+		priv->private_server = g_value_get_boolean (value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+/*****************************************************************************/
+
 static void
 nm_dhcp_listener_init (NMDhcpListener *self)
 {
 	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
 
+	priv->private_server = TRUE;
+
 	/* Maps GDBusConnection :: signal-id */
 	priv->connections = g_hash_table_new (nm_direct_hash, NULL);
 
+	/* Set of ClientRegistration, keyed by interface and PID */
+	priv->clients = g_hash_table_new_full (_client_registration_hash,
+	                                       _client_registration_equal,
+	                                       _client_registration_free,
+	                                       NULL);
+}
+
+static void
+constructed (GObject *object)
+{
+	NMDhcpListener *self = NM_DHCP_LISTENER (object);
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+
+	G_OBJECT_CLASS (nm_dhcp_listener_parent_class)->constructed (object);
+
+	if (!priv->private_server)
+		return;
+
 	priv->dbus_mgr = nm_dbus_manager_get ();
 
 	/* Register the socket our DHCP clients will return lease info on */
@@ -308,6 +525,7 @@ dispose (GObject *object)
 	priv->dbus_mgr = NULL;
 
 	g_clear_pointer (&priv->connections, g_hash_table_destroy);
+	g_clear_pointer (&priv->clients, g_hash_table_destroy);
 
 	G_OBJECT_CLASS (nm_dhcp_listener_parent_class)->dispose (object);
 }
@@ -317,18 +535,17 @@ nm_dhcp_listener_class_init (NMDhcpListenerClass *listener_class)
 {
 	GObjectClass *object_class = G_OBJECT_CLASS (listener_class);
 
+	object_class->constructed = constructed;
+	object_class->set_property = set_property;
 	object_class->dispose = dispose;
 
-	signals[EVENT] =
-	    g_signal_new (NM_DHCP_LISTENER_EVENT,
-	                  G_OBJECT_CLASS_TYPE (object_class),
-	                  G_SIGNAL_RUN_LAST, 0,
-	                  g_signal_accumulator_true_handled,
-	                  NULL, NULL,
-	                  G_TYPE_BOOLEAN,     /* listeners return TRUE if handled */
-	                  4,
-	                  G_TYPE_STRING,      /* iface */
-	                  G_TYPE_INT,         /* pid */
-	                  G_TYPE_VARIANT,     /* options */
-	                  G_TYPE_STRING);     /* reason */
+	/* tests create instances without the private socket */
+	obj_properties[PROP_PRIVATE_SERVER] =
+	    g_param_spec_boolean (NM_DHCP_LISTENER_PRIVATE_SERVER, "", "",
+	                          TRUE,
+	                          G_PARAM_WRITABLE |
+	                          G_PARAM_CONSTRUCT_ONLY |
+	                          G_PARAM_STATIC_STRINGS);
+
+	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
 }
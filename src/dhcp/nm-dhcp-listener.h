@@ -19,12 +19,14 @@
 #ifndef __NETWORKMANAGER_DHCP_LISTENER_H__
 #define __NETWORKMANAGER_DHCP_LISTENER_H__
 
+#include "nm-dhcp-client.h"
+
 #define NM_TYPE_DHCP_LISTENER           (nm_dhcp_listener_get_type ())
 #define NM_DHCP_LISTENER(obj)           (G_TYPE_CHECK_INSTANCE_CAST ((obj), NM_TYPE_DHCP_LISTENER, NMDhcpListener))
 #define NM_IS_DHCP_LISTENER(obj)        (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NM_TYPE_DHCP_LISTENER))
 #define NM_DHCP_LISTENER_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), NM_TYPE_DHCP_LISTENER, NMDhcpListenerClass))
 
-#define NM_DHCP_LISTENER_EVENT "event"
+#define NM_DHCP_LISTENER_PRIVATE_SERVER "private-server"
 
 typedef struct _NMDhcpListener NMDhcpListener;
 typedef struct _NMDhcpListenerClass NMDhcpListenerClass;
@@ -33,4 +35,16 @@ GType nm_dhcp_listener_get_type (void);
 
 NMDhcpListener *nm_dhcp_listener_get (void);
 
+void nm_dhcp_listener_register (NMDhcpListener *self,
+                                NMDhcpClient *client,
+                                const char *iface,
+                                int pid);
+void nm_dhcp_listener_unregister (NMDhcpListener *self,
+                                  NMDhcpClient *client,
+                                  const char *iface,
+                                  int pid);
+
+gboolean nm_dhcp_listener_dispatch (NMDhcpListener *self,
+                                    GVariant *options);
+
 #endif /* __NETWORKMANAGER_DHCP_LISTENER_H__ */
@@ -0,0 +1,229 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ */
+
+#include "nm-default.h"
+
+#include <string.h>
+
+#include "nm-utils/nm-dedup-multi.h"
+
+#include "dhcp/nm-dhcp-client.h"
+#include "dhcp/nm-dhcp-listener.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+typedef struct {
+	NMDhcpClient parent;
+	guint n_events;
+	NMDhcpState last_state;
+} TestDhcpClient;
+
+typedef struct {
+	NMDhcpClientClass parent;
+} TestDhcpClientClass;
+
+static GType test_dhcp_client_get_type (void);
+
+G_DEFINE_TYPE (TestDhcpClient, test_dhcp_client, NM_TYPE_DHCP_CLIENT)
+
+static void
+test_dhcp_client_init (TestDhcpClient *self)
+{
+}
+
+static void
+test_dhcp_client_class_init (TestDhcpClientClass *klass)
+{
+}
+
+static void
+_client_state_changed (NMDhcpClient *client,
+                       NMDhcpState state,
+                       GObject *ip_config,
+                       GHashTable *options,
+                       const char *event_id,
+                       TestDhcpClient *self)
+{
+	self->n_events++;
+	self->last_state = state;
+}
+
+static TestDhcpClient *
+_client_new (const char *iface)
+{
+	nm_auto_unref_dedup_multi_index NMDedupMultiIndex *multi_idx = nm_dedup_multi_index_new ();
+	TestDhcpClient *client;
+
+	client = g_object_new (test_dhcp_client_get_type (),
+	                       NM_DHCP_CLIENT_MULTI_IDX, multi_idx,
+	                       NM_DHCP_CLIENT_INTERFACE, iface,
+	                       NM_DHCP_CLIENT_ADDR_FAMILY, AF_INET,
+	                       NULL);
+	g_signal_connect (client, NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED,
+	                  G_CALLBACK (_client_state_changed), client);
+	return client;
+}
+
+static void
+_add_option (GVariantBuilder *builder, const char *key, const char *value)
+{
+	g_variant_builder_add (builder, "{sv}", key,
+	                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+	                                                  value, strlen (value), 1));
+}
+
+static gboolean
+_dispatch (NMDhcpListener *listener, const char *iface, const char *pid, const char *reason)
+{
+	GVariantBuilder builder;
+	gs_unref_variant GVariant *options = NULL;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	_add_option (&builder, "interface", iface);
+	_add_option (&builder, "pid", pid);
+	_add_option (&builder, "reason", reason);
+	_add_option (&builder, "new_ip_address", "192.168.1.10");
+	options = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+	return nm_dhcp_listener_dispatch (listener, options);
+}
+
+/*****************************************************************************/
+
+static void
+test_dispatch (void)
+{
+	gs_unref_object NMDhcpListener *listener = NULL;
+	gs_unref_object TestDhcpClient *client_a = NULL;
+	gs_unref_object TestDhcpClient *client_b = NULL;
+	gs_unref_object TestDhcpClient *client_c = NULL;
+
+	listener = g_object_new (NM_TYPE_DHCP_LISTENER,
+	                         NM_DHCP_LISTENER_PRIVATE_SERVER, FALSE,
+	                         NULL);
+
+	client_a = _client_new ("eth0");
+	client_b = _client_new ("eth1");
+	client_c = _client_new ("eth0");
+
+	nm_dhcp_listener_register (listener, NM_DHCP_CLIENT (client_a), "eth0", 100);
+	nm_dhcp_listener_register (listener, NM_DHCP_CLIENT (client_b), "eth1", 100);
+	nm_dhcp_listener_register (listener, NM_DHCP_CLIENT (client_c), "eth0", 200);
+
+	/* the interface and the PID select the client */
+	g_assert (_dispatch (listener, "eth1", "100", "EXPIRE"));
+	g_assert_cmpint (client_a->n_events, ==, 0);
+	g_assert_cmpint (client_b->n_events, ==, 1);
+	g_assert_cmpint (client_b->last_state, ==, NM_DHCP_STATE_EXPIRE);
+	g_assert_cmpint (client_c->n_events, ==, 0);
+
+	g_assert (_dispatch (listener, "eth0", "200", "FAIL"));
+	g_assert_cmpint (client_a->n_events, ==, 0);
+	g_assert_cmpint (client_b->n_events, ==, 1);
+	g_assert_cmpint (client_c->n_events, ==, 1);
+	g_assert_cmpint (client_c->last_state, ==, NM_DHCP_STATE_FAIL);
+
+	g_assert (_dispatch (listener, "eth0", "100", "EXPIRE"));
+	g_assert_cmpint (client_a->n_events, ==, 1);
+	g_assert_cmpint (client_a->last_state, ==, NM_DHCP_STATE_EXPIRE);
+
+	nm_dhcp_listener_unregister (listener, NM_DHCP_CLIENT (client_a), "eth0", 100);
+	nm_dhcp_listener_unregister (listener, NM_DHCP_CLIENT (client_b), "eth1", 100);
+	nm_dhcp_listener_unregister (listener, NM_DHCP_CLIENT (client_c), "eth0", 200);
+}
+
+static void
+test_stale_pid (void)
+{
+	gs_unref_object NMDhcpListener *listener = NULL;
+	gs_unref_object TestDhcpClient *client_a = NULL;
+	gs_unref_object TestDhcpClient *client_b = NULL;
+
+	listener = g_object_new (NM_TYPE_DHCP_LISTENER,
+	                         NM_DHCP_LISTENER_PRIVATE_SERVER, FALSE,
+	                         NULL);
+
+	client_a = _client_new ("eth0");
+	client_b = _client_new ("eth0");
+
+	/* the process of @client_a went away without unregistering, and
+	 * the PID got reused for @client_b. */
+	nm_dhcp_listener_register (listener, NM_DHCP_CLIENT (client_a), "eth0", 100);
+	nm_dhcp_listener_register (listener, NM_DHCP_CLIENT (client_b), "eth0", 100);
+
+	g_assert (_dispatch (listener, "eth0", "100", "EXPIRE"));
+	g_assert_cmpint (client_a->n_events, ==, 0);
+	g_assert_cmpint (client_b->n_events, ==, 1);
+
+	/* the late unregistration of @client_a must not drop @client_b. */
+	nm_dhcp_listener_unregister (listener, NM_DHCP_CLIENT (client_a), "eth0", 100);
+
+	g_assert (_dispatch (listener, "eth0", "100", "FAIL"));
+	g_assert_cmpint (client_a->n_events, ==, 0);
+	g_assert_cmpint (client_b->n_events, ==, 2);
+	g_assert_cmpint (client_b->last_state, ==, NM_DHCP_STATE_FAIL);
+
+	nm_dhcp_listener_unregister (listener, NM_DHCP_CLIENT (client_b), "eth0", 100);
+}
+
+static void
+test_unregistered (void)
+{
+	gs_unref_object NMDhcpListener *listener = NULL;
+	gs_unref_object TestDhcpClient *client = NULL;
+
+	listener = g_object_new (NM_TYPE_DHCP_LISTENER,
+	                         NM_DHCP_LISTENER_PRIVATE_SERVER, FALSE,
+	                         NULL);
+
+	client = _client_new ("eth0");
+	nm_dhcp_listener_register (listener, NM_DHCP_CLIENT (client), "eth0", 100);
+
+	/* unknown PID, and unknown interface */
+	NMTST_EXPECT_NM_WARN ("*unhandled DHCP event for interface eth0*");
+	g_assert (!_dispatch (listener, "eth0", "101", "EXPIRE"));
+	g_test_assert_expected_messages ();
+
+	NMTST_EXPECT_NM_WARN ("*unhandled DHCP event for interface eth1*");
+	g_assert (!_dispatch (listener, "eth1", "100", "EXPIRE"));
+	g_test_assert_expected_messages ();
+
+	/* after unregistering, the events of the process are dropped */
+	nm_dhcp_listener_unregister (listener, NM_DHCP_CLIENT (client), "eth0", 100);
+	g_assert (!_dispatch (listener, "eth0", "100", "RELEASE"));
+
+	g_assert_cmpint (client->n_events, ==, 0);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	g_test_add_func ("/dhcp/listener/dispatch", test_dispatch);
+	g_test_add_func ("/dhcp/listener/stale-pid", test_stale_pid);
+	g_test_add_func ("/dhcp/listener/unregistered", test_unregistered);
+
+	return g_test_run ();
+}
@@ -47,6 +47,7 @@
 #include "NetworkManagerUtils.h"
 #include "nm-config.h"
 #include "nm-dbus-object.h"
+#include "nm-latency.h"
 #include "devices/nm-device.h"
 #include "nm-manager.h"
 
@@ -83,6 +84,12 @@ typedef struct {
 	GPtrArray *options;
 	const char *nis_domain;
 	GPtrArray *nis_servers;
+
+	/* the strings in @nameservers, @searches and @nis_servers, to find
+	 * duplicates without scanning the arrays. */
+	GHashTable *nameservers_idx;
+	GHashTable *searches_idx;
+	GHashTable *nis_servers_idx;
 } NMResolvConfData;
 
 /*****************************************************************************/
@@ -120,6 +127,16 @@ typedef struct {
 	guint8 hash[HASH_LEN];  /* SHA1 hash of current DNS config */
 	guint8 prev_hash[HASH_LEN];  /* Hash when begin_updates() was called */
 
+	/* What was last sent to the plugins and written to resolv.conf. If
+	 * that didn't change, update_dns() doesn't touch them again. */
+	NMDnsOutputState plugin_output;
+	NMDnsOutputState resolv_conf_output;
+	bool plugin_caching:1;
+
+	/* the resolv.conf contents last written, to detect when the file
+	 * was modified by somebody else. */
+	char *resolv_conf_content;
+
 	NMDnsManagerResolvConfManager rc_manager;
 	char *mode;
 	NMDnsPlugin *sd_resolve_plugin;
@@ -173,9 +190,9 @@ NM_DEFINE_SINGLETON_GETTER (NMDnsManager, nm_dns_manager_get, NM_TYPE_DNS_MANAGE
 
 /*****************************************************************************/
 
-static void _ip_config_dns_priority_changed (gpointer config,
-                                             GParamSpec *pspec,
-                                             NMDnsIPConfigData *ip_data);
+static void _ip_config_notify (gpointer config,
+                               GParamSpec *pspec,
+                               NMDnsIPConfigData *ip_data);
 
 /*****************************************************************************/
 
@@ -253,14 +270,12 @@ _ip_config_data_new (NMDnsConfigData *data,
 	ip_data->data = data;
 	ip_data->ip_config = g_object_ref (ip_config);
 	ip_data->ip_config_type = ip_config_type;
+	ip_data->hash_dirty = TRUE;
 	c_list_link_tail (&data->data_lst_head, &ip_data->data_lst);
 	c_list_link_tail (&NM_DNS_MANAGER_GET_PRIVATE (data->self)->ip_config_lst_head, &ip_data->ip_config_lst);
 
-	g_signal_connect (ip_config,
-	                  NM_IS_IP4_CONFIG (ip_config)
-	                    ? "notify::" NM_IP4_CONFIG_DNS_PRIORITY
-	                    : "notify::" NM_IP6_CONFIG_DNS_PRIORITY,
-	                  (GCallback) _ip_config_dns_priority_changed, ip_data);
+	g_signal_connect (ip_config, "notify",
+	                  (GCallback) _ip_config_notify, ip_data);
 
 	_ASSERT_ip_config_data (ip_data);
 	return ip_data;
@@ -278,7 +293,7 @@ _ip_config_data_free (NMDnsIPConfigData *ip_data)
 	g_strfreev (ip_data->domains.reverse);
 
 	g_signal_handlers_disconnect_by_func (ip_data->ip_config,
-	                                      _ip_config_dns_priority_changed,
+	                                      _ip_config_notify,
 	                                      ip_data);
 
 	g_object_unref (ip_data->ip_config);
@@ -360,7 +375,7 @@ nm_dns_manager_has_systemd_resolved (NMDnsManager *self)
 /*****************************************************************************/
 
 static void
-add_string_item (GPtrArray *array, const char *str, gboolean dup)
+add_string_item (GPtrArray *array, GHashTable *idx, const char *str, gboolean dup)
 {
 	int i;
 
@@ -368,15 +383,24 @@ add_string_item (GPtrArray *array, const char *str, gboolean dup)
 	g_return_if_fail (str != NULL);
 
 	/* Check for dupes before adding */
-	for (i = 0; i < array->len; i++) {
-		const char *candidate = g_ptr_array_index (array, i);
-
-		if (candidate && !strcmp (candidate, str))
+	if (idx) {
+		if (g_hash_table_contains (idx, str))
 			return;
+	} else {
+		for (i = 0; i < array->len; i++) {
+			const char *candidate = g_ptr_array_index (array, i);
+
+			if (candidate && !strcmp (candidate, str))
+				return;
+		}
 	}
 
 	/* No dupes, add the new item */
-	g_ptr_array_add (array, dup ? g_strdup (str): (gpointer) str);
+	if (dup)
+		str = g_strdup (str);
+	g_ptr_array_add (array, (gpointer) str);
+	if (idx)
+		g_hash_table_add (idx, (gpointer) str);
 }
 
 static void
@@ -387,7 +411,7 @@ add_dns_option_item (GPtrArray *array, const char *str)
 }
 
 static void
-add_dns_domains (GPtrArray *array, const NMIPConfig *ip_config,
+add_dns_domains (GPtrArray *array, GHashTable *idx, const NMIPConfig *ip_config,
                  gboolean include_routing, gboolean dup)
 {
 	guint num_domains, num_searches, i;
@@ -402,7 +426,7 @@ add_dns_domains (GPtrArray *array, const NMIPConfig *ip_config,
 			continue;
 		if (!domain_is_valid (nm_utils_parse_dns_domain (str, NULL), FALSE))
 			continue;
-		add_string_item (array, str, dup);
+		add_string_item (array, idx, str, dup);
 	}
 	if (num_domains > 1 || !num_searches) {
 		for (i = 0; i < num_domains; i++) {
@@ -411,7 +435,7 @@ add_dns_domains (GPtrArray *array, const NMIPConfig *ip_config,
 				continue;
 			if (!domain_is_valid (nm_utils_parse_dns_domain (str, NULL), FALSE))
 				continue;
-			add_string_item (array, str, dup);
+			add_string_item (array, idx, str, dup);
 		}
 	}
 }
@@ -453,10 +477,10 @@ merge_one_ip_config (NMResolvConfData *rc,
 			}
 		}
 
-		add_string_item (rc->nameservers, buf, TRUE);
+		add_string_item (rc->nameservers, rc->nameservers_idx, buf, TRUE);
 	}
 
-	add_dns_domains (rc->searches, ip_config, FALSE, TRUE);
+	add_dns_domains (rc->searches, rc->searches_idx, ip_config, FALSE, TRUE);
 
 	num = nm_ip_config_get_num_dns_options (ip_config);
 	for (i = 0; i < num; i++) {
@@ -471,6 +495,7 @@ merge_one_ip_config (NMResolvConfData *rc,
 		num = nm_ip4_config_get_num_nis_servers (ip4_config);
 		for (i = 0; i < num; i++) {
 			add_string_item (rc->nis_servers,
+			                 rc->nis_servers_idx,
 			                 nm_utils_inet4_ntop (nm_ip4_config_get_nis_server (ip4_config, i), buf),
 			                 TRUE);
 		}
@@ -1028,6 +1053,267 @@ compute_hash (NMDnsManager *self, const NMGlobalDnsConfig *global, guint8 buffer
 	nm_utils_checksum_get_digest_len (sum, buffer, HASH_LEN);
 }
 
+static void
+_checksum_strv (GChecksum *sum, const char *const*strv)
+{
+	guint n = NM_PTRARRAY_LEN (strv);
+	guint i;
+
+	g_checksum_update (sum, (const guint8 *) &n, sizeof (n));
+	for (i = 0; i < n; i++)
+		g_checksum_update (sum, (const guint8 *) strv[i], strlen (strv[i]) + 1);
+}
+
+static char **
+get_ip_rdns_domains (NMIPConfig *ip_config)
+{
+	int addr_family = nm_ip_config_get_addr_family (ip_config);
+	char **strv;
+	GPtrArray *domains = NULL;
+	NMDedupMultiIter ipconf_iter;
+
+	nm_assert_addr_family (addr_family);
+
+	domains = g_ptr_array_sized_new (5);
+
+	if (addr_family == AF_INET) {
+		NMIP4Config *ip4 = (gpointer) ip_config;
+		const NMPlatformIP4Address *address;
+		const NMPlatformIP4Route *route;
+
+		nm_ip_config_iter_ip4_address_for_each (&ipconf_iter, ip4, &address)
+			nm_utils_get_reverse_dns_domains_ip4 (address->address, address->plen, domains);
+
+		nm_ip_config_iter_ip4_route_for_each (&ipconf_iter, ip4, &route) {
+			if (!NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route))
+				nm_utils_get_reverse_dns_domains_ip4 (route->network, route->plen, domains);
+		}
+	} else {
+		NMIP6Config *ip6 = (gpointer) ip_config;
+		const NMPlatformIP6Address *address;
+		const NMPlatformIP6Route *route;
+
+		nm_ip_config_iter_ip6_address_for_each (&ipconf_iter, ip6, &address)
+			nm_utils_get_reverse_dns_domains_ip6 (&address->address, address->plen, domains);
+
+		nm_ip_config_iter_ip6_route_for_each (&ipconf_iter, ip6, &route) {
+			if (!NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route))
+				nm_utils_get_reverse_dns_domains_ip6 (&route->network, route->plen, domains);
+		}
+	}
+
+	/* Terminating NULL so we can use g_strfreev() to free it */
+	g_ptr_array_add (domains, NULL);
+
+	/* Free the array and return NULL if the only element was the ending NULL */
+	strv = (char **) g_ptr_array_free (domains, (domains->len == 1));
+
+	return _nm_utils_strv_cleanup (strv, FALSE, FALSE, TRUE);
+}
+
+static void
+_checksum_str (GChecksum *sum, const char *str)
+{
+	g_checksum_update (sum, (const guint8 *) str, strlen (str) + 1);
+}
+
+/* Recompute the cached per-configuration data, if the configuration
+ * changed since the last time. Only the DNS parameters are hashed; the
+ * addresses and routes matter to the plugins only through the reverse
+ * domains and the default route, so those are hashed instead. */
+static void
+_ip_config_data_update (NMDnsIPConfigData *ip_data)
+{
+	NMIPConfig *ip_config = ip_data->ip_config;
+	nm_auto_free_checksum GChecksum *sum = NULL;
+	int addr_family;
+	guint i, n;
+	int v[3];
+
+	_ASSERT_ip_config_data (ip_data);
+
+	if (!ip_data->hash_dirty)
+		return;
+	ip_data->hash_dirty = FALSE;
+
+	addr_family = nm_ip_config_get_addr_family (ip_config);
+	ip_data->has_default_route = !!nm_ip_config_best_default_route_get (ip_config);
+	g_strfreev (ip_data->domains.reverse);
+	ip_data->domains.reverse = get_ip_rdns_domains (ip_config);
+
+	sum = g_checksum_new (G_CHECKSUM_SHA1);
+	nm_assert (sizeof (ip_data->hash) == g_checksum_type_get_length (G_CHECKSUM_SHA1));
+
+	v[0] = addr_family;
+	v[1] = nm_ip_config_get_dns_priority (ip_config);
+	v[2] = ip_data->has_default_route;
+	g_checksum_update (sum, (const guint8 *) v, sizeof (v));
+
+	n = nm_ip_config_get_num_nameservers (ip_config);
+	g_checksum_update (sum, (const guint8 *) &n, sizeof (n));
+	for (i = 0; i < n; i++) {
+		g_checksum_update (sum,
+		                   (const guint8 *) nm_ip_config_get_nameserver (ip_config, i),
+		                   nm_utils_addr_family_to_size (addr_family));
+	}
+
+	n = nm_ip_config_get_num_searches (ip_config);
+	g_checksum_update (sum, (const guint8 *) &n, sizeof (n));
+	for (i = 0; i < n; i++)
+		_checksum_str (sum, nm_ip_config_get_search (ip_config, i));
+
+	n = nm_ip_config_get_num_domains (ip_config);
+	g_checksum_update (sum, (const guint8 *) &n, sizeof (n));
+	for (i = 0; i < n; i++)
+		_checksum_str (sum, nm_ip_config_get_domain (ip_config, i));
+
+	n = nm_ip_config_get_num_dns_options (ip_config);
+	g_checksum_update (sum, (const guint8 *) &n, sizeof (n));
+	for (i = 0; i < n; i++)
+		_checksum_str (sum, nm_ip_config_get_dns_option (ip_config, i));
+
+	_checksum_strv (sum, NM_CAST_STRV_CC (ip_data->domains.reverse));
+
+	nm_utils_checksum_get_digest_len (sum, ip_data->hash, sizeof (ip_data->hash));
+}
+
+/* Unlike compute_hash(), this covers everything the plugins get to see:
+ * the order and type of the configurations, and their cached digests. */
+static void
+compute_plugin_hash (NMDnsManager *self,
+                     const NMGlobalDnsConfig *global,
+                     gboolean no_caching,
+                     guint8 buffer[HASH_LEN])
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	nm_auto_free_checksum GChecksum *sum = NULL;
+	NMDnsIPConfigData *ip_data;
+	const CList *head;
+	const char *hostname = priv->hostname ?: "";
+	guint8 flag = !!no_caching;
+
+	sum = g_checksum_new (G_CHECKSUM_SHA1);
+
+	g_checksum_update (sum, &flag, sizeof (flag));
+	g_checksum_update (sum, (const guint8 *) hostname, strlen (hostname) + 1);
+	if (global)
+		nm_global_dns_config_update_checksum (global, sum);
+
+	head = _ip_config_lst_head (self);
+	c_list_for_each_entry (ip_data, head, ip_config_lst) {
+		NMIP4Config *ip4 = NM_IS_IP4_CONFIG (ip_data->ip_config)
+		                   ? NM_IP4_CONFIG (ip_data->ip_config)
+		                   : NULL;
+		int v[4];
+
+		_ip_config_data_update (ip_data);
+
+		/* mDNS and LLMNR are set without notification, but they are
+		 * cheap to check each time. */
+		v[0] = ip_data->data->ifindex;
+		v[1] = ip_data->ip_config_type;
+		v[2] = ip4 ? (int) nm_ip4_config_mdns_get (ip4) : 0;
+		v[3] = ip4 ? (int) nm_ip4_config_llmnr_get (ip4) : 0;
+
+		g_checksum_update (sum, (const guint8 *) v, sizeof (v));
+		g_checksum_update (sum, ip_data->hash, sizeof (ip_data->hash));
+	}
+
+	nm_utils_checksum_get_digest_len (sum, buffer, HASH_LEN);
+}
+
+static void
+compute_resolv_conf_hash (NMDnsManager *self,
+                          gboolean update,
+                          gboolean caching,
+                          const char *const*searches,
+                          const char *const*nameservers,
+                          const char *const*options,
+                          const char *nis_domain,
+                          const char *const*nis_servers,
+                          guint8 buffer[HASH_LEN])
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	nm_auto_free_checksum GChecksum *sum = NULL;
+	const int v[] = {
+		priv->rc_manager,
+		!!update,
+		!!caching,
+	};
+
+	sum = g_checksum_new (G_CHECKSUM_SHA1);
+
+	g_checksum_update (sum, (const guint8 *) v, sizeof (v));
+	_checksum_strv (sum, searches);
+	_checksum_strv (sum, nameservers);
+	_checksum_strv (sum, options);
+	_checksum_strv (sum, nis_servers);
+	if (nis_domain)
+		g_checksum_update (sum, (const guint8 *) nis_domain, strlen (nis_domain));
+
+	nm_utils_checksum_get_digest_len (sum, buffer, HASH_LEN);
+}
+
+/**
+ * _nm_dns_output_state_begin:
+ * @state: the output state
+ * @hash: the digest of the input for the output
+ *
+ * Starts an update of the output. It must be followed by
+ * _nm_dns_output_state_complete().
+ *
+ * Returns: %TRUE if the input changed since the last successful update,
+ *   or if the output was invalidated in the meantime.
+ */
+gboolean
+_nm_dns_output_state_begin (NMDnsOutputState *state, const guint8 *hash)
+{
+	memcpy (state->pending_hash, hash, sizeof (state->pending_hash));
+	state->pending = TRUE;
+	return    !state->valid
+	       || memcmp (state->hash, hash, sizeof (state->hash)) != 0;
+}
+
+/**
+ * _nm_dns_output_state_complete:
+ * @state: the output state
+ * @success: whether the output was updated successfully
+ *
+ * Completes the update started by _nm_dns_output_state_begin(). The digest
+ * is only remembered if the update succeeded and the output was not
+ * invalidated in the meantime, for example by a plugin that failed
+ * while it was being updated.
+ */
+void
+_nm_dns_output_state_complete (NMDnsOutputState *state, gboolean success)
+{
+	if (!state->pending)
+		return;
+
+	state->pending = FALSE;
+	if (success) {
+		memcpy (state->hash, state->pending_hash, sizeof (state->hash));
+		state->valid = TRUE;
+	} else
+		state->valid = FALSE;
+}
+
+void
+_nm_dns_output_state_invalidate (NMDnsOutputState *state)
+{
+	state->valid = FALSE;
+	state->pending = FALSE;
+}
+
+static void
+_output_hash_clear (NMDnsManager *self)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+
+	_nm_dns_output_state_invalidate (&priv->plugin_output);
+	_nm_dns_output_state_invalidate (&priv->resolv_conf_output);
+}
+
 static gboolean
 merge_global_dns_config (NMResolvConfData *rc, NMGlobalDnsConfig *global_conf)
 {
@@ -1047,14 +1333,14 @@ merge_global_dns_config (NMResolvConfData *rc, NMGlobalDnsConfig *global_conf)
 				continue;
 			if (!domain_is_valid (searches[i], FALSE))
 				continue;
-			add_string_item (rc->searches, searches[i], TRUE);
+			add_string_item (rc->searches, rc->searches_idx, searches[i], TRUE);
 		}
 	}
 
 	options = nm_global_dns_config_get_options (global_conf);
 	if (options) {
 		for (i = 0; options[i]; i++)
-			add_string_item (rc->options, options[i], TRUE);
+			add_string_item (rc->options, NULL, options[i], TRUE);
 	}
 
 	default_domain = nm_global_dns_config_lookup_domain (global_conf, "*");
@@ -1063,7 +1349,7 @@ merge_global_dns_config (NMResolvConfData *rc, NMGlobalDnsConfig *global_conf)
 	servers = nm_global_dns_domain_get_servers (default_domain);
 	if (servers) {
 		for (i = 0; servers[i]; i++)
-			add_string_item (rc->nameservers, servers[i], TRUE);
+			add_string_item (rc->nameservers, rc->nameservers_idx, servers[i], TRUE);
 	}
 
 	return TRUE;
@@ -1119,6 +1405,9 @@ _collect_resolv_conf_data (NMDnsManager *self,
 		.options = g_ptr_array_new (),
 		.nis_domain = NULL,
 		.nis_servers = g_ptr_array_new (),
+		.nameservers_idx = g_hash_table_new (nm_str_hash, g_str_equal),
+		.searches_idx = g_hash_table_new (nm_str_hash, g_str_equal),
+		.nis_servers_idx = g_hash_table_new (nm_str_hash, g_str_equal),
 	};
 
 	priv = NM_DNS_MANAGER_GET_PRIVATE (self);
@@ -1176,12 +1465,16 @@ _collect_resolv_conf_data (NMDnsManager *self,
 		    && !nm_utils_ipaddr_valid (AF_UNSPEC, priv->hostname)) {
 			hostdomain++;
 			if (domain_is_valid (hostdomain, TRUE))
-				add_string_item (rc.searches, hostdomain, TRUE);
+				add_string_item (rc.searches, rc.searches_idx, hostdomain, TRUE);
 			else if (domain_is_valid (priv->hostname, TRUE))
-				add_string_item (rc.searches, priv->hostname, TRUE);
+				add_string_item (rc.searches, rc.searches_idx, priv->hostname, TRUE);
 		}
 	}
 
+	g_hash_table_unref (rc.nameservers_idx);
+	g_hash_table_unref (rc.searches_idx);
+	g_hash_table_unref (rc.nis_servers_idx);
+
 	*out_searches = _ptrarray_to_strv (rc.searches);
 	*out_options = _ptrarray_to_strv (rc.options);
 	*out_nameservers = _ptrarray_to_strv (rc.nameservers);
@@ -1189,53 +1482,6 @@ _collect_resolv_conf_data (NMDnsManager *self,
 	*out_nis_domain = rc.nis_domain;
 }
 
-static char **
-get_ip_rdns_domains (NMIPConfig *ip_config)
-{
-	int addr_family = nm_ip_config_get_addr_family (ip_config);
-	char **strv;
-	GPtrArray *domains = NULL;
-	NMDedupMultiIter ipconf_iter;
-
-	nm_assert_addr_family (addr_family);
-
-	domains = g_ptr_array_sized_new (5);
-
-	if (addr_family == AF_INET) {
-		NMIP4Config *ip4 = (gpointer) ip_config;
-		const NMPlatformIP4Address *address;
-		const NMPlatformIP4Route *route;
-
-		nm_ip_config_iter_ip4_address_for_each (&ipconf_iter, ip4, &address)
-			nm_utils_get_reverse_dns_domains_ip4 (address->address, address->plen, domains);
-
-		nm_ip_config_iter_ip4_route_for_each (&ipconf_iter, ip4, &route) {
-			if (!NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route))
-				nm_utils_get_reverse_dns_domains_ip4 (route->network, route->plen, domains);
-		}
-	} else {
-		NMIP6Config *ip6 = (gpointer) ip_config;
-		const NMPlatformIP6Address *address;
-		const NMPlatformIP6Route *route;
-
-		nm_ip_config_iter_ip6_address_for_each (&ipconf_iter, ip6, &address)
-			nm_utils_get_reverse_dns_domains_ip6 (&address->address, address->plen, domains);
-
-		nm_ip_config_iter_ip6_route_for_each (&ipconf_iter, ip6, &route) {
-			if (!NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route))
-				nm_utils_get_reverse_dns_domains_ip6 (&route->network, route->plen, domains);
-		}
-	}
-
-	/* Terminating NULL so we can use g_strfreev() to free it */
-	g_ptr_array_add (domains, NULL);
-
-	/* Free the array and return NULL if the only element was the ending NULL */
-	strv = (char **) g_ptr_array_free (domains, (domains->len == 1));
-
-	return _nm_utils_strv_cleanup (strv, FALSE, FALSE, TRUE);
-}
-
 /* Check if the domain is shadowed by a parent domain with more negative priority */
 static gboolean
 domain_is_shadowed (GHashTable *ht,
@@ -1281,14 +1527,10 @@ rebuild_domain_lists (NMDnsManager *self)
 
 	head = _ip_config_lst_head (self);
 	c_list_for_each_entry (ip_data, head, ip_config_lst) {
-		NMIPConfig *ip_config = ip_data->ip_config;
-
-		if (!nm_ip_config_get_num_nameservers (ip_config))
-			continue;
-		if (nm_ip_config_best_default_route_get (ip_config)) {
+		_ip_config_data_update (ip_data);
+		if (   ip_data->has_default_route
+		    && nm_ip_config_get_num_nameservers (ip_data->ip_config))
 			default_route_found = TRUE;
-			break;
-		}
 	}
 
 	c_list_for_each_entry (ip_data, head, ip_config_lst) {
@@ -1312,7 +1554,7 @@ rebuild_domain_lists (NMDnsManager *self)
 		 * If there is no default route, add the wildcard domain to all non-VPN
 		 * connections */
 		if (default_route_found) {
-			if (nm_ip_config_best_default_route_get (ip_config))
+			if (ip_data->has_default_route)
 				domains[n_domains++] = "~";
 		} else {
 			if (ip_data->ip_config_type != NM_DNS_IP_CONFIG_TYPE_VPN)
@@ -1361,9 +1603,6 @@ rebuild_domain_lists (NMDnsManager *self)
 			domains[n++] = domains[i];
 		}
 		domains[n] = NULL;
-
-		g_strfreev (ip_data->domains.reverse);
-		ip_data->domains.reverse = get_ip_rdns_domains (ip_config);
 	}
 }
 
@@ -1374,10 +1613,66 @@ clear_domain_lists (NMDnsManager *self)
 	CList *head;
 
 	head = _ip_config_lst_head (self);
-	c_list_for_each_entry (ip_data, head, ip_config_lst) {
+	c_list_for_each_entry (ip_data, head, ip_config_lst)
 		g_clear_pointer (&ip_data->domains.search, g_free);
-		g_clear_pointer (&ip_data->domains.reverse, g_strfreev);
+}
+
+static gboolean
+_resolv_conf_is_current_full (NMDnsManagerResolvConfManager rc_manager,
+                              const char *resconf_path,
+                              const char *my_resolv_conf_path,
+                              const char *content)
+{
+	gs_free char *resconf_link = NULL;
+	gs_free char *contents = NULL;
+	const char *path = my_resolv_conf_path;
+
+	if (!content)
+		return FALSE;
+
+	switch (rc_manager) {
+	case NM_DNS_MANAGER_RESOLV_CONF_MAN_FILE:
+		path = resconf_path;
+		break;
+	case NM_DNS_MANAGER_RESOLV_CONF_MAN_SYMLINK:
+		/* a symlink to somewhere else is left alone, in that case only
+		 * the internal file is written. */
+		resconf_link = g_file_read_link (resconf_path, NULL);
+		if (   !resconf_link
+		    || nm_streq (resconf_link, my_resolv_conf_path))
+			path = resconf_path;
+		break;
+	default:
+		break;
 	}
+
+	if (!g_file_get_contents (path, &contents, NULL, NULL))
+		return FALSE;
+	return nm_streq (contents, content);
+}
+
+gboolean
+nmtst_dns_resolv_conf_is_current (NMDnsManagerResolvConfManager rc_manager,
+                                  const char *resconf_path,
+                                  const char *my_resolv_conf_path,
+                                  const char *content)
+{
+	return _resolv_conf_is_current_full (rc_manager, resconf_path, my_resolv_conf_path, content);
+}
+
+/* Whether the file that was last written still has the expected contents.
+ * With rc-manager=file in particular, other tools might overwrite
+ * resolv.conf, and an update must repair that even if the configuration
+ * didn't change. */
+static gboolean
+_resolv_conf_is_current (NMDnsManager *self)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+
+	return _resolv_conf_is_current_full (priv->rc_manager,
+	                                     _PATH_RESCONF,
+	                                     MY_RESOLV_CONF,
+	                                     priv->resolv_conf_content);
 }
 
 static gboolean
@@ -1393,9 +1688,14 @@ update_dns (NMDnsManager *self,
 	gs_strfreev char **nis_servers = NULL;
 	gboolean caching = FALSE, update = TRUE;
 	gboolean resolv_conf_updated = FALSE;
+	gboolean plugin_success = FALSE;
+	gboolean success;
 	SpawnResult result = SR_ERROR;
 	NMConfigData *data;
 	NMGlobalDnsConfig *global_config;
+	guint8 plugin_hash[HASH_LEN];
+	guint8 resolv_conf_hash[HASH_LEN];
+	gint64 start_ns;
 
 	g_return_val_if_fail (!error || !*error, FALSE);
 
@@ -1406,6 +1706,8 @@ update_dns (NMDnsManager *self,
 		return TRUE;
 	}
 
+	start_ns = nm_latency_start ();
+
 	nm_clear_g_source (&priv->plugin_ratelimit.timer);
 
 	if (NM_IN_SET (priv->rc_manager, NM_DNS_MANAGER_RESOLV_CONF_MAN_UNMANAGED,
@@ -1427,14 +1729,24 @@ update_dns (NMDnsManager *self,
 	                           &searches, &options, &nameservers,
 	                           &nis_servers, &nis_domain);
 
-	if (priv->plugin || priv->sd_resolve_plugin)
+	if (priv->plugin || priv->sd_resolve_plugin) {
+		compute_plugin_hash (self, global_config, no_caching, plugin_hash);
+		if (!_nm_dns_output_state_begin (&priv->plugin_output, plugin_hash)) {
+			_LOGD ("update-dns: plugin configuration unchanged");
+			_nm_dns_output_state_complete (&priv->plugin_output, TRUE);
+			caching = priv->plugin_caching;
+			goto plugin_done;
+		}
+		plugin_success = TRUE;
 		rebuild_domain_lists (self);
+	}
 
 	if (priv->sd_resolve_plugin) {
-		nm_dns_plugin_update (priv->sd_resolve_plugin,
-		                      global_config,
-		                      _ip_config_lst_head (self),
-		                      priv->hostname);
+		if (!nm_dns_plugin_update (priv->sd_resolve_plugin,
+		                           global_config,
+		                           _ip_config_lst_head (self),
+		                           priv->hostname))
+			plugin_success = FALSE;
 	}
 
 	/* Let any plugins do their thing first */
@@ -1446,6 +1758,7 @@ update_dns (NMDnsManager *self,
 			if (no_caching) {
 				_LOGD ("update-dns: plugin %s ignored (caching disabled)",
 				       plugin_name);
+				plugin_success = FALSE;
 				goto skip;
 			}
 			caching = TRUE;
@@ -1462,17 +1775,43 @@ update_dns (NMDnsManager *self,
 			 * caching DNS configuration to resolv.conf.
 			 */
 			caching = FALSE;
+			plugin_success = FALSE;
 		}
 
 	skip:
 		;
 	}
 
+	if (priv->plugin || priv->sd_resolve_plugin) {
+		_nm_dns_output_state_complete (&priv->plugin_output, plugin_success);
+		if (plugin_success)
+			priv->plugin_caching = caching;
+	}
+
 	/* Clear the generated search list as it points to
 	 * strings owned by IP configurations and we can't
-	 * guarantee they stay alive. */
+	 * guarantee they stay alive. The reverse domains are
+	 * owned by us and kept until the configuration changes. */
 	clear_domain_lists (self);
 
+plugin_done:
+	compute_resolv_conf_hash (self, update, caching,
+	                          NM_CAST_STRV_CC (searches),
+	                          NM_CAST_STRV_CC (nameservers),
+	                          NM_CAST_STRV_CC (options),
+	                          nis_domain,
+	                          NM_CAST_STRV_CC (nis_servers),
+	                          resolv_conf_hash);
+	if (!_nm_dns_output_state_begin (&priv->resolv_conf_output, resolv_conf_hash)) {
+		if (_resolv_conf_is_current (self)) {
+			_LOGD ("update-dns: resolv.conf unchanged");
+			_nm_dns_output_state_complete (&priv->resolv_conf_output, TRUE);
+			result = SR_SUCCESS;
+			goto out;
+		}
+		_LOGD ("update-dns: resolv.conf was modified externally, write it again");
+	}
+
 	update_resolv_conf_no_stub (self,
 	                            NM_CAST_STRV_CC (searches),
 	                            NM_CAST_STRV_CC (nameservers),
@@ -1550,13 +1889,24 @@ update_dns (NMDnsManager *self,
 		                    NM_DNS_MANAGER_RESOLV_CONF_MAN_UNMANAGED);
 	}
 
+	success = (!update || result == SR_SUCCESS);
+	_nm_dns_output_state_complete (&priv->resolv_conf_output, success);
+	g_free (priv->resolv_conf_content);
+	priv->resolv_conf_content =   success
+	                            ? create_resolv_conf (NM_CAST_STRV_CC (searches),
+	                                                  NM_CAST_STRV_CC (nameservers),
+	                                                  NM_CAST_STRV_CC (options))
+	                            : NULL;
+
 	/* signal that resolv.conf was changed */
 	if (update && result == SR_SUCCESS)
 		g_signal_emit (self, signals[CONFIG_CHANGED], 0);
 
+out:
 	g_clear_pointer (&priv->config_variant, g_variant_unref);
 	_notify (self, PROP_CONFIGURATION);
 
+	nm_latency_record (NM_LATENCY_DNS_UPDATE, start_ns);
 	return !update || result == SR_SUCCESS;
 }
 
@@ -1564,13 +1914,18 @@ static void
 plugin_failed (NMDnsPlugin *plugin, gpointer user_data)
 {
 	NMDnsManager *self = NM_DNS_MANAGER (user_data);
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 	GError *error = NULL;
 
-	/* Errors with non-caching plugins aren't fatal */
-	if (!nm_dns_plugin_is_caching (plugin))
+	/* Errors with non-caching plugins aren't fatal, but the plugin
+	 * must get the full configuration again with the next update. */
+	if (!nm_dns_plugin_is_caching (plugin)) {
+		_nm_dns_output_state_invalidate (&priv->plugin_output);
 		return;
+	}
 
 	/* Disable caching until the next DNS update */
+	_output_hash_clear (self);
 	if (!update_dns (self, TRUE, &error)) {
 		_LOGW ("could not commit DNS changes: %s", error->message);
 		g_clear_error (&error);
@@ -1584,6 +1939,7 @@ plugin_child_quit_update_dns (gpointer user_data)
 	NMDnsManager *self = NM_DNS_MANAGER (user_data);
 
 	/* Let the plugin try to spawn the child again */
+	_output_hash_clear (self);
 	if (!update_dns (self, FALSE, &error)) {
 		_LOGW ("could not commit DNS changes: %s", error->message);
 		g_clear_error (&error);
@@ -1601,6 +1957,10 @@ plugin_child_quit (NMDnsPlugin *plugin, int exit_status, gpointer user_data)
 
 	_LOGW ("plugin %s child quit unexpectedly", nm_dns_plugin_get_name (plugin));
 
+	/* the configuration is lost with the child. Even if the restart is
+	 * delayed, the next update must send it again. */
+	_nm_dns_output_state_invalidate (&priv->plugin_output);
+
 	if (   !priv->plugin_ratelimit.ts
 	    || (ts - priv->plugin_ratelimit.ts) / 1000 > PLUGIN_RATELIMIT_INTERVAL) {
 		priv->plugin_ratelimit.ts = ts;
@@ -1622,13 +1982,19 @@ plugin_child_quit (NMDnsPlugin *plugin, int exit_status, gpointer user_data)
 }
 
 static void
-_ip_config_dns_priority_changed (gpointer config,
-                                 GParamSpec *pspec,
-                                 NMDnsIPConfigData *ip_data)
+_ip_config_notify (gpointer config,
+                   GParamSpec *pspec,
+                   NMDnsIPConfigData *ip_data)
 {
 	_ASSERT_ip_config_data (ip_data);
 
-	NM_DNS_MANAGER_GET_PRIVATE (ip_data->data->self)->ip_config_lst_need_sort = TRUE;
+	ip_data->hash_dirty = TRUE;
+
+	if (nm_streq (pspec->name,
+	              NM_IS_IP4_CONFIG (config)
+	                ? NM_IP4_CONFIG_DNS_PRIORITY
+	                : NM_IP6_CONFIG_DNS_PRIORITY))
+		NM_DNS_MANAGER_GET_PRIVATE (ip_data->data->self)->ip_config_lst_need_sort = TRUE;
 }
 
 gboolean
@@ -1832,6 +2198,7 @@ nm_dns_manager_stop (NMDnsManager *self)
 	if (   priv->dns_touched
 	    && priv->plugin
 	    && NM_IS_DNS_DNSMASQ (priv->plugin)) {
+		_output_hash_clear (self);
 		if (!update_dns (self, TRUE, &error)) {
 			_LOGW ("could not commit DNS changes on shutdown: %s", error->message);
 			g_clear_error (&error);
@@ -2098,6 +2465,7 @@ again:
 	}
 
 	if (param_changed || plugin_changed || systemd_resolved_changed) {
+		_output_hash_clear (self);
 		_LOGI ("init: dns=%s%s rc-manager=%s%s%s%s",
 		       mode,
 		       (systemd_resolved ? ",systemd-resolved" : ""),
@@ -2138,6 +2506,9 @@ config_changed_cb (NMConfig *config,
 	                           NM_CONFIG_CHANGE_DNS_MODE |
 	                           NM_CONFIG_CHANGE_RC_MANAGER |
 	                           NM_CONFIG_CHANGE_GLOBAL_DNS_CONFIG)) {
+		/* a reload always rewrites resolv.conf and re-sends the
+		 * configuration to the plugins. */
+		_output_hash_clear (self);
 		if (!update_dns (self, FALSE, &error)) {
 			_LOGW ("could not commit DNS changes: %s", error->message);
 			g_clear_error (&error);
@@ -2258,7 +2629,7 @@ _get_config_variant (NMDnsManager *self)
 			else
 				g_ptr_array_set_size (array_domains, 0);
 
-			add_dns_domains (array_domains, ip_config, TRUE, FALSE);
+			add_dns_domains (array_domains, NULL, ip_config, TRUE, FALSE);
 			if (array_domains->len) {
 				g_variant_builder_init (&strv_builder, G_VARIANT_TYPE ("as"));
 				for (i = 0; i < array_domains->len; i++) {
@@ -2390,6 +2761,7 @@ finalize (GObject *object)
 
 	g_free (priv->hostname);
 	g_free (priv->mode);
+	g_free (priv->resolv_conf_content);
 
 	G_OBJECT_CLASS (nm_dns_manager_parent_class)->finalize (object);
 }
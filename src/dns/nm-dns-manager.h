@@ -54,6 +54,13 @@ typedef struct {
 		const char **search;
 		char **reverse;
 	} domains;
+
+	/* digest of the DNS parameters of @ip_config. Together with
+	 * @domains.reverse and @has_default_route, it is only recomputed
+	 * when @ip_config notifies a change. */
+	guint8 hash[20];
+	bool hash_dirty:1;
+	bool has_default_route:1;
 } NMDnsIPConfigData;
 
 typedef struct _NMDnsConfigData {
@@ -133,6 +140,27 @@ gboolean nm_dns_manager_has_systemd_resolved (NMDnsManager *self);
 
 /*****************************************************************************/
 
+/* What was last applied to an output of the DNS manager (the plugins,
+ * or resolv.conf), so that an update with unchanged input can be skipped.
+ * Exposed for tests. */
+typedef struct {
+	guint8 hash[NM_UTILS_CHECKSUM_LENGTH_SHA1];
+	guint8 pending_hash[NM_UTILS_CHECKSUM_LENGTH_SHA1];
+	bool valid:1;
+	bool pending:1;
+} NMDnsOutputState;
+
+gboolean _nm_dns_output_state_begin (NMDnsOutputState *state, const guint8 *hash);
+void _nm_dns_output_state_complete (NMDnsOutputState *state, gboolean success);
+void _nm_dns_output_state_invalidate (NMDnsOutputState *state);
+
+/*****************************************************************************/
+
+gboolean nmtst_dns_resolv_conf_is_current (NMDnsManagerResolvConfManager rc_manager,
+                                           const char *resconf_path,
+                                           const char *my_resolv_conf_path,
+                                           const char *content);
+
 char *nmtst_dns_create_resolv_conf (const char *const*searches,
                                     const char *const*nameservers,
                                     const char *const*options);
@@ -53,6 +53,7 @@
 #include "dns/nm-dns-manager.h"
 #include "systemd/nm-sd.h"
 #include "nm-netns.h"
+#include "nm-trace.h"
 
 #if !defined(NM_DIST_VERSION)
 # define NM_DIST_VERSION VERSION
@@ -358,6 +359,36 @@ main (int argc, char *argv[])
 		nm_logging_syslog_openlog (v, nm_config_get_is_debug (config));
 	}
 
+	if (nm_config_data_get_value_boolean (NM_CONFIG_GET_DATA_ORIG,
+	                                      NM_CONFIG_KEYFILE_GROUP_LOGGING,
+	                                      NM_CONFIG_KEYFILE_KEY_LOGGING_ASYNC,
+	                                      FALSE)) {
+		gs_free char *v = NULL;
+		gs_free_error GError *error = NULL;
+
+		v = nm_config_data_get_value (NM_CONFIG_GET_DATA_ORIG,
+		                              NM_CONFIG_KEYFILE_GROUP_LOGGING,
+		                              NM_CONFIG_KEYFILE_KEY_LOGGING_ASYNC_SYNC_LEVEL,
+		                              NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY);
+		if (!nm_logging_async_start (v, &error)) {
+			nm_log_warn (LOGD_CORE, "config: invalid logging async-sync-level: %s",
+			             error->message);
+			nm_logging_async_start (NULL, NULL);
+		}
+	}
+
+	{
+		gs_free char *v = NULL;
+		gs_free_error GError *error = NULL;
+
+		v = nm_config_data_get_value (NM_CONFIG_GET_DATA_ORIG,
+		                              NM_CONFIG_KEYFILE_GROUP_LOGGING,
+		                              NM_CONFIG_KEYFILE_KEY_LOGGING_TRACE_FILE,
+		                              NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY);
+		if (v && !nm_trace_setup (v, &error))
+			nm_log_warn (LOGD_CORE, "trace: %s", error->message);
+	}
+
 	nm_log_info (LOGD_CORE, "NetworkManager (version " NM_DIST_VERSION ") is starting... (%s)",
 	             nm_config_get_first_start (config) ? "for the first time" : "after a restart");
 
@@ -396,6 +427,21 @@ main (int argc, char *argv[])
 	/* Set up platform interaction layer */
 	nm_linux_platform_setup ();
 
+	{
+		gs_free char *v = NULL;
+
+		v = nm_config_data_get_value (NM_CONFIG_GET_DATA_ORIG,
+		                              NM_CONFIG_KEYFILE_GROUP_MAIN,
+		                              NM_CONFIG_KEYFILE_KEY_MAIN_ROUTE_GET,
+		                              NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY);
+		if (nm_streq0 (v, "cache"))
+			nm_platform_ip_route_get_set_mode (NM_PLATFORM_GET, NM_PLATFORM_ROUTE_GET_MODE_CACHE);
+		else if (nm_streq0 (v, "strict"))
+			nm_platform_ip_route_get_set_mode (NM_PLATFORM_GET, NM_PLATFORM_ROUTE_GET_MODE_STRICT);
+		else if (v && !nm_streq (v, "kernel"))
+			nm_log_warn (LOGD_CORE, "config: invalid route-get '%s', ask kernel", v);
+	}
+
 	NM_UTILS_KEEP_ALIVE (config, nm_netns_get (), "NMConfig-depends-on-NMNetns");
 
 	nm_auth_manager_setup (nm_config_data_get_value_boolean (nm_config_get_data_orig (config),
@@ -468,6 +514,8 @@ done_no_manager:
 
 	nm_log_info (LOGD_CORE, "exiting (%s)", success ? "success" : "error");
 
+	nm_logging_async_stop ();
+
 	nm_clear_g_source (&sd_id);
 
 	exit (success ? 0 : 1);
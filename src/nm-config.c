@@ -763,6 +763,7 @@ static const ConfigGroup config_groups[] = {
 			NM_CONFIG_KEYFILE_KEY_MAIN_NO_AUTO_DEFAULT,
 			NM_CONFIG_KEYFILE_KEY_MAIN_PLUGINS,
 			NM_CONFIG_KEYFILE_KEY_MAIN_RC_MANAGER,
+			NM_CONFIG_KEYFILE_KEY_MAIN_ROUTE_GET,
 			NM_CONFIG_KEYFILE_KEY_MAIN_SLAVES_ORDER,
 			NM_CONFIG_KEYFILE_KEY_MAIN_SYSTEMD_RESOLVED,
 		),
@@ -770,10 +771,13 @@ static const ConfigGroup config_groups[] = {
 	{
 		.group = NM_CONFIG_KEYFILE_GROUP_LOGGING,
 		.keys = NM_MAKE_STRV (
+			NM_CONFIG_KEYFILE_KEY_LOGGING_ASYNC,
+			NM_CONFIG_KEYFILE_KEY_LOGGING_ASYNC_SYNC_LEVEL,
 			NM_CONFIG_KEYFILE_KEY_LOGGING_AUDIT,
 			NM_CONFIG_KEYFILE_KEY_LOGGING_BACKEND,
 			NM_CONFIG_KEYFILE_KEY_LOGGING_DOMAINS,
 			NM_CONFIG_KEYFILE_KEY_LOGGING_LEVEL,
+			NM_CONFIG_KEYFILE_KEY_LOGGING_TRACE_FILE,
 		),
 	},
 	{
@@ -70,13 +70,17 @@
 #define NM_CONFIG_KEYFILE_KEY_MAIN_NO_AUTO_DEFAULT          "no-auto-default"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_PLUGINS                  "plugins"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_RC_MANAGER               "rc-manager"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_ROUTE_GET                "route-get"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_SLAVES_ORDER             "slaves-order"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_SYSTEMD_RESOLVED         "systemd-resolved"
 
+#define NM_CONFIG_KEYFILE_KEY_LOGGING_ASYNC                 "async"
+#define NM_CONFIG_KEYFILE_KEY_LOGGING_ASYNC_SYNC_LEVEL      "async-sync-level"
 #define NM_CONFIG_KEYFILE_KEY_LOGGING_AUDIT                 "audit"
 #define NM_CONFIG_KEYFILE_KEY_LOGGING_BACKEND               "backend"
 #define NM_CONFIG_KEYFILE_KEY_LOGGING_DOMAINS               "domains"
 #define NM_CONFIG_KEYFILE_KEY_LOGGING_LEVEL                 "level"
+#define NM_CONFIG_KEYFILE_KEY_LOGGING_TRACE_FILE            "trace-file"
 
 #define NM_CONFIG_KEYFILE_KEY_CONNECTIVITY_ENABLED          "enabled"
 #define NM_CONFIG_KEYFILE_KEY_CONNECTIVITY_INTERVAL         "interval"
@@ -47,8 +47,19 @@
 
 typedef struct {
 	GVariant *value;
+
+	/* whether a PropertiesChanged notification for the property is pending. */
+	bool dirty:1;
 } PropertyCacheData;
 
+typedef struct {
+	const NMDBusInterfaceInfoExtended *interface_info;
+	const GParamSpec *pspec;
+
+	/* the index of the D-Bus property of @interface_info for @pspec, or -1. */
+	int property_idx;
+} PropertyIdxData;
+
 typedef struct {
 	CList registration_lst;
 	NMDBusObject *obj;
@@ -75,6 +86,16 @@ typedef struct {
 	GHashTable *objects_by_path;
 	CList objects_lst_head;
 
+	/* objects with pending PropertiesChanged notifications. */
+	CList properties_changed_lst_head;
+	guint properties_changed_idle_id;
+	GHashTable *property_idx_hash;
+
+	/* the number of D-Bus method calls that were not yet replied to. As long
+	 * as there are any, property changes are emitted right away, so that they
+	 * go out before a reply that might depend on them. */
+	guint n_invocations_pending;
+
 	CList private_servers_lst_head;
 
 	NMDBusManagerSetPropertyHandler set_property_handler;
@@ -112,8 +133,8 @@ NM_DEFINE_SINGLETON_GETTER (NMDBusManager, nm_dbus_manager_get, NM_TYPE_DBUS_MAN
 static const GDBusInterfaceInfo interface_info_objmgr;
 static const GDBusSignalInfo signal_info_objmgr_interfaces_added;
 static const GDBusSignalInfo signal_info_objmgr_interfaces_removed;
-static GVariantBuilder *_obj_collect_properties_all (NMDBusObject *obj,
-                                                     GVariantBuilder *builder);
+static GVariant *_obj_get_properties_all (NMDBusObject *obj);
+static void _obj_properties_changed_flush_all (NMDBusManager *self);
 
 /*****************************************************************************/
 
@@ -779,6 +800,16 @@ _reg_data_get_interface_info (RegistrationData *reg_data)
 
 /*****************************************************************************/
 
+static void
+_invocation_destroyed_cb (gpointer user_data, GObject *where_the_object_was)
+{
+	gs_unref_object NMDBusManager *self = user_data;
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+
+	nm_assert (priv->n_invocations_pending > 0);
+	priv->n_invocations_pending--;
+}
+
 static void
 dbus_vtable_method_call (GDBusConnection *connection,
                          const char *sender,
@@ -789,14 +820,25 @@ dbus_vtable_method_call (GDBusConnection *connection,
                          GDBusMethodInvocation *invocation,
                          gpointer user_data)
 {
-	NMDBusManager *self;
-	NMDBusManagerPrivate *priv;
 	RegistrationData *reg_data = user_data;
 	NMDBusObject *obj = reg_data->obj;
+	NMDBusManager *self = nm_dbus_object_get_manager (obj);
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
 	const NMDBusInterfaceInfoExtended *interface_info = _reg_data_get_interface_info (reg_data);
 	const NMDBusMethodInfoExtended *method_info = NULL;
 	gboolean on_same_interface;
 
+	/* the caller might have seen the effect of earlier changes, for which
+	 * the PropertiesChanged signal is still pending. Emit them now, so that
+	 * they are not sent after the reply to the method call. */
+	_obj_properties_changed_flush_all (self);
+
+	/* the reply may be sent right away or only later, for example after an
+	 * authorization request. Either way, the invocation is only destroyed
+	 * after the reply was sent. */
+	priv->n_invocations_pending++;
+	g_object_weak_ref (G_OBJECT (invocation), _invocation_destroyed_cb, g_object_ref (self));
+
 	on_same_interface = nm_streq (interface_info->parent.name, interface_name);
 
 	/* handle property setter first... */
@@ -808,9 +850,6 @@ dbus_vtable_method_call (GDBusConnection *connection,
 		const char *property_name;
 		gs_unref_variant GVariant *value = NULL;
 
-		self = nm_dbus_object_get_manager (obj);
-		priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
-
 		g_variant_get (parameters, "(&s&sv)", &property_interface, &property_name, &value);
 
 		nm_assert (nm_streq (property_interface, interface_info->parent.name));
@@ -855,8 +894,6 @@ dbus_vtable_method_call (GDBusConnection *connection,
 		return;
 	}
 
-	self = nm_dbus_object_get_manager (obj);
-	priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
 	if (   priv->shutting_down
 	    && !method_info->allow_during_shutdown) {
 		g_dbus_method_invocation_return_error_literal (invocation,
@@ -942,7 +979,7 @@ _obj_register (NMDBusManager *self,
 	GType gtype;
 	NMDBusObjectClass *klasses[10];
 	const NMDBusInterfaceInfoExtended *const*prev_interface_infos = NULL;
-	GVariantBuilder builder;
+	gs_unref_variant GVariant *properties_all = NULL;
 
 	nm_assert (c_list_is_empty (&obj->internal.registration_lst_head));
 	nm_assert (priv->connection);
@@ -1021,14 +1058,17 @@ _obj_register (NMDBusManager *self,
 	 *
 	 * In general, it's ok to export an object with frozen signals. But you better make sure
 	 * that all properties are in a self-consistent state when exporting the object. */
+	_obj_properties_changed_flush_all (self);
+	nm_clear_g_variant (&obj->internal.properties_all);
+	properties_all = _obj_get_properties_all (obj);
 	g_dbus_connection_emit_signal (priv->connection,
 	                               NULL,
 	                               OBJECT_MANAGER_SERVER_BASE_PATH,
 	                               interface_info_objmgr.name,
 	                               signal_info_objmgr_interfaces_added.name,
-	                               g_variant_new ("(oa{sa{sv}})",
+	                               g_variant_new ("(o@a{sa{sv}})",
 	                                              obj->internal.path,
-	                                              _obj_collect_properties_all (obj, &builder)),
+	                                              properties_all),
 	                               NULL);
 }
 
@@ -1051,6 +1091,12 @@ _obj_unregister (NMDBusManager *self,
 	nm_assert (!c_list_is_empty (&obj->internal.registration_lst_head));
 	nm_assert (priv->objmgr_registration_id);
 
+	/* emit pending property changes (also of @obj) before the object goes away. */
+	_obj_properties_changed_flush_all (self);
+	nm_assert (c_list_is_empty (&obj->internal.properties_changed_lst));
+
+	nm_clear_g_variant (&obj->internal.properties_all);
+
 	g_variant_builder_init (&builder, G_VARIANT_TYPE ("as"));
 
 	while ((reg_data = c_list_last_entry (&obj->internal.registration_lst_head, RegistrationData, registration_lst))) {
@@ -1146,21 +1192,20 @@ _nm_dbus_manager_obj_unexport (NMDBusObject *obj)
 	nm_assert (c_list_contains (&priv->objects_lst_head, &obj->internal.objects_lst));
 
 	_obj_unregister (self, obj);
+	nm_clear_g_variant (&obj->internal.properties_all);
 
 	if (!g_hash_table_remove (priv->objects_by_path, &obj->internal))
 		nm_assert_not_reached ();
 	c_list_unlink (&obj->internal.objects_lst);
 }
 
-void
-_nm_dbus_manager_obj_notify (NMDBusObject *obj,
-                             guint n_pspecs,
-                             const GParamSpec *const*pspecs)
+static void
+_obj_emit_properties_changed (NMDBusManager *self,
+                              NMDBusObject *obj)
 {
-	NMDBusManager *self;
-	NMDBusManagerPrivate *priv;
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
 	RegistrationData *reg_data;
-	guint i, p;
+	guint i;
 	gboolean any_legacy_signals = FALSE;
 	gboolean any_legacy_properties = FALSE;
 	GVariantBuilder legacy_builder;
@@ -1168,7 +1213,7 @@ _nm_dbus_manager_obj_notify (NMDBusObject *obj,
 
 	nm_assert (NM_IS_DBUS_OBJECT (obj));
 	nm_assert (obj->internal.path);
-	nm_assert (NM_IS_DBUS_MANAGER (obj->internal.bus_manager));
+	nm_assert (obj->internal.bus_manager == self);
 	nm_assert (!c_list_is_empty (&obj->internal.objects_lst));
 
 	c_list_for_each_entry (reg_data, &obj->internal.registration_lst_head, registration_lst) {
@@ -1178,16 +1223,8 @@ _nm_dbus_manager_obj_notify (NMDBusObject *obj,
 		}
 	}
 
-	self = obj->internal.bus_manager;
-	priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
-
-	/* do a naive search for the matching NMDBusPropertyInfoExtended infos. Since the number of
-	 * (interfaces x properties) is static and possibly small, this naive search is effectively
-	 * O(1). We might wanna introduce some index to lookup the properties in question faster.
-	 *
-	 * The nice part of this implementation is however, that the order in which properties
-	 * are added to the GVariant is strictly defined to be the order in which the D-Bus property-info
-	 * is declared. Getting a defined ordering with some smart lookup would be hard. */
+	/* the order in which properties are added to the GVariant is strictly defined to be
+	 * the order in which the D-Bus property-info is declared. */
 	c_list_for_each_entry (reg_data, &obj->internal.registration_lst_head, registration_lst) {
 		const NMDBusInterfaceInfoExtended *interface_info = _reg_data_get_interface_info (reg_data);
 		gboolean has_properties = FALSE;
@@ -1200,32 +1237,29 @@ _nm_dbus_manager_obj_notify (NMDBusObject *obj,
 
 		for (i = 0; interface_info->parent.properties[i]; i++) {
 			const NMDBusPropertyInfoExtended *property_info = (const NMDBusPropertyInfoExtended *) interface_info->parent.properties[i];
+			gs_unref_variant GVariant *value = NULL;
 
-			for (p = 0; p < n_pspecs; p++) {
-				const GParamSpec *pspec = pspecs[p];
-				gs_unref_variant GVariant *value = NULL;
-
-				if (!nm_streq (property_info->property_name, pspec->name))
-					continue;
+			if (!reg_data->property_cache[i].dirty)
+				continue;
+			reg_data->property_cache[i].dirty = FALSE;
 
-				value = _obj_get_property (reg_data, i, TRUE);
+			value = _obj_get_property (reg_data, i, TRUE);
 
-				if (   property_info->include_in_legacy_property_changed
-				    && any_legacy_signals) {
-					/* also track the value in the legacy_builder to emit legacy signals below. */
-					if (!any_legacy_properties) {
-						any_legacy_properties = TRUE;
-						g_variant_builder_init (&legacy_builder, G_VARIANT_TYPE ("a{sv}"));
-					}
-					g_variant_builder_add (&legacy_builder, "{sv}", property_info->parent.name, value);
+			if (   property_info->include_in_legacy_property_changed
+			    && any_legacy_signals) {
+				/* also track the value in the legacy_builder to emit legacy signals below. */
+				if (!any_legacy_properties) {
+					any_legacy_properties = TRUE;
+					g_variant_builder_init (&legacy_builder, G_VARIANT_TYPE ("a{sv}"));
 				}
+				g_variant_builder_add (&legacy_builder, "{sv}", property_info->parent.name, value);
+			}
 
-				if (!has_properties) {
-					has_properties = TRUE;
-					g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
-				}
-				g_variant_builder_add (&builder, "{sv}", property_info->parent.name, value);
+			if (!has_properties) {
+				has_properties = TRUE;
+				g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
 			}
+			g_variant_builder_add (&builder, "{sv}", property_info->parent.name, value);
 		}
 
 		if (!has_properties)
@@ -1306,6 +1340,159 @@ _nm_dbus_manager_obj_notify (NMDBusObject *obj,
 	}
 }
 
+static void
+_obj_properties_changed_flush_all (NMDBusManager *self)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	NMDBusObject *obj;
+
+	nm_clear_g_source (&priv->properties_changed_idle_id);
+
+	while ((obj = c_list_first_entry (&priv->properties_changed_lst_head, NMDBusObject, internal.properties_changed_lst))) {
+		c_list_unlink (&obj->internal.properties_changed_lst);
+		_obj_emit_properties_changed (self, obj);
+	}
+}
+
+static gboolean
+_obj_properties_changed_idle_cb (gpointer user_data)
+{
+	NMDBusManager *self = user_data;
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+
+	priv->properties_changed_idle_id = 0;
+	_obj_properties_changed_flush_all (self);
+	return G_SOURCE_REMOVE;
+}
+
+static guint
+_property_idx_data_hash (gconstpointer ptr)
+{
+	const PropertyIdxData *data = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 1408432753u);
+	nm_hash_update_vals (&h,
+	                     data->interface_info,
+	                     data->pspec);
+	return nm_hash_complete (&h);
+}
+
+static gboolean
+_property_idx_data_equal (gconstpointer ptr_a, gconstpointer ptr_b)
+{
+	const PropertyIdxData *a = ptr_a;
+	const PropertyIdxData *b = ptr_b;
+
+	return    a->interface_info == b->interface_info
+	       && a->pspec == b->pspec;
+}
+
+static int
+_property_idx_lookup (NMDBusManager *self,
+                      const NMDBusInterfaceInfoExtended *interface_info,
+                      const GParamSpec *pspec)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	PropertyIdxData needle = {
+		.interface_info = interface_info,
+		.pspec = pspec,
+	};
+	PropertyIdxData *data;
+	guint i;
+
+	/* the mapping of a pspec to the D-Bus property of an interface is static.
+	 * Search it once, and remember the result (also, if the property is not
+	 * on @interface_info). */
+	data = g_hash_table_lookup (priv->property_idx_hash, &needle);
+	if (G_LIKELY (data))
+		return data->property_idx;
+
+	data = g_slice_new (PropertyIdxData);
+	*data = needle;
+	data->property_idx = -1;
+	for (i = 0; interface_info->parent.properties[i]; i++) {
+		const NMDBusPropertyInfoExtended *property_info = (const NMDBusPropertyInfoExtended *) interface_info->parent.properties[i];
+
+		if (nm_streq (property_info->property_name, pspec->name)) {
+			data->property_idx = i;
+			break;
+		}
+	}
+	g_hash_table_add (priv->property_idx_hash, data);
+	return data->property_idx;
+}
+
+static void
+_property_idx_data_free (gpointer data)
+{
+	g_slice_free (PropertyIdxData, data);
+}
+
+void
+_nm_dbus_manager_obj_notify (NMDBusObject *obj,
+                             guint n_pspecs,
+                             const GParamSpec *const*pspecs)
+{
+	NMDBusManager *self;
+	NMDBusManagerPrivate *priv;
+	RegistrationData *reg_data;
+	gboolean any_dirty = FALSE;
+	guint p;
+
+	nm_assert (NM_IS_DBUS_OBJECT (obj));
+	nm_assert (obj->internal.path);
+	nm_assert (NM_IS_DBUS_MANAGER (obj->internal.bus_manager));
+	nm_assert (!c_list_is_empty (&obj->internal.objects_lst));
+
+	self = obj->internal.bus_manager;
+	priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+
+	/* We don't emit PropertiesChanged right away. Instead, mark the properties
+	 * as dirty and emit one merged signal per object on an idle handler. Invalidate
+	 * the cached value, so that a Get() in the meantime sees the new value. */
+	c_list_for_each_entry (reg_data, &obj->internal.registration_lst_head, registration_lst) {
+		const NMDBusInterfaceInfoExtended *interface_info = _reg_data_get_interface_info (reg_data);
+
+		if (!interface_info->parent.properties)
+			continue;
+
+		for (p = 0; p < n_pspecs; p++) {
+			int i;
+
+			i = _property_idx_lookup (self, interface_info, pspecs[p]);
+			if (i < 0)
+				continue;
+
+			nm_clear_g_variant (&reg_data->property_cache[i].value);
+			reg_data->property_cache[i].dirty = TRUE;
+			any_dirty = TRUE;
+		}
+	}
+
+	if (!any_dirty)
+		return;
+
+	nm_clear_g_variant (&obj->internal.properties_all);
+
+	if (c_list_is_empty (&obj->internal.properties_changed_lst))
+		c_list_link_tail (&priv->properties_changed_lst_head, &obj->internal.properties_changed_lst);
+
+	if (priv->n_invocations_pending > 0) {
+		_obj_properties_changed_flush_all (self);
+		return;
+	}
+
+	if (!priv->properties_changed_idle_id) {
+		/* use a high priority, so that the signals go out before we handle the
+		 * next D-Bus request. */
+		priv->properties_changed_idle_id = g_idle_add_full (G_PRIORITY_HIGH,
+		                                                    _obj_properties_changed_idle_cb,
+		                                                    self,
+		                                                    NULL);
+	}
+}
+
 void
 _nm_dbus_manager_obj_emit_signal (NMDBusObject *obj,
                                   const NMDBusInterfaceInfoExtended *interface_info,
@@ -1328,6 +1515,9 @@ _nm_dbus_manager_obj_emit_signal (NMDBusObject *obj,
 		return;
 	}
 
+	/* coalescing property changes must not reorder them with other signals. */
+	_obj_properties_changed_flush_all (self);
+
 	g_dbus_connection_emit_signal (priv->connection,
 	                               NULL,
 	                               obj->internal.path,
@@ -1363,18 +1553,24 @@ _obj_collect_properties_per_interface (NMDBusObject *obj,
 	return builder;
 }
 
-static GVariantBuilder *
-_obj_collect_properties_all (NMDBusObject *obj,
-                             GVariantBuilder *builder)
+static GVariant *
+_obj_get_properties_all (NMDBusObject *obj)
 {
 	RegistrationData *reg_data;
+	GVariantBuilder builder;
+
+	/* the snapshot of all properties is cached until the next property change.
+	 * That way, GetManagedObjects() only needs to serialize objects that changed
+	 * since the last call. */
+	if (obj->internal.properties_all)
+		return g_variant_ref (obj->internal.properties_all);
 
-	g_variant_builder_init (builder, G_VARIANT_TYPE ("a{sa{sv}}"));
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sa{sv}}"));
 
 	c_list_for_each_entry (reg_data, &obj->internal.registration_lst_head, registration_lst) {
 		GVariantBuilder properties_builder;
 
-		g_variant_builder_add (builder,
+		g_variant_builder_add (&builder,
 		                       "{sa{sv}}",
 		                       _reg_data_get_interface_info (reg_data)->parent.name,
 		                       _obj_collect_properties_per_interface (obj,
@@ -1382,7 +1578,8 @@ _obj_collect_properties_all (NMDBusObject *obj,
 		                                                              &properties_builder));
 	}
 
-	return builder;
+	obj->internal.properties_all = g_variant_ref_sink (g_variant_builder_end (&builder));
+	return g_variant_ref (obj->internal.properties_all);
 }
 
 static void
@@ -1412,20 +1609,22 @@ dbus_vtable_objmgr_method_call (GDBusConnection *connection,
 		return;
 	}
 
+	_obj_properties_changed_flush_all (self);
+
 	g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("a{oa{sa{sv}}}"));
 	c_list_for_each_entry (obj, &priv->objects_lst_head, internal.objects_lst) {
-		GVariantBuilder interfaces_builder;
+		gs_unref_variant GVariant *properties_all = NULL;
 
 		/* note that we are called on an idle handler. Hence, all properties are
 		 * supposed to be in a consistent state. That is true, if you always
 		 * g_object_thaw_notify() before returning to the mainloop. Keeping
 		 * signals frozen between while returning from the current call stack
 		 * is anyway a very fragile thing, easy to get wrong. Don't do that. */
+		properties_all = _obj_get_properties_all (obj);
 		g_variant_builder_add (&array_builder,
-		                       "{oa{sa{sv}}}",
+		                       "{o@a{sa{sv}}}",
 		                       obj->internal.path,
-		                       _obj_collect_properties_all (obj,
-		                                                    &interfaces_builder));
+		                       properties_all);
 	}
 	g_dbus_method_invocation_return_value (invocation,
 	                                       g_variant_new ("(a{oa{sa{sv}}})",
@@ -1621,7 +1820,9 @@ nm_dbus_manager_init (NMDBusManager *self)
 
 	c_list_init (&priv->private_servers_lst_head);
 	c_list_init (&priv->objects_lst_head);
+	c_list_init (&priv->properties_changed_lst_head);
 	priv->objects_by_path = g_hash_table_new ((GHashFunc) _objects_by_path_hash, (GEqualFunc) _objects_by_path_equal);
+	priv->property_idx_hash = g_hash_table_new_full (_property_idx_data_hash, _property_idx_data_equal, _property_idx_data_free, NULL);
 }
 
 static void
@@ -1635,8 +1836,11 @@ dispose (GObject *object)
 	 * expect any remaining objects. */
 	nm_assert (!priv->objects_by_path || g_hash_table_size (priv->objects_by_path) == 0);
 	nm_assert (c_list_is_empty (&priv->objects_lst_head));
+	nm_assert (c_list_is_empty (&priv->properties_changed_lst_head));
 
+	nm_clear_g_source (&priv->properties_changed_idle_id);
 	g_clear_pointer (&priv->objects_by_path, g_hash_table_destroy);
+	g_clear_pointer (&priv->property_idx_hash, g_hash_table_destroy);
 
 	c_list_for_each_entry_safe (s, s_safe, &priv->private_servers_lst_head, private_servers_lst)
 		private_server_free (s);
@@ -88,6 +88,14 @@ struct _NMDBusObjectInternal {
 	CList objects_lst;
 	CList registration_lst_head;
 
+	/* linked in NMDBusManager, while there are pending PropertiesChanged
+	 * notifications for this object. */
+	CList properties_changed_lst;
+
+	/* the cached "a{sa{sv}}" variant with all interfaces and properties, as
+	 * returned by GetManagedObjects. Cleared on property changes. */
+	GVariant *properties_all;
+
 	/* we perform asynchronous operation on exported objects. For example, we receive
 	 * a Set property call, and asynchronously validate the operation. We must make
 	 * sure that when the authentication is complete, that we are still looking at
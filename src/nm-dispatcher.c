@@ -37,6 +37,7 @@
 #include "nm-proxy-config.h"
 #include "nm-ip4-config.h"
 #include "nm-ip6-config.h"
+#include "nm-latency.h"
 #include "nm-manager.h"
 #include "settings/nm-settings-connection.h"
 #include "platform/nm-platform.h"
@@ -332,6 +333,7 @@ typedef struct {
 	NMDispatcherFunc callback;
 	gpointer user_data;
 	guint idle_id;
+	gint64 start_ns;
 } DispatchInfo;
 
 static void
@@ -432,6 +434,7 @@ dispatcher_done_cb (GObject *proxy, GAsyncResult *result, gpointer user_data)
 	ret = _nm_dbus_proxy_call_finish (G_DBUS_PROXY (proxy), result,
 	                                  G_VARIANT_TYPE ("(a(sus))"),
 	                                  &error);
+	nm_latency_record (NM_LATENCY_DISPATCHER, info->start_ns);
 	if (ret) {
 		g_variant_get (ret, "(a(sus))", &results);
 		dispatcher_results_process (info->request_id, info->action, results);
@@ -637,6 +640,7 @@ _dispatcher_call (NMDispatcherAction action,
 	if (blocking) {
 		GVariant *ret;
 		GVariantIter *results;
+		const gint64 start_ns = nm_latency_start ();
 
 		ret = _nm_dbus_proxy_call_sync (dispatcher_proxy, "Action",
 		                                g_variant_new ("(s@a{sa{sv}}a{sv}a{sv}a{sv}a{sv}a{sv}@a{sv}@a{sv}ssa{sv}a{sv}a{sv}b)",
@@ -658,6 +662,7 @@ _dispatcher_call (NMDispatcherAction action,
 		                                G_VARIANT_TYPE ("(a(sus))"),
 		                                G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT,
 		                                NULL, &error);
+		nm_latency_record (NM_LATENCY_DISPATCHER, start_ns);
 		if (ret) {
 			g_variant_get (ret, "(a(sus))", &results);
 			dispatcher_results_process (reqid, action, results);
@@ -676,6 +681,7 @@ _dispatcher_call (NMDispatcherAction action,
 		info->request_id = reqid;
 		info->callback = callback;
 		info->user_data = user_data;
+		info->start_ns = nm_latency_start ();
 		g_dbus_proxy_call (dispatcher_proxy, "Action",
 		                   g_variant_new ("(s@a{sa{sv}}a{sv}a{sv}a{sv}a{sv}a{sv}@a{sv}@a{sv}ssa{sv}a{sv}a{sv}b)",
 		                                  action_to_string (action),
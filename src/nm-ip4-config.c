@@ -37,6 +37,7 @@
 #include "NetworkManagerUtils.h"
 #include "nm-core-internal.h"
 #include "nm-dbus-object.h"
+#include "nm-latency.h"
 
 /*****************************************************************************/
 
@@ -798,7 +799,9 @@ nm_ip4_config_commit (const NMIP4Config *self,
 	gs_unref_ptrarray GPtrArray *routes = NULL;
 	gs_unref_ptrarray GPtrArray *routes_prune = NULL;
 	int ifindex;
+	gboolean incremental;
 	gboolean success = TRUE;
+	const gint64 start_ns = nm_latency_start ();
 
 	g_return_val_if_fail (NM_IS_IP4_CONFIG (self), FALSE);
 
@@ -811,21 +814,41 @@ nm_ip4_config_commit (const NMIP4Config *self,
 	routes = nm_dedup_multi_objs_to_ptr_array_head (nm_ip4_config_lookup_routes (self),
 	                                                NULL, NULL);
 
-	routes_prune = nm_platform_ip_route_get_prune_list (platform,
-	                                                    AF_INET,
-	                                                    ifindex,
-	                                                    route_table_sync);
+	/* if the routes didn't change since our last commit, we only need to
+	 * sync the difference and don't need a prune list. This must be checked
+	 * before syncing addresses, which may also change routes. */
+	incremental = nm_platform_ip_route_sync_can_incremental (platform,
+	                                                         AF_INET,
+	                                                         ifindex,
+	                                                         route_table_sync);
+	if (!incremental) {
+		routes_prune = nm_platform_ip_route_get_prune_list (platform,
+		                                                    AF_INET,
+		                                                    ifindex,
+		                                                    route_table_sync);
+	}
 
 	nm_platform_ip4_address_sync (platform, ifindex, addresses);
 
-	if (!nm_platform_ip_route_sync (platform,
-	                                AF_INET,
-	                                ifindex,
-	                                routes,
-	                                routes_prune,
-	                                NULL))
-		success = FALSE;
+	if (incremental) {
+		success = nm_platform_ip_route_sync_incremental (platform,
+		                                                 AF_INET,
+		                                                 ifindex,
+		                                                 routes,
+		                                                 route_table_sync,
+		                                                 NULL);
+	} else {
+		success = nm_platform_ip_route_sync (platform,
+		                                     AF_INET,
+		                                     ifindex,
+		                                     routes,
+		                                     routes_prune,
+		                                     NULL);
+		if (success)
+			nm_platform_ip_route_sync_track (platform, AF_INET, ifindex, routes, route_table_sync);
+	}
 
+	nm_latency_record (NM_LATENCY_IP4_CONFIG_COMMIT, start_ns);
 	return success;
 }
 
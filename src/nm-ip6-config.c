@@ -39,6 +39,7 @@
 #include "nm-ip4-config.h"
 #include "ndisc/nm-ndisc.h"
 #include "nm-dbus-object.h"
+#include "nm-latency.h"
 
 /*****************************************************************************/
 
@@ -561,7 +562,9 @@ nm_ip6_config_commit (const NMIP6Config *self,
 	gs_unref_ptrarray GPtrArray *routes = NULL;
 	gs_unref_ptrarray GPtrArray *routes_prune = NULL;
 	int ifindex;
+	gboolean incremental;
 	gboolean success = TRUE;
+	const gint64 start_ns = nm_latency_start ();
 
 	g_return_val_if_fail (NM_IS_IP6_CONFIG (self), FALSE);
 
@@ -574,21 +577,43 @@ nm_ip6_config_commit (const NMIP6Config *self,
 	routes = nm_dedup_multi_objs_to_ptr_array_head (nm_ip6_config_lookup_routes (self),
 	                                                NULL, NULL);
 
-	routes_prune = nm_platform_ip_route_get_prune_list (platform,
-	                                                    AF_INET6,
-	                                                    ifindex,
-	                                                    route_table_sync);
+	/* if the routes didn't change since our last commit, we only need to
+	 * sync the difference and don't need a prune list. This must be checked
+	 * before syncing addresses, which may also change routes. */
+	incremental = nm_platform_ip_route_sync_can_incremental (platform,
+	                                                         AF_INET6,
+	                                                         ifindex,
+	                                                         route_table_sync);
+	if (!incremental) {
+		routes_prune = nm_platform_ip_route_get_prune_list (platform,
+		                                                    AF_INET6,
+		                                                    ifindex,
+		                                                    route_table_sync);
+	}
 
 	nm_platform_ip6_address_sync (platform, ifindex, addresses, FALSE);
 
-	if (!nm_platform_ip_route_sync (platform,
-	                                AF_INET6,
-	                                ifindex,
-	                                routes,
-	                                routes_prune,
-	                                out_temporary_not_available))
-		success = FALSE;
-
+	if (incremental) {
+		success = nm_platform_ip_route_sync_incremental (platform,
+		                                                 AF_INET6,
+		                                                 ifindex,
+		                                                 routes,
+		                                                 route_table_sync,
+		                                                 out_temporary_not_available);
+	} else {
+		success = nm_platform_ip_route_sync (platform,
+		                                     AF_INET6,
+		                                     ifindex,
+		                                     routes,
+		                                     routes_prune,
+		                                     out_temporary_not_available);
+		if (   success
+		    && (   !out_temporary_not_available
+		        || !*out_temporary_not_available))
+			nm_platform_ip_route_sync_track (platform, AF_INET6, ifindex, routes, route_table_sync);
+	}
+
+	nm_latency_record (NM_LATENCY_IP6_CONFIG_COMMIT, start_ns);
 	return success;
 }
 
@@ -0,0 +1,183 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-latency.h"
+
+#include <string.h>
+
+/*****************************************************************************/
+
+/* 2^SUB_BITS linear sub-buckets per power of two. */
+#define SUB_BITS   3
+#define SUB_COUNT  (1u << SUB_BITS)
+
+/* values are clamped to 2^MAX_BITS - 1 microseconds (about 19 hours). */
+#define MAX_BITS   36
+
+#define N_BUCKETS  ((MAX_BITS - SUB_BITS + 1) * SUB_COUNT)
+
+G_STATIC_ASSERT (N_BUCKETS == _NM_LATENCY_N_BUCKETS);
+G_STATIC_ASSERT ((((guint64) 1) << MAX_BITS) - 1 == _NM_LATENCY_MAX_USEC);
+
+typedef struct {
+	guint64 count;
+	guint64 sum_usec;
+	guint64 max_usec;
+	guint64 buckets[N_BUCKETS];
+} Histogram;
+
+static Histogram histograms[_NM_LATENCY_NUM];
+
+static const char *const type_names[_NM_LATENCY_NUM] = {
+	[NM_LATENCY_NETLINK_REQUEST]    = "netlink-request",
+	[NM_LATENCY_ROUTE_SYNC]         = "route-sync",
+	[NM_LATENCY_IP4_CONFIG_COMMIT]  = "ip4-config-commit",
+	[NM_LATENCY_IP6_CONFIG_COMMIT]  = "ip6-config-commit",
+	[NM_LATENCY_DNS_UPDATE]         = "dns-update",
+	[NM_LATENCY_DISPATCHER]         = "dispatcher",
+	[NM_LATENCY_DEVICE_STATE]       = "device-state",
+};
+
+/*****************************************************************************/
+
+guint
+_nm_latency_bucket_idx (guint64 v)
+{
+	guint msb;
+
+	if (v < SUB_COUNT)
+		return v;
+
+	msb = 63u - (guint) __builtin_clzll (v);
+	return   ((msb - SUB_BITS + 1) << SUB_BITS)
+	       + ((v >> (msb - SUB_BITS)) & (SUB_COUNT - 1));
+}
+
+/* the highest value that falls into bucket @idx. */
+guint64
+_nm_latency_bucket_upper (guint idx)
+{
+	guint shift;
+
+	if (idx < SUB_COUNT)
+		return idx;
+
+	shift = (idx >> SUB_BITS) - 1;
+	return (((guint64) (SUB_COUNT + (idx & (SUB_COUNT - 1)))) << shift) + (((guint64) 1) << shift) - 1;
+}
+
+void
+nm_latency_record_ns (NMLatencyType type, gint64 duration_ns)
+{
+	Histogram *h;
+	guint64 v;
+
+	nm_assert (type >= 0 && type < _NM_LATENCY_NUM);
+
+	v = duration_ns > 0 ? (guint64) duration_ns / 1000u : 0u;
+	v = MIN (v, (((guint64) 1) << MAX_BITS) - 1);
+
+	h = &histograms[type];
+	h->count++;
+	h->sum_usec += v;
+	if (v > h->max_usec)
+		h->max_usec = v;
+	h->buckets[_nm_latency_bucket_idx (v)]++;
+}
+
+/*****************************************************************************/
+
+static guint64
+_percentile (const Histogram *h, guint percent)
+{
+	guint64 threshold;
+	guint64 seen = 0;
+	guint i;
+
+	if (!h->count)
+		return 0;
+
+	threshold = MAX ((h->count * percent + 99u) / 100u, (guint64) 1);
+	for (i = 0; i < N_BUCKETS; i++) {
+		seen += h->buckets[i];
+		if (seen >= threshold)
+			return MIN (_nm_latency_bucket_upper (i), h->max_usec);
+	}
+	return h->max_usec;
+}
+
+static GVariant *
+_histogram_to_variant (const Histogram *h)
+{
+	GVariantBuilder builder;
+	GVariantBuilder buckets;
+	guint i;
+
+	g_variant_builder_init (&buckets, G_VARIANT_TYPE ("a(tt)"));
+	for (i = 0; i < N_BUCKETS; i++) {
+		if (h->buckets[i]) {
+			g_variant_builder_add (&buckets, "(tt)",
+			                       _nm_latency_bucket_upper (i),
+			                       h->buckets[i]);
+		}
+	}
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+	g_variant_builder_add (&builder, "{sv}", "count", g_variant_new_uint64 (h->count));
+	g_variant_builder_add (&builder, "{sv}", "sum-usec", g_variant_new_uint64 (h->sum_usec));
+	g_variant_builder_add (&builder, "{sv}", "max-usec", g_variant_new_uint64 (h->max_usec));
+	g_variant_builder_add (&builder, "{sv}", "p50-usec", g_variant_new_uint64 (_percentile (h, 50)));
+	g_variant_builder_add (&builder, "{sv}", "p90-usec", g_variant_new_uint64 (_percentile (h, 90)));
+	g_variant_builder_add (&builder, "{sv}", "p99-usec", g_variant_new_uint64 (_percentile (h, 99)));
+	g_variant_builder_add (&builder, "{sv}", "buckets", g_variant_builder_end (&buckets));
+	return g_variant_builder_end (&builder);
+}
+
+/**
+ * nm_latency_to_variant:
+ *
+ * Returns: (transfer floating): a "a{sa{sv}}" variant with one entry
+ *   per operation. Each entry has the number of samples ("count"),
+ *   their sum, the maximum and the 50th, 90th and 99th percentile
+ *   (all in microseconds), and the non-empty buckets as an array
+ *   of (upper bound, count) pairs.
+ */
+GVariant *
+nm_latency_to_variant (void)
+{
+	GVariantBuilder builder;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sa{sv}}"));
+	for (i = 0; i < _NM_LATENCY_NUM; i++) {
+		g_variant_builder_add (&builder, "{s@a{sv}}",
+		                       type_names[i],
+		                       _histogram_to_variant (&histograms[i]));
+	}
+	return g_variant_builder_end (&builder);
+}
+
+void
+nmtst_latency_reset (void)
+{
+	memset (histograms, 0, sizeof (histograms));
+}
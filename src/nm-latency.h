@@ -0,0 +1,77 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2018 Red Hat, Inc.
+ */
+
+#ifndef __NM_LATENCY_H__
+#define __NM_LATENCY_H__
+
+#include "nm-utils/nm-time-utils.h"
+
+/*****************************************************************************/
+
+/* Latency histograms for a fixed set of operations.
+ *
+ * Durations are recorded in microseconds into log-linear buckets: each
+ * power of two is split into 8 linear sub-buckets, so every bucket
+ * is accurate to 12.5%. Recording a value is a few shifts and an
+ * increment. The histograms are exposed on D-Bus via the manager's
+ * GetLatencyStatistics() method. */
+
+typedef enum {
+	NM_LATENCY_NETLINK_REQUEST,
+	NM_LATENCY_ROUTE_SYNC,
+	NM_LATENCY_IP4_CONFIG_COMMIT,
+	NM_LATENCY_IP6_CONFIG_COMMIT,
+	NM_LATENCY_DNS_UPDATE,
+	NM_LATENCY_DISPATCHER,
+	NM_LATENCY_DEVICE_STATE,
+	_NM_LATENCY_NUM,
+} NMLatencyType;
+
+static inline gint64
+nm_latency_start (void)
+{
+	return nm_utils_get_monotonic_timestamp_ns ();
+}
+
+void nm_latency_record_ns (NMLatencyType type, gint64 duration_ns);
+
+/* Record the time since @start_ns (see nm_latency_start()). A non-positive
+ * @start_ns is ignored. Must only be called from the main thread. */
+static inline void
+nm_latency_record (NMLatencyType type, gint64 start_ns)
+{
+	if (start_ns > 0)
+		nm_latency_record_ns (type, nm_utils_get_monotonic_timestamp_ns () - start_ns);
+}
+
+GVariant *nm_latency_to_variant (void);
+
+/*****************************************************************************/
+
+/* exposed for tests. */
+#define _NM_LATENCY_MAX_USEC   ((((guint64) 1) << 36) - 1)
+#define _NM_LATENCY_N_BUCKETS  ((36 - 3 + 1) * 8)
+
+guint _nm_latency_bucket_idx (guint64 usec);
+guint64 _nm_latency_bucket_upper (guint idx);
+
+void nmtst_latency_reset (void);
+
+#endif /* __NM_LATENCY_H__ */
@@ -602,54 +602,41 @@ _iovec_set_format (struct iovec *iov, gpointer *iov_free, const char *format, ..
 
 #endif
 
-void
-_nm_log_impl (const char *file,
-              guint line,
-              const char *func,
-              NMLogLevel level,
-              NMLogDomain domain,
-              int error,
-              const char *ifname,
-              const char *conn_uuid,
-              const char *fmt,
-              ...)
-{
-	va_list args;
+typedef struct {
+	const char *file;
+	const char *func;
 	char *msg;
+	char *ifname;
+	char *conn_uuid;
 	GTimeVal tv;
-	int errno_saved;
-
-	if ((guint) level >= G_N_ELEMENTS (_nm_logging_enabled_state))
-		g_return_if_reached ();
 
-	if (!(_nm_logging_enabled_state[level] & domain))
-		return;
+	/* the monotonic timestamp, only set for the journal backend. */
+	gint64 now_ns;
 
-	errno_saved = errno;
+	NMLogDomain domain;
 
-	/* Make sure that %m maps to the specified error */
-	if (error != 0) {
-		if (error < 0)
-			error = -error;
-		errno = error;
-	}
+	/* the subset of @domain that was enabled for @level at the time
+	 * of logging. */
+	NMLogDomain domain_enabled;
 
-	va_start (args, fmt);
-	msg = g_strdup_vprintf (fmt, args);
-	va_end (args);
+	guint line;
+	int error;
+	NMLogLevel level;
+} LogRecord;
 
 #define MESSAGE_FMT "%s%-7s [%ld.%04ld] %s"
-#define MESSAGE_ARG(global, tv, msg) \
+#define MESSAGE_ARG(global, rec) \
     (global).prefix, \
-    (global).level_desc[level].level_str, \
-    (tv).tv_sec, \
-    ((tv).tv_usec / 100), \
-    (msg)
-
-	g_get_current_time (&tv);
+    (global).level_desc[(rec)->level].level_str, \
+    (rec)->tv.tv_sec, \
+    ((rec)->tv.tv_usec / 100), \
+    (rec)->msg
 
+static void
+_log_record_write (const LogRecord *rec)
+{
 	if (global.debug_stderr)
-		g_printerr (MESSAGE_FMT"\n", MESSAGE_ARG (global, tv, msg));
+		g_printerr (MESSAGE_FMT"\n", MESSAGE_ARG (global, rec));
 
 	switch (global.log_backend) {
 #if SYSTEMD_JOURNAL
@@ -663,19 +650,19 @@ _nm_log_impl (const char *file,
 			gpointer *iov_free = iov_free_data;
 			nm_auto_free_gstring GString *s_domain_all = NULL;
 
-			now = nm_utils_get_monotonic_timestamp_ns ();
+			now = rec->now_ns ?: nm_utils_get_monotonic_timestamp_ns ();
 			boottime = nm_utils_monotonic_timestamp_as_boottime (now, 1);
 
-			_iovec_set_format_a (iov++, 30, "PRIORITY=%d", global.level_desc[level].syslog_level);
-			_iovec_set_format (iov++, iov_free++, "MESSAGE="MESSAGE_FMT, MESSAGE_ARG (global, tv, msg));
+			_iovec_set_format_a (iov++, 30, "PRIORITY=%d", global.level_desc[rec->level].syslog_level);
+			_iovec_set_format (iov++, iov_free++, "MESSAGE="MESSAGE_FMT, MESSAGE_ARG (global, rec));
 			_iovec_set_string (iov++, syslog_identifier_full (&global));
 			_iovec_set_format_a (iov++, 30, "SYSLOG_PID=%ld", (long) getpid ());
 			{
 				const LogDesc *diter;
 				int i_domain = _NUM_MAX_FIELDS_SYSLOG_FACILITY;
 				const char *s_domain_1 = NULL;
-				NMLogDomain dom_all = domain;
-				NMLogDomain dom = dom_all & _nm_logging_enabled_state[level];
+				NMLogDomain dom_all = rec->domain;
+				NMLogDomain dom = rec->domain_enabled;
 
 				for (diter = &global.domain_desc[0]; diter->name; diter++) {
 					if (!NM_FLAGS_ANY (dom_all, diter->num))
@@ -712,19 +699,19 @@ _nm_log_impl (const char *file,
 				else
 					_iovec_set_format_str_a (iov++, 30, "NM_LOG_DOMAINS=%s", s_domain_1);
 			}
-			_iovec_set_format_str_a (iov++, 15, "NM_LOG_LEVEL=%s", global.level_desc[level].name);
-			if (func)
-				_iovec_set_format (iov++, iov_free++, "CODE_FUNC=%s", func);
-			_iovec_set_format (iov++, iov_free++, "CODE_FILE=%s", file ?: "");
-			_iovec_set_format_a (iov++, 20, "CODE_LINE=%u", line);
+			_iovec_set_format_str_a (iov++, 15, "NM_LOG_LEVEL=%s", global.level_desc[rec->level].name);
+			if (rec->func)
+				_iovec_set_format (iov++, iov_free++, "CODE_FUNC=%s", rec->func);
+			_iovec_set_format (iov++, iov_free++, "CODE_FILE=%s", rec->file ?: "");
+			_iovec_set_format_a (iov++, 20, "CODE_LINE=%u", rec->line);
 			_iovec_set_format_a (iov++, 60, "TIMESTAMP_MONOTONIC=%lld.%06lld", (long long) (now / NM_UTILS_NS_PER_SECOND), (long long) ((now % NM_UTILS_NS_PER_SECOND) / 1000));
 			_iovec_set_format_a (iov++, 60, "TIMESTAMP_BOOTTIME=%lld.%06lld", (long long) (boottime / NM_UTILS_NS_PER_SECOND), (long long) ((boottime % NM_UTILS_NS_PER_SECOND) / 1000));
-			if (error != 0)
-				_iovec_set_format_a (iov++, 30, "ERRNO=%d", error);
-			if (ifname)
-				_iovec_set_format (iov++, iov_free++, "NM_DEVICE=%s", ifname);
-			if (conn_uuid)
-				_iovec_set_format (iov++, iov_free++, "NM_CONNECTION=%s", conn_uuid);
+			if (rec->error != 0)
+				_iovec_set_format_a (iov++, 30, "ERRNO=%d", rec->error);
+			if (rec->ifname)
+				_iovec_set_format (iov++, iov_free++, "NM_DEVICE=%s", rec->ifname);
+			if (rec->conn_uuid)
+				_iovec_set_format (iov++, iov_free++, "NM_CONNECTION=%s", rec->conn_uuid);
 
 			nm_assert (iov <= &iov_data[G_N_ELEMENTS (iov_data)]);
 			nm_assert (iov_free <= &iov_free_data[G_N_ELEMENTS (iov_free_data)]);
@@ -737,16 +724,351 @@ _nm_log_impl (const char *file,
 		break;
 #endif
 	case LOG_BACKEND_SYSLOG:
-		syslog (global.level_desc[level].syslog_level,
-		        MESSAGE_FMT, MESSAGE_ARG (global, tv, msg));
+		syslog (global.level_desc[rec->level].syslog_level,
+		        MESSAGE_FMT, MESSAGE_ARG (global, rec));
 		break;
 	default:
-		g_log (syslog_identifier_domain (&global), global.level_desc[level].g_log_level,
-		       MESSAGE_FMT, MESSAGE_ARG (global, tv, msg));
+		g_log (syslog_identifier_domain (&global), global.level_desc[rec->level].g_log_level,
+		       MESSAGE_FMT, MESSAGE_ARG (global, rec));
 		break;
 	}
+}
+
+static void
+_log_record_clear (LogRecord *rec)
+{
+	nm_clear_g_free (&rec->msg);
+	nm_clear_g_free (&rec->ifname);
+	nm_clear_g_free (&rec->conn_uuid);
+}
+
+/*****************************************************************************/
+
+/* Asynchronous logging.
+ *
+ * When enabled with nm_logging_async_start(), messages logged from the
+ * main thread are formatted on the main thread, but handed over to a
+ * writer thread via a single-producer, single-consumer ring buffer. The
+ * writer thread does the (possibly blocking) submission to journal or
+ * syslog.
+ *
+ * - messages from other threads are always written synchronously.
+ * - messages at or above the configured sync-level are written
+ *   synchronously too, after waiting for the queued messages to be
+ *   written. That way, they don't get lost on a crash and the order
+ *   of messages is preserved.
+ * - if the ring buffer is full, new messages are dropped. The writer
+ *   thread reports the number of dropped messages once it catches up. */
+
+#define LOG_RING_SIZE 4096
+
+G_STATIC_ASSERT ((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0);
+
+typedef struct {
+	GThread *writer;
+
+	GMutex lock;
+	GCond cond;
+
+	/* the position of the next record to write by the producer and
+	 * to read by the writer, respectively. Both are only incremented
+	 * and wrap around. */
+	volatile gint head;
+	volatile gint tail;
+
+	volatile gint writer_waiting;
+	volatile gint flush_waiting;
+	volatile gint quit;
+
+	/* number of dropped messages not yet reported by the writer. */
+	volatile gint dropped;
+
+	/* statistics, only accessed by the producer. */
+	guint64 n_queued;
+	guint64 n_dropped;
+	guint n_max_fill;
+
+	NMLogLevel sync_level;
+
+	LogRecord records[LOG_RING_SIZE];
+} LogRing;
+
+/* _nm_log_impl() is called from other threads too. They must not touch
+ * the ring, so they first compare themselves against @log_ring_producer,
+ * which is set before the ring gets published and cleared only after.
+ * The ring itself is only dereferenced by the producer thread, and that
+ * is also the thread that frees it in nm_logging_async_stop(). */
+static GThread *log_ring_producer;
+static LogRing *log_ring;
+
+static void
+_log_ring_wakeup (LogRing *ring, volatile gint *waiting)
+{
+	if (g_atomic_int_get (waiting)) {
+		g_mutex_lock (&ring->lock);
+		g_cond_broadcast (&ring->cond);
+		g_mutex_unlock (&ring->lock);
+	}
+}
+
+static gboolean
+_log_ring_push (LogRing *ring, LogRecord *rec)
+{
+	guint head = (guint) ring->head;
+	guint fill;
+
+	fill = head - (guint) g_atomic_int_get (&ring->tail);
+	if (fill >= LOG_RING_SIZE) {
+		g_atomic_int_inc (&ring->dropped);
+		ring->n_dropped++;
+		return FALSE;
+	}
+
+	ring->records[head % LOG_RING_SIZE] = *rec;
+	g_atomic_int_set (&ring->head, (gint) (head + 1));
+
+	ring->n_queued++;
+	ring->n_max_fill = MAX (ring->n_max_fill, fill + 1);
+
+	_log_ring_wakeup (ring, &ring->writer_waiting);
+	return TRUE;
+}
+
+static void
+_log_ring_flush (LogRing *ring)
+{
+	if (g_atomic_int_get (&ring->tail) == ring->head)
+		return;
+
+	g_mutex_lock (&ring->lock);
+	g_atomic_int_set (&ring->flush_waiting, 1);
+	while (g_atomic_int_get (&ring->tail) != ring->head) {
+		g_cond_broadcast (&ring->cond);
+		g_cond_wait (&ring->cond, &ring->lock);
+	}
+	g_atomic_int_set (&ring->flush_waiting, 0);
+	g_mutex_unlock (&ring->lock);
+}
+
+static gpointer
+_log_ring_writer_thread (gpointer user_data)
+{
+	LogRing *ring = user_data;
+	guint tail = (guint) ring->tail;
+
+	for (;;) {
+		guint head = (guint) g_atomic_int_get (&ring->head);
+		gint dropped;
+
+		if (tail != head) {
+			/* write out the whole batch, before publishing the
+			 * new tail to the producer. */
+			for (; tail != head; tail++) {
+				LogRecord *rec = &ring->records[tail % LOG_RING_SIZE];
+
+				_log_record_write (rec);
+				_log_record_clear (rec);
+			}
+			g_atomic_int_set (&ring->tail, (gint) tail);
+
+			dropped = g_atomic_int_get (&ring->dropped);
+			if (dropped > 0) {
+				LogRecord rec = {
+					.file           = __FILE__,
+					.line           = __LINE__,
+					.func           = G_STRFUNC,
+					.level          = LOGL_WARN,
+					.domain         = LOGD_CORE,
+					.domain_enabled = LOGD_CORE,
+				};
+
+				g_atomic_int_add (&ring->dropped, -dropped);
+				g_get_current_time (&rec.tv);
+				if (global.log_backend == LOG_BACKEND_JOURNAL)
+					rec.now_ns = nm_utils_get_monotonic_timestamp_ns ();
+				rec.msg = g_strdup_printf ("logging: dropped %d messages because the log buffer was full",
+				                           dropped);
+				_log_record_write (&rec);
+				_log_record_clear (&rec);
+			}
+
+			_log_ring_wakeup (ring, &ring->flush_waiting);
+			continue;
+		}
+
+		if (g_atomic_int_get (&ring->quit))
+			break;
+
+		g_mutex_lock (&ring->lock);
+		g_atomic_int_set (&ring->writer_waiting, 1);
+		if (   (guint) g_atomic_int_get (&ring->head) == tail
+		    && !g_atomic_int_get (&ring->quit))
+			g_cond_wait (&ring->cond, &ring->lock);
+		g_atomic_int_set (&ring->writer_waiting, 0);
+		g_mutex_unlock (&ring->lock);
+	}
+
+	return NULL;
+}
+
+/**
+ * nm_logging_async_start:
+ * @sync_level: (allow-none): messages with this level or higher are
+ *   still written synchronously. "OFF" queues all messages. If %NULL,
+ *   defaults to "WARN".
+ * @error: (allow-none): the error location.
+ *
+ * Start writing log messages from a dedicated thread. Must be called
+ * after nm_logging_syslog_openlog(), from the thread that does the
+ * logging. Messages logged from other threads are not affected.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+nm_logging_async_start (const char *sync_level, GError **error)
+{
+	NMLogLevel level = LOGL_WARN;
+	LogRing *ring;
+
+	g_return_val_if_fail (!g_atomic_pointer_get (&log_ring_producer), FALSE);
+	g_return_val_if_fail (global.log_backend != LOG_BACKEND_GLIB, FALSE);
+
+	if (   sync_level
+	    && !match_log_level (sync_level, &level, error))
+		return FALSE;
+
+	if (level == _LOGL_KEEP) {
+		g_set_error (error, NM_MANAGER_ERROR, NM_MANAGER_ERROR_UNKNOWN_LOG_LEVEL,
+		             _("Unknown log level '%s'"), sync_level);
+		return FALSE;
+	}
+
+	ring = g_new0 (LogRing, 1);
+	g_mutex_init (&ring->lock);
+	g_cond_init (&ring->cond);
+	ring->sync_level = level;
+	ring->writer = g_thread_new ("nm-logging", _log_ring_writer_thread, ring);
+
+	g_atomic_pointer_set (&log_ring_producer, g_thread_self ());
+	g_atomic_pointer_set (&log_ring, ring);
+
+	nm_log_dbg (LOGD_CORE, "logging: write messages asynchronously (synchronous from level %s)",
+	            global.level_desc[level].name);
+	return TRUE;
+}
+
+/**
+ * nm_logging_async_stop:
+ *
+ * Write all pending messages and stop the writer thread started by
+ * nm_logging_async_start(). Afterwards, all messages are written
+ * synchronously again.
+ */
+void
+nm_logging_async_stop (void)
+{
+	LogRing *ring;
+
+	if (!g_atomic_pointer_get (&log_ring_producer))
+		return;
+
+	g_return_if_fail (g_atomic_pointer_get (&log_ring_producer) == g_thread_self ());
+
+	ring = g_atomic_pointer_get (&log_ring);
+	g_atomic_pointer_set (&log_ring, NULL);
+	g_atomic_pointer_set (&log_ring_producer, NULL);
+
+	g_mutex_lock (&ring->lock);
+	g_atomic_int_set (&ring->quit, 1);
+	g_cond_broadcast (&ring->cond);
+	g_mutex_unlock (&ring->lock);
+
+	g_thread_join (ring->writer);
+
+	nm_log_dbg (LOGD_CORE, "logging: stop asynchronous writing (%llu messages queued, %llu dropped, at most %u pending)",
+	            (unsigned long long) ring->n_queued,
+	            (unsigned long long) ring->n_dropped,
+	            ring->n_max_fill);
+
+	nm_assert (ring->tail == ring->head);
+	g_mutex_clear (&ring->lock);
+	g_cond_clear (&ring->cond);
+	g_free (ring);
+}
+
+/*****************************************************************************/
+
+void
+_nm_log_impl (const char *file,
+              guint line,
+              const char *func,
+              NMLogLevel level,
+              NMLogDomain domain,
+              int error,
+              const char *ifname,
+              const char *conn_uuid,
+              const char *fmt,
+              ...)
+{
+	va_list args;
+	LogRecord rec;
+	LogRing *ring = NULL;
+	int errno_saved;
+
+	if ((guint) level >= G_N_ELEMENTS (_nm_logging_enabled_state))
+		g_return_if_reached ();
+
+	if (!(_nm_logging_enabled_state[level] & domain))
+		return;
+
+	errno_saved = errno;
+
+	/* Make sure that %m maps to the specified error */
+	if (error != 0) {
+		if (error < 0)
+			error = -error;
+		errno = error;
+	}
+
+	rec = (LogRecord) {
+		.file           = file,
+		.line           = line,
+		.func           = func,
+		.level          = level,
+		.domain         = domain,
+		.domain_enabled = domain & _nm_logging_enabled_state[level],
+		.error          = error,
+	};
+
+	va_start (args, fmt);
+	rec.msg = g_strdup_vprintf (fmt, args);
+	va_end (args);
+
+	g_get_current_time (&rec.tv);
+
+	if (g_atomic_pointer_get (&log_ring_producer) == g_thread_self ())
+		ring = g_atomic_pointer_get (&log_ring);
+
+	if (ring) {
+		if (level < ring->sync_level) {
+			/* @file and @func are string literals, but the other
+			 * arguments must be cloned. */
+			if (global.log_backend == LOG_BACKEND_JOURNAL)
+				rec.now_ns = nm_utils_get_monotonic_timestamp_ns ();
+			rec.ifname = g_strdup (ifname);
+			rec.conn_uuid = g_strdup (conn_uuid);
+			if (!_log_ring_push (ring, &rec))
+				_log_record_clear (&rec);
+			errno = errno_saved;
+			return;
+		}
+		_log_ring_flush (ring);
+	}
 
-	g_free (msg);
+	rec.ifname = (char *) ifname;
+	rec.conn_uuid = (char *) conn_uuid;
+	_log_record_write (&rec);
+	g_free (rec.msg);
 
 	errno = errno_saved;
 }
@@ -163,6 +163,9 @@ void nm_logging_set_prefix (const char *format, ...) _nm_printf (1, 2);
 void     nm_logging_syslog_openlog (const char *logging_backend, gboolean debug);
 gboolean nm_logging_syslog_enabled (void);
 
+gboolean nm_logging_async_start (const char *sync_level, GError **error);
+void     nm_logging_async_stop (void);
+
 /*****************************************************************************/
 
 /* This is the default definition of _NMLOG_ENABLED(). Special implementations
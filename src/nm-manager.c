@@ -28,6 +28,7 @@
 #include <errno.h>
 #include <string.h>
 #include <unistd.h>
+#include <linux/if_infiniband.h>
 
 #include "nm-utils/nm-c-list.h"
 
@@ -61,6 +62,7 @@
 #include "nm-checkpoint-manager.h"
 #include "nm-dbus-object.h"
 #include "nm-dispatcher.h"
+#include "nm-latency.h"
 #include "NetworkManagerUtils.h"
 
 /*****************************************************************************/
@@ -161,6 +163,13 @@ typedef struct {
 
 	CList devices_lst_head;
 
+	/* Indexes over devices_lst_head. Each maps a lookup key to a
+	 * set of NMDevice instances, see _devices_idx_update(). */
+	GHashTable *devices_by_ifindex;
+	GHashTable *devices_by_iface;
+	GHashTable *devices_by_ip_iface;
+	GHashTable *devices_by_perm_hw_addr;
+
 	NMState state;
 	NMConfig *config;
 	NMConnectivity *concheck_mgr;
@@ -173,7 +182,11 @@ typedef struct {
 	} prop_filter;
 	NMRfkillManager *rfkill_mgr;
 
+	/* queue of ifindexes with pending platform link changes, see
+	 * platform_link_cb(). */
 	CList link_cb_lst;
+	GHashTable *link_cb_idx;
+	guint link_cb_idle_id;
 
 	NMCheckpointManager *checkpoint_mgr;
 
@@ -1076,6 +1089,31 @@ _get_activatable_connections_filter (NMSettings *settings,
 	                                NULL);
 }
 
+/**
+ * nm_manager_is_connection_activatable:
+ * @self: the #NMManager
+ * @sett_conn: the settings connection
+ * @for_auto_activation: whether to check for auto-activation
+ *
+ * Returns: %TRUE if @sett_conn would be contained in the list
+ *   returned by nm_manager_get_activatable_connections().
+ */
+gboolean
+nm_manager_is_connection_activatable (NMManager *self,
+                                      NMSettingsConnection *sett_conn,
+                                      gboolean for_auto_activation)
+{
+	const GetActivatableConnectionsFilterData d = {
+		.self = self,
+		.for_auto_activation = for_auto_activation,
+	};
+
+	g_return_val_if_fail (NM_IS_MANAGER (self), FALSE);
+	g_return_val_if_fail (NM_IS_SETTINGS_CONNECTION (sett_conn), FALSE);
+
+	return _get_activatable_connections_filter (NULL, sett_conn, (gpointer) &d);
+}
+
 NMSettingsConnection **
 nm_manager_get_activatable_connections (NMManager *manager,
                                         gboolean for_auto_activation,
@@ -1230,6 +1268,180 @@ impl_manager_reload (NMDBusObject *obj,
 
 /*****************************************************************************/
 
+static char *
+_devices_idx_hwaddr_key (const char *hwaddr)
+{
+	guint8 buf[NM_UTILS_HWADDR_LEN_MAX];
+	gsize len;
+
+	/* Keys are the normalized string representation of the address.
+	 * InfiniBand addresses only compare by their last 8 bytes (see
+	 * nm_utils_hwaddr_matches()), so they are not indexed. */
+	if (   !hwaddr
+	    || !_nm_utils_hwaddr_aton (hwaddr, buf, sizeof (buf), &len)
+	    || len == INFINIBAND_ALEN)
+		return NULL;
+	return nm_utils_hwaddr_ntoa (buf, len);
+}
+
+static void
+_devices_idx_bucket_add (GHashTable *idx, gconstpointer key, gboolean key_is_str, NMDevice *device)
+{
+	GHashTable *bucket;
+
+	bucket = g_hash_table_lookup (idx, key);
+	if (!bucket) {
+		bucket = g_hash_table_new (nm_direct_hash, NULL);
+		g_hash_table_insert (idx,
+		                     key_is_str ? g_strdup (key) : (gpointer) key,
+		                     bucket);
+	}
+	if (!nm_g_hash_table_add (bucket, device))
+		nm_assert_not_reached ();
+}
+
+static void
+_devices_idx_bucket_remove (GHashTable *idx, gconstpointer key, NMDevice *device)
+{
+	GHashTable *bucket;
+
+	bucket = g_hash_table_lookup (idx, key);
+	if (   !bucket
+	    || !g_hash_table_remove (bucket, device))
+		g_return_if_reached ();
+	if (g_hash_table_size (bucket) == 0)
+		g_hash_table_remove (idx, key);
+}
+
+static void
+_devices_idx_remove (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+
+	if (device->_manager_idx.ifindex > 0) {
+		_devices_idx_bucket_remove (priv->devices_by_ifindex,
+		                            GINT_TO_POINTER (device->_manager_idx.ifindex),
+		                            device);
+		device->_manager_idx.ifindex = 0;
+	}
+	if (device->_manager_idx.iface) {
+		_devices_idx_bucket_remove (priv->devices_by_iface, device->_manager_idx.iface, device);
+		nm_clear_g_free (&device->_manager_idx.iface);
+	}
+	if (device->_manager_idx.ip_iface) {
+		_devices_idx_bucket_remove (priv->devices_by_ip_iface, device->_manager_idx.ip_iface, device);
+		nm_clear_g_free (&device->_manager_idx.ip_iface);
+	}
+	if (device->_manager_idx.perm_hw_addr) {
+		_devices_idx_bucket_remove (priv->devices_by_perm_hw_addr, device->_manager_idx.perm_hw_addr, device);
+		nm_clear_g_free (&device->_manager_idx.perm_hw_addr);
+	}
+}
+
+/* Re-sync the index entries of @device with its current properties.
+ *
+ * This is called when the device gets added and from its property
+ * notifications. Note that the device freezes notifications between
+ * nm_device_realize_start() and nm_device_realize_finish(), the queued
+ * notifications re-sync the index once the device is realized. */
+static void
+_devices_idx_update (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	int ifindex;
+	const char *iface;
+	const char *ip_iface;
+	gs_free char *perm_hw_addr = NULL;
+
+	nm_assert (c_list_contains (&priv->devices_lst_head, &device->devices_lst));
+
+	ifindex = nm_device_get_ifindex (device);
+	if (ifindex <= 0)
+		ifindex = 0;
+	if (ifindex != device->_manager_idx.ifindex) {
+		if (device->_manager_idx.ifindex > 0) {
+			_devices_idx_bucket_remove (priv->devices_by_ifindex,
+			                            GINT_TO_POINTER (device->_manager_idx.ifindex),
+			                            device);
+		}
+		device->_manager_idx.ifindex = ifindex;
+		if (ifindex > 0) {
+			_devices_idx_bucket_add (priv->devices_by_ifindex,
+			                         GINT_TO_POINTER (ifindex),
+			                         FALSE,
+			                         device);
+		}
+	}
+
+	iface = nm_device_get_iface (device);
+	if (!nm_streq0 (iface, device->_manager_idx.iface)) {
+		if (device->_manager_idx.iface) {
+			_devices_idx_bucket_remove (priv->devices_by_iface, device->_manager_idx.iface, device);
+			nm_clear_g_free (&device->_manager_idx.iface);
+		}
+		if (iface) {
+			device->_manager_idx.iface = g_strdup (iface);
+			_devices_idx_bucket_add (priv->devices_by_iface, iface, TRUE, device);
+		}
+	}
+
+	ip_iface = nm_device_get_ip_iface (device);
+	if (!nm_streq0 (ip_iface, device->_manager_idx.ip_iface)) {
+		if (device->_manager_idx.ip_iface) {
+			_devices_idx_bucket_remove (priv->devices_by_ip_iface, device->_manager_idx.ip_iface, device);
+			nm_clear_g_free (&device->_manager_idx.ip_iface);
+		}
+		if (ip_iface) {
+			device->_manager_idx.ip_iface = g_strdup (ip_iface);
+			_devices_idx_bucket_add (priv->devices_by_ip_iface, ip_iface, TRUE, device);
+		}
+	}
+
+	/* Don't force the permanent address to be read. If it is not yet
+	 * known, the device will notify the property once it is. */
+	perm_hw_addr = _devices_idx_hwaddr_key (nm_device_get_permanent_hw_address_full (device, FALSE, NULL));
+	if (!nm_streq0 (perm_hw_addr, device->_manager_idx.perm_hw_addr)) {
+		if (device->_manager_idx.perm_hw_addr) {
+			_devices_idx_bucket_remove (priv->devices_by_perm_hw_addr, device->_manager_idx.perm_hw_addr, device);
+			nm_clear_g_free (&device->_manager_idx.perm_hw_addr);
+		}
+		if (perm_hw_addr) {
+			_devices_idx_bucket_add (priv->devices_by_perm_hw_addr, perm_hw_addr, TRUE, device);
+			device->_manager_idx.perm_hw_addr = g_steal_pointer (&perm_hw_addr);
+		}
+	}
+}
+
+/* Returns the single device indexed under @key, or %NULL. If there are
+ * several devices for @key, sets @out_ambiguous and returns %NULL; the
+ * caller then must fall back to iterating devices_lst_head, which keeps
+ * the order in which devices were added. */
+static NMDevice *
+_devices_idx_lookup (GHashTable *idx, gconstpointer key, gboolean *out_ambiguous)
+{
+	GHashTable *bucket;
+	GHashTableIter iter;
+	NMDevice *device;
+
+	*out_ambiguous = FALSE;
+
+	bucket = g_hash_table_lookup (idx, key);
+	if (!bucket)
+		return NULL;
+
+	if (g_hash_table_size (bucket) > 1) {
+		*out_ambiguous = TRUE;
+		return NULL;
+	}
+
+	g_hash_table_iter_init (&iter, bucket);
+	if (!g_hash_table_iter_next (&iter, (gpointer *) &device, NULL))
+		nm_assert_not_reached ();
+	return device;
+}
+
+/*****************************************************************************/
+
 NMDevice *
 nm_manager_get_device_by_path (NMManager *self, const char *path)
 {
@@ -1254,15 +1466,22 @@ nm_manager_get_device_by_ifindex (NMManager *self, int ifindex)
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 	NMDevice *device;
+	gboolean ambiguous;
+
+	if (ifindex <= 0)
+		return NULL;
 
-	if (ifindex > 0) {
+	device = _devices_idx_lookup (priv->devices_by_ifindex, GINT_TO_POINTER (ifindex), &ambiguous);
+	if (ambiguous) {
 		c_list_for_each_entry (device, &priv->devices_lst_head, devices_lst) {
 			if (nm_device_get_ifindex (device) == ifindex)
 				return device;
 		}
+		return NULL;
 	}
 
-	return NULL;
+	nm_assert (!device || nm_device_get_ifindex (device) == ifindex);
+	return device;
 }
 
 static NMDevice *
@@ -1273,12 +1492,24 @@ find_device_by_permanent_hw_addr (NMManager *self, const char *hwaddr)
 	const char *device_addr;
 	guint8 hwaddr_bin[NM_UTILS_HWADDR_LEN_MAX];
 	gsize hwaddr_len;
+	gs_free char *key = NULL;
+	gboolean ambiguous;
 
 	g_return_val_if_fail (hwaddr != NULL, NULL);
 
 	if (!_nm_utils_hwaddr_aton (hwaddr, hwaddr_bin, sizeof (hwaddr_bin), &hwaddr_len))
 		return NULL;
 
+	key = _devices_idx_hwaddr_key (hwaddr);
+	if (key) {
+		device = _devices_idx_lookup (priv->devices_by_perm_hw_addr, key, &ambiguous);
+		if (device)
+			return device;
+	}
+
+	/* The index only knows permanent addresses that were already read.
+	 * Fall back to iterating all devices, which forces reading the
+	 * address of the devices that don't have it yet. */
 	c_list_for_each_entry (device, &priv->devices_lst_head, devices_lst) {
 		device_addr = nm_device_get_permanent_hw_address (device);
 		if (   device_addr
@@ -1293,9 +1524,14 @@ find_device_by_ip_iface (NMManager *self, const char *iface)
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 	NMDevice *device;
+	gboolean ambiguous;
 
 	g_return_val_if_fail (iface, NULL);
 
+	device = _devices_idx_lookup (priv->devices_by_ip_iface, iface, &ambiguous);
+	if (!ambiguous)
+		return device && nm_device_is_real (device) ? device : NULL;
+
 	c_list_for_each_entry (device, &priv->devices_lst_head, devices_lst) {
 		if (   nm_device_is_real (device)
 		    && nm_streq0 (nm_device_get_ip_iface (device), iface))
@@ -1304,6 +1540,22 @@ find_device_by_ip_iface (NMManager *self, const char *iface)
 	return NULL;
 }
 
+static gboolean
+_find_device_by_iface_check (NMDevice *candidate,
+                             NMConnection *connection,
+                             NMConnection *slave)
+{
+	if (connection && !nm_device_check_connection_compatible (candidate, connection, NULL))
+		return FALSE;
+	if (slave) {
+		if (!nm_device_is_master (candidate))
+			return FALSE;
+		if (!nm_device_check_slave_connection_compatible (candidate, slave))
+			return FALSE;
+	}
+	return TRUE;
+}
+
 /**
  * find_device_by_iface:
  * @self: the #NMManager
@@ -1328,21 +1580,24 @@ find_device_by_iface (NMManager *self,
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 	NMDevice *fallback = NULL;
 	NMDevice *candidate;
+	gboolean ambiguous;
 
 	g_return_val_if_fail (iface != NULL, NULL);
 
+	candidate = _devices_idx_lookup (priv->devices_by_iface, iface, &ambiguous);
+	if (!ambiguous) {
+		if (   candidate
+		    && _find_device_by_iface_check (candidate, connection, slave))
+			return candidate;
+		return NULL;
+	}
+
 	c_list_for_each_entry (candidate, &priv->devices_lst_head, devices_lst) {
 
 		if (strcmp (nm_device_get_iface (candidate), iface))
 			continue;
-		if (connection && !nm_device_check_connection_compatible (candidate, connection, NULL))
+		if (!_find_device_by_iface_check (candidate, connection, slave))
 			continue;
-		if (slave) {
-			if (!nm_device_is_master (candidate))
-				continue;
-			if (!nm_device_check_slave_connection_compatible (candidate, slave))
-				continue;
-		}
 
 		if (nm_device_is_real (candidate))
 			return candidate;
@@ -1674,6 +1929,7 @@ remove_device (NMManager *self,
 
 	nm_settings_device_removed (priv->settings, device, quitting);
 
+	_devices_idx_remove (self, device);
 	c_list_unlink (&device->devices_lst);
 
 	_parent_notify_changed (self, device, TRUE);
@@ -1884,9 +2140,19 @@ nm_manager_get_device (NMManager *self, const char *ifname, NMDeviceType device_
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 	NMDevice *device;
 
+	gboolean ambiguous;
+
 	g_return_val_if_fail (ifname, NULL);
 	g_return_val_if_fail (device_type != NM_DEVICE_TYPE_UNKNOWN, NULL);
 
+	device = _devices_idx_lookup (priv->devices_by_iface, ifname, &ambiguous);
+	if (!ambiguous) {
+		if (   device
+		    && nm_device_get_device_type (device) == device_type)
+			return device;
+		return NULL;
+	}
+
 	c_list_for_each_entry (device, &priv->devices_lst_head, devices_lst) {
 		if (   nm_device_get_device_type (device) == device_type
 		    && nm_streq0 (nm_device_get_iface (device), ifname))
@@ -2784,6 +3050,7 @@ device_ifindex_changed (NMDevice *device,
                         GParamSpec *pspec,
                         NMManager *self)
 {
+	_devices_idx_update (self, device);
 	_parent_notify_changed (self, device, FALSE);
 }
 
@@ -2797,11 +3064,17 @@ device_ip_iface_changed (NMDevice *device,
 	NMDeviceType device_type = nm_device_get_device_type (device);
 	NMDevice *candidate;
 
+	_devices_idx_update (self, device);
+
 	/* Remove NMDevice objects that are actually child devices of others,
 	 * when the other device finally knows its IP interface name.  For example,
 	 * remove the PPP interface that's a child of a WWAN device, since it's
 	 * not really a standalone NMDevice.
 	 */
+	if (   !ip_iface
+	    || !g_hash_table_contains (priv->devices_by_iface, ip_iface))
+		return;
+
 	c_list_for_each_entry (candidate, &priv->devices_lst_head, devices_lst) {
 		if (   candidate != device
 		    && g_strcmp0 (nm_device_get_iface (candidate), ip_iface) == 0
@@ -2818,12 +3091,22 @@ device_iface_changed (NMDevice *device,
                       GParamSpec *pspec,
                       NMManager *self)
 {
+	_devices_idx_update (self, device);
+
 	/* Virtual connections may refer to the new device name as
 	 * parent device, retry to activate them.
 	 */
 	retry_connections_for_parent_device (self, device);
 }
 
+static void
+device_perm_hw_addr_changed (NMDevice *device,
+                             GParamSpec *pspec,
+                             NMManager *self)
+{
+	_devices_idx_update (self, device);
+}
+
 static void
 _emit_device_added_removed (NMManager *self,
                             NMDevice *device,
@@ -3013,6 +3296,7 @@ add_device (NMManager *self, NMDevice *device, GError **error)
 
 	nm_assert (c_list_is_empty (&device->devices_lst));
 	c_list_link_tail (&priv->devices_lst_head, &device->devices_lst);
+	_devices_idx_update (self, device);
 
 	g_signal_connect (device, NM_DEVICE_STATE_CHANGED,
 	                  G_CALLBACK (manager_device_state_changed),
@@ -3042,6 +3326,10 @@ add_device (NMManager *self, NMDevice *device, GError **error)
 	                  G_CALLBACK (device_iface_changed),
 	                  self);
 
+	g_signal_connect (device, "notify::" NM_DEVICE_PERM_HW_ADDRESS,
+	                  G_CALLBACK (device_perm_hw_addr_changed),
+	                  self);
+
 	g_signal_connect (device, "notify::" NM_DEVICE_REAL,
 	                  G_CALLBACK (device_realized),
 	                  self);
@@ -3171,6 +3459,9 @@ platform_link_added (NMManager *self,
 	if (nm_manager_get_device_by_ifindex (self, ifindex))
 		return;
 
+	if (!g_hash_table_contains (priv->devices_by_iface, plink->name))
+		goto add;
+
 	/* Let unrealized devices try to realize themselves with the link */
 	c_list_for_each_entry (candidate, &priv->devices_lst_head, devices_lst) {
 		gboolean compatible = TRUE;
@@ -3292,24 +3583,21 @@ add:
 	}
 }
 
+/* How long one invocation of _platform_link_cb_idle() may take before it
+ * yields back to the mainloop. */
+#define PLATFORM_LINK_CB_BUDGET_NSEC (20 * NM_UTILS_NS_PER_MSEC)
+
 typedef struct {
 	CList lst;
-	NMManager *self;
 	int ifindex;
-	guint idle_id;
 } PlatformLinkCbData;
 
-static gboolean
-_platform_link_cb_idle (PlatformLinkCbData *data)
+static void
+_platform_link_handle (NMManager *self, int ifindex)
 {
-	int ifindex = data->ifindex;
-	NMManager *self = data->self;
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 	const NMPlatformLink *plink;
 
-	c_list_unlink_stale (&data->lst);
-	g_slice_free (PlatformLinkCbData, data);
-
 	plink = nm_platform_link_get (priv->platform, ifindex);
 	if (plink) {
 		const NMPObject *plink_keep_alive = nmp_object_ref (NMP_OBJECT_UP_CAST (plink));
@@ -3338,7 +3626,42 @@ _platform_link_cb_idle (PlatformLinkCbData *data)
 			}
 		}
 	}
+}
+
+static gboolean
+_platform_link_cb_idle (gpointer user_data)
+{
+	NMManager *self = user_data;
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	PlatformLinkCbData *data;
+	gint64 deadline;
+	guint n = 0;
+
+	deadline = nm_utils_get_monotonic_timestamp_ns () + PLATFORM_LINK_CB_BUDGET_NSEC;
+
+	while ((data = c_list_first_entry (&priv->link_cb_lst, PlatformLinkCbData, lst))) {
+		int ifindex = data->ifindex;
+
+		/* Always handle at least one link, so that we make progress. */
+		if (   n > 0
+		    && nm_utils_get_monotonic_timestamp_ns () >= deadline) {
+			_LOGT (LOGD_PLATFORM, "link-cb: handled %u links, yield with %u pending",
+			       n, g_hash_table_size (priv->link_cb_idx));
+			return G_SOURCE_CONTINUE;
+		}
+
+		/* Dequeue the link before handling it. Handling it might trigger
+		 * further link changes, which then get queued again. */
+		g_hash_table_remove (priv->link_cb_idx, GINT_TO_POINTER (ifindex));
+		c_list_unlink_stale (&data->lst);
+		g_slice_free (PlatformLinkCbData, data);
+
+		_platform_link_handle (self, ifindex);
+		n++;
+	}
 
+	_LOGT (LOGD_PLATFORM, "link-cb: handled %u links", n);
+	priv->link_cb_idle_id = 0;
 	return G_SOURCE_REMOVE;
 }
 
@@ -3361,11 +3684,18 @@ platform_link_cb (NMPlatform *platform,
 		self = NM_MANAGER (user_data);
 		priv = NM_MANAGER_GET_PRIVATE (self);
 
+		/* The idle handler looks up the current state of the link in the
+		 * platform cache. Hence, when a change for the same ifindex is
+		 * already pending, there is nothing to do: the last state wins. */
+		if (g_hash_table_contains (priv->link_cb_idx, GINT_TO_POINTER (ifindex)))
+			break;
+
 		data = g_slice_new (PlatformLinkCbData);
-		data->self = self;
 		data->ifindex = ifindex;
 		c_list_link_tail (&priv->link_cb_lst, &data->lst);
-		data->idle_id = g_idle_add ((GSourceFunc) _platform_link_cb_idle, data);
+		g_hash_table_insert (priv->link_cb_idx, GINT_TO_POINTER (ifindex), data);
+		if (!priv->link_cb_idle_id)
+			priv->link_cb_idle_id = g_idle_add (_platform_link_cb_idle, self);
 		break;
 	default:
 		break;
@@ -6334,6 +6664,20 @@ impl_manager_get_logging (NMDBusObject *obj,
 	                                                      nm_logging_domains_to_string ()));
 }
 
+static void
+impl_manager_get_latency_statistics (NMDBusObject *obj,
+                                     const NMDBusInterfaceInfoExtended *interface_info,
+                                     const NMDBusMethodInfoExtended *method_info,
+                                     GDBusConnection *connection,
+                                     const char *sender,
+                                     GDBusMethodInvocation *invocation,
+                                     GVariant *parameters)
+{
+	g_dbus_method_invocation_return_value (invocation,
+	                                       g_variant_new ("(@a{sa{sv}})",
+	                                                      nm_latency_to_variant ()));
+}
+
 typedef struct {
 	NMManager *self;
 	GDBusMethodInvocation *context;
@@ -7441,11 +7785,17 @@ nm_manager_init (NMManager *self)
 	GFile *file;
 
 	c_list_init (&priv->link_cb_lst);
+	priv->link_cb_idx = g_hash_table_new (nm_direct_hash, NULL);
 	c_list_init (&priv->devices_lst_head);
 	c_list_init (&priv->active_connections_lst_head);
 	c_list_init (&priv->async_op_lst_head);
 	c_list_init (&priv->delete_volatile_connection_lst_head);
 
+	priv->devices_by_ifindex = g_hash_table_new_full (nm_direct_hash, NULL, NULL, (GDestroyNotify) g_hash_table_unref);
+	priv->devices_by_iface = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+	priv->devices_by_ip_iface = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+	priv->devices_by_perm_hw_addr = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+
 	priv->platform = g_object_ref (NM_PLATFORM_GET);
 
 	priv->capabilities = g_array_new (FALSE, FALSE, sizeof (guint32));
@@ -7696,13 +8046,14 @@ dispose (GObject *object)
 	g_signal_handlers_disconnect_by_func (priv->platform,
 	                                      G_CALLBACK (platform_link_cb),
 	                                      self);
+	nm_clear_g_source (&priv->link_cb_idle_id);
 	c_list_for_each_safe (iter, iter_safe, &priv->link_cb_lst) {
 		PlatformLinkCbData *data = c_list_entry (iter, PlatformLinkCbData, lst);
 
-		g_source_remove (data->idle_id);
 		c_list_unlink_stale (iter);
 		g_slice_free (PlatformLinkCbData, data);
 	}
+	g_hash_table_remove_all (priv->link_cb_idx);
 
 	g_slist_free_full (priv->auth_chains, (GDestroyNotify) nm_auth_chain_destroy);
 	priv->auth_chains = NULL;
@@ -7805,6 +8156,15 @@ finalize (GObject *object)
 
 	g_array_free (priv->capabilities, TRUE);
 
+	g_hash_table_unref (priv->link_cb_idx);
+
+	nm_assert (g_hash_table_size (priv->devices_by_ifindex) == 0);
+	nm_assert (g_hash_table_size (priv->devices_by_iface) == 0);
+	g_hash_table_unref (priv->devices_by_ifindex);
+	g_hash_table_unref (priv->devices_by_iface);
+	g_hash_table_unref (priv->devices_by_ip_iface);
+	g_hash_table_unref (priv->devices_by_perm_hw_addr);
+
 	G_OBJECT_CLASS (nm_manager_parent_class)->finalize (object);
 
 	g_object_unref (priv->platform);
@@ -7980,6 +8340,15 @@ static const NMDBusInterfaceInfoExtended interface_info_manager = {
 				),
 				.handle = impl_manager_get_logging,
 			),
+			NM_DEFINE_DBUS_METHOD_INFO_EXTENDED (
+				NM_DEFINE_GDBUS_METHOD_INFO_INIT (
+					"GetLatencyStatistics",
+					.out_args = NM_DEFINE_GDBUS_ARG_INFOS (
+						NM_DEFINE_GDBUS_ARG_INFO ("statistics", "a{sa{sv}}"),
+					),
+				),
+				.handle = impl_manager_get_latency_statistics,
+			),
 			NM_DEFINE_DBUS_METHOD_INFO_EXTENDED (
 				NM_DEFINE_GDBUS_METHOD_INFO_INIT (
 					"CheckConnectivity",
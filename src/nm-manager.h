@@ -110,6 +110,10 @@ const CList * nm_manager_get_active_connections        (NMManager *manager);
 	     }); \
 	    )
 
+gboolean nm_manager_is_connection_activatable (NMManager *self,
+                                               NMSettingsConnection *sett_conn,
+                                               gboolean for_auto_activation);
+
 NMSettingsConnection **nm_manager_get_activatable_connections (NMManager *manager,
                                                                gboolean for_auto_activation,
                                                                gboolean sort,
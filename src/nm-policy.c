@@ -67,13 +67,30 @@ typedef struct {
 	NMManager *manager;
 	NMNetns *netns;
 	NMFirewallManager *firewall_manager;
+
+	/* devices waiting for an auto-activation check. They are all processed
+	 * together by auto_activate_batch_cb(). */
 	CList pending_activation_checks;
+	GHashTable *pending_activation_checks_by_device;
+	guint autoactivate_batch_id;
+
+	struct {
+		guint64 requests;
+		guint64 coalesced;
+		guint64 batches;
+		guint64 checks;
+	} autoactivate_stats;
 
 	NMAgentManager *agent_mgr;
 
 	GHashTable *devices;
 	GHashTable *pending_active_connections;
 
+	/* NMDevice -> AutoconnectCandidates. A cache of the profiles which might
+	 * auto-activate on a device. */
+	GHashTable *autoconnect_candidates;
+	guint autoconnect_candidates_generation;
+
 	GSList *pending_secondaries;
 
 	NMSettings *settings;
@@ -1155,17 +1172,19 @@ check_activating_active_connections (NMPolicy *self)
 
 typedef struct {
 	CList pending_lst;
-	NMPolicy *policy;
 	NMDevice *device;
-	guint autoactivate_id;
+	bool in_progress:1;
 } ActivateData;
 
 static void
-activate_data_free (ActivateData *data)
+activate_data_free (NMPolicy *self, ActivateData *data)
 {
+	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
+
 	nm_device_remove_pending_action (data->device, NM_PENDING_ACTION_AUTOACTIVATE, TRUE);
 	c_list_unlink_stale (&data->pending_lst);
-	nm_clear_g_source (&data->autoactivate_id);
+	if (!g_hash_table_remove (priv->pending_activation_checks_by_device, data->device))
+		nm_assert_not_reached ();
 	g_object_unref (data->device);
 	g_slice_free (ActivateData, data);
 }
@@ -1211,15 +1230,167 @@ pending_ac_state_changed (NMActiveConnection *ac, guint state, guint reason, NMP
 	}
 }
 
+/*****************************************************************************/
+
+typedef struct {
+	char *iface;
+	NMSettingsConnection **list;
+	guint len;
+	guint generation;
+} AutoconnectCandidates;
+
+static void
+_autoconnect_candidates_free (gpointer data)
+{
+	AutoconnectCandidates *candidates = data;
+
+	g_free (candidates->iface);
+	g_free (candidates->list);
+	g_slice_free (AutoconnectCandidates, candidates);
+}
+
+static void
+_autoconnect_candidates_invalidate (NMPolicy *self)
+{
+	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
+
+	/* the cached lists contain dangling pointers now. They must
+	 * not be used until they are rebuilt. */
+	priv->autoconnect_candidates_generation++;
+}
+
+static gboolean
+_autoconnect_candidates_filter (NMSettings *settings,
+                                NMSettingsConnection *sett_conn,
+                                gpointer user_data)
+{
+	NMDevice *device = user_data;
+	NMConnection *connection = nm_settings_connection_get_connection (sett_conn);
+	const char *type_check_compatible;
+	NMSettingConnection *s_con;
+	NMSettingMatch *s_match;
+
+	/* This only performs the cheap checks of nm_device_check_connection_compatible()
+	 * that solely depend on the profile and the name and type of the device. */
+
+	s_con = nm_connection_get_setting_connection (connection);
+	if (!nm_setting_connection_get_autoconnect (s_con))
+		return FALSE;
+
+	type_check_compatible = NM_DEVICE_GET_CLASS (device)->connection_type_check_compatible;
+	if (   type_check_compatible
+	    && !nm_connection_is_type (connection, type_check_compatible))
+		return FALSE;
+
+	s_match = (NMSettingMatch *) nm_connection_get_setting (connection, NM_TYPE_SETTING_MATCH);
+	if (s_match) {
+		const char *const *patterns;
+		guint num_patterns;
+
+		patterns = nm_setting_match_get_interface_names (s_match, &num_patterns);
+		if (!nm_wildcard_match_check (nm_device_get_iface (device), patterns, num_patterns))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* _autoconnect_candidates_get:
+ * @self: the #NMPolicy
+ * @device: the device
+ * @out_len: the number of returned candidates
+ *
+ * Returns the profiles which can possibly autoconnect on @device.
+ * That are the profiles that have autoconnect enabled, and whose interface-name,
+ * type and match settings are compatible with the device. The result is cached
+ * per device and rebuilt when a profile is added, changed or removed, or when the
+ * interface name of the device changes. The more expensive checks that depend on
+ * the runtime state of the device are still left to nm_device_can_auto_connect().
+ *
+ * Returns: (transfer none): the list of candidates, in no particular order.
+ *   It is only valid until the next change of the settings.
+ */
+static NMSettingsConnection *const*
+_autoconnect_candidates_get (NMPolicy *self, NMDevice *device, guint *out_len)
+{
+	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
+	AutoconnectCandidates *candidates;
+	const char *iface = nm_device_get_iface (device);
+
+	candidates = g_hash_table_lookup (priv->autoconnect_candidates, device);
+	if (   candidates
+	    && candidates->generation == priv->autoconnect_candidates_generation
+	    && nm_streq0 (candidates->iface, iface)) {
+		*out_len = candidates->len;
+		return candidates->list;
+	}
+
+	if (!candidates) {
+		candidates = g_slice_new0 (AutoconnectCandidates);
+		g_hash_table_insert (priv->autoconnect_candidates, device, candidates);
+	} else {
+		nm_clear_g_free (&candidates->iface);
+		nm_clear_g_free (&candidates->list);
+	}
+
+	candidates->iface = g_strdup (iface);
+	candidates->generation = priv->autoconnect_candidates_generation;
+	candidates->list = nm_settings_get_connections_clone_for_ifname (priv->settings,
+	                                                                 iface,
+	                                                                 &candidates->len,
+	                                                                 _autoconnect_candidates_filter,
+	                                                                 device,
+	                                                                 NULL,
+	                                                                 NULL);
+
+	_LOGT (LOGD_DEVICE, "auto-activate: %u candidate profiles for device %s",
+	       candidates->len, iface ?: "(null)");
+
+	*out_len = candidates->len;
+	return candidates->list;
+}
+
+/*****************************************************************************/
+
+static int
+_autoconnect_rank_cmp (gconstpointer pa, gconstpointer pb, gpointer user_data)
+{
+	GHashTable *rank = user_data;
+	NMSettingsConnection *a = *((NMSettingsConnection **) pa);
+	NMSettingsConnection *b = *((NMSettingsConnection **) pb);
+	guint ra, rb;
+
+	ra = GPOINTER_TO_UINT (g_hash_table_lookup (rank, a));
+	rb = GPOINTER_TO_UINT (g_hash_table_lookup (rank, b));
+
+	/* profiles that were added after the rank was built have none (0).
+	 * Compare them like auto_activate_device() does without rank, which
+	 * also gives the order the rank was built from. */
+	if (   ra
+	    && rb
+	    && ra != rb)
+		return ra < rb ? -1 : 1;
+	return nm_settings_connection_cmp_autoconnect_priority (a, b);
+}
+
+/* auto_activate_device:
+ * @self: the #NMPolicy
+ * @device: the device to check
+ * @rank: (allow-none): the autoconnect order of the candidate profiles, as
+ *   computed once per batch by _autoconnect_rank_build(). If %NULL, the
+ *   candidates are sorted by nm_settings_connection_cmp_autoconnect_priority().
+ */
 static void
 auto_activate_device (NMPolicy *self,
-                      NMDevice *device)
+                      NMDevice *device,
+                      GHashTable *rank)
 {
 	NMPolicyPrivate *priv;
 	NMSettingsConnection *best_connection;
 	gs_free char *specific_object = NULL;
 	gs_free NMSettingsConnection **connections = NULL;
-	guint i, len;
+	NMSettingsConnection *const*candidates;
+	guint i, len, n_candidates;
 	gs_free_error GError *error = NULL;
 	gs_unref_object NMAuthSubject *subject = NULL;
 	NMActiveConnection *ac;
@@ -1239,10 +1410,29 @@ auto_activate_device (NMPolicy *self,
 	if (!nm_device_autoconnect_allowed (device))
 		return;
 
-	connections = nm_manager_get_activatable_connections (priv->manager, TRUE, TRUE, &len);
-	if (!connections[0])
+	candidates = _autoconnect_candidates_get (self, device, &n_candidates);
+	if (n_candidates == 0)
 		return;
 
+	connections = g_new (NMSettingsConnection *, n_candidates + 1);
+	for (i = 0, len = 0; i < n_candidates; i++) {
+		if (nm_manager_is_connection_activatable (priv->manager, candidates[i], TRUE))
+			connections[len++] = candidates[i];
+	}
+	connections[len] = NULL;
+	if (len == 0)
+		return;
+
+	if (len > 1) {
+		if (rank) {
+			g_qsort_with_data (connections, len, sizeof (NMSettingsConnection *),
+			                   _autoconnect_rank_cmp, rank);
+		} else {
+			g_qsort_with_data (connections, len, sizeof (NMSettingsConnection *),
+			                   nm_settings_connection_cmp_autoconnect_priority_p_with_data, NULL);
+		}
+	}
+
 	/* Find the first connection that should be auto-activated */
 	best_connection = NULL;
 	for (i = 0; i < len; i++) {
@@ -1311,18 +1501,101 @@ auto_activate_device (NMPolicy *self,
 	}
 }
 
+/* _autoconnect_rank_build:
+ *
+ * Sorts the union of the candidate profiles of all pending devices once
+ * by autoconnect priority. The result maps each profile to its (1-based)
+ * position, so that every device of the batch can order its candidates
+ * by a cheap integer comparison. */
+static GHashTable *
+_autoconnect_rank_build (NMPolicy *self)
+{
+	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
+	gs_free NMSettingsConnection **list = NULL;
+	GHashTable *rank;
+	GHashTableIter iter;
+	ActivateData *data;
+	gpointer sett_conn;
+	guint i, len;
+
+	rank = g_hash_table_new (nm_direct_hash, NULL);
+
+	c_list_for_each_entry (data, &priv->pending_activation_checks, pending_lst) {
+		NMSettingsConnection *const*candidates;
+		guint n_candidates;
+
+		candidates = _autoconnect_candidates_get (self, data->device, &n_candidates);
+		for (i = 0; i < n_candidates; i++)
+			g_hash_table_add (rank, candidates[i]);
+	}
+
+	len = g_hash_table_size (rank);
+	if (len == 0)
+		return rank;
+
+	list = g_new (NMSettingsConnection *, len);
+	i = 0;
+	g_hash_table_iter_init (&iter, rank);
+	while (g_hash_table_iter_next (&iter, &sett_conn, NULL))
+		list[i++] = sett_conn;
+
+	g_qsort_with_data (list, len, sizeof (NMSettingsConnection *),
+	                   nm_settings_connection_cmp_autoconnect_priority_p_with_data, NULL);
+
+	for (i = 0; i < len; i++)
+		g_hash_table_insert (rank, list[i], GUINT_TO_POINTER (i + 1));
+	return rank;
+}
+
 static gboolean
-auto_activate_device_cb (gpointer user_data)
+auto_activate_batch_cb (gpointer user_data)
 {
-	ActivateData *data = user_data;
+	NMPolicy *self = user_data;
+	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
+	gs_unref_hashtable GHashTable *rank = NULL;
+	guint rank_generation = 0;
+	ActivateData *data;
+	guint n, n_checked = 0;
+
+	priv->autoactivate_batch_id = 0;
+	priv->autoactivate_stats.batches++;
+
+	/* Only handle the devices that are pending when the batch starts. Devices that
+	 * get scheduled while processing the batch, are handled by the next one. */
+	n = g_hash_table_size (priv->pending_activation_checks_by_device);
+	while (   n-- > 0
+	       && (data = c_list_first_entry (&priv->pending_activation_checks, ActivateData, pending_lst))) {
+		/* activating a profile might change the settings. In that case, the
+		 * rank contains dangling pointers and must be rebuilt. */
+		if (   !rank
+		    || rank_generation != priv->autoconnect_candidates_generation) {
+			g_clear_pointer (&rank, g_hash_table_unref);
+			rank = _autoconnect_rank_build (self);
+			rank_generation = priv->autoconnect_candidates_generation;
+		}
 
-	g_assert (data);
-	g_assert (NM_IS_POLICY (data->policy));
-	g_assert (NM_IS_DEVICE (data->device));
+		/* While the check is in progress, further requests for the device are
+		 * coalesced into this one. */
+		data->in_progress = TRUE;
+		auto_activate_device (self, data->device, rank);
+		activate_data_free (self, data);
+		n_checked++;
+	}
+
+	priv->autoactivate_stats.checks += n_checked;
+
+	_LOGD (LOGD_DEVICE, "auto-activate: checked %u devices in batch (%"G_GUINT64_FORMAT" requests, "
+	       "%"G_GUINT64_FORMAT" coalesced, %"G_GUINT64_FORMAT" checks in %"G_GUINT64_FORMAT" batches so far)",
+	       n_checked,
+	       priv->autoactivate_stats.requests,
+	       priv->autoactivate_stats.coalesced,
+	       priv->autoactivate_stats.checks,
+	       priv->autoactivate_stats.batches);
+
+	if (   !c_list_is_empty (&priv->pending_activation_checks)
+	    && !priv->autoactivate_batch_id)
+		priv->autoactivate_batch_id = g_idle_add (auto_activate_batch_cb, self);
 
-	data->autoactivate_id = 0;
-	auto_activate_device (data->policy, data->device);
-	activate_data_free (data);
 	return G_SOURCE_REMOVE;
 }
 
@@ -1330,13 +1603,8 @@ static ActivateData *
 find_pending_activation (NMPolicy *self, NMDevice *device)
 {
 	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
-	ActivateData *data;
 
-	c_list_for_each_entry (data, &priv->pending_activation_checks, pending_lst) {
-		if (data->device == device)
-			return data;
-	}
-	return NULL;
+	return g_hash_table_lookup (priv->pending_activation_checks_by_device, device);
 }
 
 /*****************************************************************************/
@@ -1515,8 +1783,12 @@ schedule_activate_check (NMPolicy *self, NMDevice *device)
 	if (!nm_device_autoconnect_allowed (device))
 		return;
 
-	if (find_pending_activation (self, device))
+	priv->autoactivate_stats.requests++;
+
+	if (find_pending_activation (self, device)) {
+		priv->autoactivate_stats.coalesced++;
 		return;
+	}
 
 	nm_manager_for_each_active_connection (priv->manager, ac, tmp_list) {
 		if (nm_active_connection_get_device (ac) == device)
@@ -1526,10 +1798,12 @@ schedule_activate_check (NMPolicy *self, NMDevice *device)
 	nm_device_add_pending_action (device, NM_PENDING_ACTION_AUTOACTIVATE, TRUE);
 
 	data = g_slice_new0 (ActivateData);
-	data->policy = self;
 	data->device = g_object_ref (device);
-	data->autoactivate_id = g_idle_add (auto_activate_device_cb, data);
 	c_list_link_tail (&priv->pending_activation_checks, &data->pending_lst);
+	g_hash_table_insert (priv->pending_activation_checks_by_device, device, data);
+
+	if (!priv->autoactivate_batch_id)
+		priv->autoactivate_batch_id = g_idle_add (auto_activate_batch_cb, self);
 }
 
 static gboolean
@@ -2077,12 +2351,14 @@ device_removed (NMManager *manager, NMDevice *device, gpointer user_data)
 
 	/* Clear any idle callbacks for this device */
 	data = find_pending_activation (self, device);
-	if (data && data->autoactivate_id)
-		activate_data_free (data);
+	if (data && !data->in_progress)
+		activate_data_free (self, data);
 
 	if (g_hash_table_remove (priv->devices, device))
 		devices_list_unregister (self, device);
 
+	g_hash_table_remove (priv->autoconnect_candidates, device);
+
 	/* Don't update routing and DNS here as we've already handled that
 	 * for devices that need it when the device's state changed to UNMANAGED.
 	 */
@@ -2316,6 +2592,7 @@ connection_added (NMSettings *settings,
 	NMPolicyPrivate *priv = user_data;
 	NMPolicy *self = _PRIV_TO_SELF (priv);
 
+	_autoconnect_candidates_invalidate (self);
 	schedule_activate_all (self);
 }
 
@@ -2390,6 +2667,8 @@ connection_updated (NMSettings *settings,
 	NMDevice *device = NULL;
 	NMDevice *dev;
 
+	_autoconnect_candidates_invalidate (self);
+
 	if (by_user) {
 		/* find device with given connection */
 		nm_manager_for_each_device (priv->manager, dev, tmp_lst) {
@@ -2445,9 +2724,23 @@ connection_removed (NMSettings *settings,
 	NMPolicyPrivate *priv = user_data;
 	NMPolicy *self = _PRIV_TO_SELF (priv);
 
+	_autoconnect_candidates_invalidate (self);
 	_deactivate_if_active (self, connection);
 }
 
+static void
+settings_connections_changed (NMSettings *settings,
+                              GParamSpec *pspec,
+                              gpointer user_data)
+{
+	NMPolicyPrivate *priv = user_data;
+	NMPolicy *self = _PRIV_TO_SELF (priv);
+
+	/* this is also notified after the initial loading of the profiles, which
+	 * does not emit individual connection-added signals. */
+	_autoconnect_candidates_invalidate (self);
+}
+
 static void
 connection_flags_changed (NMSettings *settings,
                           NMSettingsConnection *connection,
@@ -2590,6 +2883,8 @@ nm_policy_init (NMPolicy *self)
 
 	priv->devices = g_hash_table_new (nm_direct_hash, NULL);
 	priv->pending_active_connections = g_hash_table_new (nm_direct_hash, NULL);
+	priv->autoconnect_candidates = g_hash_table_new_full (nm_direct_hash, NULL, NULL, _autoconnect_candidates_free);
+	priv->pending_activation_checks_by_device = g_hash_table_new (nm_direct_hash, NULL);
 	priv->ip6_prefix_delegations = g_array_new (FALSE, FALSE, sizeof (IP6PrefixDelegation));
 	g_array_set_clear_func (priv->ip6_prefix_delegations, clear_ip6_prefix_delegation);
 }
@@ -2639,6 +2934,7 @@ constructed (GObject *object)
 	g_signal_connect (priv->settings, NM_SETTINGS_SIGNAL_CONNECTION_UPDATED,       (GCallback) connection_updated, priv);
 	g_signal_connect (priv->settings, NM_SETTINGS_SIGNAL_CONNECTION_REMOVED,       (GCallback) connection_removed, priv);
 	g_signal_connect (priv->settings, NM_SETTINGS_SIGNAL_CONNECTION_FLAGS_CHANGED, (GCallback) connection_flags_changed, priv);
+	g_signal_connect (priv->settings, "notify::" NM_SETTINGS_CONNECTIONS,            (GCallback) settings_connections_changed, priv);
 
 	g_signal_connect (priv->agent_mgr, NM_AGENT_MANAGER_AGENT_REGISTERED, G_CALLBACK (secret_agent_registered), self);
 
@@ -2679,7 +2975,8 @@ dispose (GObject *object)
 	g_clear_pointer (&priv->pending_active_connections, g_hash_table_unref);
 
 	c_list_for_each_entry_safe (data, data_safe, &priv->pending_activation_checks, pending_lst)
-		activate_data_free (data);
+		activate_data_free (self, data);
+	nm_clear_g_source (&priv->autoactivate_batch_id);
 
 	g_slist_free_full (priv->pending_secondaries, (GDestroyNotify) pending_secondary_data_free);
 	priv->pending_secondaries = NULL;
@@ -2752,6 +3049,8 @@ finalize (GObject *object)
 	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
 
 	g_hash_table_unref (priv->devices);
+	g_hash_table_unref (priv->autoconnect_candidates);
+	g_hash_table_unref (priv->pending_activation_checks_by_device);
 
 	G_OBJECT_CLASS (nm_policy_parent_class)->finalize (object);
 
@@ -0,0 +1,144 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-trace.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/*****************************************************************************/
+
+/* the ring has 64K entries (2 MiB). */
+#define TRACE_N_RECORDS (64 * 1024)
+
+NMTraceHeader *_nm_trace_header;
+
+/*****************************************************************************/
+
+void
+_nm_trace_record (NMTraceEvent event,
+                  int ifindex,
+                  guint8 obj_type,
+                  guint8 arg,
+                  guint32 seq,
+                  guint32 value,
+                  gint64 start_ns)
+{
+	NMTraceHeader *header = _nm_trace_header;
+	NMTraceRecord *record;
+	gint64 now_ns;
+
+	nm_assert (header);
+
+	now_ns = nm_utils_get_monotonic_timestamp_ns ();
+
+	record = &((NMTraceRecord *) &header[1])[header->head % header->n_records];
+
+	*record = (NMTraceRecord) {
+		.timestamp_ns = now_ns,
+		.duration_ns  = start_ns > 0
+		                ? (guint32) MIN (now_ns - start_ns, (gint64) G_MAXUINT32)
+		                : 0,
+		.seq          = seq,
+		.ifindex      = ifindex,
+		.value        = value,
+		.event        = event,
+		.obj_type     = obj_type,
+		.arg          = arg,
+	};
+
+	/* a concurrent reader of the file must ignore the record at
+	 * @head, it might be incomplete. */
+	header->head++;
+}
+
+/**
+ * nm_trace_setup:
+ * @path: the name of the trace file.
+ * @error: (allow-none): the error location.
+ *
+ * Start recording trace events into the file @path. An existing file
+ * is overwritten, so that restarts don't accumulate old traces. The
+ * header records the PID of the writer. @path must not be a symlink.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+nm_trace_setup (const char *path, GError **error)
+{
+	NMTraceHeader *header;
+	gsize size;
+	gint64 now_ns;
+	int errsv;
+	int fd;
+
+	g_return_val_if_fail (path, FALSE);
+	g_return_val_if_fail (!_nm_trace_header, FALSE);
+
+	size = sizeof (NMTraceHeader) + TRACE_N_RECORDS * sizeof (NMTraceRecord);
+
+	fd = open (path, O_RDWR | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+	if (fd < 0) {
+		errsv = errno;
+		g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+		             "failed to open trace file \"%s\": %s",
+		             path, g_strerror (errsv));
+		return FALSE;
+	}
+
+	if (ftruncate (fd, size) < 0) {
+		errsv = errno;
+		nm_close (fd);
+		g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+		             "failed to resize trace file \"%s\": %s",
+		             path, g_strerror (errsv));
+		return FALSE;
+	}
+
+	header = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	errsv = errno;
+	nm_close (fd);
+	if (header == MAP_FAILED) {
+		g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+		             "failed to map trace file \"%s\": %s",
+		             path, g_strerror (errsv));
+		return FALSE;
+	}
+
+	now_ns = nm_utils_get_monotonic_timestamp_ns ();
+
+	memcpy (header->magic, NM_TRACE_MAGIC, sizeof (NM_TRACE_MAGIC));
+	header->version = NM_TRACE_VERSION;
+	header->record_size = sizeof (NMTraceRecord);
+	header->n_records = TRACE_N_RECORDS;
+	header->pid = getpid ();
+	header->head = 0;
+	header->monotonic_start_ns = now_ns;
+	header->realtime_start_us = g_get_real_time ();
+	header->boottime_offset_ns = nm_utils_monotonic_timestamp_as_boottime (now_ns, 1) - now_ns;
+
+	_nm_trace_header = header;
+
+	nm_log_info (LOGD_CORE, "trace: recording events to \"%s\"", path);
+	return TRUE;
+}
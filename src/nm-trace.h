@@ -0,0 +1,149 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2018 Red Hat, Inc.
+ */
+
+#ifndef __NM_TRACE_H__
+#define __NM_TRACE_H__
+
+#include "nm-utils/nm-time-utils.h"
+
+/*****************************************************************************/
+
+/* Binary event tracing.
+ *
+ * Events are written as fixed-size records into a ring buffer that is
+ * mmap'ed from a file. That is much cheaper than logging at trace level,
+ * so it can be left enabled. The file is decoded offline with
+ * tools/nm-trace-decode.py.
+ *
+ * The file layout is a NMTraceHeader, followed by @n_records
+ * NMTraceRecord entries. The record for event number N is at index
+ * (N % @n_records), @head is the number of events written so far. All
+ * fields are in host byte order. */
+
+#define NM_TRACE_MAGIC     "NMTRACE"
+#define NM_TRACE_VERSION   1
+
+typedef enum {
+	NM_TRACE_EVENT_NONE                 = 0,
+
+	/* a netlink request was sent and NMPlatform waits for the response.
+	 * @seq: the sequence number. */
+	NM_TRACE_EVENT_NETLINK_REQUEST      = 1,
+
+	/* the response for a netlink request was received (or timed out).
+	 * @seq: the sequence number, @value: the WaitForNlResponseResult,
+	 * @duration: the time since the request was sent. */
+	NM_TRACE_EVENT_NETLINK_RESPONSE     = 2,
+
+	/* a netlink message was received and processed.
+	 * @seq: the sequence number, @value: the nlmsg_type,
+	 * @duration: the time for parsing the message and updating the cache. */
+	NM_TRACE_EVENT_NETLINK_MSG          = 3,
+
+	/* the platform cache changed.
+	 * @obj_type: the NMPObjectType, @arg: the NMPCacheOpsType,
+	 * @ifindex: the ifindex of the object, if any. */
+	NM_TRACE_EVENT_CACHE_UPDATE         = 4,
+
+	/* the state of a device changed.
+	 * @arg: the new NMDeviceState, @value: the old state in the lower 16
+	 * bits and the NMDeviceStateReason in the upper 16 bits, @duration:
+	 * the time spent in the old state. */
+	NM_TRACE_EVENT_DEVICE_STATE         = 5,
+
+	/* a device processed a change of its platform link.
+	 * @duration: the processing time. */
+	NM_TRACE_EVENT_DEVICE_LINK_CHANGED  = 6,
+} NMTraceEvent;
+
+typedef struct {
+	char magic[8];
+	guint32 version;
+	guint32 record_size;
+	guint32 n_records;
+	guint32 pid;
+
+	/* the number of records written so far. */
+	guint64 head;
+
+	/* timestamps when the trace was started, to convert the record
+	 * timestamps (see nm_utils_get_monotonic_timestamp_ns()) to
+	 * wall clock and CLOCK_BOOTTIME. */
+	gint64 monotonic_start_ns;
+	gint64 realtime_start_us;
+	gint64 boottime_offset_ns;
+
+	guint8 _reserved[8];
+} NMTraceHeader;
+
+typedef struct {
+	gint64 timestamp_ns;
+	guint32 duration_ns;
+	guint32 seq;
+	gint32 ifindex;
+	guint32 value;
+	guint16 event;
+	guint8 obj_type;
+	guint8 arg;
+	guint8 _reserved[4];
+} NMTraceRecord;
+
+G_STATIC_ASSERT (sizeof (NMTraceHeader) == 64);
+G_STATIC_ASSERT (sizeof (NMTraceRecord) == 32);
+
+/*****************************************************************************/
+
+extern NMTraceHeader *_nm_trace_header;
+
+static inline gboolean
+nm_trace_enabled (void)
+{
+	return G_UNLIKELY (!!_nm_trace_header);
+}
+
+/* a timestamp to measure durations, only when tracing is enabled. */
+static inline gint64
+nm_trace_start (void)
+{
+	return nm_trace_enabled ()
+	       ? nm_utils_get_monotonic_timestamp_ns ()
+	       : 0;
+}
+
+void _nm_trace_record (NMTraceEvent event,
+                       int ifindex,
+                       guint8 obj_type,
+                       guint8 arg,
+                       guint32 seq,
+                       guint32 value,
+                       gint64 start_ns);
+
+/* Record an event. If @start_ns is set (see nm_trace_start()), the
+ * duration since then is recorded. Must only be called from the
+ * main thread. */
+#define nm_trace(event, ifindex, obj_type, arg, seq, value, start_ns) \
+	G_STMT_START { \
+		if (nm_trace_enabled ()) \
+			_nm_trace_record ((event), (ifindex), (obj_type), (arg), (seq), (value), (start_ns)); \
+	} G_STMT_END
+
+gboolean nm_trace_setup (const char *path, GError **error);
+
+#endif /* __NM_TRACE_H__ */
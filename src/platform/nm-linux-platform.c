@@ -58,6 +58,8 @@
 #include "nm-utils/unaligned.h"
 #include "nm-utils/nm-io-utils.h"
 #include "nm-utils/nm-udev-utils.h"
+#include "nm-latency.h"
+#include "nm-trace.h"
 
 /*****************************************************************************/
 
@@ -350,6 +352,7 @@ typedef struct {
 	guint32 seq_number;
 	WaitForNlResponseResult seq_result;
 	DelayedActionWaitForNlResponseType response_type;
+	gint64 start_ns;
 	gint64 timeout_abs_ns;
 	WaitForNlResponseResult *out_seq_result;
 	char **out_errmsg;
@@ -366,6 +369,11 @@ typedef struct {
 	struct nl_sock *genl;
 
 	struct nl_sock *nlh;
+	struct nl_recvbuf *nlh_recvbuf;
+
+	/* whether a datagram from @nlh_recvbuf is being processed. */
+	bool nlh_recvbuf_busy;
+
 	guint32 nlh_seq_next;
 #if NM_MORE_LOGGING
 	guint32 nlh_seq_last_handled;
@@ -4428,6 +4436,12 @@ delayed_action_wait_for_nl_response_complete (NMPlatform *platform,
 	data = &g_array_index (priv->delayed_action.list_wait_for_nl_response, DelayedActionWaitForNlResponseData, idx);
 
 	_LOGt_delayed_action (DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE, data, "complete");
+	nm_trace (NM_TRACE_EVENT_NETLINK_RESPONSE, 0, 0, 0, data->seq_number, (guint32) seq_result, data->start_ns);
+	if (NM_IN_SET (seq_result, WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK,
+	                           WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_UNKNOWN,
+	                           WAIT_FOR_NL_RESPONSE_RESULT_FAILED_TIMEOUT)
+	    || seq_result < 0)
+		nm_latency_record (NM_LATENCY_NETLINK_REQUEST, data->start_ns);
 
 	if (priv->delayed_action.list_wait_for_nl_response->len <= 1)
 		priv->delayed_action.flags &= ~DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE;
@@ -4693,15 +4707,19 @@ delayed_action_schedule_WAIT_FOR_NL_RESPONSE (NMPlatform *platform,
                                               DelayedActionWaitForNlResponseType response_type,
                                               gpointer response_out_data)
 {
+	const gint64 now_ns = nm_utils_get_monotonic_timestamp_ns ();
 	DelayedActionWaitForNlResponseData data = {
 		.seq_number = seq_number,
-		.timeout_abs_ns = nm_utils_get_monotonic_timestamp_ns () + (200 * (NM_UTILS_NS_PER_SECOND / 1000)),
+		.start_ns = now_ns,
+		.timeout_abs_ns = now_ns + (200 * (NM_UTILS_NS_PER_SECOND / 1000)),
 		.out_seq_result = out_seq_result,
 		.out_errmsg = out_errmsg,
 		.response_type = response_type,
 		.response.out_data = response_out_data,
 	};
 
+	nm_trace (NM_TRACE_EVENT_NETLINK_REQUEST, 0, 0, 0, seq_number, 0, 0);
+
 	delayed_action_schedule (platform,
 	                         DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE,
 	                         &data);
@@ -4785,6 +4803,14 @@ cache_on_change (NMPlatform *platform,
 	           ? nmp_object_to_string (obj_new, NMP_OBJECT_TO_STRING_ALL, str_buf, sizeof (str_buf))
 	           : ""));
 
+	nm_trace (NM_TRACE_EVENT_CACHE_UPDATE,
+	          (obj_new ?: obj_old)->object.ifindex,
+	          klass->obj_type,
+	          cache_op,
+	          0,
+	          0,
+	          0);
+
 	switch (klass->obj_type) {
 	case NMP_OBJECT_TYPE_LINK:
 		{
@@ -5507,35 +5533,19 @@ do_add_link_with_lookup (NMPlatform *platform,
 }
 
 static int
-do_add_addrroute (NMPlatform *platform,
-                  const NMPObject *obj_id,
-                  struct nl_msg *nlmsg,
-                  gboolean suppress_netlink_failure)
+do_add_addrroute_handle_result (NMPlatform *platform,
+                                const NMPObject *obj_id,
+                                WaitForNlResponseResult seq_result,
+                                const char *errmsg,
+                                gboolean suppress_netlink_failure,
+                                gboolean *out_need_refetch)
 {
-	WaitForNlResponseResult seq_result = WAIT_FOR_NL_RESPONSE_RESULT_UNKNOWN;
-	gs_free char *errmsg = NULL;
-	int nle;
 	char s_buf[256];
 
-	nm_assert (NM_IN_SET (NMP_OBJECT_GET_TYPE (obj_id),
-	                      NMP_OBJECT_TYPE_IP4_ADDRESS, NMP_OBJECT_TYPE_IP6_ADDRESS,
-	                      NMP_OBJECT_TYPE_IP4_ROUTE, NMP_OBJECT_TYPE_IP6_ROUTE));
-
-	event_handler_read_netlink (platform, FALSE);
-
-	nle = _nl_send_nlmsg (platform, nlmsg, &seq_result, &errmsg, DELAYED_ACTION_RESPONSE_TYPE_VOID, NULL);
-	if (nle < 0) {
-		_LOGE ("do-add-%s[%s]: failure sending netlink request \"%s\" (%d)",
-		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
-		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
-		       nm_strerror (nle), -nle);
-		return -NME_PL_NETLINK;
-	}
-
-	delayed_action_handle_all (platform, FALSE);
-
 	nm_assert (seq_result);
 
+	*out_need_refetch = FALSE;
+
 	_NMLOG ((   seq_result == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK
 	         || (   suppress_netlink_failure
 	             && seq_result < 0))
@@ -5555,37 +5565,62 @@ do_add_addrroute (NMPlatform *platform,
 		 *
 		 * rh#1484434 */
 		if (!nmp_cache_lookup_obj (nm_platform_get_cache (platform), obj_id))
-			do_request_one_type (platform, NMP_OBJECT_GET_TYPE (obj_id));
+			*out_need_refetch = TRUE;
 	}
 
 	return wait_for_nl_response_to_nmerr (seq_result);
 }
 
-static gboolean
-do_delete_object (NMPlatform *platform, const NMPObject *obj_id, struct nl_msg *nlmsg)
+static int
+do_add_addrroute (NMPlatform *platform,
+                  const NMPObject *obj_id,
+                  struct nl_msg *nlmsg,
+                  gboolean suppress_netlink_failure)
 {
 	WaitForNlResponseResult seq_result = WAIT_FOR_NL_RESPONSE_RESULT_UNKNOWN;
 	gs_free char *errmsg = NULL;
+	gboolean need_refetch;
 	int nle;
-	char s_buf[256];
-	gboolean success;
-	const char *log_detail = "";
+
+	nm_assert (NM_IN_SET (NMP_OBJECT_GET_TYPE (obj_id),
+	                      NMP_OBJECT_TYPE_IP4_ADDRESS, NMP_OBJECT_TYPE_IP6_ADDRESS,
+	                      NMP_OBJECT_TYPE_IP4_ROUTE, NMP_OBJECT_TYPE_IP6_ROUTE));
 
 	event_handler_read_netlink (platform, FALSE);
 
 	nle = _nl_send_nlmsg (platform, nlmsg, &seq_result, &errmsg, DELAYED_ACTION_RESPONSE_TYPE_VOID, NULL);
 	if (nle < 0) {
-		_LOGE ("do-delete-%s[%s]: failure sending netlink request \"%s\" (%d)",
+		_LOGE ("do-add-%s[%s]: failure sending netlink request \"%s\" (%d)",
 		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
 		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
 		       nm_strerror (nle), -nle);
-		return FALSE;
+		return -NME_PL_NETLINK;
 	}
 
 	delayed_action_handle_all (platform, FALSE);
 
+	nle = do_add_addrroute_handle_result (platform, obj_id, seq_result, errmsg,
+	                                      suppress_netlink_failure, &need_refetch);
+	if (need_refetch)
+		do_request_one_type (platform, NMP_OBJECT_GET_TYPE (obj_id));
+	return nle;
+}
+
+static gboolean
+do_delete_object_handle_result (NMPlatform *platform,
+                                const NMPObject *obj_id,
+                                WaitForNlResponseResult seq_result,
+                                const char *errmsg,
+                                gboolean *out_need_refetch)
+{
+	char s_buf[256];
+	gboolean success;
+	const char *log_detail = "";
+
 	nm_assert (seq_result);
 
+	*out_need_refetch = FALSE;
+
 	success = TRUE;
 	if (seq_result == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK) {
 		/* ok */
@@ -5620,12 +5655,347 @@ do_delete_object (NMPlatform *platform, const NMPObject *obj_id, struct nl_msg *
 		 *
 		 * rh#1484434 */
 		if (nmp_cache_lookup_obj (nm_platform_get_cache (platform), obj_id))
-			do_request_one_type (platform, NMP_OBJECT_GET_TYPE (obj_id));
+			*out_need_refetch = TRUE;
+	}
+
+	return success;
+}
+
+static gboolean
+do_delete_object (NMPlatform *platform, const NMPObject *obj_id, struct nl_msg *nlmsg)
+{
+	WaitForNlResponseResult seq_result = WAIT_FOR_NL_RESPONSE_RESULT_UNKNOWN;
+	gs_free char *errmsg = NULL;
+	gboolean need_refetch;
+	gboolean success;
+	int nle;
+
+	event_handler_read_netlink (platform, FALSE);
+
+	nle = _nl_send_nlmsg (platform, nlmsg, &seq_result, &errmsg, DELAYED_ACTION_RESPONSE_TYPE_VOID, NULL);
+	if (nle < 0) {
+		_LOGE ("do-delete-%s[%s]: failure sending netlink request \"%s\" (%d)",
+		       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
+		       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
+		       nm_strerror (nle), -nle);
+		return FALSE;
 	}
 
+	delayed_action_handle_all (platform, FALSE);
+
+	success = do_delete_object_handle_result (platform, obj_id, seq_result, errmsg, &need_refetch);
+	if (need_refetch)
+		do_request_one_type (platform, NMP_OBJECT_GET_TYPE (obj_id));
 	return success;
 }
 
+/*****************************************************************************/
+
+/* the maximum number of requests that are sent before collecting the
+ * responses. The pending responses are looked up linearly by sequence
+ * number, so don't let the list grow too long. */
+#define BATCH_WINDOW_SIZE 256
+
+/* the maximum size of one datagram with several requests. */
+#define BATCH_DATAGRAM_MAX_SIZE (16 * 1024)
+
+/* The state for one window of a batch. At about 11KB, it is too large
+ * for the stack and is allocated once per nm_platform_object_batch(). */
+typedef struct {
+	struct nl_msg *nlmsgs[BATCH_WINDOW_SIZE];
+	int nles[BATCH_WINDOW_SIZE];
+	WaitForNlResponseResult seq_results[BATCH_WINDOW_SIZE];
+	char *errmsgs[BATCH_WINDOW_SIZE];
+
+	/* scratch space for _nl_send_nlmsg_batch(). */
+	struct iovec iov[BATCH_WINDOW_SIZE];
+	guint iov_idx[BATCH_WINDOW_SIZE];
+} BatchWindow;
+
+/**
+ * _nl_send_nlmsg_batch:
+ * @platform:
+ * @w: the window. @w->nlmsgs contains the messages to send, %NULL elements
+ *   are skipped. For each message, @w->nles is set to 0 if it was sent or to a
+ *   negative error. @w->seq_results and @w->errmsgs receive the response from
+ *   kernel, but only after waiting for them via delayed_action_handle_all().
+ * @n_nlmsgs: the number of messages, at most %BATCH_WINDOW_SIZE.
+ *
+ * Like _nl_send_nlmsg(), but packs several messages into one datagram
+ * and thus sends all of them with only a few sendmsg() calls.
+ */
+static void
+_nl_send_nlmsg_batch (NMPlatform *platform,
+                      BatchWindow *w,
+                      guint n_nlmsgs)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	struct nl_msg **nlmsgs = w->nlmsgs;
+	int *out_nle = w->nles;
+	struct iovec *iov = w->iov;
+	guint *iov_idx = w->iov_idx;
+	struct sockaddr_nl nladdr = {
+		.nl_family = AF_NETLINK,
+	};
+	struct msghdr msg = {
+		.msg_name = &nladdr,
+		.msg_namelen = sizeof (nladdr),
+		.msg_iov = iov,
+	};
+	guint n_iov;
+	gsize len;
+	guint i, j;
+	int try_count;
+	int nle;
+
+	nm_assert (n_nlmsgs <= BATCH_WINDOW_SIZE);
+
+	for (i = 0; i < n_nlmsgs; ) {
+		n_iov = 0;
+		len = 0;
+		for (; i < n_nlmsgs; i++) {
+			struct nlmsghdr *nlhdr;
+
+			if (!nlmsgs[i]) {
+				out_nle[i] = -NME_BUG;
+				continue;
+			}
+
+			nlhdr = nlmsg_hdr (nlmsgs[i]);
+			nm_assert (NLMSG_ALIGN (nlhdr->nlmsg_len) == nlhdr->nlmsg_len);
+
+			if (   n_iov > 0
+			    && len + nlhdr->nlmsg_len > BATCH_DATAGRAM_MAX_SIZE)
+				break;
+
+			nlhdr->nlmsg_seq = _nlh_seq_next_get (priv);
+			if (!nlhdr->nlmsg_pid)
+				nlhdr->nlmsg_pid = nl_socket_get_local_port (priv->nlh);
+			nlhdr->nlmsg_flags |= (NLM_F_REQUEST | NLM_F_ACK);
+
+			iov[n_iov] = (struct iovec) {
+				.iov_base = nlhdr,
+				.iov_len = nlhdr->nlmsg_len,
+			};
+			iov_idx[n_iov] = i;
+			n_iov++;
+			len += nlhdr->nlmsg_len;
+		}
+
+		if (n_iov == 0)
+			continue;
+
+		msg.msg_iovlen = n_iov;
+		try_count = 0;
+again:
+		nle = sendmsg (nl_socket_get_fd (priv->nlh), &msg, 0);
+		if (nle < 0) {
+			nle = errno;
+			if (nle == EINTR && try_count++ < 100)
+				goto again;
+			_LOGD ("netlink: nl-send-nlmsg-batch: failed sending %u messages: %s (%d)", n_iov, g_strerror (nle), nle);
+			for (j = 0; j < n_iov; j++)
+				out_nle[iov_idx[j]] = -nm_errno_from_native (nle);
+			continue;
+		}
+
+		for (j = 0; j < n_iov; j++) {
+			guint k = iov_idx[j];
+
+			out_nle[k] = 0;
+			delayed_action_schedule_WAIT_FOR_NL_RESPONSE (platform,
+			                                              nlmsg_hdr (nlmsgs[k])->nlmsg_seq,
+			                                              &w->seq_results[k],
+			                                              &w->errmsgs[k],
+			                                              DELAYED_ACTION_RESPONSE_TYPE_VOID,
+			                                              NULL);
+		}
+	}
+}
+
+static struct nl_msg *
+_nl_msg_new_batch_op (const NMPlatformBatchOp *op, gint32 *p_now)
+{
+	const NMPObject *obj = op->obj;
+	guint32 lifetime;
+	guint32 preferred;
+
+	switch (NMP_OBJECT_GET_TYPE (obj)) {
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		if (op->op_type == NM_PLATFORM_BATCH_OP_ADD) {
+			NMPObject obj_normalized;
+
+			nmp_object_stackinit_obj (&obj_normalized, obj);
+			nm_platform_ip_route_normalize (NMP_OBJECT_GET_CLASS (obj)->addr_family,
+			                                NMP_OBJECT_CAST_IP_ROUTE (&obj_normalized));
+			return _nl_msg_new_route (RTM_NEWROUTE, op->flags & NMP_NLM_FLAG_FMASK, &obj_normalized);
+		}
+		return _nl_msg_new_route (RTM_DELROUTE, 0, obj);
+	case NMP_OBJECT_TYPE_IP4_ADDRESS: {
+		const NMPlatformIP4Address *a = NMP_OBJECT_CAST_IP4_ADDRESS (obj);
+
+		if (op->op_type == NM_PLATFORM_BATCH_OP_ADD) {
+			if (!*p_now)
+				*p_now = nm_utils_get_monotonic_timestamp_s ();
+			lifetime = nm_utils_lifetime_get (a->timestamp, a->lifetime, a->preferred, *p_now, &preferred);
+			return _nl_msg_new_address (RTM_NEWADDR,
+			                            NLM_F_CREATE | NLM_F_REPLACE,
+			                            AF_INET,
+			                            a->ifindex,
+			                            &a->address,
+			                            a->plen,
+			                            &a->peer_address,
+			                            a->n_ifa_flags,
+			                            nm_utils_ip4_address_is_link_local (a->address) ? RT_SCOPE_LINK : RT_SCOPE_UNIVERSE,
+			                            lifetime,
+			                            preferred,
+			                            a->label[0] ? a->label : NULL);
+		}
+		return _nl_msg_new_address (RTM_DELADDR,
+		                            0,
+		                            AF_INET,
+		                            a->ifindex,
+		                            &a->address,
+		                            a->plen,
+		                            &a->peer_address,
+		                            0,
+		                            RT_SCOPE_NOWHERE,
+		                            NM_PLATFORM_LIFETIME_PERMANENT,
+		                            NM_PLATFORM_LIFETIME_PERMANENT,
+		                            NULL);
+	}
+	case NMP_OBJECT_TYPE_IP6_ADDRESS: {
+		const NMPlatformIP6Address *a = NMP_OBJECT_CAST_IP6_ADDRESS (obj);
+
+		if (op->op_type == NM_PLATFORM_BATCH_OP_ADD) {
+			if (!*p_now)
+				*p_now = nm_utils_get_monotonic_timestamp_s ();
+			lifetime = nm_utils_lifetime_get (a->timestamp, a->lifetime, a->preferred, *p_now, &preferred);
+			return _nl_msg_new_address (RTM_NEWADDR,
+			                            NLM_F_CREATE | NLM_F_REPLACE,
+			                            AF_INET6,
+			                            a->ifindex,
+			                            &a->address,
+			                            a->plen,
+			                            &a->peer_address,
+			                            a->n_ifa_flags,
+			                            RT_SCOPE_UNIVERSE,
+			                            lifetime,
+			                            preferred,
+			                            NULL);
+		}
+		return _nl_msg_new_address (RTM_DELADDR,
+		                            0,
+		                            AF_INET6,
+		                            a->ifindex,
+		                            &a->address,
+		                            a->plen,
+		                            NULL,
+		                            0,
+		                            RT_SCOPE_NOWHERE,
+		                            NM_PLATFORM_LIFETIME_PERMANENT,
+		                            NM_PLATFORM_LIFETIME_PERMANENT,
+		                            NULL);
+	}
+	default:
+		return NULL;
+	}
+}
+
+static void
+object_batch (NMPlatform *platform,
+              NMPlatformBatchOp *ops,
+              guint n_ops)
+{
+	gs_free BatchWindow *w = NULL;
+	guint refetch_types = 0;
+	gint32 now = 0;
+	guint i_start;
+	guint i_end;
+	guint i;
+
+	for (i = 0; i < n_ops; i++) {
+		/* processing the responses may drop the objects from the cache.
+		 * Keep them alive. */
+		nmp_object_ref (ops[i].obj);
+	}
+
+	w = g_new (BatchWindow, 1);
+
+	for (i_start = 0; i_start < n_ops; i_start = i_end) {
+		struct nl_msg **nlmsgs = w->nlmsgs;
+		int *nles = w->nles;
+		WaitForNlResponseResult *seq_results = w->seq_results;
+		char **errmsgs = w->errmsgs;
+		guint n;
+
+		i_end = MIN (i_start + BATCH_WINDOW_SIZE, n_ops);
+		n = i_end - i_start;
+
+		for (i = 0; i < n; i++) {
+			nlmsgs[i] = _nl_msg_new_batch_op (&ops[i_start + i], &now);
+			nm_assert (nlmsgs[i]);
+			seq_results[i] = WAIT_FOR_NL_RESPONSE_RESULT_UNKNOWN;
+			errmsgs[i] = NULL;
+		}
+
+		event_handler_read_netlink (platform, FALSE);
+
+		_nl_send_nlmsg_batch (platform, w, n);
+
+		/* collect all responses at once. */
+		delayed_action_handle_all (platform, FALSE);
+
+		for (i = 0; i < n; i++) {
+			NMPlatformBatchOp *op = &ops[i_start + i];
+			gboolean need_refetch = FALSE;
+
+			if (nles[i] < 0) {
+				_LOGE ("do-%s-%s[%s]: failure sending netlink request \"%s\" (%d)",
+				       op->op_type == NM_PLATFORM_BATCH_OP_ADD ? "add" : "delete",
+				       NMP_OBJECT_GET_CLASS (op->obj)->obj_type_name,
+				       nmp_object_to_string (op->obj, NMP_OBJECT_TO_STRING_ID, NULL, 0),
+				       nm_strerror (nles[i]), -nles[i]);
+				op->result = nles[i] == -NME_BUG ? -NME_BUG : -NME_PL_NETLINK;
+			} else if (op->op_type == NM_PLATFORM_BATCH_OP_ADD) {
+				op->result = do_add_addrroute_handle_result (platform,
+				                                             op->obj,
+				                                             seq_results[i],
+				                                             errmsgs[i],
+				                                             NM_FLAGS_HAS (op->flags, NMP_NLM_FLAG_SUPPRESS_NETLINK_FAILURE),
+				                                             &need_refetch);
+			} else {
+				op->result = do_delete_object_handle_result (platform,
+				                                             op->obj,
+				                                             seq_results[i],
+				                                             errmsgs[i],
+				                                             &need_refetch)
+				             ? 0
+				             : wait_for_nl_response_to_nmerr (seq_results[i]) ?: -NME_UNSPEC;
+			}
+
+			if (need_refetch)
+				refetch_types |= (1u << NMP_OBJECT_GET_TYPE (op->obj));
+
+			nlmsg_free (nlmsgs[i]);
+			g_free (errmsgs[i]);
+		}
+	}
+
+	for (i = 0; i < n_ops; i++)
+		nmp_object_unref (ops[i].obj);
+
+	if (refetch_types) {
+		NMPObjectType obj_type;
+
+		for (obj_type = NMP_OBJECT_TYPE_UNKNOWN + 1; obj_type <= NMP_OBJECT_TYPE_MAX; obj_type++) {
+			if (NM_FLAGS_HAS (refetch_types, (1u << obj_type)))
+				do_request_one_type (platform, obj_type);
+		}
+	}
+}
+
 static int
 do_change_link (NMPlatform *platform,
                 ChangeLinkType change_link_type,
@@ -7691,26 +8061,47 @@ event_handler (GIOChannel *channel,
 
 /*****************************************************************************/
 
-/* copied from libnl3's recvmsgs() */
+/* copied from libnl3's recvmsgs().
+ *
+ * Unlike libnl3, the datagrams are read in batches via recvmmsg() into
+ * the preallocated buffers of @nlh_recvbuf, which are reused for the
+ * lifetime of the socket.
+ *
+ * Processing a message emits platform signals, whose handlers may call
+ * back into the platform and read from the socket again. Such a nested
+ * call still consumes the remaining datagrams of @nlh_recvbuf, but it must
+ * not refill the slots while the outer call is processing one of them.
+ * Instead, it reads into a buffer of its own. */
 static int
 event_handler_recvmsgs (NMPlatform *platform, gboolean handle_events)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
 	struct nl_sock *sk = priv->nlh;
+	const gboolean nested = priv->nlh_recvbuf_busy;
+	nm_auto_nl_recvbuf struct nl_recvbuf *rb_nested = NULL;
+	struct nl_recvbuf *rb;
 	int n;
 	int err = 0;
 	gboolean multipart = 0;
 	gboolean interrupted = FALSE;
 	struct nlmsghdr *hdr;
 	WaitForNlResponseResult seq_result;
-	struct sockaddr_nl nla = {0};
+	const struct sockaddr_nl *nla;
 	struct ucred creds;
 	gboolean creds_has;
-	nm_auto_free unsigned char *buf = NULL;
+	const unsigned char *buf;
 
 continue_reading:
-	g_clear_pointer (&buf, free);
-	n = nl_recv (sk, &nla, &buf, &creds, &creds_has);
+	if (   !nested
+	    || nl_recvbuf_has_pending (priv->nlh_recvbuf))
+		rb = priv->nlh_recvbuf;
+	else {
+		if (!rb_nested)
+			rb_nested = nl_recvbuf_new (sk, 1);
+		rb = rb_nested;
+	}
+
+	n = nl_recvbuf_next (sk, rb, &nla, &buf, &creds, &creds_has);
 
 	if (n <= 0) {
 
@@ -7718,7 +8109,8 @@ continue_reading:
 			int buf_size;
 
 			/* the message receive buffer was too small. We lost one message, which
-			 * is unfortunate. Try to double the buffer size for the next time. */
+			 * is unfortunate. Try to double the buffer size for the next time.
+			 * The receive buffers get resized once the current batch is consumed. */
 			buf_size = nl_socket_get_msg_buf_size (sk);
 			if (buf_size < 512*1024) {
 				buf_size *= 2;
@@ -7730,9 +8122,13 @@ continue_reading:
 			}
 		}
 
+		priv->nlh_recvbuf_busy = nested;
 		return n;
 	}
 
+	if (rb == priv->nlh_recvbuf)
+		priv->nlh_recvbuf_busy = TRUE;
+
 	hdr = (struct nlmsghdr *) buf;
 	while (nlmsg_ok (hdr, n)) {
 		nm_auto_nlmsg struct nl_msg *msg = NULL;
@@ -7745,7 +8141,7 @@ continue_reading:
 		msg = nlmsg_alloc_convert (hdr);
 
 		nlmsg_set_proto (msg, NETLINK_ROUTE);
-		nlmsg_set_src (msg, &nla);
+		nlmsg_set_src (msg, (struct sockaddr_nl *) nla);
 
 		if (!creds_has || creds.pid) {
 			if (!creds_has)
@@ -7853,12 +8249,17 @@ continue_reading:
 		event_seq_check_refresh_all (platform, seq_number);
 
 		if (process_valid_msg) {
+			const gint64 trace_start_ns = nm_trace_start ();
+
 			/* Valid message (not checking for MULTIPART bit to
 			 * get along with broken kernels. NL_SKIP has no
 			 * effect on this.  */
 
 			event_valid_msg (platform, msg, handle_events);
 
+			nm_trace (NM_TRACE_EVENT_NETLINK_MSG, 0, 0, 0, seq_number,
+			          nlmsg_hdr (msg)->nlmsg_type, trace_start_ns);
+
 			seq_result = WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK;
 		}
 
@@ -7883,6 +8284,8 @@ stop:
 		goto continue_reading;
 	}
 
+	priv->nlh_recvbuf_busy = nested;
+
 	if (interrupted)
 		return -NME_NL_DUMP_INTR;
 	return err;
@@ -8209,6 +8612,10 @@ constructed (GObject *_object)
 	nle = nl_socket_set_msg_buf_size (priv->nlh, 32 * 1024);
 	g_assert (!nle);
 
+	priv->nlh_recvbuf = nl_recvbuf_new (priv->nlh, 0);
+	_LOGT ("netlink: recvmsg: read up to %u messages per recvmmsg() call",
+	       nl_recvbuf_get_n_slots (priv->nlh_recvbuf));
+
 	nle = nl_socket_add_memberships (priv->nlh,
 	                                 RTNLGRP_LINK,
 	                                 RTNLGRP_IPV4_IFADDR, RTNLGRP_IPV6_IFADDR,
@@ -8321,6 +8728,7 @@ finalize (GObject *object)
 
 	g_source_remove (priv->event_id);
 	g_io_channel_unref (priv->event_channel);
+	nl_recvbuf_free (priv->nlh_recvbuf);
 	nl_socket_free (priv->nlh);
 
 	if (priv->sysctl_get_prev_values) {
@@ -8427,6 +8835,7 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	platform_class->link_6lowpan_add = link_6lowpan_add;
 
 	platform_class->object_delete = object_delete;
+	platform_class->object_batch = object_batch;
 	platform_class->ip4_address_add = ip4_address_add;
 	platform_class->ip6_address_add = ip6_address_add;
 	platform_class->ip4_address_delete = ip4_address_delete;
@@ -1437,3 +1437,266 @@ abort:
 	NM_SET_OUT (out_creds_has, tmpcreds_has);
 	return retval;
 }
+
+/*****************************************************************************/
+
+/* upper bound for the number of datagrams we read with one recvmmsg() call. */
+#define NL_RECVBUF_MAX_SLOTS 16
+
+/* upper bound for the size of all slots together. The message buffer size
+ * grows after a truncated message, but the arena should not grow with it. */
+#define NL_RECVBUF_MAX_SIZE  (512u * 1024u)
+
+#define NL_RECVBUF_CMSG_SIZE CMSG_SPACE (sizeof (struct ucred))
+
+struct nl_recvbuf {
+	struct mmsghdr *msgs;
+	struct iovec *iovs;
+	struct sockaddr_nl *nlas;
+	unsigned char *cmsgs;
+	unsigned char *data;
+	size_t slot_size;
+	guint n_slots;
+	guint max_slots;
+
+	/* the number of datagrams received by the last recvmmsg() call,
+	 * and the index of the next one to hand out. */
+	guint n_filled;
+	guint n_next;
+};
+
+static size_t
+_nl_recvbuf_get_slot_size (struct nl_sock *sk)
+{
+	return    sk->s_bufsize
+	       ?: (((size_t) nm_utils_getpagesize ()) * 4u);
+}
+
+static void
+_nl_recvbuf_setup (struct nl_sock *sk, struct nl_recvbuf *rb)
+{
+	int rcvbuf = 0;
+	socklen_t optlen = sizeof (rcvbuf);
+	guint n_slots;
+	guint i;
+
+	nm_assert (rb->n_next == rb->n_filled);
+
+	rb->slot_size = _nl_recvbuf_get_slot_size (sk);
+
+	/* size the arena so that one batch can consume a sizable part of
+	 * the socket's receive queue, but not more than @max_slots and
+	 * NL_RECVBUF_MAX_SIZE. */
+	if (   sk->s_fd < 0
+	    || getsockopt (sk->s_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, &optlen) < 0
+	    || rcvbuf <= 0)
+		n_slots = 1;
+	else {
+		n_slots = CLAMP (MIN ((size_t) rcvbuf, (size_t) NL_RECVBUF_MAX_SIZE) / rb->slot_size,
+		                 1u,
+		                 (size_t) rb->max_slots);
+	}
+
+	if (n_slots != rb->n_slots) {
+		g_free (rb->msgs);
+		g_free (rb->iovs);
+		g_free (rb->nlas);
+		g_free (rb->cmsgs);
+		rb->msgs = g_new (struct mmsghdr, n_slots);
+		rb->iovs = g_new (struct iovec, n_slots);
+		rb->nlas = g_new (struct sockaddr_nl, n_slots);
+		rb->cmsgs = g_malloc (NL_RECVBUF_CMSG_SIZE * n_slots);
+		rb->n_slots = n_slots;
+	}
+
+	g_free (rb->data);
+	rb->data = g_malloc (rb->slot_size * n_slots);
+
+	for (i = 0; i < n_slots; i++) {
+		rb->iovs[i] = (struct iovec) {
+			.iov_base = &rb->data[rb->slot_size * i],
+			.iov_len  = rb->slot_size,
+		};
+		rb->msgs[i] = (struct mmsghdr) {
+			.msg_hdr = {
+				.msg_name    = &rb->nlas[i],
+				.msg_iov     = &rb->iovs[i],
+				.msg_iovlen  = 1,
+				.msg_control = &rb->cmsgs[NL_RECVBUF_CMSG_SIZE * i],
+			},
+		};
+	}
+}
+
+/**
+ * nl_recvbuf_new:
+ * @sk: the netlink socket that is going to be read.
+ * @max_slots: the maximum number of datagrams to read at once, or 0
+ *   for the default.
+ *
+ * Allocates a set of receive buffers that is reused by nl_recvbuf_next()
+ * for all subsequent reads. The size of one buffer is the message buffer
+ * size of @sk (see nl_socket_set_msg_buf_size()), the number of buffers
+ * depends on the receive buffer size of the socket. Hence, configure the
+ * socket first. MSG_PEEK is not supported.
+ *
+ * Returns: (transfer full): the new receive buffer. Free with nl_recvbuf_free().
+ */
+struct nl_recvbuf *
+nl_recvbuf_new (struct nl_sock *sk, guint max_slots)
+{
+	struct nl_recvbuf *rb;
+
+	g_return_val_if_fail (sk, NULL);
+
+	rb = g_slice_new0 (struct nl_recvbuf);
+	rb->max_slots = max_slots > 0
+	                ? MIN (max_slots, (guint) NL_RECVBUF_MAX_SLOTS)
+	                : NL_RECVBUF_MAX_SLOTS;
+	_nl_recvbuf_setup (sk, rb);
+	return rb;
+}
+
+void
+nl_recvbuf_free (struct nl_recvbuf *rb)
+{
+	if (!rb)
+		return;
+
+	g_free (rb->msgs);
+	g_free (rb->iovs);
+	g_free (rb->nlas);
+	g_free (rb->cmsgs);
+	g_free (rb->data);
+	g_slice_free (struct nl_recvbuf, rb);
+}
+
+guint
+nl_recvbuf_get_n_slots (const struct nl_recvbuf *rb)
+{
+	g_return_val_if_fail (rb, 0);
+
+	return rb->n_slots;
+}
+
+/**
+ * nl_recvbuf_has_pending:
+ * @rb: the receive buffer
+ *
+ * Returns: %TRUE if @rb still has datagrams from the last batch. In that
+ *   case, the next call to nl_recvbuf_next() returns one of them and does
+ *   not read from the socket, so it does not overwrite any slot.
+ */
+gboolean
+nl_recvbuf_has_pending (const struct nl_recvbuf *rb)
+{
+	g_return_val_if_fail (rb, FALSE);
+
+	return rb->n_next < rb->n_filled;
+}
+
+/**
+ * nl_recvbuf_next:
+ * @sk: the netlink socket
+ * @rb: the receive buffer, previously created for @sk.
+ * @out_nla: (out): the source address of the datagram.
+ * @out_buf: (out): the content of the datagram. The buffer is owned by @rb
+ *   and only valid until the next call to nl_recvbuf_next().
+ * @out_creds: (out) (allow-none): the credentials of the sender.
+ * @out_creds_has: (out) (allow-none): whether @out_creds was set.
+ *
+ * Returns the next datagram from @rb. Once all datagrams from the previous
+ * batch are consumed, reads the next batch from the socket with a single
+ * recvmmsg() call. This behaves like nl_recv(), except that it does not
+ * allocate memory per datagram.
+ *
+ * If the message buffer size of @sk changed (for example, to recover from
+ * a truncated message), the buffers are resized before reading the next
+ * batch.
+ *
+ * Returns: the length of the datagram, zero on EOF, or a negative
+ *   error code. -NME_NL_MSG_TRUNC indicates that this particular datagram
+ *   was truncated; the following datagrams of the batch are still
+ *   returned by the next calls.
+ */
+int
+nl_recvbuf_next (struct nl_sock *sk,
+                 struct nl_recvbuf *rb,
+                 const struct sockaddr_nl **out_nla,
+                 const unsigned char **out_buf,
+                 struct ucred *out_creds,
+                 gboolean *out_creds_has)
+{
+	struct mmsghdr *mmsg;
+	struct cmsghdr *cmsg;
+	gboolean creds_has = FALSE;
+	guint i;
+	int n;
+
+	nm_assert (sk);
+	nm_assert (rb);
+	nm_assert (out_nla);
+	nm_assert (out_buf);
+	nm_assert (!out_creds_has == !out_creds);
+
+	if (rb->n_next >= rb->n_filled) {
+		rb->n_next = 0;
+		rb->n_filled = 0;
+
+		if (rb->slot_size != _nl_recvbuf_get_slot_size (sk))
+			_nl_recvbuf_setup (sk, rb);
+
+		for (i = 0; i < rb->n_slots; i++) {
+			/* recvmmsg() updates the lengths and flags, reset them. */
+			rb->msgs[i].msg_len = 0;
+			rb->msgs[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_nl);
+			rb->msgs[i].msg_hdr.msg_controllen =   (sk->s_flags & NL_SOCK_PASSCRED)
+			                                     ? NL_RECVBUF_CMSG_SIZE
+			                                     : 0;
+			rb->msgs[i].msg_hdr.msg_flags = 0;
+		}
+
+retry:
+		n = recvmmsg (sk->s_fd, rb->msgs, rb->n_slots, 0, NULL);
+		if (n < 0) {
+			if (errno == EINTR)
+				goto retry;
+			return -nm_errno_from_native (errno);
+		}
+		if (n == 0)
+			return 0;
+
+		rb->n_filled = n;
+	}
+
+	mmsg = &rb->msgs[rb->n_next++];
+
+	if (mmsg->msg_len == 0)
+		return 0;
+
+	if (   mmsg->msg_len > rb->slot_size
+	    || (mmsg->msg_hdr.msg_flags & MSG_TRUNC))
+		return -NME_NL_MSG_TRUNC;
+
+	if (mmsg->msg_hdr.msg_namelen != sizeof (struct sockaddr_nl))
+		return -NME_UNSPEC;
+
+	if (   out_creds
+	    && (sk->s_flags & NL_SOCK_PASSCRED)
+	    && !(mmsg->msg_hdr.msg_flags & MSG_CTRUNC)) {
+		for (cmsg = CMSG_FIRSTHDR (&mmsg->msg_hdr); cmsg; cmsg = CMSG_NXTHDR (&mmsg->msg_hdr, cmsg)) {
+			if (cmsg->cmsg_level != SOL_SOCKET)
+				continue;
+			if (cmsg->cmsg_type != SCM_CREDENTIALS)
+				continue;
+			memcpy (out_creds, CMSG_DATA (cmsg), sizeof (*out_creds));
+			creds_has = TRUE;
+			break;
+		}
+	}
+
+	*out_nla = mmsg->msg_hdr.msg_name;
+	*out_buf = mmsg->msg_hdr.msg_iov->iov_base;
+	NM_SET_OUT (out_creds_has, creds_has);
+	return mmsg->msg_len;
+}
@@ -440,6 +440,36 @@ int nl_recv (struct nl_sock *sk,
              struct ucred *out_creds,
              gboolean *out_creds_has);
 
+/*****************************************************************************/
+
+/* A reusable arena of receive buffers for reading a batch of datagrams
+ * with one recvmmsg() call. */
+struct nl_recvbuf;
+
+struct nl_recvbuf *nl_recvbuf_new (struct nl_sock *sk, guint max_slots);
+
+void nl_recvbuf_free (struct nl_recvbuf *rb);
+
+static inline void
+_nm_auto_nl_recvbuf_cleanup (struct nl_recvbuf **ptr)
+{
+	nl_recvbuf_free (*ptr);
+}
+#define nm_auto_nl_recvbuf nm_auto(_nm_auto_nl_recvbuf_cleanup)
+
+guint nl_recvbuf_get_n_slots (const struct nl_recvbuf *rb);
+
+gboolean nl_recvbuf_has_pending (const struct nl_recvbuf *rb);
+
+int nl_recvbuf_next (struct nl_sock *sk,
+                     struct nl_recvbuf *rb,
+                     const struct sockaddr_nl **out_nla,
+                     const unsigned char **out_buf,
+                     struct ucred *out_creds,
+                     gboolean *out_creds_has);
+
+/*****************************************************************************/
+
 int nl_send (struct nl_sock *sk, struct nl_msg *msg);
 
 int nl_send_auto (struct nl_sock *sk, struct nl_msg *msg);
@@ -44,6 +44,7 @@
 #include "nm-utils/nm-errno.h"
 
 #include "nm-core-utils.h"
+#include "nm-latency.h"
 #include "nm-platform-utils.h"
 #include "nm-platform-private.h"
 #include "nmp-object.h"
@@ -116,6 +117,20 @@ enum {
 	LAST_PROP,
 };
 
+typedef struct {
+	/* incremented on every change of a route of the interface in the cache. */
+	guint route_gen;
+
+	/* the routes of the last commit, by their ID. %NULL, if we don't know. */
+	GHashTable *committed;
+	guint committed_route_gen;
+	NMIPRouteTableSyncMode committed_route_table_sync;
+} RouteSyncData;
+
+typedef struct {
+	RouteSyncData data[2];
+} RouteSyncIfaceData;
+
 typedef struct _NMPlatformPrivate {
 	bool use_udev:1;
 	bool log_with_ptr:1;
@@ -126,8 +141,10 @@ typedef struct _NMPlatformPrivate {
 	guint ip4_dev_route_blacklist_check_id;
 	guint ip4_dev_route_blacklist_gc_timeout_id;
 	GHashTable *ip4_dev_route_blacklist_hash;
+	GHashTable *route_sync_hash;
 	NMDedupMultiIndex *multi_idx;
 	NMPCache *cache;
+	NMPlatformRouteGetMode ip_route_get_mode;
 } NMPlatformPrivate;
 
 G_DEFINE_TYPE (NMPlatform, nm_platform, G_TYPE_OBJECT)
@@ -138,6 +155,8 @@ G_DEFINE_TYPE (NMPlatform, nm_platform, G_TYPE_OBJECT)
 
 static void _ip4_dev_route_blacklist_schedule (NMPlatform *self);
 
+static void _route_sync_iface_data_free (RouteSyncIfaceData *iface_data);
+
 /*****************************************************************************/
 
 gboolean
@@ -3537,6 +3556,103 @@ nm_platform_ip6_address_get (NMPlatform *self, int ifindex, struct in6_addr addr
 	return NMP_OBJECT_CAST_IP6_ADDRESS (obj);
 }
 
+static void
+_batch_ops_clear (NMPlatformBatchOp *ops, guint n_ops)
+{
+	guint i;
+
+	for (i = 0; i < n_ops; i++)
+		nmp_object_unref (ops[i].obj);
+}
+
+static void
+_addr_sync_delete_add (NMPlatformBatchOp *ops, guint *n_ops, const NMPObject *obj)
+{
+	ops[(*n_ops)++] = (NMPlatformBatchOp) {
+		.obj = nmp_object_ref (obj),
+		.op_type = NM_PLATFORM_BATCH_OP_DELETE,
+	};
+}
+
+/* The addresses of @known_addresses that are not %NULL were sent with @ops_add,
+ * in the same order. Drop those that could not be added. */
+static gboolean
+_addr_sync_handle_add_results (GPtrArray *known_addresses, const NMPlatformBatchOp *ops_add, guint n_ops_add)
+{
+	gboolean success = TRUE;
+	guint i, j;
+
+	for (i = 0, j = 0; i < known_addresses->len; i++) {
+		if (!known_addresses->pdata[i])
+			continue;
+
+		nm_assert (j < n_ops_add);
+		if (ops_add[j++].result < 0) {
+			nmp_object_unref (known_addresses->pdata[i]);
+			known_addresses->pdata[i] = NULL;
+			success = FALSE;
+		}
+	}
+	nm_assert (j == n_ops_add);
+	return success;
+}
+
+/* Like _addr_sync_handle_add_results(), but for IPv6 the order of the
+ * addresses determines their priority. So, like when adding them one by
+ * one, stop at the first failure: remove the addresses that the batch
+ * added after the failed one again, unless they were already configured
+ * before (@was_present). Those stay in @known_addresses, the others are
+ * dropped. */
+static gboolean
+_addr_sync_ip6_handle_add_results (NMPlatform *self,
+                                   GPtrArray *known_addresses,
+                                   const NMPlatformBatchOp *ops_add,
+                                   guint n_ops_add,
+                                   const bool *was_present)
+{
+	gs_free NMPlatformBatchOp *ops_delete = NULL;
+	guint n_ops_delete = 0;
+	gboolean failed = FALSE;
+	guint i, j;
+
+	for (i = 0, j = 0; i < known_addresses->len; i++) {
+		const NMPlatformBatchOp *op;
+
+		if (!known_addresses->pdata[i])
+			continue;
+
+		nm_assert (j < n_ops_add);
+		op = &ops_add[j];
+		if (!failed) {
+			if (op->result >= 0) {
+				j++;
+				continue;
+			}
+			failed = TRUE;
+		} else {
+			if (was_present[j]) {
+				j++;
+				continue;
+			}
+			if (op->result >= 0) {
+				if (!ops_delete)
+					ops_delete = g_new (NMPlatformBatchOp, n_ops_add - j);
+				_addr_sync_delete_add (ops_delete, &n_ops_delete, op->obj);
+			}
+		}
+		j++;
+		nmp_object_unref (known_addresses->pdata[i]);
+		known_addresses->pdata[i] = NULL;
+	}
+	nm_assert (j == n_ops_add);
+
+	if (n_ops_delete > 0) {
+		nm_platform_object_batch (self, ops_delete, n_ops_delete);
+		_batch_ops_clear (ops_delete, n_ops_delete);
+	}
+	return !failed;
+}
+
 static gboolean
 _addr_array_clean_expired (int addr_family, int ifindex, GPtrArray *array, guint32 now, GHashTable **idx)
 {
@@ -3776,6 +3892,8 @@ nm_platform_ip4_address_sync (NMPlatform *self,
 	GHashTable *plat_subnets = NULL;
 	GHashTable *known_subnets = NULL;
 	gs_unref_hashtable GHashTable *known_addresses_idx = NULL;
+	gs_free NMPlatformBatchOp *ops = NULL;
+	guint n_ops = 0;
 	guint i, j, len;
 	NMPLookup lookup;
 	guint32 lifetime, preferred;
@@ -3794,6 +3912,13 @@ nm_platform_ip4_address_sync (NMPlatform *self,
 	if (plat_addresses)
 		plat_subnets = ip4_addr_subnets_build_index (plat_addresses, TRUE, TRUE);
 
+	/* The deletions and additions are each sent as one batch, in the order
+	 * in which they would be done one by one. */
+	len = MAX (plat_addresses ? plat_addresses->len : 0u,
+	           known_addresses ? known_addresses->len : 0u);
+	if (len > 0)
+		ops = g_new (NMPlatformBatchOp, len);
+
 	/* Delete unknown addresses */
 	len = plat_addresses ? plat_addresses->len : 0;
 	for (i = 0; i < len; i++) {
@@ -3828,10 +3953,7 @@ nm_platform_ip4_address_sync (NMPlatform *self,
 			}
 		}
 
-		nm_platform_ip4_address_delete (self, ifindex,
-		                                plat_address->address,
-		                                plat_address->plen,
-		                                plat_address->peer_address);
+		_addr_sync_delete_add (ops, &n_ops, plat_obj);
 
 		if (   !ip4_addr_subnets_is_secondary (plat_obj, plat_subnets, plat_addresses, &addr_list)
 		    && addr_list) {
@@ -3848,13 +3970,7 @@ nm_platform_ip4_address_sync (NMPlatform *self,
 				nm_assert (o);
 
 				if (*o) {
-					const NMPlatformIP4Address *a;
-
-					a = NMP_OBJECT_CAST_IP4_ADDRESS (*o);
-					nm_platform_ip4_address_delete (self, ifindex,
-					                                a->address,
-					                                a->plen,
-					                                a->peer_address);
+					_addr_sync_delete_add (ops, &n_ops, *o);
 					nmp_object_unref (*o);
 					*o = NULL;
 				}
@@ -3864,6 +3980,11 @@ nm_platform_ip4_address_sync (NMPlatform *self,
 	ip4_addr_subnets_destroy_index (plat_subnets, plat_addresses);
 	ip4_addr_subnets_destroy_index (known_subnets, known_addresses);
 
+	/* errors are ignored, as when deleting the addresses one by one. */
+	nm_platform_object_batch (self, ops, n_ops);
+	_batch_ops_clear (ops, n_ops);
+	n_ops = 0;
+
 	if (!known_addresses)
 		return TRUE;
 
@@ -3874,6 +3995,7 @@ nm_platform_ip4_address_sync (NMPlatform *self,
 	/* Add missing addresses */
 	for (i = 0; i < known_addresses->len; i++) {
 		const NMPObject *o;
+		NMPObject *obj;
 
 		o = known_addresses->pdata[i];
 		if (!o)
@@ -3883,21 +4005,28 @@ nm_platform_ip4_address_sync (NMPlatform *self,
 
 		lifetime = nm_utils_lifetime_get (known_address->timestamp, known_address->lifetime, known_address->preferred,
 		                                  now, &preferred);
-		if (!lifetime)
-			goto delete_and_next2;
-
-		if (!nm_platform_ip4_address_add (self, ifindex, known_address->address, known_address->plen,
-		                                  known_address->peer_address, lifetime, preferred,
-		                                  ifa_flags,
-		                                  known_address->label))
-			goto delete_and_next2;
+		if (!lifetime) {
+			nmp_object_unref (o);
+			known_addresses->pdata[i] = NULL;
+			continue;
+		}
 
-		continue;
-delete_and_next2:
-		nmp_object_unref (o);
-		known_addresses->pdata[i] = NULL;
+		obj = nmp_object_clone (o, FALSE);
+		obj->ip4_address.ifindex = ifindex;
+		obj->ip4_address.n_ifa_flags = ifa_flags;
+		ops[n_ops++] = (NMPlatformBatchOp) {
+			.obj = obj,
+			.op_type = NM_PLATFORM_BATCH_OP_ADD,
+		};
 	}
 
+	nm_platform_object_batch (self, ops, n_ops);
+
+	/* addresses that could not be added are dropped from the list, but
+	 * that is not a failure. */
+	_addr_sync_handle_add_results (known_addresses, ops, n_ops);
+	_batch_ops_clear (ops, n_ops);
+
 	return TRUE;
 }
 
@@ -3927,7 +4056,9 @@ ip6_address_scope_cmp (gconstpointer a, gconstpointer b)
  * @known_addresses: List of addresses. The list will be modified and only
  *   addresses that were successfully added will be kept in the list.
  *   That means, expired addresses and addresses that could not be added
- *   will be dropped.
+ *   will be dropped. Like when adding the addresses one by one, adding
+ *   stops at the first failure, so the addresses after a failed one are
+ *   not added either.
  *   Hence, the input argument @known_addresses is also an output argument
  *   telling which addresses were successfully added.
  *   Addresses are removed by unrefing the instance via nmp_object_unref()
@@ -3950,6 +4081,10 @@ nm_platform_ip6_address_sync (NMPlatform *self,
 	gint32 now = nm_utils_get_monotonic_timestamp_s ();
 	guint i_plat, i_know;
 	gs_unref_hashtable GHashTable *known_addresses_idx = NULL;
+	gs_free NMPlatformBatchOp *ops = NULL;
+	gs_free bool *was_present = NULL;
+	guint n_ops = 0;
+	gboolean success;
 	NMPLookup lookup;
 	guint32 ifa_flags;
 
@@ -3971,6 +4106,13 @@ nm_platform_ip6_address_sync (NMPlatform *self,
 	                                                                   ifindex),
 	                                           NULL, NULL);
 
+	/* The deletions and additions are each sent as one batch, in the order
+	 * in which they would be done one by one. */
+	if (plat_addresses || known_addresses) {
+		ops = g_new (NMPlatformBatchOp, MAX (plat_addresses ? plat_addresses->len : 0u,
+		                                     known_addresses ? known_addresses->len : 0u));
+	}
+
 	if (plat_addresses) {
 		guint known_addresses_len;
 
@@ -4015,7 +4157,7 @@ nm_platform_ip6_address_sync (NMPlatform *self,
 				}
 			}
 
-			nm_platform_ip6_address_delete (self, ifindex, plat_addr->address, plat_addr->plen);
+			_addr_sync_delete_add (ops, &n_ops, plat_obj);
 clear_and_next:
 			nmp_object_unref (g_steal_pointer (&plat_addresses->pdata[i_plat]));
 		}
@@ -4058,12 +4200,17 @@ clear_and_next:
 				break;
 			}
 
-			nm_platform_ip6_address_delete (self, ifindex, plat_addr->address, plat_addr->plen);
+			_addr_sync_delete_add (ops, &n_ops, plat_addresses->pdata[i_plat]);
 next_plat:
 			;
 		}
 	}
 
+	/* errors are ignored, as when deleting the addresses one by one. */
+	nm_platform_object_batch (self, ops, n_ops);
+	_batch_ops_clear (ops, n_ops);
+	n_ops = 0;
+
 	if (!known_addresses)
 		return TRUE;
 
@@ -4074,24 +4221,29 @@ next_plat:
 	/* Add missing addresses. New addresses are added by kernel with top
 	 * priority.
 	 */
+	was_present = g_new (bool, known_addresses->len);
 	for (i_know = 0; i_know < known_addresses->len; i_know++) {
-		const NMPlatformIP6Address *known_address = NMP_OBJECT_CAST_IP6_ADDRESS (known_addresses->pdata[i_know]);
-		guint32 lifetime, preferred;
+		const NMPObject *o = known_addresses->pdata[i_know];
+		NMPObject *obj;
 
-		if (!known_address)
+		if (!o)
 			continue;
 
-		lifetime = nm_utils_lifetime_get (known_address->timestamp, known_address->lifetime, known_address->preferred,
-		                                  now, &preferred);
-
-		if (!nm_platform_ip6_address_add (self, ifindex, known_address->address,
-		                                  known_address->plen, known_address->peer_address,
-		                                  lifetime, preferred,
-		                                  ifa_flags | known_address->n_ifa_flags))
-			return FALSE;
+		obj = nmp_object_clone (o, FALSE);
+		obj->ip6_address.ifindex = ifindex;
+		obj->ip6_address.n_ifa_flags |= ifa_flags;
+		was_present[n_ops] = !!nm_platform_ip6_address_get (self, ifindex, obj->ip6_address.address);
+		ops[n_ops++] = (NMPlatformBatchOp) {
+			.obj = obj,
+			.op_type = NM_PLATFORM_BATCH_OP_ADD,
+		};
 	}
 
-	return TRUE;
+	nm_platform_object_batch (self, ops, n_ops);
+	success = _addr_sync_ip6_handle_add_results (self, known_addresses, ops, n_ops, was_present);
+	_batch_ops_clear (ops, n_ops);
+
+	return success;
 }
 
 gboolean
@@ -4152,6 +4304,19 @@ _err_inval_due_to_ipv6_tentative_pref_src (NMPlatform *self, const NMPObject *ob
 	return TRUE;
 }
 
+static gboolean
+_route_table_sync_mode_matches (const NMPObject *obj,
+                                NMIPRouteTableSyncMode route_table_sync)
+{
+	if (route_table_sync == NM_IP_ROUTE_TABLE_SYNC_MODE_FULL)
+		return nm_platform_route_table_uncoerce (NMP_OBJECT_CAST_IP_ROUTE (obj)->table_coerced, TRUE) != RT_TABLE_LOCAL;
+	if (route_table_sync == NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN)
+		return nm_platform_route_table_is_main (NMP_OBJECT_CAST_IP_ROUTE (obj)->table_coerced);
+
+	nm_assert (route_table_sync == NM_IP_ROUTE_TABLE_SYNC_MODE_ALL);
+	return TRUE;
+}
+
 GPtrArray *
 nm_platform_ip_route_get_prune_list (NMPlatform *self,
                                      int addr_family,
@@ -4184,14 +4349,8 @@ nm_platform_ip_route_get_prune_list (NMPlatform *self,
 	c_list_for_each (iter, &head_entry->lst_entries_head) {
 		const NMPObject *obj = c_list_entry (iter, NMDedupMultiEntry, lst_entries)->obj;
 
-		if (route_table_sync == NM_IP_ROUTE_TABLE_SYNC_MODE_FULL) {
-			if (nm_platform_route_table_uncoerce (NMP_OBJECT_CAST_IP_ROUTE (obj)->table_coerced, TRUE) == RT_TABLE_LOCAL)
-				continue;
-		} else if (route_table_sync == NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN) {
-			if (!nm_platform_route_table_is_main (NMP_OBJECT_CAST_IP_ROUTE (obj)->table_coerced))
-				continue;
-		} else
-			nm_assert (route_table_sync == NM_IP_ROUTE_TABLE_SYNC_MODE_ALL);
+		if (!_route_table_sync_mode_matches (obj, route_table_sync))
+			continue;
 
 		g_ptr_array_add (routes_prune, (gpointer) nmp_object_ref (obj));
 	}
@@ -4203,6 +4362,136 @@ nm_platform_ip_route_get_prune_list (NMPlatform *self,
 	return routes_prune;
 }
 
+static gboolean
+_ip_route_sync_handle_add_result (NMPlatform *self,
+                                  const NMPlatformVTableRoute *vt,
+                                  int ifindex,
+                                  const NMPObject *conf_o,
+                                  int r,
+                                  GPtrArray **out_temporary_not_available)
+{
+	const NMDedupMultiEntry *plat_entry;
+	gboolean gateway_route_added = FALSE;
+	int r2;
+	char sbuf1[sizeof (_nm_utils_to_string_buffer)];
+	char sbuf2[sizeof (_nm_utils_to_string_buffer)];
+
+again:
+	if (r >= 0)
+		return TRUE;
+
+	if (r == -EEXIST) {
+		/* Don't fail for EEXIST. It's not clear that the existing route
+		 * is identical to the one that we were about to add. However,
+		 * above we should have deleted conflicting (non-identical) routes. */
+		if (_LOGD_ENABLED ()) {
+			plat_entry = nm_platform_lookup_entry (self,
+			                                       NMP_CACHE_ID_TYPE_OBJECT_TYPE,
+			                                       conf_o);
+			if (!plat_entry) {
+				_LOG3D ("route-sync: adding route %s failed with EEXIST, however we cannot find such a route",
+				        nmp_object_to_string (conf_o, NMP_OBJECT_TO_STRING_PUBLIC, sbuf1, sizeof (sbuf1)));
+			} else if (vt->route_cmp (NMP_OBJECT_CAST_IPX_ROUTE (conf_o),
+			                          NMP_OBJECT_CAST_IPX_ROUTE (plat_entry->obj),
+			                          NM_PLATFORM_IP_ROUTE_CMP_TYPE_SEMANTICALLY) != 0) {
+				_LOG3D ("route-sync: adding route %s failed due to existing (different!) route %s",
+				        nmp_object_to_string (conf_o, NMP_OBJECT_TO_STRING_PUBLIC, sbuf1, sizeof (sbuf1)),
+				        nmp_object_to_string (plat_entry->obj, NMP_OBJECT_TO_STRING_PUBLIC, sbuf2, sizeof (sbuf2)));
+			}
+		}
+		return TRUE;
+	}
+
+	if (NMP_OBJECT_CAST_IP_ROUTE (conf_o)->rt_source < NM_IP_CONFIG_SOURCE_USER) {
+		_LOG3D ("route-sync: ignore failure to add IPv%c route: %s: %s",
+		       vt->is_ip4 ? '4' : '6',
+		       nmp_object_to_string (conf_o, NMP_OBJECT_TO_STRING_PUBLIC, sbuf1, sizeof (sbuf1)),
+		       nm_strerror (r));
+		return TRUE;
+	}
+
+	if (   r == -EINVAL
+	    && out_temporary_not_available
+	    && _err_inval_due_to_ipv6_tentative_pref_src (self, conf_o)) {
+		_LOG3D ("route-sync: ignore failure to add IPv6 route with tentative IPv6 pref-src: %s: %s",
+		        nmp_object_to_string (conf_o, NMP_OBJECT_TO_STRING_PUBLIC, sbuf1, sizeof (sbuf1)),
+		        nm_strerror (r));
+		if (!*out_temporary_not_available)
+			*out_temporary_not_available = g_ptr_array_new_full (0, (GDestroyNotify) nmp_object_unref);
+		g_ptr_array_add (*out_temporary_not_available, (gpointer) nmp_object_ref (conf_o));
+		return TRUE;
+	}
+
+	if (   !gateway_route_added
+	    && (   (   r == -ENETUNREACH
+	            && vt->is_ip4
+	            && !!NMP_OBJECT_CAST_IP4_ROUTE (conf_o)->gateway)
+	        || (   r == -EHOSTUNREACH
+	            && !vt->is_ip4
+	            && !IN6_IS_ADDR_UNSPECIFIED (&NMP_OBJECT_CAST_IP6_ROUTE (conf_o)->gateway)))) {
+		NMPObject oo;
+
+		if (vt->is_ip4) {
+			const NMPlatformIP4Route *rt = NMP_OBJECT_CAST_IP4_ROUTE (conf_o);
+
+			nmp_object_stackinit (&oo,
+			                      NMP_OBJECT_TYPE_IP4_ROUTE,
+			                      &((NMPlatformIP4Route) {
+			                          .ifindex = rt->ifindex,
+			                          .network = rt->gateway,
+			                          .plen = 32,
+			                          .metric = rt->metric,
+			                          .rt_source = rt->rt_source,
+			                          .table_coerced = rt->table_coerced,
+			                      }));
+		} else {
+			const NMPlatformIP6Route *rt = NMP_OBJECT_CAST_IP6_ROUTE (conf_o);
+
+			nmp_object_stackinit (&oo,
+			                      NMP_OBJECT_TYPE_IP6_ROUTE,
+			                      &((NMPlatformIP6Route) {
+			                          .ifindex = rt->ifindex,
+			                          .network = rt->gateway,
+			                          .plen = 128,
+			                          .metric = rt->metric,
+			                          .rt_source = rt->rt_source,
+			                          .table_coerced = rt->table_coerced,
+			                      }));
+		}
+
+		_LOG3D ("route-sync: failure to add IPv%c route: %s: %s; try adding direct route to gateway %s",
+		        vt->is_ip4 ? '4' : '6',
+		        nmp_object_to_string (conf_o, NMP_OBJECT_TO_STRING_PUBLIC, sbuf1, sizeof (sbuf1)),
+		        nm_strerror (r),
+		        nmp_object_to_string (&oo, NMP_OBJECT_TO_STRING_PUBLIC, sbuf2, sizeof (sbuf2)));
+
+		r2 = nm_platform_ip_route_add (self,
+		                                 NMP_NLM_FLAG_APPEND
+		                               | NMP_NLM_FLAG_SUPPRESS_NETLINK_FAILURE,
+		                               &oo);
+
+		if (r2 < 0) {
+			_LOG3D ("route-sync: failure to add gateway IPv%c route: %s: %s",
+			        vt->is_ip4 ? '4' : '6',
+			        nmp_object_to_string (conf_o, NMP_OBJECT_TO_STRING_PUBLIC, sbuf1, sizeof (sbuf1)),
+			        nm_strerror (r2));
+		}
+
+		gateway_route_added = TRUE;
+		r = nm_platform_ip_route_add (self,
+		                                NMP_NLM_FLAG_APPEND
+		                              | NMP_NLM_FLAG_SUPPRESS_NETLINK_FAILURE,
+		                              conf_o);
+		goto again;
+	}
+
+	_LOG3W ("route-sync: failure to add IPv%c route: %s: %s",
+	       vt->is_ip4 ? '4' : '6',
+	       nmp_object_to_string (conf_o, NMP_OBJECT_TO_STRING_PUBLIC, sbuf1, sizeof (sbuf1)),
+	       nm_strerror (r));
+	return FALSE;
+}
+
 /**
  * nm_platform_ip_route_sync:
  * @self: the #NMPlatform instance.
@@ -4218,6 +4507,11 @@ nm_platform_ip_route_get_prune_list (NMPlatform *self,
  * @out_temporary_not_available: (allow-none): (out): routes that could
  *   currently not be synced. The caller shall keep them and try later again.
  *
+ * The routes are sent to the kernel in batches (see nm_platform_object_batch()):
+ * first conflicting routes are deleted and the device routes are added,
+ * then the same for gateway routes, and finally the routes from @routes_prune
+ * are deleted.
+ *
  * Returns: %TRUE on success.
  */
 gboolean
@@ -4230,13 +4524,17 @@ nm_platform_ip_route_sync (NMPlatform *self,
 {
 	const NMPlatformVTableRoute *vt;
 	gs_unref_hashtable GHashTable *routes_idx = NULL;
+	gs_free NMPlatformBatchOp *ops_delete = NULL;
+	gs_free NMPlatformBatchOp *ops_add = NULL;
+	guint n_ops_delete;
+	guint n_ops_add;
 	const NMPObject *conf_o;
 	const NMDedupMultiEntry *plat_entry;
 	guint i;
 	int i_type;
 	gboolean success = TRUE;
 	char sbuf1[sizeof (_nm_utils_to_string_buffer)];
-	char sbuf2[sizeof (_nm_utils_to_string_buffer)];
+	const gint64 start_ns = nm_latency_start ();
 
 	nm_assert (NM_IS_PLATFORM (self));
 	nm_assert (NM_IN_SET (addr_family, AF_INET, AF_INET6));
@@ -4246,11 +4544,16 @@ nm_platform_ip_route_sync (NMPlatform *self,
 	     ? &nm_platform_vtable_route_v4
 	     : &nm_platform_vtable_route_v6;
 
+	if (routes && routes->len > 0) {
+		ops_delete = g_new (NMPlatformBatchOp, routes->len);
+		ops_add = g_new (NMPlatformBatchOp, routes->len);
+	}
+
 	for (i_type = 0; routes && i_type < 2; i_type++) {
-		for (i = 0; i < routes->len; i++) {
-			int r, r2;
-			gboolean gateway_route_added = FALSE;
+		n_ops_delete = 0;
+		n_ops_add = 0;
 
+		for (i = 0; i < routes->len; i++) {
 			conf_o = routes->pdata[i];
 
 #define VTABLE_IS_DEVICE_ROUTE(vt, o) (vt->is_ip4 \
@@ -4290,119 +4593,42 @@ nm_platform_ip_route_sync (NMPlatform *self,
 
 				/* we need to replace the existing route with a (slightly) different
 				 * one. Delete it first. */
-				if (!nm_platform_object_delete (self, plat_o)) {
-					/* ignore error. */
-				}
+				ops_delete[n_ops_delete++] = (NMPlatformBatchOp) {
+					.obj = nmp_object_ref (plat_o),
+					.op_type = NM_PLATFORM_BATCH_OP_DELETE,
+				};
 			}
 
-sync_route_add:
-			r = nm_platform_ip_route_add (self,
-			                                NMP_NLM_FLAG_APPEND
-			                              | NMP_NLM_FLAG_SUPPRESS_NETLINK_FAILURE,
-			                              conf_o);
-			if (r < 0) {
-				if (r == -EEXIST) {
-					/* Don't fail for EEXIST. It's not clear that the existing route
-					 * is identical to the one that we were about to add. However,
-					 * above we should have deleted conflicting (non-identical) routes. */
-					if (_LOGD_ENABLED ()) {
-						plat_entry = nm_platform_lookup_entry (self,
-						                                       NMP_CACHE_ID_TYPE_OBJECT_TYPE,
-						                                       conf_o);
-						if (!plat_entry) {
-							_LOG3D ("route-sync: adding route %s failed with EEXIST, however we cannot find such a route",
-							        nmp_object_to_string (conf_o, NMP_OBJECT_TO_STRING_PUBLIC, sbuf1, sizeof (sbuf1)));
-						} else if (vt->route_cmp (NMP_OBJECT_CAST_IPX_ROUTE (conf_o),
-						                          NMP_OBJECT_CAST_IPX_ROUTE (plat_entry->obj),
-						                          NM_PLATFORM_IP_ROUTE_CMP_TYPE_SEMANTICALLY) != 0) {
-							_LOG3D ("route-sync: adding route %s failed due to existing (different!) route %s",
-							        nmp_object_to_string (conf_o, NMP_OBJECT_TO_STRING_PUBLIC, sbuf1, sizeof (sbuf1)),
-							        nmp_object_to_string (plat_entry->obj, NMP_OBJECT_TO_STRING_PUBLIC, sbuf2, sizeof (sbuf2)));
-						}
-					}
-				} else if (NMP_OBJECT_CAST_IP_ROUTE (conf_o)->rt_source < NM_IP_CONFIG_SOURCE_USER) {
-					_LOG3D ("route-sync: ignore failure to add IPv%c route: %s: %s",
-					       vt->is_ip4 ? '4' : '6',
-					       nmp_object_to_string (conf_o, NMP_OBJECT_TO_STRING_PUBLIC, sbuf1, sizeof (sbuf1)),
-					       nm_strerror (r));
-				} else if (   r == -EINVAL
-				           && out_temporary_not_available
-				           && _err_inval_due_to_ipv6_tentative_pref_src (self, conf_o)) {
-					_LOG3D ("route-sync: ignore failure to add IPv6 route with tentative IPv6 pref-src: %s: %s",
-					        nmp_object_to_string (conf_o, NMP_OBJECT_TO_STRING_PUBLIC, sbuf1, sizeof (sbuf1)),
-					        nm_strerror (r));
-					if (!*out_temporary_not_available)
-						*out_temporary_not_available = g_ptr_array_new_full (0, (GDestroyNotify) nmp_object_unref);
-					g_ptr_array_add (*out_temporary_not_available, (gpointer) nmp_object_ref (conf_o));
-				} else if (   !gateway_route_added
-				           && (   (   r == -ENETUNREACH
-				                   && vt->is_ip4
-				                   && !!NMP_OBJECT_CAST_IP4_ROUTE (conf_o)->gateway)
-				               || (   r == -EHOSTUNREACH
-				                   && !vt->is_ip4
-				                   && !IN6_IS_ADDR_UNSPECIFIED (&NMP_OBJECT_CAST_IP6_ROUTE (conf_o)->gateway)))) {
-					NMPObject oo;
-
-					if (vt->is_ip4) {
-						const NMPlatformIP4Route *rt = NMP_OBJECT_CAST_IP4_ROUTE (conf_o);
-
-						nmp_object_stackinit (&oo,
-						                      NMP_OBJECT_TYPE_IP4_ROUTE,
-						                      &((NMPlatformIP4Route) {
-						                          .ifindex = rt->ifindex,
-						                          .network = rt->gateway,
-						                          .plen = 32,
-						                          .metric = rt->metric,
-						                          .rt_source = rt->rt_source,
-						                          .table_coerced = rt->table_coerced,
-						                      }));
-					} else {
-						const NMPlatformIP6Route *rt = NMP_OBJECT_CAST_IP6_ROUTE (conf_o);
-
-						nmp_object_stackinit (&oo,
-						                      NMP_OBJECT_TYPE_IP6_ROUTE,
-						                      &((NMPlatformIP6Route) {
-						                          .ifindex = rt->ifindex,
-						                          .network = rt->gateway,
-						                          .plen = 128,
-						                          .metric = rt->metric,
-						                          .rt_source = rt->rt_source,
-						                          .table_coerced = rt->table_coerced,
-						                      }));
-					}
-
-					_LOG3D ("route-sync: failure to add IPv%c route: %s: %s; try adding direct route to gateway %s",
-					        vt->is_ip4 ? '4' : '6',
-					        nmp_object_to_string (conf_o, NMP_OBJECT_TO_STRING_PUBLIC, sbuf1, sizeof (sbuf1)),
-					        nm_strerror (r),
-					        nmp_object_to_string (&oo, NMP_OBJECT_TO_STRING_PUBLIC, sbuf2, sizeof (sbuf2)));
-
-					r2 = nm_platform_ip_route_add (self,
-					                                 NMP_NLM_FLAG_APPEND
-					                               | NMP_NLM_FLAG_SUPPRESS_NETLINK_FAILURE,
-					                               &oo);
-
-					if (r2 < 0) {
-						_LOG3D ("route-sync: failure to add gateway IPv%c route: %s: %s",
-						        vt->is_ip4 ? '4' : '6',
-						        nmp_object_to_string (conf_o, NMP_OBJECT_TO_STRING_PUBLIC, sbuf1, sizeof (sbuf1)),
-						        nm_strerror (r2));
-					}
-
-					gateway_route_added = TRUE;
-					goto sync_route_add;
-				} else {
-					_LOG3W ("route-sync: failure to add IPv%c route: %s: %s",
-					       vt->is_ip4 ? '4' : '6',
-					       nmp_object_to_string (conf_o, NMP_OBJECT_TO_STRING_PUBLIC, sbuf1, sizeof (sbuf1)),
-					       nm_strerror (r));
-					success = FALSE;
-				}
-			}
+			ops_add[n_ops_add++] = (NMPlatformBatchOp) {
+				.obj = nmp_object_ref (conf_o),
+				.op_type = NM_PLATFORM_BATCH_OP_ADD,
+				.flags =   NMP_NLM_FLAG_APPEND
+				         | NMP_NLM_FLAG_SUPPRESS_NETLINK_FAILURE,
+			};
 		}
+
+		/* ignore errors from deleting. */
+		nm_platform_object_batch (self, ops_delete, n_ops_delete);
+		_batch_ops_clear (ops_delete, n_ops_delete);
+
+		nm_platform_object_batch (self, ops_add, n_ops_add);
+		for (i = 0; i < n_ops_add; i++) {
+			if (!_ip_route_sync_handle_add_result (self,
+			                                       vt,
+			                                       ifindex,
+			                                       ops_add[i].obj,
+			                                       ops_add[i].result,
+			                                       out_temporary_not_available))
+				success = FALSE;
+		}
+		_batch_ops_clear (ops_add, n_ops_add);
 	}
 
-	if (routes_prune) {
+	if (routes_prune && routes_prune->len > 0) {
+		g_free (ops_delete);
+		ops_delete = g_new (NMPlatformBatchOp, routes_prune->len);
+		n_ops_delete = 0;
+
 		for (i = 0; i < routes_prune->len; i++) {
 			const NMPObject *prune_o;
 
@@ -4420,12 +4646,345 @@ sync_route_add:
 			                               prune_o))
 				continue;
 
-			if (!nm_platform_object_delete (self, prune_o)) {
-				/* ignore error... */
-			}
+			ops_delete[n_ops_delete++] = (NMPlatformBatchOp) {
+				.obj = nmp_object_ref (prune_o),
+				.op_type = NM_PLATFORM_BATCH_OP_DELETE,
+			};
+		}
+
+		/* ignore errors... */
+		nm_platform_object_batch (self, ops_delete, n_ops_delete);
+		_batch_ops_clear (ops_delete, n_ops_delete);
+	}
+
+	nm_latency_record (NM_LATENCY_ROUTE_SYNC, start_ns);
+	return success;
+}
+
+/*****************************************************************************/
+
+static RouteSyncData *
+_route_sync_data_get (NMPlatform *self, int addr_family, int ifindex, gboolean create)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+	RouteSyncIfaceData *iface_data;
+
+	nm_assert (NM_IN_SET (addr_family, AF_INET, AF_INET6));
+
+	iface_data = priv->route_sync_hash
+	             ? g_hash_table_lookup (priv->route_sync_hash, GINT_TO_POINTER (ifindex))
+	             : NULL;
+	if (!iface_data) {
+		if (!create)
+			return NULL;
+		if (!priv->route_sync_hash) {
+			priv->route_sync_hash = g_hash_table_new_full (nm_direct_hash, NULL, NULL,
+			                                               (GDestroyNotify) _route_sync_iface_data_free);
+		}
+		iface_data = g_slice_new0 (RouteSyncIfaceData);
+		g_hash_table_insert (priv->route_sync_hash, GINT_TO_POINTER (ifindex), iface_data);
+	}
+	return &iface_data->data[addr_family == AF_INET ? 0 : 1];
+}
+
+static void
+_route_sync_data_clear (RouteSyncData *sd)
+{
+	g_clear_pointer (&sd->committed, g_hash_table_unref);
+}
+
+static void
+_route_sync_iface_data_free (RouteSyncIfaceData *iface_data)
+{
+	_route_sync_data_clear (&iface_data->data[0]);
+	_route_sync_data_clear (&iface_data->data[1]);
+	g_slice_free (RouteSyncIfaceData, iface_data);
+}
+
+static void
+_route_sync_notify_cache_change (NMPlatform *self, const NMPObject *obj, NMPCacheOpsType cache_op)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+	RouteSyncData *sd;
+
+	if (!priv->route_sync_hash)
+		return;
+
+	switch (NMP_OBJECT_GET_TYPE (obj)) {
+	case NMP_OBJECT_TYPE_LINK:
+		if (cache_op == NMP_CACHE_OPS_REMOVED)
+			g_hash_table_remove (priv->route_sync_hash, GINT_TO_POINTER (obj->object.ifindex));
+		break;
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		sd = _route_sync_data_get (self,
+		                           NMP_OBJECT_GET_TYPE (obj) == NMP_OBJECT_TYPE_IP4_ROUTE ? AF_INET : AF_INET6,
+		                           obj->object.ifindex,
+		                           FALSE);
+		if (sd)
+			sd->route_gen++;
+		break;
+	default:
+		break;
+	}
+}
+
+static GHashTable *
+_route_sync_committed_new (void)
+{
+	return g_hash_table_new_full ((GHashFunc) nmp_object_id_hash,
+	                              (GEqualFunc) nmp_object_id_equal,
+	                              (GDestroyNotify) nmp_object_unref,
+	                              NULL);
+}
+
+/* check that the cache contains all routes from @committed, and that
+ * the cache contains no other routes that we would prune in @route_table_sync
+ * mode. */
+static gboolean
+_route_sync_committed_verify (NMPlatform *self,
+                              int addr_family,
+                              int ifindex,
+                              GHashTable *committed,
+                              NMIPRouteTableSyncMode route_table_sync)
+{
+	NMPLookup lookup;
+	const NMDedupMultiHeadEntry *head_entry;
+	GHashTableIter h_iter;
+	const NMPObject *obj;
+	CList *iter;
+
+	g_hash_table_iter_init (&h_iter, committed);
+	while (g_hash_table_iter_next (&h_iter, (gpointer *) &obj, NULL)) {
+		if (!nm_platform_lookup_entry (self, NMP_CACHE_ID_TYPE_OBJECT_TYPE, obj))
+			return FALSE;
+	}
+
+	nmp_lookup_init_object (&lookup,
+	                        addr_family == AF_INET
+	                          ? NMP_OBJECT_TYPE_IP4_ROUTE
+	                          : NMP_OBJECT_TYPE_IP6_ROUTE,
+	                        ifindex);
+	head_entry = nm_platform_lookup (self, &lookup);
+	if (!head_entry)
+		return TRUE;
+
+	c_list_for_each (iter, &head_entry->lst_entries_head) {
+		obj = c_list_entry (iter, NMDedupMultiEntry, lst_entries)->obj;
+		if (   _route_table_sync_mode_matches (obj, route_table_sync)
+		    && !g_hash_table_contains (committed, obj))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * nm_platform_ip_route_sync_can_incremental:
+ * @self: the #NMPlatform instance.
+ * @addr_family: AF_INET or AF_INET6.
+ * @ifindex: the interface.
+ * @route_table_sync: the sync mode.
+ *
+ * Platform remembers the routes of the last commit (see nm_platform_ip_route_sync_track()
+ * and nm_platform_ip_route_sync_incremental()) and tracks whether any route of
+ * @ifindex changed since.
+ *
+ * Returns: %TRUE, if the routes of @ifindex are still as left by the last
+ *   commit in @route_table_sync mode. In that case, the caller does not need
+ *   a prune list but can call nm_platform_ip_route_sync_incremental(), which
+ *   only sends the difference to the kernel. Note that this must be checked
+ *   before configuring addresses, because that may modify routes too.
+ */
+gboolean
+nm_platform_ip_route_sync_can_incremental (NMPlatform *self,
+                                           int addr_family,
+                                           int ifindex,
+                                           NMIPRouteTableSyncMode route_table_sync)
+{
+	RouteSyncData *sd;
+
+	_CHECK_SELF (self, klass, FALSE);
+
+	sd = _route_sync_data_get (self, addr_family, ifindex, FALSE);
+	return    sd
+	       && sd->committed
+	       && sd->committed_route_table_sync == route_table_sync
+	       && sd->committed_route_gen == sd->route_gen;
+}
+
+/**
+ * nm_platform_ip_route_sync_track:
+ * @self: the #NMPlatform instance.
+ * @addr_family: AF_INET or AF_INET6.
+ * @ifindex: the interface.
+ * @routes: (allow-none): the routes that were just synced via
+ *   nm_platform_ip_route_sync().
+ * @route_table_sync: the sync mode that was used for the prune list.
+ *
+ * Remember @routes as the committed state of @ifindex, so that the next
+ * commit can be done incrementally. Only call this after a successful
+ * sync. If platform has extra routes that would be pruned in @route_table_sync
+ * mode, or some of @routes are missing, nothing is remembered.
+ */
+void
+nm_platform_ip_route_sync_track (NMPlatform *self,
+                                 int addr_family,
+                                 int ifindex,
+                                 GPtrArray *routes,
+                                 NMIPRouteTableSyncMode route_table_sync)
+{
+	gs_unref_hashtable GHashTable *committed = NULL;
+	RouteSyncData *sd;
+	guint i;
+
+	_CHECK_SELF_VOID (self, klass);
+
+	nm_assert (NM_IN_SET (route_table_sync, NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN,
+	                                        NM_IP_ROUTE_TABLE_SYNC_MODE_FULL,
+	                                        NM_IP_ROUTE_TABLE_SYNC_MODE_ALL));
+
+	sd = _route_sync_data_get (self, addr_family, ifindex, TRUE);
+	_route_sync_data_clear (sd);
+
+	committed = _route_sync_committed_new ();
+	for (i = 0; routes && i < routes->len; i++)
+		g_hash_table_add (committed, (gpointer) nmp_object_ref (routes->pdata[i]));
+
+	if (!_route_sync_committed_verify (self, addr_family, ifindex, committed, route_table_sync)) {
+		_LOG3T ("route-sync: cannot track IPv%c routes for incremental sync",
+		        addr_family == AF_INET ? '4' : '6');
+		return;
+	}
+
+	sd->committed = g_steal_pointer (&committed);
+	sd->committed_route_table_sync = route_table_sync;
+	sd->committed_route_gen = sd->route_gen;
+}
+
+/**
+ * nm_platform_ip_route_sync_incremental:
+ * @self: the #NMPlatform instance.
+ * @addr_family: AF_INET or AF_INET6.
+ * @ifindex: the @ifindex for which the routes are to be added.
+ * @routes: (allow-none): a list of routes to configure.
+ * @route_table_sync: the sync mode.
+ * @out_temporary_not_available: (allow-none): (out): routes that could
+ *   currently not be synced.
+ *
+ * Like nm_platform_ip_route_sync(), but instead of a prune list, the routes
+ * are compared against those of the last commit. Only routes that were added,
+ * changed or removed since are sent to the kernel.
+ *
+ * Only call this, if nm_platform_ip_route_sync_can_incremental() returned
+ * %TRUE before configuring the addresses.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+nm_platform_ip_route_sync_incremental (NMPlatform *self,
+                                       int addr_family,
+                                       int ifindex,
+                                       GPtrArray *routes,
+                                       NMIPRouteTableSyncMode route_table_sync,
+                                       GPtrArray **out_temporary_not_available)
+{
+	gs_unref_hashtable GHashTable *committed_old = NULL;
+	gs_unref_hashtable GHashTable *committed_new = NULL;
+	gs_unref_ptrarray GPtrArray *routes_changed = NULL;
+	gs_unref_ptrarray GPtrArray *routes_prune = NULL;
+	RouteSyncData *sd;
+	gboolean is_current;
+	gboolean success;
+	guint n_kept = 0;
+	guint i;
+
+	_CHECK_SELF (self, klass, FALSE);
+
+	nm_assert (NM_IN_SET (addr_family, AF_INET, AF_INET6));
+	nm_assert (ifindex > 0);
+
+	sd = _route_sync_data_get (self, addr_family, ifindex, FALSE);
+	if (!sd || !sd->committed) {
+		/* the state got invalidated in the meantime, for example because
+		 * the link was removed. There is nothing to prune. */
+		return nm_platform_ip_route_sync (self, addr_family, ifindex, routes, NULL, out_temporary_not_available);
+	}
+
+	/* addresses were configured after nm_platform_ip_route_sync_can_incremental(),
+	 * which might have changed routes. In that case, we cannot skip routes that
+	 * did not change since the last commit, but need to check them against the
+	 * cache. The prune list is still correct. */
+	is_current = (sd->committed_route_gen == sd->route_gen);
+
+	committed_old = g_steal_pointer (&sd->committed);
+	committed_new = _route_sync_committed_new ();
+
+	routes_changed = g_ptr_array_new_with_free_func ((GDestroyNotify) nmp_object_unref);
+
+	for (i = 0; routes && i < routes->len; i++) {
+		const NMPObject *conf_o = routes->pdata[i];
+		const NMPObject *old_o;
+
+		if (!nm_g_hash_table_add (committed_new, (gpointer) nmp_object_ref (conf_o))) {
+			/* duplicate. nm_platform_ip_route_sync() would skip it too. */
+			continue;
+		}
+
+		old_o = g_hash_table_lookup (committed_old, conf_o);
+		if (old_o) {
+			n_kept++;
+			if (   is_current
+			    && nmp_object_equal (old_o, conf_o))
+				continue;
+		}
+
+		g_ptr_array_add (routes_changed, (gpointer) nmp_object_ref (conf_o));
+	}
+
+	if (n_kept < g_hash_table_size (committed_old)) {
+		GHashTableIter h_iter;
+		const NMPObject *old_o;
+
+		routes_prune = g_ptr_array_new_with_free_func ((GDestroyNotify) nmp_object_unref);
+		g_hash_table_iter_init (&h_iter, committed_old);
+		while (g_hash_table_iter_next (&h_iter, (gpointer *) &old_o, NULL)) {
+			if (   !g_hash_table_contains (committed_new, old_o)
+			    && _route_table_sync_mode_matches (old_o, route_table_sync))
+				g_ptr_array_add (routes_prune, (gpointer) nmp_object_ref (old_o));
 		}
 	}
 
+	_LOG3T ("route-sync: incremental IPv%c sync: %u of %u routes changed, %u removed%s",
+	        addr_family == AF_INET ? '4' : '6',
+	        routes_changed->len,
+	        g_hash_table_size (committed_new),
+	        routes_prune ? routes_prune->len : 0u,
+	        is_current ? "" : " (routes changed meanwhile)");
+
+	success = nm_platform_ip_route_sync (self,
+	                                     addr_family,
+	                                     ifindex,
+	                                     routes_changed,
+	                                     routes_prune,
+	                                     out_temporary_not_available);
+
+	if (   !success
+	    || (   out_temporary_not_available
+	        && *out_temporary_not_available))
+		return success;
+
+	if (is_current) {
+		/* only the changed routes could be missing. */
+		for (i = 0; i < routes_changed->len; i++) {
+			if (!nm_platform_lookup_entry (self, NMP_CACHE_ID_TYPE_OBJECT_TYPE, routes_changed->pdata[i]))
+				return success;
+		}
+	} else if (!_route_sync_committed_verify (self, addr_family, ifindex, committed_new, route_table_sync))
+		return success;
+
+	sd->committed = g_steal_pointer (&committed_new);
+	sd->committed_route_table_sync = route_table_sync;
+	sd->committed_route_gen = sd->route_gen;
 	return success;
 }
 
@@ -4619,8 +5178,295 @@ nm_platform_object_delete (NMPlatform *self,
 	return klass->object_delete (self, obj);
 }
 
+static void
+_object_batch_sequential (NMPlatform *self, NMPlatformBatchOp *ops, guint n_ops)
+{
+	gint32 now = 0;
+	guint32 lifetime;
+	guint32 preferred;
+	gboolean success;
+	guint i;
+
+	for (i = 0; i < n_ops; i++) {
+		NMPlatformBatchOp *op = &ops[i];
+		const NMPObject *obj = op->obj;
+
+		switch (NMP_OBJECT_GET_TYPE (obj)) {
+		case NMP_OBJECT_TYPE_IP4_ROUTE:
+		case NMP_OBJECT_TYPE_IP6_ROUTE:
+			if (op->op_type == NM_PLATFORM_BATCH_OP_ADD)
+				op->result = nm_platform_ip_route_add (self, op->flags, obj);
+			else
+				op->result = nm_platform_object_delete (self, obj) ? 0 : -NME_UNSPEC;
+			break;
+		case NMP_OBJECT_TYPE_IP4_ADDRESS: {
+			const NMPlatformIP4Address *a = NMP_OBJECT_CAST_IP4_ADDRESS (obj);
+
+			if (op->op_type == NM_PLATFORM_BATCH_OP_ADD) {
+				if (!now)
+					now = nm_utils_get_monotonic_timestamp_s ();
+				lifetime = nm_utils_lifetime_get (a->timestamp, a->lifetime, a->preferred, now, &preferred);
+				success = nm_platform_ip4_address_add (self, a->ifindex, a->address, a->plen,
+				                                       a->peer_address, lifetime, preferred,
+				                                       a->n_ifa_flags,
+				                                       a->label[0] ? a->label : NULL);
+			} else
+				success = nm_platform_ip4_address_delete (self, a->ifindex, a->address, a->plen, a->peer_address);
+			op->result = success ? 0 : -NME_UNSPEC;
+			break;
+		}
+		case NMP_OBJECT_TYPE_IP6_ADDRESS: {
+			const NMPlatformIP6Address *a = NMP_OBJECT_CAST_IP6_ADDRESS (obj);
+
+			if (op->op_type == NM_PLATFORM_BATCH_OP_ADD) {
+				if (!now)
+					now = nm_utils_get_monotonic_timestamp_s ();
+				lifetime = nm_utils_lifetime_get (a->timestamp, a->lifetime, a->preferred, now, &preferred);
+				success = nm_platform_ip6_address_add (self, a->ifindex, a->address, a->plen,
+				                                       a->peer_address, lifetime, preferred,
+				                                       a->n_ifa_flags);
+			} else
+				success = nm_platform_ip6_address_delete (self, a->ifindex, a->address, a->plen);
+			op->result = success ? 0 : -NME_UNSPEC;
+			break;
+		}
+		default:
+			nm_assert_not_reached ();
+			op->result = -NME_BUG;
+			break;
+		}
+	}
+}
+
+/**
+ * nm_platform_object_batch:
+ * @self: the #NMPlatform instance.
+ * @ops: the operations to perform.
+ * @n_ops: the number of operations in @ops.
+ *
+ * Adds or deletes many IPv4/IPv6 addresses and routes at once. The
+ * operations are performed in order, but unlike calling nm_platform_ip_route_add()
+ * and nm_platform_object_delete() one by one, the platform implementation
+ * may send all requests before collecting the responses. Hence, one failing
+ * operation does not stop the following ones. The result for each
+ * operation is returned in the @result field of @ops.
+ */
+void
+nm_platform_object_batch (NMPlatform *self, NMPlatformBatchOp *ops, guint n_ops)
+{
+	guint i;
+
+	_CHECK_SELF_VOID (self, klass);
+
+	if (n_ops == 0)
+		return;
+
+	g_return_if_fail (ops);
+
+	for (i = 0; i < n_ops; i++) {
+		nm_assert (NM_IN_SET (NMP_OBJECT_GET_TYPE (ops[i].obj), NMP_OBJECT_TYPE_IP4_ADDRESS,
+		                                                        NMP_OBJECT_TYPE_IP6_ADDRESS,
+		                                                        NMP_OBJECT_TYPE_IP4_ROUTE,
+		                                                        NMP_OBJECT_TYPE_IP6_ROUTE));
+		nm_assert (NM_IN_SET (ops[i].op_type, NM_PLATFORM_BATCH_OP_ADD,
+		                                      NM_PLATFORM_BATCH_OP_DELETE));
+		ops[i].result = 0;
+	}
+
+	if (!klass->object_batch) {
+		_object_batch_sequential (self, ops, n_ops);
+		return;
+	}
+
+	if (_LOGD_ENABLED ()) {
+		char sbuf[sizeof (_nm_utils_to_string_buffer)];
+
+		for (i = 0; i < n_ops; i++) {
+			_LOGD ("batch: %s %s: %s",
+			       ops[i].op_type == NM_PLATFORM_BATCH_OP_ADD ? "add" : "delete",
+			       NMP_OBJECT_GET_CLASS (ops[i].obj)->obj_type_name,
+			       nmp_object_to_string (ops[i].obj, NMP_OBJECT_TO_STRING_PUBLIC, sbuf, sizeof (sbuf)));
+		}
+	}
+
+	klass->object_batch (self, ops, n_ops);
+}
+
 /*****************************************************************************/
 
+NMPlatformRouteGetMode
+nm_platform_ip_route_get_get_mode (NMPlatform *self)
+{
+	_CHECK_SELF (self, klass, NM_PLATFORM_ROUTE_GET_MODE_KERNEL);
+
+	return NM_PLATFORM_GET_PRIVATE (self)->ip_route_get_mode;
+}
+
+void
+nm_platform_ip_route_get_set_mode (NMPlatform *self,
+                                   NMPlatformRouteGetMode mode)
+{
+	_CHECK_SELF_VOID (self, klass);
+
+	g_return_if_fail (NM_IN_SET (mode, NM_PLATFORM_ROUTE_GET_MODE_KERNEL,
+	                                   NM_PLATFORM_ROUTE_GET_MODE_CACHE,
+	                                   NM_PLATFORM_ROUTE_GET_MODE_STRICT));
+
+	NM_PLATFORM_GET_PRIVATE (self)->ip_route_get_mode = mode;
+}
+
+static gboolean
+_ip_route_get_cache_skip_address (NMPlatform *self,
+                                  int addr_family,
+                                  gconstpointer address)
+{
+	NMPLookup lookup;
+	NMDedupMultiIter iter;
+	const NMPObject *obj;
+
+	/* these destinations are resolved by the local table or need
+	 * special handling by kernel. */
+	if (addr_family == AF_INET) {
+		in_addr_t a = *((const in_addr_t *) address);
+
+		if (   a == INADDR_ANY
+		    || a == INADDR_BROADCAST
+		    || (ntohl (a) >> 24) == 127
+		    || IN_MULTICAST (ntohl (a)))
+			return TRUE;
+	} else {
+		const struct in6_addr *a = address;
+
+		if (   IN6_IS_ADDR_UNSPECIFIED (a)
+		    || IN6_IS_ADDR_LOOPBACK (a)
+		    || IN6_IS_ADDR_MULTICAST (a)
+		    || IN6_IS_ADDR_LINKLOCAL (a))
+			return TRUE;
+	}
+
+	/* neither do we know the local table, which has our own addresses
+	 * (and, for IPv4, the broadcast addresses of their subnets). */
+	nmp_lookup_init_obj_type (&lookup,
+	                          addr_family == AF_INET
+	                            ? NMP_OBJECT_TYPE_IP4_ADDRESS
+	                            : NMP_OBJECT_TYPE_IP6_ADDRESS);
+	nmp_cache_iter_for_each (&iter, nm_platform_lookup (self, &lookup), &obj) {
+		if (addr_family == AF_INET) {
+			const NMPlatformIP4Address *a = NMP_OBJECT_CAST_IP4_ADDRESS (obj);
+			in_addr_t dst = *((const in_addr_t *) address);
+
+			if (a->address == dst)
+				return TRUE;
+			if (   a->plen < 31
+			    && dst == (a->address | ~nm_utils_ip4_prefix_to_netmask (a->plen)))
+				return TRUE;
+		} else {
+			if (IN6_ARE_ADDR_EQUAL (&NMP_OBJECT_CAST_IP6_ADDRESS (obj)->address, address))
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static gboolean
+_ip_route_get_cache_match (const NMPObject *obj, gpointer user_data)
+{
+	const NMPlatformIPXRoute *r = NMP_OBJECT_CAST_IPX_ROUTE (obj);
+	const int oif_ifindex = GPOINTER_TO_INT (user_data);
+
+	if (NMP_OBJECT_GET_TYPE (obj) == NMP_OBJECT_TYPE_IP4_ROUTE) {
+		/* a lookup without TOS does not hit routes with a TOS. */
+		if (r->r4.tos != 0)
+			return FALSE;
+	} else {
+		/* a lookup without source address does not hit source specific routes. */
+		if (r->r6.src_plen != 0)
+			return FALSE;
+	}
+
+	if (   oif_ifindex > 0
+	    && r->rx.ifindex != oif_ifindex)
+		return FALSE;
+
+	return TRUE;
+}
+
+/* Resolves the route that kernel would pick for @address from the cached
+ * routes of the main table. Returns %NULL, unless the result is certain. */
+static NMPObject *
+_ip_route_get_from_cache (NMPlatform *self,
+                          int addr_family,
+                          gconstpointer address,
+                          int oif_ifindex)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+	const NMPlatformLink *pllink;
+	const NMPObject *obj;
+	NMPObject *route;
+	NMPlatformIPXRoute *r;
+	gboolean ambiguous;
+
+	if (!nmp_cache_route_index_get_enabled (priv->cache))
+		return NULL;
+
+	if (_ip_route_get_cache_skip_address (self, addr_family, address))
+		return NULL;
+
+	/* For IPv4, a lookup with an output interface only considers routes via
+	 * that interface. For IPv6, the output interface is only a preference and
+	 * we check below, that the best route is via @oif_ifindex. */
+	obj = nmp_cache_route_index_best_match (priv->cache,
+	                                        addr_family,
+	                                        RT_TABLE_MAIN,
+	                                        address,
+	                                        _ip_route_get_cache_match,
+	                                        GINT_TO_POINTER (addr_family == AF_INET ? oif_ifindex : 0),
+	                                        &ambiguous);
+	if (!obj || ambiguous)
+		return NULL;
+
+	if (   oif_ifindex > 0
+	    && NMP_OBJECT_CAST_IP_ROUTE (obj)->ifindex != oif_ifindex)
+		return NULL;
+
+	/* kernel skips routes on interfaces without carrier, depending
+	 * on the ignore_routes_with_linkdown sysctl. Don't guess. */
+	pllink = nm_platform_link_get (self, NMP_OBJECT_CAST_IP_ROUTE (obj)->ifindex);
+	if (   !pllink
+	    || !NM_FLAGS_HAS (pllink->n_ifi_flags, IFF_UP)
+	    || !pllink->connected)
+		return NULL;
+
+	/* mimic the reply of RTM_GETROUTE: a cloned host route to @address. */
+	route = nmp_object_clone (obj, FALSE);
+	r = NMP_OBJECT_CAST_IPX_ROUTE (route);
+	if (addr_family == AF_INET) {
+		r->r4.network = *((const in_addr_t *) address);
+		r->r4.plen = 32;
+		r->r4.metric = 0;
+	} else {
+		r->r6.network = *((const struct in6_addr *) address);
+		r->r6.plen = 128;
+	}
+	r->rx.r_rtm_flags |= RTM_F_CLONED;
+	return route;
+}
+
+static gboolean
+_ip_route_get_result_equal (const NMPObject *a, const NMPObject *b)
+{
+	const NMPlatformIPXRoute *ra = NMP_OBJECT_CAST_IPX_ROUTE (a);
+	const NMPlatformIPXRoute *rb = NMP_OBJECT_CAST_IPX_ROUTE (b);
+
+	/* only compare what the users of nm_platform_ip_route_get() care about. */
+	if (   ra->rx.ifindex != rb->rx.ifindex
+	    || ra->rx.table_coerced != rb->rx.table_coerced)
+		return FALSE;
+	if (NMP_OBJECT_GET_TYPE (a) == NMP_OBJECT_TYPE_IP4_ROUTE)
+		return ra->r4.gateway == rb->r4.gateway;
+	return IN6_ARE_ADDR_EQUAL (&ra->r6.gateway, &rb->r6.gateway);
+}
+
 int
 nm_platform_ip_route_get (NMPlatform *self,
                           int addr_family,
@@ -4628,7 +5474,9 @@ nm_platform_ip_route_get (NMPlatform *self,
                           int oif_ifindex,
                           NMPObject **out_route)
 {
+	NMPlatformPrivate *priv;
 	nm_auto_nmpobj NMPObject *route = NULL;
+	nm_auto_nmpobj NMPObject *route_cached = NULL;
 	int result;
 	char buf[NM_UTILS_INET_ADDRSTRLEN];
 	char buf_oif[64];
@@ -4639,12 +5487,24 @@ nm_platform_ip_route_get (NMPlatform *self,
 	g_return_val_if_fail (NM_IN_SET (addr_family, AF_INET,
 	                                              AF_INET6), -NME_BUG);
 
+	priv = NM_PLATFORM_GET_PRIVATE (self);
+
 	_LOGT ("route: get IPv%c route for: %s%s",
 	       nm_utils_addr_family_to_char (addr_family),
 	       inet_ntop (addr_family, address, buf, sizeof (buf)),
 	       oif_ifindex > 0 ? nm_sprintf_buf (buf_oif, " oif %d", oif_ifindex) : "");
 
-	if (!klass->ip_route_get)
+	if (priv->ip_route_get_mode != NM_PLATFORM_ROUTE_GET_MODE_KERNEL)
+		route_cached = _ip_route_get_from_cache (self, addr_family, address, oif_ifindex);
+
+	if (   route_cached
+	    && priv->ip_route_get_mode == NM_PLATFORM_ROUTE_GET_MODE_CACHE) {
+		_LOGT ("route: get IPv%c route for: %s resolved from cache",
+		       nm_utils_addr_family_to_char (addr_family),
+		       inet_ntop (addr_family, address, buf, sizeof (buf)));
+		route = g_steal_pointer (&route_cached);
+		result = 0;
+	} else if (!klass->ip_route_get)
 		result = -NME_PL_OPNOTSUPP;
 	else {
 		result = klass->ip_route_get (self,
@@ -4654,6 +5514,15 @@ nm_platform_ip_route_get (NMPlatform *self,
 		                              &route);
 	}
 
+	if (   route_cached
+	    && (   result < 0
+	        || !_ip_route_get_result_equal (route_cached, route))) {
+		_LOGW ("route: get IPv%c route for: %s from cache differs from kernel: %s",
+		       nm_utils_addr_family_to_char (addr_family),
+		       inet_ntop (addr_family, address, buf, sizeof (buf)),
+		       nmp_object_to_string (route_cached, NMP_OBJECT_TO_STRING_PUBLIC, NULL, 0));
+	}
+
 	if (result < 0) {
 		nm_assert (!route);
 		_LOGW ("route: get IPv%c route for: %s failed with %s",
@@ -7176,6 +8045,8 @@ nm_platform_cache_update_emit_signal (NMPlatform *self,
 	ifindex = o->object.ifindex;
 	klass = NMP_OBJECT_GET_CLASS (o);
 
+	_route_sync_notify_cache_change (self, o, cache_op);
+
 	if (   klass->obj_type == NMP_OBJECT_TYPE_IP4_ROUTE
 	    && NM_PLATFORM_GET_PRIVATE (self)->ip4_dev_route_blacklist_gc_timeout_id
 	    && NM_IN_SET (cache_op, NMP_CACHE_OPS_ADDED, NMP_CACHE_OPS_UPDATED))
@@ -7317,6 +8188,8 @@ constructor (GType type,
 
 	priv->cache = nmp_cache_new (nm_platform_get_multi_idx (self),
 	                             priv->use_udev);
+	nmp_cache_route_index_set_enabled (priv->cache, TRUE);
+	priv->ip_route_get_mode = NM_PLATFORM_ROUTE_GET_MODE_KERNEL;
 	return object;
 }
 
@@ -7329,6 +8202,7 @@ finalize (GObject *object)
 	nm_clear_g_source (&priv->ip4_dev_route_blacklist_check_id);
 	nm_clear_g_source (&priv->ip4_dev_route_blacklist_gc_timeout_id);
 	g_clear_pointer (&priv->ip4_dev_route_blacklist_hash, g_hash_table_unref);
+	g_clear_pointer (&priv->route_sync_hash, g_hash_table_unref);
 	g_clear_object (&self->_netns);
 	nm_dedup_multi_index_unref (priv->multi_idx);
 	nmp_cache_free (priv->cache);
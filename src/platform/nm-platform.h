@@ -754,6 +754,50 @@ typedef enum {
 	NM_PLATFORM_KERNEL_SUPPORT_RTA_PREF                         = (1LL <<  2),
 } NMPlatformKernelSupportFlags;
 
+/**
+ * NMPlatformRouteGetMode:
+ * @NM_PLATFORM_ROUTE_GET_MODE_KERNEL: nm_platform_ip_route_get() always
+ *   asks kernel via RTM_GETROUTE.
+ * @NM_PLATFORM_ROUTE_GET_MODE_CACHE: resolve the route from the cached
+ *   routes of the main table, if the result is unambiguous. Otherwise,
+ *   fall back to asking kernel.
+ * @NM_PLATFORM_ROUTE_GET_MODE_STRICT: like %NM_PLATFORM_ROUTE_GET_MODE_CACHE,
+ *   but always ask kernel too and warn if the results differ. The result
+ *   from kernel is returned.
+ *
+ * The cache lookup does not know about routing rules, and the cache does
+ * not contain blackhole, unreachable, prohibit and throw routes. So, it
+ * can give a wrong answer if there are any of them. The default is
+ * %NM_PLATFORM_ROUTE_GET_MODE_KERNEL. The daemon selects the mode with the
+ * "route-get" option in the [main] section of NetworkManager.conf.
+ */
+typedef enum {
+	NM_PLATFORM_ROUTE_GET_MODE_KERNEL,
+	NM_PLATFORM_ROUTE_GET_MODE_CACHE,
+	NM_PLATFORM_ROUTE_GET_MODE_STRICT,
+} NMPlatformRouteGetMode;
+
+typedef enum {
+	NM_PLATFORM_BATCH_OP_ADD,
+	NM_PLATFORM_BATCH_OP_DELETE,
+} NMPlatformBatchOpType;
+
+/**
+ * NMPlatformBatchOp:
+ * @obj: the IPv4/IPv6 address or route to add or delete.
+ * @op_type: whether to add or delete @obj.
+ * @flags: for %NM_PLATFORM_BATCH_OP_ADD of routes, the flags as for
+ *   nm_platform_ip_route_add().
+ * @result: (out): set by nm_platform_object_batch(). Zero on success,
+ *   or a negative error code as for nm_platform_ip_route_add().
+ */
+typedef struct {
+	const NMPObject *obj;
+	NMPlatformBatchOpType op_type;
+	NMPNlmFlags flags;
+	int result;
+} NMPlatformBatchOp;
+
 /*****************************************************************************/
 
 struct _NMPlatformPrivate;
@@ -918,6 +962,8 @@ typedef struct {
 
 	gboolean (*object_delete) (NMPlatform *, const NMPObject *obj);
 
+	void (*object_batch) (NMPlatform *, NMPlatformBatchOp *ops, guint n_ops);
+
 	gboolean (*ip4_address_add) (NMPlatform *,
 	                             int ifindex,
 	                             in_addr_t address,
@@ -1399,6 +1445,8 @@ const NMPlatformIP6Address *nm_platform_ip6_address_get (NMPlatform *self, int i
 
 gboolean nm_platform_object_delete (NMPlatform *self, const NMPObject *route);
 
+void nm_platform_object_batch (NMPlatform *self, NMPlatformBatchOp *ops, guint n_ops);
+
 gboolean nm_platform_ip4_address_add (NMPlatform *self,
                                       int ifindex,
                                       in_addr_t address,
@@ -1445,10 +1493,32 @@ gboolean nm_platform_ip_route_sync (NMPlatform *self,
                                     GPtrArray *routes_prune,
                                     GPtrArray **out_temporary_not_available);
 
+gboolean nm_platform_ip_route_sync_can_incremental (NMPlatform *self,
+                                                    int addr_family,
+                                                    int ifindex,
+                                                    NMIPRouteTableSyncMode route_table_sync);
+
+void nm_platform_ip_route_sync_track (NMPlatform *self,
+                                      int addr_family,
+                                      int ifindex,
+                                      GPtrArray *routes,
+                                      NMIPRouteTableSyncMode route_table_sync);
+
+gboolean nm_platform_ip_route_sync_incremental (NMPlatform *self,
+                                                int addr_family,
+                                                int ifindex,
+                                                GPtrArray *routes,
+                                                NMIPRouteTableSyncMode route_table_sync,
+                                                GPtrArray **out_temporary_not_available);
+
 gboolean nm_platform_ip_route_flush (NMPlatform *self,
                                      int addr_family,
                                      int ifindex);
 
+NMPlatformRouteGetMode nm_platform_ip_route_get_get_mode (NMPlatform *self);
+void nm_platform_ip_route_get_set_mode (NMPlatform *self,
+                                        NMPlatformRouteGetMode mode);
+
 int nm_platform_ip_route_get (NMPlatform *self,
                               int addr_family,
                               gconstpointer address,
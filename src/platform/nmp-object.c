@@ -27,6 +27,8 @@
 #include <linux/if.h>
 #include <libudev.h>
 
+#include "c-rbtree/src/c-rbtree.h"
+
 #include "nm-utils.h"
 #include "nm-utils/nm-secret-utils.h"
 
@@ -61,6 +63,27 @@ typedef struct {
 	NMPCacheIdType cache_id_type;
 } DedupMultiIdxType;
 
+typedef struct {
+	guint32 table;
+	NMIPAddr network;
+	guint8 plen;
+	guint32 metric;
+} RouteIdxKey;
+
+typedef struct {
+	CRBNode rb_node;
+	RouteIdxKey key;
+	const NMPObject *obj;
+} RouteIdxNode;
+
+typedef struct {
+	CRBTree tree;
+
+	/* the number of routes per prefix length. Best-match lookups only
+	 * probe prefix lengths that are actually in use. */
+	guint plen_n[129];
+} RouteIdx;
+
 struct _NMPCache {
 	/* the cache contains only one hash table for all object types, and similarly
 	 * it contains only one NMMultiIndex.
@@ -84,6 +107,12 @@ struct _NMPCache {
 	 * Don't bother, use _idx_type_get() instead! */
 	DedupMultiIdxType idx_types[NMP_CACHE_ID_TYPE_MAX];
 
+	/* optional ordered index of the routes, sorted by (table, network, plen, metric).
+	 * Enable it with nmp_cache_route_index_set_enabled(). @route_idx_nodes maps
+	 * the route objects in the cache to their RouteIdxNode. */
+	GHashTable *route_idx_nodes;
+	RouteIdx route_idx[2];
+
 	gboolean use_udev;
 };
 
@@ -2143,6 +2172,180 @@ _idxcache_update_other_cache_ids (NMPCache *cache,
 		nm_dedup_multi_index_remove_entry (cache->multi_idx, entry_old);
 }
 
+static RouteIdx *
+_route_idx_get (const NMPCache *cache, int addr_family)
+{
+	nm_assert (NM_IN_SET (addr_family, AF_INET, AF_INET6));
+
+	return (RouteIdx *) &cache->route_idx[addr_family == AF_INET ? 0 : 1];
+}
+
+static void
+_route_idx_key_init (RouteIdxKey *key,
+                     int addr_family,
+                     guint32 table,
+                     gconstpointer network,
+                     guint8 plen,
+                     guint32 metric)
+{
+	memset (key, 0, sizeof (*key));
+	key->table = table;
+	if (addr_family == AF_INET)
+		key->network.addr4 = nm_utils_ip4_address_clear_host_address (*((const in_addr_t *) network), plen);
+	else
+		nm_utils_ip6_address_clear_host_address (&key->network.addr6, network, plen);
+	key->plen = plen;
+	key->metric = metric;
+}
+
+static void
+_route_idx_key_init_from_obj (RouteIdxKey *key, const NMPObject *obj)
+{
+	const NMPlatformIPXRoute *r = NMP_OBJECT_CAST_IPX_ROUTE (obj);
+
+	if (NMP_OBJECT_GET_TYPE (obj) == NMP_OBJECT_TYPE_IP4_ROUTE) {
+		_route_idx_key_init (key, AF_INET,
+		                     nm_platform_route_table_uncoerce (r->rx.table_coerced, TRUE),
+		                     &r->r4.network,
+		                     r->rx.plen,
+		                     r->rx.metric);
+	} else {
+		_route_idx_key_init (key, AF_INET6,
+		                     nm_platform_route_table_uncoerce (r->rx.table_coerced, TRUE),
+		                     &r->r6.network,
+		                     r->rx.plen,
+		                     r->rx.metric);
+	}
+}
+
+static int
+_route_idx_key_cmp (int addr_family, const RouteIdxKey *a, const RouteIdxKey *b)
+{
+	NM_CMP_FIELD (a, b, table);
+	if (addr_family == AF_INET)
+		NM_CMP_DIRECT (ntohl (a->network.addr4), ntohl (b->network.addr4));
+	else
+		NM_CMP_DIRECT_MEMCMP (&a->network.addr6, &b->network.addr6, sizeof (struct in6_addr));
+	NM_CMP_FIELD (a, b, plen);
+	NM_CMP_FIELD (a, b, metric);
+	return 0;
+}
+
+static int
+_route_idx_node_cmp (CRBTree *tree, void *k, CRBNode *n)
+{
+	const RouteIdxNode *node_a = k;
+	const RouteIdxNode *node_b = c_rbnode_entry (n, RouteIdxNode, rb_node);
+
+	/* several routes can share the same key (they differ for example by ifindex
+	 * or gateway). The ID makes the order total, because the cache contains
+	 * at most one object per ID. */
+	NM_CMP_RETURN (_route_idx_key_cmp (NMP_OBJECT_GET_CLASS (node_a->obj)->addr_family,
+	                                   &node_a->key,
+	                                   &node_b->key));
+	return nmp_object_id_cmp (node_a->obj, node_b->obj);
+}
+
+static RouteIdxNode *
+_route_idx_lower_bound (RouteIdx *route_idx,
+                        int addr_family,
+                        const RouteIdxKey *key)
+{
+	RouteIdxNode *result = NULL;
+	CRBNode *n;
+
+	/* find the first node that is not smaller than @key. */
+	n = route_idx->tree.root;
+	while (n) {
+		RouteIdxNode *node = c_rbnode_entry (n, RouteIdxNode, rb_node);
+
+		if (_route_idx_key_cmp (addr_family, &node->key, key) >= 0) {
+			result = node;
+			n = n->left;
+		} else
+			n = n->right;
+	}
+	return result;
+}
+
+static void
+_route_idx_node_free (gpointer data)
+{
+	RouteIdxNode *node = data;
+
+	nmp_object_unref (node->obj);
+	g_slice_free (RouteIdxNode, node);
+}
+
+static void
+_route_idx_add (NMPCache *cache, const NMPObject *obj)
+{
+	RouteIdx *route_idx;
+	RouteIdxNode *node;
+	CRBNode *parent;
+	CRBNode **slot;
+
+	node = g_slice_new (RouteIdxNode);
+	node->obj = nmp_object_ref (obj);
+	_route_idx_key_init_from_obj (&node->key, obj);
+
+	route_idx = _route_idx_get (cache, NMP_OBJECT_GET_CLASS (obj)->addr_family);
+
+	slot = c_rbtree_find_slot (&route_idx->tree, _route_idx_node_cmp, node, &parent);
+	if (!slot) {
+		/* the cache has only one object per ID. This cannot happen. */
+		nm_assert_not_reached ();
+		_route_idx_node_free (node);
+		return;
+	}
+	c_rbtree_add (&route_idx->tree, parent, slot, &node->rb_node);
+	route_idx->plen_n[node->key.plen]++;
+
+	if (!g_hash_table_insert (cache->route_idx_nodes, (gpointer) obj, node))
+		nm_assert_not_reached ();
+}
+
+static void
+_route_idx_remove (NMPCache *cache, const NMPObject *obj)
+{
+	RouteIdx *route_idx;
+	RouteIdxNode *node;
+
+	node = g_hash_table_lookup (cache->route_idx_nodes, obj);
+	if (!node) {
+		nm_assert_not_reached ();
+		return;
+	}
+
+	route_idx = _route_idx_get (cache, NMP_OBJECT_GET_CLASS (obj)->addr_family);
+
+	nm_assert (route_idx->plen_n[node->key.plen] > 0);
+	route_idx->plen_n[node->key.plen]--;
+	c_rbnode_unlink (&node->rb_node);
+
+	/* frees @node. */
+	g_hash_table_remove (cache->route_idx_nodes, obj);
+}
+
+static void
+_route_idx_update (NMPCache *cache,
+                   const NMPObject *obj_old,
+                   const NMPObject *obj_new)
+{
+	nm_assert (cache->route_idx_nodes);
+	nm_assert (!obj_old || NM_IN_SET (NMP_OBJECT_GET_TYPE (obj_old), NMP_OBJECT_TYPE_IP4_ROUTE,
+	                                                                  NMP_OBJECT_TYPE_IP6_ROUTE));
+	nm_assert (!obj_new || NM_IN_SET (NMP_OBJECT_GET_TYPE (obj_new), NMP_OBJECT_TYPE_IP4_ROUTE,
+	                                                                  NMP_OBJECT_TYPE_IP6_ROUTE));
+
+	if (obj_old == obj_new)
+		return;
+	if (obj_old)
+		_route_idx_remove (cache, obj_old);
+	if (obj_new)
+		_route_idx_add (cache, obj_new);
+}
+
 static void
 _idxcache_update (NMPCache *cache,
                   const NMDedupMultiEntry *entry_old,
@@ -2222,6 +2425,14 @@ _idxcache_update (NMPCache *cache,
 		                                  is_dump);
 	}
 
+	if (   cache->route_idx_nodes
+	    && NM_IN_SET (klass->obj_type, NMP_OBJECT_TYPE_IP4_ROUTE,
+	                                   NMP_OBJECT_TYPE_IP6_ROUTE)) {
+		_route_idx_update (cache,
+		                   obj_old,
+		                   entry_new ? entry_new->obj : NULL);
+	}
+
 	NM_SET_OUT (out_entry_new, entry_new);
 }
 
@@ -2754,6 +2965,202 @@ nmp_cache_dirty_set_all (NMPCache *cache, NMPObjectType obj_type)
 
 /*****************************************************************************/
 
+/**
+ * nmp_cache_route_index_set_enabled:
+ * @cache: the platform cache
+ * @enabled: whether to maintain the ordered route index
+ *
+ * The ordered route index keeps all IPv4 and IPv6 routes of the cache sorted by
+ * (table, network, plen, metric). It allows for range queries via
+ * nmp_cache_route_index_lower_bound() and nmp_cache_route_index_next() and for
+ * best-match lookups via nmp_cache_route_index_best_match(), without walking
+ * and sorting the unordered lists from nmp_cache_lookup_all().
+ *
+ * The index is disabled by default. Enabling it indexes all routes that are
+ * already in the cache, subsequently it is kept up to date on every cache update.
+ */
+void
+nmp_cache_route_index_set_enabled (NMPCache *cache, gboolean enabled)
+{
+	NMPLookup lookup;
+	NMDedupMultiIter iter;
+	const NMPObject *obj;
+	guint i;
+
+	g_return_if_fail (cache);
+
+	if (!enabled == !cache->route_idx_nodes)
+		return;
+
+	if (!enabled) {
+		/* the tree nodes are owned by the hash table. */
+		memset (cache->route_idx, 0, sizeof (cache->route_idx));
+		g_clear_pointer (&cache->route_idx_nodes, g_hash_table_unref);
+		return;
+	}
+
+	cache->route_idx_nodes = g_hash_table_new_full (nm_direct_hash, NULL, NULL, _route_idx_node_free);
+
+	for (i = 0; i < 2; i++) {
+		nmp_cache_iter_for_each (&iter,
+		                         nmp_cache_lookup (cache,
+		                                           nmp_lookup_init_obj_type (&lookup,
+		                                                                     i == 0
+		                                                                       ? NMP_OBJECT_TYPE_IP4_ROUTE
+		                                                                       : NMP_OBJECT_TYPE_IP6_ROUTE)),
+		                         &obj)
+			_route_idx_add (cache, obj);
+	}
+}
+
+gboolean
+nmp_cache_route_index_get_enabled (const NMPCache *cache)
+{
+	g_return_val_if_fail (cache, FALSE);
+
+	return !!cache->route_idx_nodes;
+}
+
+/**
+ * nmp_cache_route_index_lower_bound:
+ * @cache: the platform cache
+ * @addr_family: the address family, AF_INET or AF_INET6
+ * @table: the (uncoerced) route table
+ * @network: the network address, of type in_addr_t or struct in6_addr.
+ *   The host part is ignored.
+ * @plen: the prefix length
+ * @metric: the route metric
+ *
+ * Returns: the first route in the ordered index that sorts not before
+ *   (@table, @network, @plen, @metric), or %NULL. Continue iterating
+ *   with nmp_cache_route_index_next(). For example, to visit all routes of
+ *   a table, start with a zero @network, @plen and @metric and stop once
+ *   the table of the returned route changes.
+ */
+const NMPObject *
+nmp_cache_route_index_lower_bound (const NMPCache *cache,
+                                   int addr_family,
+                                   guint32 table,
+                                   gconstpointer network,
+                                   guint8 plen,
+                                   guint32 metric)
+{
+	RouteIdxKey key;
+	RouteIdxNode *node;
+
+	g_return_val_if_fail (cache, NULL);
+	g_return_val_if_fail (cache->route_idx_nodes, NULL);
+	g_return_val_if_fail (NM_IN_SET (addr_family, AF_INET, AF_INET6), NULL);
+	g_return_val_if_fail (network, NULL);
+	g_return_val_if_fail (plen <= (addr_family == AF_INET ? 32 : 128), NULL);
+
+	_route_idx_key_init (&key, addr_family, table, network, plen, metric);
+	node = _route_idx_lower_bound (_route_idx_get (cache, addr_family), addr_family, &key);
+	return node ? node->obj : NULL;
+}
+
+/**
+ * nmp_cache_route_index_next:
+ * @cache: the platform cache
+ * @obj: a route that is in the ordered index
+ *
+ * Returns: the route that follows @obj in the ordered index, or %NULL.
+ */
+const NMPObject *
+nmp_cache_route_index_next (const NMPCache *cache,
+                            const NMPObject *obj)
+{
+	RouteIdxNode *node;
+
+	g_return_val_if_fail (cache, NULL);
+	g_return_val_if_fail (cache->route_idx_nodes, NULL);
+
+	node = g_hash_table_lookup (cache->route_idx_nodes, obj);
+	g_return_val_if_fail (node, NULL);
+
+	node = c_rbnode_entry (c_rbnode_next (&node->rb_node), RouteIdxNode, rb_node);
+	return node ? node->obj : NULL;
+}
+
+/**
+ * nmp_cache_route_index_best_match:
+ * @cache: the platform cache
+ * @addr_family: the address family, AF_INET or AF_INET6
+ * @table: the (uncoerced) route table
+ * @dst: the destination address, of type in_addr_t or struct in6_addr
+ * @match_fn: (allow-none): if given, only consider routes for which
+ *   @match_fn returns %TRUE
+ * @user_data: user data for @match_fn
+ * @out_ambiguous: (allow-none): (out): whether there are several
+ *   matching routes with the same prefix and metric as the returned
+ *   one. In that case, the choice depends on the order in which the
+ *   routes were added and the result should not be trusted.
+ *
+ * Returns: the route in @table with the longest prefix that contains
+ *   @dst. Among those, the one with the lowest metric. Returns %NULL,
+ *   if no route matches.
+ *
+ * This only considers the routes in the cache of one table, it does
+ * not evaluate routing rules nor route types.
+ */
+const NMPObject *
+nmp_cache_route_index_best_match (const NMPCache *cache,
+                                  int addr_family,
+                                  guint32 table,
+                                  gconstpointer dst,
+                                  NMPObjectMatchFn match_fn,
+                                  gpointer user_data,
+                                  gboolean *out_ambiguous)
+{
+	RouteIdx *route_idx;
+	RouteIdxKey key;
+	RouteIdxNode *node;
+	RouteIdxNode *best;
+	int plen;
+
+	g_return_val_if_fail (cache, NULL);
+	g_return_val_if_fail (cache->route_idx_nodes, NULL);
+	g_return_val_if_fail (NM_IN_SET (addr_family, AF_INET, AF_INET6), NULL);
+	g_return_val_if_fail (dst, NULL);
+
+	route_idx = _route_idx_get (cache, addr_family);
+
+	for (plen = (addr_family == AF_INET ? 32 : 128); plen >= 0; plen--) {
+		if (route_idx->plen_n[plen] == 0)
+			continue;
+
+		best = NULL;
+		_route_idx_key_init (&key, addr_family, table, dst, plen, 0);
+		for (node = _route_idx_lower_bound (route_idx, addr_family, &key);
+		     node;
+		     node = c_rbnode_entry (c_rbnode_next (&node->rb_node), RouteIdxNode, rb_node)) {
+			if (!best)
+				key.metric = node->key.metric;
+			if (_route_idx_key_cmp (addr_family, &node->key, &key) != 0)
+				break;
+			if (   match_fn
+			    && !match_fn (node->obj, user_data))
+				continue;
+			if (best) {
+				/* a second match with the same metric. */
+				NM_SET_OUT (out_ambiguous, TRUE);
+				return best->obj;
+			}
+			best = node;
+			if (!out_ambiguous)
+				break;
+		}
+		if (best) {
+			NM_SET_OUT (out_ambiguous, FALSE);
+			return best->obj;
+		}
+	}
+	NM_SET_OUT (out_ambiguous, FALSE);
+	return NULL;
+}
+
+/*****************************************************************************/
+
 NMPCache *
 nmp_cache_new (NMDedupMultiIndex *multi_idx, gboolean use_udev)
 {
@@ -2774,6 +3181,8 @@ nmp_cache_free (NMPCache *cache)
 {
 	guint i;
 
+	nmp_cache_route_index_set_enabled (cache, FALSE);
+
 	for (i = NMP_CACHE_ID_TYPE_NONE + 1; i <= NMP_CACHE_ID_TYPE_MAX; i++)
 		nm_dedup_multi_index_remove_idx (cache->multi_idx, _idx_type_get (cache, i));
 
@@ -747,6 +747,24 @@ NMPCacheOpsType nmp_cache_update_link_master_connected (NMPCache *cache,
 
 void nmp_cache_dirty_set_all (NMPCache *cache, NMPObjectType obj_type);
 
+void nmp_cache_route_index_set_enabled (NMPCache *cache, gboolean enabled);
+gboolean nmp_cache_route_index_get_enabled (const NMPCache *cache);
+const NMPObject *nmp_cache_route_index_lower_bound (const NMPCache *cache,
+                                                    int addr_family,
+                                                    guint32 table,
+                                                    gconstpointer network,
+                                                    guint8 plen,
+                                                    guint32 metric);
+const NMPObject *nmp_cache_route_index_next (const NMPCache *cache,
+                                             const NMPObject *obj);
+const NMPObject *nmp_cache_route_index_best_match (const NMPCache *cache,
+                                                   int addr_family,
+                                                   guint32 table,
+                                                   gconstpointer dst,
+                                                   NMPObjectMatchFn match_fn,
+                                                   gpointer user_data,
+                                                   gboolean *out_ambiguous);
+
 NMPCache *nmp_cache_new (NMDedupMultiIndex *multi_idx, gboolean use_udev);
 void nmp_cache_free (NMPCache *cache);
 
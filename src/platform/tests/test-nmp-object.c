@@ -22,6 +22,7 @@
 
 #include <libudev.h>
 #include <linux/pkt_sched.h>
+#include <linux/rtnetlink.h>
 
 #include "platform/nmp-object.h"
 #include "nm-utils/nm-udev-utils.h"
@@ -539,6 +540,123 @@ test_cache_qdisc (void)
 
 /*****************************************************************************/
 
+static NMPObject *
+_route_index_new_ip4 (guint32 table,
+                      const char *network,
+                      guint8 plen,
+                      guint32 metric,
+                      int ifindex)
+{
+	const NMPlatformIP4Route r = {
+		.ifindex = ifindex,
+		.table_coerced = nm_platform_route_table_coerce (table),
+		.network = nmtst_inet4_from_string (network),
+		.plen = plen,
+		.metric = metric,
+	};
+
+	return nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, (NMPlatformObject *) &r);
+}
+
+static gboolean
+_route_index_match_ifindex (const NMPObject *obj, gpointer user_data)
+{
+	return NMP_OBJECT_CAST_IP_ROUTE (obj)->ifindex == GPOINTER_TO_INT (user_data);
+}
+
+static const NMPObject *
+_route_index_best_match (NMPCache *cache, guint32 table, const char *dst, int ifindex)
+{
+	in_addr_t a = nmtst_inet4_from_string (dst);
+	const NMPObject *obj;
+	gboolean ambiguous = TRUE;
+
+	obj = nmp_cache_route_index_best_match (cache, AF_INET, table, &a,
+	                                        ifindex > 0 ? _route_index_match_ifindex : NULL,
+	                                        GINT_TO_POINTER (ifindex),
+	                                        &ambiguous);
+	g_assert (!ambiguous);
+	return obj;
+}
+
+static void
+test_cache_route_index (void)
+{
+	NMPCache *cache;
+	nm_auto_unref_dedup_multi_index NMDedupMultiIndex *multi_idx = NULL;
+	nm_auto_nmpobj NMPObject *r_default = _route_index_new_ip4 (RT_TABLE_MAIN, "0.0.0.0", 0, 10, 1);
+	nm_auto_nmpobj NMPObject *r_8 = _route_index_new_ip4 (RT_TABLE_MAIN, "10.0.0.0", 8, 100, 1);
+	nm_auto_nmpobj NMPObject *r_16a = _route_index_new_ip4 (RT_TABLE_MAIN, "10.1.0.0", 16, 100, 1);
+	nm_auto_nmpobj NMPObject *r_16b = _route_index_new_ip4 (RT_TABLE_MAIN, "10.1.0.0", 16, 50, 2);
+	nm_auto_nmpobj NMPObject *r_table = _route_index_new_ip4 (10, "10.1.2.0", 24, 0, 1);
+	const NMPObject *obj;
+	in_addr_t a = 0;
+
+	multi_idx = nm_dedup_multi_index_new ();
+	cache = nmp_cache_new (multi_idx, nmtst_get_rand_int () % 2);
+
+	/* routes that are already cached get indexed when enabling the index. */
+	g_assert (nmp_cache_update_netlink_route (cache, r_8, FALSE, NLM_F_CREATE, NULL, NULL, NULL, NULL) == NMP_CACHE_OPS_ADDED);
+	g_assert (nmp_cache_update_netlink_route (cache, r_16a, FALSE, NLM_F_CREATE, NULL, NULL, NULL, NULL) == NMP_CACHE_OPS_ADDED);
+
+	g_assert (!nmp_cache_route_index_get_enabled (cache));
+	nmp_cache_route_index_set_enabled (cache, TRUE);
+	g_assert (nmp_cache_route_index_get_enabled (cache));
+
+	g_assert (nmp_cache_update_netlink_route (cache, r_16b, FALSE, NLM_F_CREATE, NULL, NULL, NULL, NULL) == NMP_CACHE_OPS_ADDED);
+	g_assert (nmp_cache_update_netlink_route (cache, r_default, FALSE, NLM_F_CREATE, NULL, NULL, NULL, NULL) == NMP_CACHE_OPS_ADDED);
+	g_assert (nmp_cache_update_netlink_route (cache, r_table, FALSE, NLM_F_CREATE, NULL, NULL, NULL, NULL) == NMP_CACHE_OPS_ADDED);
+
+	/* the main table in order (table, network, plen, metric). Table 10 sorts first. */
+	obj = nmp_cache_route_index_lower_bound (cache, AF_INET, RT_TABLE_MAIN, &a, 0, 0);
+	g_assert (obj == r_default);
+	obj = nmp_cache_route_index_next (cache, obj);
+	g_assert (obj == r_8);
+	obj = nmp_cache_route_index_next (cache, obj);
+	g_assert (obj == r_16b);
+	obj = nmp_cache_route_index_next (cache, obj);
+	g_assert (obj == r_16a);
+	g_assert (!nmp_cache_route_index_next (cache, obj));
+
+	g_assert (nmp_cache_route_index_lower_bound (cache, AF_INET, 10, &a, 0, 0) == r_table);
+	g_assert (nmp_cache_route_index_next (cache, r_table) == r_default);
+
+	g_assert (_route_index_best_match (cache, RT_TABLE_MAIN, "10.1.2.3", 0) == r_16b);
+	g_assert (_route_index_best_match (cache, RT_TABLE_MAIN, "10.1.2.3", 1) == r_16a);
+	g_assert (_route_index_best_match (cache, RT_TABLE_MAIN, "10.2.0.1", 0) == r_8);
+	g_assert (_route_index_best_match (cache, RT_TABLE_MAIN, "192.168.1.1", 0) == r_default);
+	g_assert (_route_index_best_match (cache, RT_TABLE_MAIN, "192.168.1.1", 2) == NULL);
+	g_assert (_route_index_best_match (cache, 10, "10.1.2.3", 0) == r_table);
+	g_assert (_route_index_best_match (cache, 10, "10.1.3.1", 0) == NULL);
+	g_assert (_route_index_best_match (cache, 11, "10.1.2.3", 0) == NULL);
+
+	/* two routes with the same prefix and metric. */
+	{
+		nm_auto_nmpobj NMPObject *r_16c = _route_index_new_ip4 (RT_TABLE_MAIN, "10.1.0.0", 16, 50, 3);
+		gboolean ambiguous = FALSE;
+
+		a = nmtst_inet4_from_string ("10.1.2.3");
+		g_assert (nmp_cache_update_netlink_route (cache, r_16c, FALSE, NLM_F_CREATE | NLM_F_APPEND, NULL, NULL, NULL, NULL) == NMP_CACHE_OPS_ADDED);
+		g_assert (NM_IN_SET (nmp_cache_route_index_best_match (cache, AF_INET, RT_TABLE_MAIN, &a, NULL, NULL, &ambiguous), r_16b, r_16c));
+		g_assert (ambiguous);
+		g_assert (_route_index_best_match (cache, RT_TABLE_MAIN, "10.1.2.3", 3) == r_16c);
+		g_assert (nmp_cache_remove (cache, r_16c, TRUE, FALSE, NULL) == NMP_CACHE_OPS_REMOVED);
+		a = 0;
+	}
+
+	/* removing a route from the cache drops it from the index. */
+	g_assert (nmp_cache_remove (cache, r_16b, TRUE, FALSE, NULL) == NMP_CACHE_OPS_REMOVED);
+	g_assert (_route_index_best_match (cache, RT_TABLE_MAIN, "10.1.2.3", 0) == r_16a);
+	g_assert (nmp_cache_route_index_next (cache, r_8) == r_16a);
+
+	nmp_cache_route_index_set_enabled (cache, FALSE);
+	g_assert (!nmp_cache_route_index_get_enabled (cache));
+
+	nmp_cache_free (cache);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -584,6 +702,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/nmp-object/obj-base", test_obj_base);
 	g_test_add_func ("/nmp-object/cache_link", test_cache_link);
 	g_test_add_func ("/nmp-object/cache_qdisc", test_cache_qdisc);
+	g_test_add_func ("/nmp-object/cache_route_index", test_cache_route_index);
 
 	result = g_test_run ();
 
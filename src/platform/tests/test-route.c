@@ -422,6 +422,315 @@ test_ip6_route (void)
 
 /*****************************************************************************/
 
+static void
+test_ip4_route_batch (void)
+{
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, DEVICE_NAME);
+	const guint n_routes = 300;
+	gs_free NMPlatformBatchOp *ops = NULL;
+	gs_unref_ptrarray GPtrArray *routes = NULL;
+	guint i;
+
+	ops = g_new0 (NMPlatformBatchOp, n_routes);
+
+	for (i = 0; i < n_routes; i++) {
+		NMPlatformIP4Route rt = {
+			.ifindex = ifindex,
+			.rt_source = NM_IP_CONFIG_SOURCE_USER,
+			.network = nmtst_inet4_from_string ("10.10.0.0") | htonl (i),
+			.plen = 32,
+			.metric = 22987,
+		};
+
+		ops[i].obj = nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, (const NMPlatformObject *) &rt);
+		ops[i].op_type = NM_PLATFORM_BATCH_OP_ADD;
+		ops[i].flags = NMP_NLM_FLAG_ADD;
+	}
+
+	nm_platform_object_batch (NM_PLATFORM_GET, ops, n_routes);
+	for (i = 0; i < n_routes; i++)
+		g_assert_cmpint (ops[i].result, ==, 0);
+
+	routes = nmtstp_ip4_route_get_all (NM_PLATFORM_GET, ifindex);
+	g_assert_cmpint (routes->len, ==, n_routes);
+	g_clear_pointer (&routes, g_ptr_array_unref);
+
+	for (i = 0; i < n_routes; i++)
+		ops[i].op_type = NM_PLATFORM_BATCH_OP_DELETE;
+
+	nm_platform_object_batch (NM_PLATFORM_GET, ops, n_routes);
+	for (i = 0; i < n_routes; i++) {
+		g_assert_cmpint (ops[i].result, ==, 0);
+		nmp_object_unref (ops[i].obj);
+	}
+
+	routes = nmtstp_ip4_route_get_all (NM_PLATFORM_GET, ifindex);
+	g_assert_cmpint (routes->len, ==, 0);
+}
+
+static NMPObject *
+_ip4_route_sync_obj_new (int ifindex, guint i, guint32 mss)
+{
+	const NMPlatformIP4Route rt = {
+		.ifindex = ifindex,
+		.rt_source = NM_IP_CONFIG_SOURCE_USER,
+		.network = nmtst_inet4_from_string ("10.30.0.0") | htonl (i << 8),
+		.plen = 24,
+		.metric = 22987,
+		.mss = mss,
+	};
+
+	return nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, (const NMPlatformObject *) &rt);
+}
+
+/* commit @routes like nm_ip4_config_commit() does. Returns whether
+ * the incremental sync was used. */
+static gboolean
+_ip4_route_sync_commit (int ifindex, GPtrArray *routes, NMIPRouteTableSyncMode sync_mode)
+{
+	gs_unref_ptrarray GPtrArray *routes_prune = NULL;
+
+	if (nm_platform_ip_route_sync_can_incremental (NM_PLATFORM_GET, AF_INET, ifindex, sync_mode)) {
+		g_assert (nm_platform_ip_route_sync_incremental (NM_PLATFORM_GET, AF_INET, ifindex, routes, sync_mode, NULL));
+		return TRUE;
+	}
+
+	routes_prune = nm_platform_ip_route_get_prune_list (NM_PLATFORM_GET, AF_INET, ifindex, sync_mode);
+	g_assert (nm_platform_ip_route_sync (NM_PLATFORM_GET, AF_INET, ifindex, routes, routes_prune, NULL));
+	nm_platform_ip_route_sync_track (NM_PLATFORM_GET, AF_INET, ifindex, routes, sync_mode);
+	return FALSE;
+}
+
+static void
+_ip4_route_sync_assert (int ifindex, GPtrArray *routes)
+{
+	gs_unref_ptrarray GPtrArray *plat_routes = NULL;
+	guint i;
+
+	plat_routes = nmtstp_ip4_route_get_all (NM_PLATFORM_GET, ifindex);
+	g_assert_cmpint (plat_routes->len, ==, routes->len);
+	for (i = 0; i < routes->len; i++) {
+		const NMDedupMultiEntry *entry;
+
+		entry = nm_platform_lookup_entry (NM_PLATFORM_GET, NMP_CACHE_ID_TYPE_OBJECT_TYPE, routes->pdata[i]);
+		g_assert (entry);
+		g_assert_cmpint (NMP_OBJECT_CAST_IP4_ROUTE (entry->obj)->mss, ==, NMP_OBJECT_CAST_IP4_ROUTE (routes->pdata[i])->mss);
+	}
+}
+
+static void
+test_ip4_route_sync_incremental (void)
+{
+	const NMIPRouteTableSyncMode sync_mode = NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN;
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, DEVICE_NAME);
+	SignalData *route_added = add_signal_ifindex (NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NM_PLATFORM_SIGNAL_ADDED, ip4_route_callback, ifindex);
+	SignalData *route_removed = add_signal_ifindex (NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NM_PLATFORM_SIGNAL_REMOVED, ip4_route_callback, ifindex);
+	gs_unref_ptrarray GPtrArray *routes = NULL;
+	const guint n_routes = 5;
+	guint i;
+
+	routes = g_ptr_array_new_with_free_func ((GDestroyNotify) nmp_object_unref);
+	for (i = 0; i < n_routes; i++)
+		g_ptr_array_add (routes, _ip4_route_sync_obj_new (ifindex, i, 0));
+
+	/* the first commit is a full sync, and tracks the routes. */
+	g_assert (!_ip4_route_sync_commit (ifindex, routes, sync_mode));
+	accept_signals (route_added, n_routes, n_routes);
+	_ip4_route_sync_assert (ifindex, routes);
+	g_assert ( nm_platform_ip_route_sync_can_incremental (NM_PLATFORM_GET, AF_INET, ifindex, sync_mode));
+	g_assert (!nm_platform_ip_route_sync_can_incremental (NM_PLATFORM_GET, AF_INET, ifindex, NM_IP_ROUTE_TABLE_SYNC_MODE_ALL));
+
+	/* nothing changed, nothing is sent. */
+	g_assert (_ip4_route_sync_commit (ifindex, routes, sync_mode));
+	ensure_no_signal (route_added);
+	ensure_no_signal (route_removed);
+
+	/* a single changed route is replaced, the others are not touched. */
+	nmp_object_unref (routes->pdata[2]);
+	routes->pdata[2] = _ip4_route_sync_obj_new (ifindex, 2, 1300);
+	g_assert (_ip4_route_sync_commit (ifindex, routes, sync_mode));
+	accept_signal (route_removed);
+	accept_signal (route_added);
+	_ip4_route_sync_assert (ifindex, routes);
+
+	/* a route that is no longer configured is removed. */
+	g_ptr_array_remove_index (routes, routes->len - 1);
+	g_assert (_ip4_route_sync_commit (ifindex, routes, sync_mode));
+	accept_signal (route_removed);
+	ensure_no_signal (route_added);
+	_ip4_route_sync_assert (ifindex, routes);
+	g_assert (nm_platform_ip_route_sync_can_incremental (NM_PLATFORM_GET, AF_INET, ifindex, sync_mode));
+
+	/* the routes change outside of a commit: one is added, one deleted. */
+	nmtstp_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER,
+	                      nmtst_inet4_from_string ("10.31.0.0"), 24, INADDR_ANY, 0, 22987, 0);
+	accept_signal (route_added);
+	g_assert (nmtstp_platform_ip4_route_delete (NM_PLATFORM_GET, ifindex,
+	                                            NMP_OBJECT_CAST_IP4_ROUTE (routes->pdata[0])->network,
+	                                            24, 22987));
+	accept_signal (route_removed);
+	g_assert (!nm_platform_ip_route_sync_can_incremental (NM_PLATFORM_GET, AF_INET, ifindex, sync_mode));
+
+	/* so the next commit falls back to a full sync, which restores the
+	 * deleted route and prunes the foreign one. */
+	g_assert (!_ip4_route_sync_commit (ifindex, routes, sync_mode));
+	accept_signal (route_added);
+	accept_signal (route_removed);
+	_ip4_route_sync_assert (ifindex, routes);
+	g_assert (nm_platform_ip_route_sync_can_incremental (NM_PLATFORM_GET, AF_INET, ifindex, sync_mode));
+
+	/* routes that changed after nm_platform_ip_route_sync_can_incremental()
+	 * returned TRUE (as when addresses are configured) are all checked against
+	 * the cache. The result is not tracked, because of the foreign route. */
+	nmtstp_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER,
+	                      nmtst_inet4_from_string ("10.31.0.0"), 24, INADDR_ANY, 0, 22987, 0);
+	accept_signal (route_added);
+	g_assert (nmtstp_platform_ip4_route_delete (NM_PLATFORM_GET, ifindex,
+	                                            NMP_OBJECT_CAST_IP4_ROUTE (routes->pdata[1])->network,
+	                                            24, 22987));
+	accept_signal (route_removed);
+	g_assert (nm_platform_ip_route_sync_incremental (NM_PLATFORM_GET, AF_INET, ifindex, routes, sync_mode, NULL));
+	accept_signal (route_added);
+	ensure_no_signal (route_removed);
+	g_assert (!nm_platform_ip_route_sync_can_incremental (NM_PLATFORM_GET, AF_INET, ifindex, sync_mode));
+
+	g_assert (!_ip4_route_sync_commit (ifindex, routes, sync_mode));
+	accept_signal (route_removed);
+	ensure_no_signal (route_added);
+	_ip4_route_sync_assert (ifindex, routes);
+
+	/* clean up */
+	g_ptr_array_set_size (routes, 0);
+	g_assert (_ip4_route_sync_commit (ifindex, routes, sync_mode));
+	accept_signals (route_removed, n_routes - 1, n_routes - 1);
+
+	free_signal (route_added);
+	free_signal (route_removed);
+}
+
+static void
+test_ip4_route_get_cache (void)
+{
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, DEVICE_NAME);
+	const guint n_routes = 256;
+	const guint n_lookups = 1000;
+	const gboolean has_kernel = NM_IS_LINUX_PLATFORM (NM_PLATFORM_GET);
+	const NMPlatformRouteGetMode mode = nm_platform_ip_route_get_get_mode (NM_PLATFORM_GET);
+	gs_free NMPlatformBatchOp *ops = NULL;
+	nm_auto_nmpobj NMPObject *route = NULL;
+	const NMPlatformIP4Route *r;
+	gint64 t_cache;
+	gint64 t_kernel = 0;
+	in_addr_t a;
+	guint i;
+
+	ops = g_new0 (NMPlatformBatchOp, n_routes + 1);
+
+	for (i = 0; i < n_routes + 1; i++) {
+		NMPlatformIP4Route rt = {
+			.ifindex = ifindex,
+			.rt_source = NM_IP_CONFIG_SOURCE_USER,
+			.metric = 22987,
+		};
+
+		if (i < n_routes) {
+			rt.network = nmtst_inet4_from_string ("10.20.0.0") | htonl (i << 8);
+			rt.plen = 24;
+		} else {
+			rt.network = nmtst_inet4_from_string ("10.0.0.0");
+			rt.plen = 8;
+		}
+
+		ops[i].obj = nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, (const NMPlatformObject *) &rt);
+		ops[i].op_type = NM_PLATFORM_BATCH_OP_ADD;
+		ops[i].flags = NMP_NLM_FLAG_ADD;
+	}
+
+	nm_platform_object_batch (NM_PLATFORM_GET, ops, n_routes + 1);
+	for (i = 0; i < n_routes + 1; i++)
+		g_assert_cmpint (ops[i].result, ==, 0);
+
+	nm_platform_ip_route_get_set_mode (NM_PLATFORM_GET, NM_PLATFORM_ROUTE_GET_MODE_CACHE);
+
+	a = nmtst_inet4_from_string ("10.20.5.7");
+	g_assert (NMTST_NM_ERR_SUCCESS (nm_platform_ip_route_get (NM_PLATFORM_GET, AF_INET, &a, 0, &route)));
+	r = NMP_OBJECT_CAST_IP4_ROUTE (route);
+	g_assert (NM_FLAGS_HAS (r->r_rtm_flags, RTM_F_CLONED));
+	g_assert_cmpint (r->ifindex, ==, ifindex);
+	g_assert (r->network == a);
+	g_assert_cmpint (r->plen, ==, 32);
+	g_assert (r->gateway == 0);
+	g_clear_pointer (&route, nmp_object_unref);
+
+	a = nmtst_inet4_from_string ("10.99.0.1");
+	g_assert (NMTST_NM_ERR_SUCCESS (nm_platform_ip_route_get (NM_PLATFORM_GET, AF_INET, &a, ifindex, &route)));
+	g_assert_cmpint (NMP_OBJECT_CAST_IP4_ROUTE (route)->ifindex, ==, ifindex);
+	g_clear_pointer (&route, nmp_object_unref);
+
+	/* microbenchmark: resolve via the cache and via RTM_GETROUTE. In strict mode,
+	 * each lookup also verifies the cache result against kernel. */
+	t_cache = g_get_monotonic_time ();
+	for (i = 0; i < n_lookups; i++) {
+		a = nmtst_inet4_from_string ("10.20.0.1") | htonl ((i % (n_routes + 16)) << 8);
+		g_assert (NMTST_NM_ERR_SUCCESS (nm_platform_ip_route_get (NM_PLATFORM_GET, AF_INET, &a, 0, &route)));
+		g_clear_pointer (&route, nmp_object_unref);
+	}
+	t_cache = g_get_monotonic_time () - t_cache;
+
+	if (has_kernel) {
+		nm_platform_ip_route_get_set_mode (NM_PLATFORM_GET, NM_PLATFORM_ROUTE_GET_MODE_KERNEL);
+		t_kernel = g_get_monotonic_time ();
+		for (i = 0; i < n_lookups; i++) {
+			a = nmtst_inet4_from_string ("10.20.0.1") | htonl ((i % (n_routes + 16)) << 8);
+			g_assert (NMTST_NM_ERR_SUCCESS (nm_platform_ip_route_get (NM_PLATFORM_GET, AF_INET, &a, 0, &route)));
+			g_clear_pointer (&route, nmp_object_unref);
+		}
+		t_kernel = g_get_monotonic_time () - t_kernel;
+
+		/* the answer from the cache must agree with kernel, both for addresses
+		 * that hit one of our routes and for those that don't. */
+		for (i = 0; i < n_routes + 16; i++) {
+			nm_auto_nmpobj NMPObject *route_kernel = NULL;
+			const NMPlatformIP4Route *r_kernel;
+			int result;
+			int result_kernel;
+
+			a = nmtst_inet4_from_string ("10.20.0.1") | htonl (i << 8);
+
+			nm_platform_ip_route_get_set_mode (NM_PLATFORM_GET, NM_PLATFORM_ROUTE_GET_MODE_CACHE);
+			result = nm_platform_ip_route_get (NM_PLATFORM_GET, AF_INET, &a, 0, &route);
+			nm_platform_ip_route_get_set_mode (NM_PLATFORM_GET, NM_PLATFORM_ROUTE_GET_MODE_KERNEL);
+			result_kernel = nm_platform_ip_route_get (NM_PLATFORM_GET, AF_INET, &a, 0, &route_kernel);
+
+			g_assert_cmpint (result, ==, result_kernel);
+			if (result < 0)
+				continue;
+
+			r = NMP_OBJECT_CAST_IP4_ROUTE (route);
+			r_kernel = NMP_OBJECT_CAST_IP4_ROUTE (route_kernel);
+			g_assert_cmpint (r->ifindex, ==, r_kernel->ifindex);
+			g_assert_cmpint (r->gateway, ==, r_kernel->gateway);
+			g_assert_cmpint (r->table_coerced, ==, r_kernel->table_coerced);
+			g_assert (r->network == r_kernel->network);
+			g_assert_cmpint (r->plen, ==, r_kernel->plen);
+			g_clear_pointer (&route, nmp_object_unref);
+		}
+	}
+
+	_LOGI ("route-get: %u lookups from cache took %"G_GINT64_FORMAT" usec, from kernel %"G_GINT64_FORMAT" usec",
+	       n_lookups, t_cache, t_kernel);
+
+	nm_platform_ip_route_get_set_mode (NM_PLATFORM_GET, mode);
+
+	for (i = 0; i < n_routes + 1; i++)
+		ops[i].op_type = NM_PLATFORM_BATCH_OP_DELETE;
+	nm_platform_object_batch (NM_PLATFORM_GET, ops, n_routes + 1);
+	for (i = 0; i < n_routes + 1; i++) {
+		g_assert_cmpint (ops[i].result, ==, 0);
+		nmp_object_unref (ops[i].obj);
+	}
+}
+
 static void
 test_ip4_route_get (void)
 {
@@ -889,6 +1198,9 @@ _nmtstp_setup_tests (void)
 	add_test_func ("/route/ip4", test_ip4_route);
 	add_test_func ("/route/ip6", test_ip6_route);
 	add_test_func ("/route/ip4_metric0", test_ip4_route_metric0);
+	add_test_func ("/route/ip4_batch", test_ip4_route_batch);
+	add_test_func ("/route/ip4_route_get_cache", test_ip4_route_get_cache);
+	add_test_func ("/route/ip4_sync_incremental", test_ip4_route_sync_incremental);
 	add_test_func_data ("/route/ip4_options/1", test_ip4_route_options, GINT_TO_POINTER (1));
 	if (nmtstp_is_root_test ())
 		add_test_func_data ("/route/ip4_options/2", test_ip4_route_options, GINT_TO_POINTER (2));
@@ -118,6 +118,12 @@ struct _NMSettingsConnection {
 	NMDBusObject parent;
 	struct _NMSettingsConnectionPrivate *_priv;
 	CList _connections_lst;
+
+	/* the keys under which NMSettings indexes the connection. They
+	 * are owned and only accessed by NMSettings. */
+	char *_idx_uuid;
+	char *_idx_ifname;
+	char *_idx_type;
 };
 
 struct _NMSettingsConnectionClass {
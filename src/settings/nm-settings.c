@@ -123,6 +123,14 @@ typedef struct {
 
 	CList connections_lst_head;
 
+	/* indexes of the connections in @connections_lst_head. They map the UUID, the
+	 * interface-name and the connection type to a set of connections. Profiles without
+	 * interface-name are indexed by "". UUIDs are supposed to be unique, but plugins
+	 * might still provide duplicates, so that index has buckets too. */
+	GHashTable *connections_by_uuid;
+	GHashTable *connections_by_ifname;
+	GHashTable *connections_by_type;
+
 	NMSettingsConnection **connections_cached_list;
 	GSList *unmanaged_specs;
 	GSList *unrecognized_specs;
@@ -287,19 +295,52 @@ NMSettingsConnection *
 nm_settings_get_connection_by_uuid (NMSettings *self, const char *uuid)
 {
 	NMSettingsPrivate *priv;
+	NMSettingsConnection *sett_conn;
 	NMSettingsConnection *candidate;
+	GHashTable *bucket;
 
 	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
 	g_return_val_if_fail (uuid != NULL, NULL);
 
 	priv = NM_SETTINGS_GET_PRIVATE (self);
 
-	c_list_for_each_entry (candidate, &priv->connections_lst_head, _connections_lst) {
-		if (nm_streq (uuid, nm_settings_connection_get_uuid (candidate)))
-			return candidate;
+	bucket = g_hash_table_lookup (priv->connections_by_uuid, uuid);
+	if (!bucket)
+		sett_conn = NULL;
+	else if (g_hash_table_size (bucket) == 1) {
+		GHashTableIter iter;
+
+		g_hash_table_iter_init (&iter, bucket);
+		if (!g_hash_table_iter_next (&iter, (gpointer *) &sett_conn, NULL))
+			nm_assert_not_reached ();
+	} else {
+		/* with duplicate UUIDs, return the first one in the list, like a
+		 * linear search would. */
+		sett_conn = NULL;
+		c_list_for_each_entry (candidate, &priv->connections_lst_head, _connections_lst) {
+			if (g_hash_table_contains (bucket, candidate)) {
+				sett_conn = candidate;
+				break;
+			}
+		}
+		nm_assert (sett_conn);
 	}
 
-	return NULL;
+	nm_assert (!sett_conn || nm_streq0 (uuid, nm_settings_connection_get_uuid (sett_conn)));
+#if NM_MORE_ASSERTS > 5
+	nm_assert (({
+		NMSettingsConnection *candidate, *found = NULL;
+
+		c_list_for_each_entry (candidate, &priv->connections_lst_head, _connections_lst) {
+			if (nm_streq0 (uuid, nm_settings_connection_get_uuid (candidate))) {
+				found = candidate;
+				break;
+			}
+		}
+		found == sett_conn;
+	}));
+#endif
+	return sett_conn;
 }
 
 static void
@@ -351,6 +392,81 @@ error:
 	g_dbus_method_invocation_take_error (invocation, error);
 }
 
+static void
+_connections_idx_bucket_add (GHashTable *idx, const char *key, NMSettingsConnection *sett_conn)
+{
+	GHashTable *bucket;
+
+	bucket = g_hash_table_lookup (idx, key);
+	if (!bucket) {
+		bucket = g_hash_table_new (nm_direct_hash, NULL);
+		g_hash_table_insert (idx, g_strdup (key), bucket);
+	}
+	if (!nm_g_hash_table_add (bucket, sett_conn))
+		nm_assert_not_reached ();
+}
+
+static void
+_connections_idx_bucket_remove (GHashTable *idx, const char *key, NMSettingsConnection *sett_conn)
+{
+	GHashTable *bucket;
+
+	bucket = g_hash_table_lookup (idx, key);
+	if (   !bucket
+	    || !g_hash_table_remove (bucket, sett_conn))
+		g_return_if_reached ();
+	if (g_hash_table_size (bucket) == 0)
+		g_hash_table_remove (idx, key);
+}
+
+static void
+_connections_idx_add (NMSettingsPrivate *priv, NMSettingsConnection *sett_conn)
+{
+	NMConnection *connection = nm_settings_connection_get_connection (sett_conn);
+
+	nm_assert (!sett_conn->_idx_uuid);
+
+	sett_conn->_idx_uuid = g_strdup (nm_connection_get_uuid (connection));
+	sett_conn->_idx_ifname = g_strdup (nm_connection_get_interface_name (connection) ?: "");
+	sett_conn->_idx_type = g_strdup (nm_connection_get_connection_type (connection) ?: "");
+
+	nm_assert (sett_conn->_idx_uuid);
+
+	_connections_idx_bucket_add (priv->connections_by_uuid, sett_conn->_idx_uuid, sett_conn);
+	_connections_idx_bucket_add (priv->connections_by_ifname, sett_conn->_idx_ifname, sett_conn);
+	_connections_idx_bucket_add (priv->connections_by_type, sett_conn->_idx_type, sett_conn);
+}
+
+static void
+_connections_idx_remove (NMSettingsPrivate *priv, NMSettingsConnection *sett_conn)
+{
+	nm_assert (sett_conn->_idx_uuid);
+
+	_connections_idx_bucket_remove (priv->connections_by_uuid, sett_conn->_idx_uuid, sett_conn);
+	_connections_idx_bucket_remove (priv->connections_by_ifname, sett_conn->_idx_ifname, sett_conn);
+	_connections_idx_bucket_remove (priv->connections_by_type, sett_conn->_idx_type, sett_conn);
+
+	nm_clear_g_free (&sett_conn->_idx_uuid);
+	nm_clear_g_free (&sett_conn->_idx_ifname);
+	nm_clear_g_free (&sett_conn->_idx_type);
+}
+
+static void
+_connections_idx_update (NMSettingsPrivate *priv, NMSettingsConnection *sett_conn)
+{
+	NMConnection *connection = nm_settings_connection_get_connection (sett_conn);
+
+	if (   nm_streq0 (sett_conn->_idx_uuid, nm_connection_get_uuid (connection))
+	    && nm_streq (sett_conn->_idx_ifname, nm_connection_get_interface_name (connection) ?: "")
+	    && nm_streq (sett_conn->_idx_type, nm_connection_get_connection_type (connection) ?: ""))
+		return;
+
+	_connections_idx_remove (priv, sett_conn);
+	_connections_idx_add (priv, sett_conn);
+}
+
+/*****************************************************************************/
+
 static void
 _clear_connections_cached_list (NMSettingsPrivate *priv)
 {
@@ -476,6 +592,147 @@ nm_settings_get_connections_clone (NMSettings *self,
 	return list;
 }
 
+static NMSettingsConnection **
+_connections_clone_from_buckets (NMSettings *self,
+                                 GHashTable *bucket1,
+                                 GHashTable *bucket2,
+                                 guint *out_len,
+                                 NMSettingsConnectionFilterFunc func,
+                                 gpointer func_data,
+                                 GCompareDataFunc sort_compare_func,
+                                 gpointer sort_data)
+{
+	GHashTable *buckets[] = { bucket1, bucket2 };
+	NMSettingsConnection **list;
+	NMSettingsConnection *sett_conn;
+	GHashTableIter iter;
+	guint len = 0, i;
+
+	for (i = 0; i < G_N_ELEMENTS (buckets); i++) {
+		if (buckets[i])
+			len += g_hash_table_size (buckets[i]);
+	}
+
+	list = g_new (NMSettingsConnection *, ((gsize) len + 1));
+	len = 0;
+	for (i = 0; i < G_N_ELEMENTS (buckets); i++) {
+		if (!buckets[i])
+			continue;
+		g_hash_table_iter_init (&iter, buckets[i]);
+		while (g_hash_table_iter_next (&iter, (gpointer *) &sett_conn, NULL)) {
+			if (   !func
+			    || func (self, sett_conn, func_data))
+				list[len++] = sett_conn;
+		}
+	}
+	list[len] = NULL;
+
+	/* the buckets are unordered. Always sort, so that the result doesn't
+	 * depend on the hash table order. */
+	if (!sort_compare_func) {
+		sort_compare_func = nm_settings_connection_cmp_timestamp_p_with_data;
+		sort_data = NULL;
+	}
+	if (len > 1) {
+		g_qsort_with_data (list, len, sizeof (NMSettingsConnection *),
+		                   sort_compare_func, sort_data);
+	}
+	NM_SET_OUT (out_len, len);
+	return list;
+}
+
+/**
+ * nm_settings_get_connections_clone_for_ifname:
+ * @self: the #NMSettings
+ * @ifname: (allow-none): the interface name
+ * @out_len: (allow-none): optional output argument
+ * @func: caller-supplied function for filtering connections
+ * @func_data: caller-supplied data passed to @func
+ * @sort_compare_func: (allow-none): optional function pointer for
+ *   sorting the returned list. If %NULL, the list is sorted with
+ *   nm_settings_connection_cmp_timestamp_p_with_data().
+ * @sort_data: user data for @sort_compare_func.
+ *
+ * Like nm_settings_get_connections_clone(), but only considers the
+ * profiles that can apply to an interface named @ifname: those which
+ * have a matching interface-name or no interface-name at all.
+ * If @ifname is %NULL, only the latter are returned.
+ * The lookup uses an index, it does not iterate over all profiles.
+ *
+ * Returns: (transfer container) (element-type NMSettingsConnection):
+ *   a NULL terminated array of #NMSettingsConnection objects.
+ */
+NMSettingsConnection **
+nm_settings_get_connections_clone_for_ifname (NMSettings *self,
+                                              const char *ifname,
+                                              guint *out_len,
+                                              NMSettingsConnectionFilterFunc func,
+                                              gpointer func_data,
+                                              GCompareDataFunc sort_compare_func,
+                                              gpointer sort_data)
+{
+	NMSettingsPrivate *priv;
+
+	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
+
+	priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	return _connections_clone_from_buckets (self,
+	                                        g_hash_table_lookup (priv->connections_by_ifname, ""),
+	                                        ifname && ifname[0]
+	                                          ? g_hash_table_lookup (priv->connections_by_ifname, ifname)
+	                                          : NULL,
+	                                        out_len,
+	                                        func,
+	                                        func_data,
+	                                        sort_compare_func,
+	                                        sort_data);
+}
+
+/**
+ * nm_settings_get_connections_clone_for_type:
+ * @self: the #NMSettings
+ * @connection_type: the connection type, as in #NMSettingConnection:type
+ * @out_len: (allow-none): optional output argument
+ * @func: caller-supplied function for filtering connections
+ * @func_data: caller-supplied data passed to @func
+ * @sort_compare_func: (allow-none): optional function pointer for
+ *   sorting the returned list. If %NULL, the list is sorted with
+ *   nm_settings_connection_cmp_timestamp_p_with_data().
+ * @sort_data: user data for @sort_compare_func.
+ *
+ * Like nm_settings_get_connections_clone(), but only returns profiles
+ * of type @connection_type. The lookup uses an index.
+ *
+ * Returns: (transfer container) (element-type NMSettingsConnection):
+ *   a NULL terminated array of #NMSettingsConnection objects.
+ */
+NMSettingsConnection **
+nm_settings_get_connections_clone_for_type (NMSettings *self,
+                                            const char *connection_type,
+                                            guint *out_len,
+                                            NMSettingsConnectionFilterFunc func,
+                                            gpointer func_data,
+                                            GCompareDataFunc sort_compare_func,
+                                            gpointer sort_data)
+{
+	NMSettingsPrivate *priv;
+
+	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
+	g_return_val_if_fail (connection_type, NULL);
+
+	priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	return _connections_clone_from_buckets (self,
+	                                        g_hash_table_lookup (priv->connections_by_type, connection_type),
+	                                        NULL,
+	                                        out_len,
+	                                        func,
+	                                        func_data,
+	                                        sort_compare_func,
+	                                        sort_data);
+}
+
 NMSettingsConnection *
 nm_settings_get_connection_by_path (NMSettings *self, const char *path)
 {
@@ -778,6 +1035,8 @@ load_plugins (NMSettings *self, const char **plugins, GError **error)
 static void
 connection_updated (NMSettingsConnection *connection, gboolean by_user, gpointer user_data)
 {
+	_connections_idx_update (NM_SETTINGS_GET_PRIVATE ((NMSettings *) user_data), connection);
+
 	g_signal_emit (NM_SETTINGS (user_data),
 	               signals[CONNECTION_UPDATED],
 	               0,
@@ -828,6 +1087,7 @@ connection_removed (NMSettingsConnection *connection, gpointer user_data)
 
 	/* Forget about the connection internally */
 	_clear_connections_cached_list (priv);
+	_connections_idx_remove (priv, connection);
 	priv->connections_len--;
 	c_list_unlink (&connection->_connections_lst);
 
@@ -975,6 +1235,7 @@ claim_connection (NMSettings *self, NMSettingsConnection *sett_conn)
 	g_object_ref (self);
 	priv->connections_len++;
 	c_list_link_tail (&priv->connections_lst_head, &sett_conn->_connections_lst);
+	_connections_idx_add (priv, sett_conn);
 
 	path = nm_dbus_object_export (NM_DBUS_OBJECT (sett_conn));
 
@@ -1044,20 +1305,18 @@ nm_settings_add_connection (NMSettings *self,
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 	GSList *iter;
 	NMSettingsConnection *added = NULL;
-	NMSettingsConnection *candidate = NULL;
 	const char *uuid;
 
 	uuid = nm_connection_get_uuid (connection);
 
 	/* Make sure a connection with this UUID doesn't already exist */
-	c_list_for_each_entry (candidate, &priv->connections_lst_head, _connections_lst) {
-		if (nm_streq0 (uuid, nm_settings_connection_get_uuid (candidate))) {
-			g_set_error_literal (error,
-			                     NM_SETTINGS_ERROR,
-			                     NM_SETTINGS_ERROR_UUID_EXISTS,
-			                     "A connection with this UUID already exists.");
-			return NULL;
-		}
+	if (   uuid
+	    && g_hash_table_contains (priv->connections_by_uuid, uuid)) {
+		g_set_error_literal (error,
+		                     NM_SETTINGS_ERROR,
+		                     NM_SETTINGS_ERROR_UUID_EXISTS,
+		                     "A connection with this UUID already exists.");
+		return NULL;
 	}
 
 	/* 1) plugin writes the NMConnection to disk
@@ -1873,6 +2132,10 @@ nm_settings_init (NMSettings *self)
 
 	c_list_init (&priv->connections_lst_head);
 
+	priv->connections_by_uuid = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+	priv->connections_by_ifname = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+	priv->connections_by_type = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+
 	priv->agent_mgr = g_object_ref (nm_agent_manager_get ());
 	priv->config = g_object_ref (nm_config_get ());
 }
@@ -1915,6 +2178,11 @@ finalize (GObject *object)
 
 	nm_assert (c_list_is_empty (&priv->connections_lst_head));
 
+	nm_assert (g_hash_table_size (priv->connections_by_uuid) == 0);
+	g_hash_table_unref (priv->connections_by_uuid);
+	g_hash_table_unref (priv->connections_by_ifname);
+	g_hash_table_unref (priv->connections_by_type);
+
 	g_slist_free_full (priv->unmanaged_specs, g_free);
 	g_slist_free_full (priv->unrecognized_specs, g_free);
 
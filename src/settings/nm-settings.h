@@ -94,6 +94,22 @@ NMSettingsConnection **nm_settings_get_connections_clone (NMSettings *self,
                                                           GCompareDataFunc sort_compare_func,
                                                           gpointer sort_data);
 
+NMSettingsConnection **nm_settings_get_connections_clone_for_ifname (NMSettings *self,
+                                                                     const char *ifname,
+                                                                     guint *out_len,
+                                                                     NMSettingsConnectionFilterFunc func,
+                                                                     gpointer func_data,
+                                                                     GCompareDataFunc sort_compare_func,
+                                                                     gpointer sort_data);
+
+NMSettingsConnection **nm_settings_get_connections_clone_for_type (NMSettings *self,
+                                                                   const char *connection_type,
+                                                                   guint *out_len,
+                                                                   NMSettingsConnectionFilterFunc func,
+                                                                   gpointer func_data,
+                                                                   GCompareDataFunc sort_compare_func,
+                                                                   gpointer sort_data);
+
 NMSettingsConnection *nm_settings_add_connection (NMSettings *settings,
                                                   NMConnection *connection,
                                                   gboolean save_to_disk,
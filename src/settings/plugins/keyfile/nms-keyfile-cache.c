@@ -0,0 +1,333 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service - keyfile plugin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nms-keyfile-cache.h"
+
+#include <sys/stat.h>
+#include <string.h>
+
+#include "nm-core-internal.h"
+#include "nm-utils/nm-io-utils.h"
+
+#include "nms-keyfile-reader.h"
+
+#if !defined(NM_DIST_VERSION)
+# define NM_DIST_VERSION VERSION
+#endif
+
+/*****************************************************************************/
+
+#define _NMLOG_PREFIX_NAME      "keyfile"
+#define _NMLOG_DOMAIN           LOGD_SETTINGS
+#define _NMLOG(level, ...) \
+    nm_log ((level), _NMLOG_DOMAIN, NULL, NULL, \
+            "%s" _NM_UTILS_MACRO_FIRST (__VA_ARGS__), \
+            _NMLOG_PREFIX_NAME": " \
+            _NM_UTILS_MACRO_REST (__VA_ARGS__))
+
+/*****************************************************************************/
+
+gboolean
+nms_keyfile_file_stamp_get (const char *full_path, NMSKeyfileFileStamp *stamp)
+{
+	struct stat st;
+
+	if (stat (full_path, &st) != 0)
+		return FALSE;
+
+	*stamp = (NMSKeyfileFileStamp) {
+		.dev      = st.st_dev,
+		.ino      = st.st_ino,
+		.size     = st.st_size,
+		.mtime_ns = (guint64) st.st_mtim.tv_sec * NM_UTILS_NS_PER_SECOND + st.st_mtim.tv_nsec,
+		.ctime_ns = (guint64) st.st_ctim.tv_sec * NM_UTILS_NS_PER_SECOND + st.st_ctim.tv_nsec,
+	};
+	return TRUE;
+}
+
+/**
+ * nms_keyfile_cache_get_build_id:
+ *
+ * Returns: the identifier of this build that is stored in the cache.
+ *   A cache written by a different build is ignored.
+ */
+const char *
+nms_keyfile_cache_get_build_id (void)
+{
+#if defined(NM_GIT_SHA)
+	return NM_DIST_VERSION " " NM_GIT_SHA;
+#else
+	return NM_DIST_VERSION;
+#endif
+}
+
+/*****************************************************************************/
+
+/**
+ * nms_keyfile_cache_load:
+ * @cache_file: the cache to load
+ * @profile_dir: the configured profile directory
+ *
+ * Returns: (transfer full): a hash table of the cache entries by the path
+ *   of their keyfile, or %NULL if the cache does not exist, or if it was
+ *   written by another build or for another profile directory.
+ */
+GHashTable *
+nms_keyfile_cache_load (const char *cache_file,
+                        const char *profile_dir)
+{
+	gs_free_error GError *error = NULL;
+	gs_unref_variant GVariant *cache = NULL;
+	gs_unref_variant GVariant *entries_variant = NULL;
+	GMappedFile *mapped;
+	GBytes *bytes;
+	GHashTable *entries;
+	GVariantIter iter;
+	GVariant *entry;
+	guint32 version;
+	const char *build_id;
+	const char *cache_profile_dir;
+
+	mapped = g_mapped_file_new (cache_file, FALSE, &error);
+	if (!mapped) {
+		_LOGT ("cache: cannot open \"%s\": %s", cache_file, error->message);
+		return NULL;
+	}
+	bytes = g_mapped_file_get_bytes (mapped);
+	g_mapped_file_unref (mapped);
+
+	/* The data is untrusted, but accessing a GVariant in non-normal
+	 * form is safe. */
+	cache = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (NMS_KEYFILE_CACHE_TYPE), bytes, FALSE));
+	g_bytes_unref (bytes);
+
+	g_variant_get (cache, "(u&s&s@a(sttttta{sa{sv}}a(uss)))",
+	               &version,
+	               &build_id,
+	               &cache_profile_dir,
+	               &entries_variant);
+	if (version != NMS_KEYFILE_CACHE_VERSION) {
+		_LOGD ("cache: ignore \"%s\" with unsupported version %u", cache_file, (guint) version);
+		return NULL;
+	}
+
+	/* normalization changes between versions, so the connections of
+	 * another build might no longer be valid. */
+	if (!nm_streq (build_id, nms_keyfile_cache_get_build_id ())) {
+		_LOGD ("cache: ignore \"%s\" written by NetworkManager \"%s\"", cache_file, build_id);
+		return NULL;
+	}
+
+	/* the generated UUIDs depend on the profile directory. */
+	if (!nm_streq (cache_profile_dir, profile_dir)) {
+		_LOGD ("cache: ignore \"%s\" for different profile directory", cache_file);
+		return NULL;
+	}
+
+	entries = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, (GDestroyNotify) g_variant_unref);
+
+	g_variant_iter_init (&iter, entries_variant);
+	while ((entry = g_variant_iter_next_value (&iter))) {
+		const char *path;
+
+		g_variant_get_child (entry, 0, "&s", &path);
+		if (path[0] != '/') {
+			g_variant_unref (entry);
+			continue;
+		}
+		/* the key points into the entry, which is owned by the hash table. */
+		g_hash_table_insert (entries, (char *) path, entry);
+	}
+
+	_LOGD ("cache: loaded %u entries from \"%s\"", g_hash_table_size (entries), cache_file);
+	return entries;
+}
+
+/**
+ * nms_keyfile_cache_entry_new:
+ * @full_path: the path of the keyfile
+ * @stamp: the stat() data of @full_path, before it was read
+ * @connection: the connection read from @full_path. Its secrets
+ *   are not stored, so callers only add connections without secrets.
+ * @warnings: (allow-none): the #NMSKeyfileReaderWarning from reading the file
+ *
+ * Returns: (transfer full): the cache entry for @full_path. Can be called
+ *   from any thread.
+ */
+GVariant *
+nms_keyfile_cache_entry_new (const char *full_path,
+                             const NMSKeyfileFileStamp *stamp,
+                             NMConnection *connection,
+                             GPtrArray *warnings)
+{
+	GVariantBuilder warnings_builder;
+	guint i;
+
+	g_variant_builder_init (&warnings_builder, G_VARIANT_TYPE ("a(uss)"));
+	for (i = 0; warnings && i < warnings->len; i++) {
+		const NMSKeyfileReaderWarning *w = warnings->pdata[i];
+
+		g_variant_builder_add (&warnings_builder, "(uss)",
+		                       (guint32) w->level,
+		                       w->uuid ?: "",
+		                       w->message);
+	}
+
+	return g_variant_ref_sink (g_variant_new ("(sttttt@a{sa{sv}}@a(uss))",
+	                                          full_path,
+	                                          stamp->dev,
+	                                          stamp->ino,
+	                                          stamp->size,
+	                                          stamp->mtime_ns,
+	                                          stamp->ctime_ns,
+	                                          nm_connection_to_dbus (connection, NM_CONNECTION_SERIALIZE_NO_SECRETS),
+	                                          g_variant_builder_end (&warnings_builder)));
+}
+
+/**
+ * nms_keyfile_cache_lookup:
+ * @cache: (allow-none): the cache from nms_keyfile_cache_load()
+ * @full_path: the path of the keyfile
+ * @stamp: the current stat() data of @full_path
+ * @out_entry: (out) (transfer full): the matching cache entry
+ * @out_warnings: (out) (transfer full): the warnings that were emitted when
+ *   the file was read, to be logged again.
+ *
+ * Returns: (transfer full): the cached connection for @full_path, or %NULL
+ *   if there is none or the file changed. Can be called from any thread.
+ */
+NMConnection *
+nms_keyfile_cache_lookup (GHashTable *cache,
+                          const char *full_path,
+                          const NMSKeyfileFileStamp *stamp,
+                          GVariant **out_entry,
+                          GPtrArray **out_warnings)
+{
+	gs_free_error GError *error = NULL;
+	gs_unref_variant GVariant *dict = NULL;
+	gs_unref_variant GVariant *warnings_variant = NULL;
+	NMSKeyfileFileStamp entry_stamp;
+	NMConnection *connection;
+	GPtrArray *warnings;
+	GVariantIter iter;
+	GVariant *entry;
+	const char *path;
+	const char *uuid;
+	const char *message;
+	guint32 level;
+
+	if (!cache)
+		return NULL;
+
+	entry = g_hash_table_lookup (cache, full_path);
+	if (!entry)
+		return NULL;
+
+	g_variant_get (entry, "(&sttttt@a{sa{sv}}@a(uss))",
+	               &path,
+	               &entry_stamp.dev,
+	               &entry_stamp.ino,
+	               &entry_stamp.size,
+	               &entry_stamp.mtime_ns,
+	               &entry_stamp.ctime_ns,
+	               &dict,
+	               &warnings_variant);
+	if (memcmp (&entry_stamp, stamp, sizeof (entry_stamp)) != 0)
+		return NULL;
+
+	connection = _nm_simple_connection_new_from_dbus (dict,
+	                                                  NM_SETTING_PARSE_FLAGS_STRICT
+	                                                  | NM_SETTING_PARSE_FLAGS_NORMALIZE,
+	                                                  &error);
+	if (!connection)
+		return NULL;
+
+	warnings = g_ptr_array_new_with_free_func (nms_keyfile_reader_warning_free);
+	g_variant_iter_init (&iter, warnings_variant);
+	while (g_variant_iter_next (&iter, "(u&s&s)", &level, &uuid, &message)) {
+		NMSKeyfileReaderWarning *w;
+
+		if (level >= _LOGL_N_REAL)
+			continue;
+
+		w = g_slice_new (NMSKeyfileReaderWarning);
+		w->level = level;
+		w->uuid = uuid[0] ? g_strdup (uuid) : NULL;
+		w->message = g_strdup (message);
+		g_ptr_array_add (warnings, w);
+	}
+
+	NM_SET_OUT (out_entry, g_variant_ref (entry));
+	if (out_warnings)
+		*out_warnings = warnings;
+	else
+		g_ptr_array_unref (warnings);
+	return connection;
+}
+
+/**
+ * nms_keyfile_cache_write:
+ * @cache_file: the file to write
+ * @profile_dir: the configured profile directory
+ * @entries: (array length=n_entries): the entries from
+ *   nms_keyfile_cache_entry_new() or nms_keyfile_cache_lookup().
+ *   %NULL elements are skipped.
+ * @n_entries: the number of @entries
+ * @error: (allow-none): the error
+ *
+ * Returns: %TRUE if the cache was written.
+ */
+gboolean
+nms_keyfile_cache_write (const char *cache_file,
+                         const char *profile_dir,
+                         GVariant *const *entries,
+                         guint n_entries,
+                         GError **error)
+{
+	gs_unref_variant GVariant *cache = NULL;
+	GVariantBuilder builder;
+	guint i, n = 0;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sttttta{sa{sv}}a(uss))"));
+	for (i = 0; i < n_entries; i++) {
+		if (!entries[i])
+			continue;
+		g_variant_builder_add_value (&builder, entries[i]);
+		n++;
+	}
+
+	cache = g_variant_ref_sink (g_variant_new ("(uss@a(sttttta{sa{sv}}a(uss)))",
+	                                           (guint32) NMS_KEYFILE_CACHE_VERSION,
+	                                           nms_keyfile_cache_get_build_id (),
+	                                           profile_dir,
+	                                           g_variant_builder_end (&builder)));
+
+	if (!nm_utils_file_set_contents (cache_file,
+	                                 g_variant_get_data (cache),
+	                                 g_variant_get_size (cache),
+	                                 0600,
+	                                 error))
+		return FALSE;
+
+	_LOGD ("cache: wrote %u entries to \"%s\"", n, cache_file);
+	return TRUE;
+}
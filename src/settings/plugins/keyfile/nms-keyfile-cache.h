@@ -0,0 +1,72 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service - keyfile plugin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2018 Red Hat, Inc.
+ */
+
+#ifndef __NMS_KEYFILE_CACHE_H__
+#define __NMS_KEYFILE_CACHE_H__
+
+#include "nm-connection.h"
+
+/* The parsed and normalized connections are kept in an on-disk cache,
+ * so that on the next start only files that changed need to be parsed again.
+ * The cache is a serialized GVariant, that is mapped into memory. Each entry
+ * is validated against the stat() data of its file. Profiles with secrets
+ * and volatile profiles from NM_KEYFILE_PATH_NAME_RUN are not cached.
+ *
+ * The cache is only valid for the build of NetworkManager that wrote it,
+ * because normalization differs between versions. */
+#define NMS_KEYFILE_CACHE_FILE    NMSTATEDIR "/keyfile-cache"
+
+/* exposed for tests. */
+#define NMS_KEYFILE_CACHE_VERSION 3
+#define NMS_KEYFILE_CACHE_TYPE    "(ussa(sttttta{sa{sv}}a(uss)))"
+
+typedef struct {
+	guint64 dev;
+	guint64 ino;
+	guint64 size;
+	guint64 mtime_ns;
+	guint64 ctime_ns;
+} NMSKeyfileFileStamp;
+
+gboolean nms_keyfile_file_stamp_get (const char *full_path, NMSKeyfileFileStamp *stamp);
+
+const char *nms_keyfile_cache_get_build_id (void);
+
+GHashTable *nms_keyfile_cache_load (const char *cache_file,
+                                    const char *profile_dir);
+
+GVariant *nms_keyfile_cache_entry_new (const char *full_path,
+                                       const NMSKeyfileFileStamp *stamp,
+                                       NMConnection *connection,
+                                       GPtrArray *warnings);
+
+NMConnection *nms_keyfile_cache_lookup (GHashTable *cache,
+                                        const char *full_path,
+                                        const NMSKeyfileFileStamp *stamp,
+                                        GVariant **out_entry,
+                                        GPtrArray **out_warnings);
+
+gboolean nms_keyfile_cache_write (const char *cache_file,
+                                  const char *profile_dir,
+                                  GVariant *const *entries,
+                                  guint n_entries,
+                                  GError **error);
+
+#endif /* __NMS_KEYFILE_CACHE_H__ */
@@ -121,40 +121,13 @@ nms_keyfile_connection_init (NMSKeyfileConnection *connection)
 {
 }
 
-NMSKeyfileConnection *
-nms_keyfile_connection_new (NMConnection *source,
-                            const char *full_path,
-                            const char *profile_dir,
-                            GError **error)
+static NMSKeyfileConnection *
+_connection_new (NMConnection *tmp,
+                 const char *full_path,
+                 gboolean update_unsaved,
+                 GError **error)
 {
 	GObject *object;
-	NMConnection *tmp;
-	const char *uuid;
-	gboolean update_unsaved = TRUE;
-
-	nm_assert (source || full_path);
-	nm_assert (!full_path || full_path[0] == '/');
-	nm_assert (!profile_dir || profile_dir[0] == '/');
-
-	/* If we're given a connection already, prefer that instead of re-reading */
-	if (source)
-		tmp = g_object_ref (source);
-	else {
-		tmp = nms_keyfile_reader_from_file (full_path, profile_dir, error);
-		if (!tmp)
-			return NULL;
-
-		uuid = nm_connection_get_uuid (tmp);
-		if (!uuid) {
-			g_set_error (error, NM_SETTINGS_ERROR, NM_SETTINGS_ERROR_INVALID_CONNECTION,
-			             "Connection in file %s had no UUID", full_path);
-			g_object_unref (tmp);
-			return NULL;
-		}
-
-		/* If we just read the connection from disk, it's clearly not Unsaved */
-		update_unsaved = FALSE;
-	}
 
 	object = g_object_new (NMS_TYPE_KEYFILE_CONNECTION,
 	                       NM_SETTINGS_CONNECTION_FILENAME, full_path,
@@ -173,10 +146,62 @@ nms_keyfile_connection_new (NMConnection *source,
 		object = NULL;
 	}
 
-	g_object_unref (tmp);
 	return (NMSKeyfileConnection *) object;
 }
 
+/**
+ * nms_keyfile_connection_new_from_read:
+ * @read_connection: a connection, as returned by nms_keyfile_reader_from_file_full()
+ *   for @full_path.
+ * @full_path: the filename from which @read_connection was read
+ * @error: error in case of failure
+ *
+ * Like nms_keyfile_connection_new() without source, but for a connection
+ * that was already read from disk beforehand (possibly on a worker thread).
+ *
+ * Returns: the new settings connection.
+ */
+NMSKeyfileConnection *
+nms_keyfile_connection_new_from_read (NMConnection *read_connection,
+                                      const char *full_path,
+                                      GError **error)
+{
+	nm_assert (NM_IS_CONNECTION (read_connection));
+	nm_assert (full_path && full_path[0] == '/');
+
+	if (!nm_connection_get_uuid (read_connection)) {
+		g_set_error (error, NM_SETTINGS_ERROR, NM_SETTINGS_ERROR_INVALID_CONNECTION,
+		             "Connection in file %s had no UUID", full_path);
+		return NULL;
+	}
+
+	/* If we just read the connection from disk, it's clearly not Unsaved */
+	return _connection_new (read_connection, full_path, FALSE, error);
+}
+
+NMSKeyfileConnection *
+nms_keyfile_connection_new (NMConnection *source,
+                            const char *full_path,
+                            const char *profile_dir,
+                            GError **error)
+{
+	gs_unref_object NMConnection *tmp = NULL;
+
+	nm_assert (source || full_path);
+	nm_assert (!full_path || full_path[0] == '/');
+	nm_assert (!profile_dir || profile_dir[0] == '/');
+
+	/* If we're given a connection already, prefer that instead of re-reading */
+	if (source)
+		return _connection_new (source, full_path, TRUE, error);
+
+	tmp = nms_keyfile_reader_from_file (full_path, profile_dir, error);
+	if (!tmp)
+		return NULL;
+
+	return nms_keyfile_connection_new_from_read (tmp, full_path, error);
+}
+
 static void
 nms_keyfile_connection_class_init (NMSKeyfileConnectionClass *keyfile_connection_class)
 {
@@ -41,4 +41,8 @@ NMSKeyfileConnection *nms_keyfile_connection_new (NMConnection *source,
                                                   const char *profile_dir,
                                                   GError **error);
 
+NMSKeyfileConnection *nms_keyfile_connection_new_from_read (NMConnection *read_connection,
+                                                            const char *full_path,
+                                                            GError **error);
+
 #endif /* __NMS_KEYFILE_CONNECTION_H__ */
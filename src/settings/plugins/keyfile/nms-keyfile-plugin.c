@@ -37,10 +37,13 @@
 #include "nm-config.h"
 #include "nm-core-internal.h"
 #include "nm-keyfile-internal.h"
+#include "nm-utils/nm-io-utils.h"
 
 #include "settings/nm-settings-plugin.h"
 
+#include "nms-keyfile-cache.h"
 #include "nms-keyfile-connection.h"
+#include "nms-keyfile-reader.h"
 #include "nms-keyfile-writer.h"
 #include "nms-keyfile-utils.h"
 
@@ -81,6 +84,31 @@ G_DEFINE_TYPE (NMSKeyfilePlugin, nms_keyfile_plugin, NM_TYPE_SETTINGS_PLUGIN)
 
 /*****************************************************************************/
 
+/* When (re-)reading all connections, the keyfiles are parsed on a pool of
+ * worker threads. The results are then consumed on the main thread in the
+ * original (sorted) order, so that the outcome and the logging is the
+ * same as when loading the files sequentially. */
+#define READ_THREADS_MAX 8
+
+typedef struct {
+	const char *full_path;
+	NMConnection *connection;
+	GVariant *cache_entry;
+	GError *error;
+	GPtrArray *warnings;
+	bool from_cache:1;
+	bool done:1;
+} ReadData;
+
+typedef struct {
+	GMutex lock;
+	GCond cond;
+	const char *profile_dir;
+	GHashTable *cache;
+} ReadJob;
+
+/*****************************************************************************/
+
 static void
 connection_removed_cb (NMSettingsConnection *sett_conn, NMSKeyfilePlugin *self)
 {
@@ -132,6 +160,8 @@ find_by_path (NMSKeyfilePlugin *self, const char *path)
  * @source: if %NULL, this re-reads the connection from @full_path
  *   and updates it. When passing @source, this adds a connection from
  *   memory.
+ * @read_data: (allow-none): if given, @source must be %NULL and
+ *   the content of @full_path was already read by a worker thread.
  * @full_path: the filename of the keyfile to be loaded
  * @connection: an existing connection that might be updated.
  *   If given, @connection must be an existing connection that is currently
@@ -161,6 +191,7 @@ find_by_path (NMSKeyfilePlugin *self, const char *path)
 static NMSKeyfileConnection *
 update_connection (NMSKeyfilePlugin *self,
                    NMConnection *source,
+                   ReadData *read_data,
                    const char *full_path,
                    NMSKeyfileConnection *connection,
                    gboolean protect_existing_connection,
@@ -175,6 +206,7 @@ update_connection (NMSKeyfilePlugin *self,
 
 	g_return_val_if_fail (!source || NM_IS_CONNECTION (source), NULL);
 	g_return_val_if_fail (full_path || source, NULL);
+	nm_assert (!read_data || (!source && nm_streq0 (full_path, read_data->full_path)));
 
 	if (full_path)
 		_LOGD ("loading from file \"%s\"...", full_path);
@@ -186,7 +218,16 @@ update_connection (NMSKeyfilePlugin *self,
 		return FALSE;
 	}
 
-	connection_new = nms_keyfile_connection_new (source, full_path, nms_keyfile_utils_get_path (), &local);
+	if (read_data) {
+		nms_keyfile_reader_warnings_log (read_data->warnings);
+		if (read_data->connection)
+			connection_new = nms_keyfile_connection_new_from_read (read_data->connection, full_path, &local);
+		else {
+			connection_new = NULL;
+			local = g_steal_pointer (&read_data->error);
+		}
+	} else
+		connection_new = nms_keyfile_connection_new (source, full_path, nms_keyfile_utils_get_path (), &local);
 	if (!connection_new) {
 		/* Error; remove the connection */
 		if (source)
@@ -331,7 +372,7 @@ dir_changed (GFileMonitor *monitor,
 	case G_FILE_MONITOR_EVENT_CREATED:
 	case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
 		if (exists)
-			update_connection (NMS_KEYFILE_PLUGIN (config), NULL, full_path, connection, TRUE, NULL, NULL);
+			update_connection (NMS_KEYFILE_PLUGIN (config), NULL, NULL, full_path, connection, TRUE, NULL, NULL);
 		break;
 	default:
 		break;
@@ -442,6 +483,65 @@ _read_dir (GPtrArray *filenames,
 	g_dir_close (dir);
 }
 
+static void
+_read_data_parse (ReadData *read_data, const ReadJob *job)
+{
+	NMSKeyfileFileStamp stamp;
+	gboolean stamp_valid;
+
+	stamp_valid = nms_keyfile_file_stamp_get (read_data->full_path, &stamp);
+	if (stamp_valid) {
+		read_data->connection = nms_keyfile_cache_lookup (job->cache,
+		                                                  read_data->full_path,
+		                                                  &stamp,
+		                                                  &read_data->cache_entry,
+		                                                  &read_data->warnings);
+		if (read_data->connection) {
+			read_data->from_cache = TRUE;
+			return;
+		}
+	}
+
+	read_data->warnings = g_ptr_array_new_with_free_func (nms_keyfile_reader_warning_free);
+	read_data->connection = nms_keyfile_reader_from_file_full (read_data->full_path,
+	                                                           job->profile_dir,
+	                                                           read_data->warnings,
+	                                                           &read_data->error);
+	/* the cache is persistent. Profiles in /run must not survive a reboot,
+	 * and secrets don't belong into the cache. Don't cache such profiles. */
+	if (   read_data->connection
+	    && stamp_valid
+	    && !nm_utils_file_is_in_path (read_data->full_path, NM_KEYFILE_PATH_NAME_RUN)
+	    && !_nm_connection_aggregate (read_data->connection, NM_CONNECTION_AGGREGATE_ANY_SECRETS, NULL)) {
+		read_data->cache_entry = nms_keyfile_cache_entry_new (read_data->full_path,
+		                                                      &stamp,
+		                                                      read_data->connection,
+		                                                      read_data->warnings);
+	}
+}
+
+static void
+_read_job_worker (gpointer data, gpointer user_data)
+{
+	ReadData *read_data = data;
+	ReadJob *job = user_data;
+
+	_read_data_parse (read_data, job);
+
+	g_mutex_lock (&job->lock);
+	read_data->done = TRUE;
+	g_cond_broadcast (&job->cond);
+	g_mutex_unlock (&job->lock);
+}
+
+static void
+_read_job_wait (ReadJob *job, ReadData *read_data)
+{
+	g_mutex_lock (&job->lock);
+	while (!read_data->done)
+		g_cond_wait (&job->cond, &job->lock);
+	g_mutex_unlock (&job->lock);
+}
 
 static void
 read_connections (NMSettingsPlugin *config)
@@ -455,6 +555,14 @@ read_connections (NMSettingsPlugin *config)
 	guint i;
 	GPtrArray *filenames;
 	GHashTable *paths;
+	ReadData *read_data;
+	GThreadPool *pool = NULL;
+	guint n_threads;
+	guint n_cached = 0;
+	gboolean cache_dirty;
+	ReadJob job = {
+		.profile_dir = nms_keyfile_utils_get_path (),
+	};
 
 	filenames = g_ptr_array_new_with_free_func (g_free);
 
@@ -473,11 +581,86 @@ read_connections (NMSettingsPlugin *config)
 	g_ptr_array_sort_with_data (filenames, (GCompareDataFunc) _sort_paths, paths);
 	g_hash_table_destroy (paths);
 
+	read_data = g_new0 (ReadData, filenames->len);
+	for (i = 0; i < filenames->len; i++)
+		read_data[i].full_path = filenames->pdata[i];
+
+	job.cache = nms_keyfile_cache_load (NMS_KEYFILE_CACHE_FILE, job.profile_dir);
+
+	/* Parsing and normalizing the files is independent of the plugin's
+	 * state, so it can be done in parallel. Claiming the connections must
+	 * happen on the main thread, in the order of @filenames. */
+	n_threads = MIN (g_get_num_processors (), READ_THREADS_MAX);
+	if (   filenames->len > 1
+	    && n_threads > 1) {
+		GError *error = NULL;
+
+		g_mutex_init (&job.lock);
+		g_cond_init (&job.cond);
+		pool = g_thread_pool_new (_read_job_worker, &job,
+		                          MIN (n_threads, filenames->len),
+		                          FALSE, &error);
+		if (!pool) {
+			_LOGD ("cannot create thread pool, reading connections sequentially: %s", error->message);
+			g_clear_error (&error);
+			g_cond_clear (&job.cond);
+			g_mutex_clear (&job.lock);
+		} else {
+			_LOGT ("reading %u files with up to %u threads", filenames->len, MIN (n_threads, filenames->len));
+			for (i = 0; i < filenames->len; i++)
+				g_thread_pool_push (pool, &read_data[i], NULL);
+		}
+	}
+
 	for (i = 0; i < filenames->len; i++) {
-		connection = update_connection (self, NULL, filenames->pdata[i], NULL, FALSE, alive_connections, NULL);
+		if (pool)
+			_read_job_wait (&job, &read_data[i]);
+		else
+			_read_data_parse (&read_data[i], &job);
+
+		if (read_data[i].from_cache) {
+			_LOGT ("cache: use cached connection for \"%s\"", read_data[i].full_path);
+			n_cached++;
+		}
+
+		connection = update_connection (self, NULL, &read_data[i], filenames->pdata[i], NULL, FALSE, alive_connections, NULL);
 		if (connection)
 			g_hash_table_add (alive_connections, connection);
+
+		g_clear_object (&read_data[i].connection);
+		g_clear_error (&read_data[i].error);
+		g_clear_pointer (&read_data[i].warnings, g_ptr_array_unref);
+	}
+
+	if (pool) {
+		g_thread_pool_free (pool, FALSE, TRUE);
+		g_cond_clear (&job.cond);
+		g_mutex_clear (&job.lock);
+	}
+
+	/* Only rewrite the cache if any entry was added, changed or removed. If
+	 * there was no valid cache, always write it, to replace a stale file. */
+	cache_dirty =    !job.cache
+	              || n_cached != g_hash_table_size (job.cache);
+	for (i = 0; !cache_dirty && i < filenames->len; i++) {
+		if (   read_data[i].cache_entry
+		    && !read_data[i].from_cache)
+			cache_dirty = TRUE;
 	}
+	if (cache_dirty) {
+		gs_free GVariant **entries = g_new (GVariant *, filenames->len + 1);
+		gs_free_error GError *error = NULL;
+
+		for (i = 0; i < filenames->len; i++)
+			entries[i] = read_data[i].cache_entry;
+		if (!nms_keyfile_cache_write (NMS_KEYFILE_CACHE_FILE, job.profile_dir, entries, filenames->len, &error))
+			_LOGD ("cache: failure to write \"%s\": %s", NMS_KEYFILE_CACHE_FILE, error->message);
+	}
+
+	nm_clear_pointer (&job.cache, g_hash_table_destroy);
+	for (i = 0; i < filenames->len; i++)
+		nm_clear_g_variant (&read_data[i].cache_entry);
+	g_free (read_data);
 	g_ptr_array_free (filenames, TRUE);
 
 	g_hash_table_iter_init (&iter, priv->connections);
@@ -531,7 +714,7 @@ load_connection (NMSettingsPlugin *config,
 	if (nm_keyfile_utils_ignore_filename (filename, require_extension))
 		return FALSE;
 
-	connection = update_connection (self, NULL, filename, find_by_path (self, filename), TRUE, NULL, NULL);
+	connection = update_connection (self, NULL, NULL, filename, find_by_path (self, filename), TRUE, NULL, NULL);
 
 	return (connection != NULL);
 }
@@ -562,7 +745,7 @@ add_connection (NMSettingsPlugin *config,
 	                                    error))
 		return NULL;
 
-	return NM_SETTINGS_CONNECTION (update_connection (self, reread ?: connection, path, NULL, FALSE, NULL, error));
+	return NM_SETTINGS_CONNECTION (update_connection (self, reread ?: connection, NULL, path, NULL, FALSE, NULL, error));
 }
 
 static GSList *
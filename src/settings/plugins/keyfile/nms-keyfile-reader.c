@@ -59,6 +59,7 @@ _fmt_warn (const char *group, NMSetting *setting, const char *property_name, con
 
 typedef struct {
 	bool verbose;
+	GPtrArray *deferred_warnings;
 } HandlerReadData;
 
 static gboolean
@@ -88,6 +89,23 @@ _handler_read (GKeyFile *keyfile,
 		else
 			level = LOGL_INFO;
 
+		if (handler_data->deferred_warnings) {
+			NMSKeyfileReaderWarning *w;
+			const char *message;
+
+			/* keep the warning even if the level is disabled right now. It
+			 * might be stored in the keyfile cache and replayed later. */
+			message = _fmt_warn (warn_data->group, warn_data->setting,
+			                     warn_data->property_name, warn_data->message,
+			                     &message_free);
+			w = g_slice_new (NMSKeyfileReaderWarning);
+			w->level = level;
+			w->uuid = g_strdup (nm_connection_get_uuid (connection));
+			w->message = message_free ?: g_strdup (message);
+			g_ptr_array_add (handler_data->deferred_warnings, w);
+			return TRUE;
+		}
+
 		nm_log (level, LOGD_SETTINGS, NULL,
 		        nm_connection_get_uuid (connection),
 		        "keyfile: %s",
@@ -100,18 +118,15 @@ _handler_read (GKeyFile *keyfile,
 	return FALSE;
 }
 
-NMConnection *
-nms_keyfile_reader_from_keyfile (GKeyFile *key_file,
-                                 const char *filename,
-                                 const char *base_dir,
-                                 const char *profile_dir,
-                                 gboolean verbose,
-                                 GError **error)
+static NMConnection *
+_reader_from_keyfile (GKeyFile *key_file,
+                      const char *filename,
+                      const char *base_dir,
+                      const char *profile_dir,
+                      HandlerReadData *data,
+                      GError **error)
 {
 	NMConnection *connection;
-	HandlerReadData data = {
-		.verbose = verbose,
-	};
 	gs_free char *base_dir_free = NULL;
 	gs_free char *profile_filename_free = NULL;
 	gs_free char *filename_id = NULL;
@@ -138,7 +153,7 @@ nms_keyfile_reader_from_keyfile (GKeyFile *key_file,
 		filename = &s[1];
 	}
 
-	connection = nm_keyfile_read (key_file, base_dir, _handler_read, &data, error);
+	connection = nm_keyfile_read (key_file, base_dir, _handler_read, data, error);
 	if (!connection)
 		return NULL;
 
@@ -161,13 +176,50 @@ nms_keyfile_reader_from_keyfile (GKeyFile *key_file,
 }
 
 NMConnection *
-nms_keyfile_reader_from_file (const char *full_filename,
-                              const char *profile_dir,
-                              GError **error)
+nms_keyfile_reader_from_keyfile (GKeyFile *key_file,
+                                 const char *filename,
+                                 const char *base_dir,
+                                 const char *profile_dir,
+                                 gboolean verbose,
+                                 GError **error)
+{
+	HandlerReadData data = {
+		.verbose = verbose,
+	};
+
+	return _reader_from_keyfile (key_file, filename, base_dir, profile_dir, &data, error);
+}
+
+/**
+ * nms_keyfile_reader_from_file_full:
+ * @full_filename: the absolute path of the keyfile
+ * @profile_dir: the profile directory, used for generating the UUID
+ * @deferred_warnings: (allow-none): if given, parsing warnings are not
+ *   logged right away but appended to this array as #NMSKeyfileReaderWarning
+ *   instances. The array must be created with nms_keyfile_reader_warning_free()
+ *   as free function.
+ * @error: error in case of failure
+ *
+ * Contrary to nms_keyfile_reader_from_file(), this function can be called
+ * from a worker thread, as long as @deferred_warnings is given. The caller
+ * is then responsible to log the warnings via nms_keyfile_reader_warnings_log()
+ * on the main thread.
+ *
+ * Returns: (transfer full): the normalized connection or %NULL on failure.
+ */
+NMConnection *
+nms_keyfile_reader_from_file_full (const char *full_filename,
+                                   const char *profile_dir,
+                                   GPtrArray *deferred_warnings,
+                                   GError **error)
 {
 	gs_unref_keyfile GKeyFile *key_file = NULL;
 	NMConnection *connection = NULL;
 	GError *verify_error = NULL;
+	HandlerReadData data = {
+		.verbose = TRUE,
+		.deferred_warnings = deferred_warnings,
+	};
 
 	nm_assert (full_filename && full_filename[0] == '/');
 	nm_assert (!profile_dir || profile_dir[0] == '/');
@@ -182,7 +234,7 @@ nms_keyfile_reader_from_file (const char *full_filename,
 	if (!g_key_file_load_from_file (key_file, full_filename, G_KEY_FILE_NONE, error))
 		return NULL;
 
-	connection = nms_keyfile_reader_from_keyfile (key_file, full_filename, NULL, profile_dir, TRUE, error);
+	connection = _reader_from_keyfile (key_file, full_filename, NULL, profile_dir, &data, error);
 	if (!connection)
 		return NULL;
 
@@ -199,3 +251,38 @@ nms_keyfile_reader_from_file (const char *full_filename,
 	return connection;
 }
 
+NMConnection *
+nms_keyfile_reader_from_file (const char *full_filename,
+                              const char *profile_dir,
+                              GError **error)
+{
+	return nms_keyfile_reader_from_file_full (full_filename, profile_dir, NULL, error);
+}
+
+/*****************************************************************************/
+
+void
+nms_keyfile_reader_warning_free (gpointer data)
+{
+	NMSKeyfileReaderWarning *w = data;
+
+	g_free (w->uuid);
+	g_free (w->message);
+	g_slice_free (NMSKeyfileReaderWarning, w);
+}
+
+void
+nms_keyfile_reader_warnings_log (GPtrArray *warnings)
+{
+	guint i;
+
+	if (!warnings)
+		return;
+
+	for (i = 0; i < warnings->len; i++) {
+		const NMSKeyfileReaderWarning *w = warnings->pdata[i];
+
+		nm_log (w->level, LOGD_SETTINGS, NULL, w->uuid,
+		        "keyfile: %s", w->message);
+	}
+}
@@ -35,4 +35,19 @@ NMConnection *nms_keyfile_reader_from_file (const char *full_filename,
                                             const char *profile_dir,
                                             GError **error);
 
+typedef struct {
+	NMLogLevel level;
+	char *uuid;
+	char *message;
+} NMSKeyfileReaderWarning;
+
+void nms_keyfile_reader_warning_free (gpointer data);
+
+void nms_keyfile_reader_warnings_log (GPtrArray *warnings);
+
+NMConnection *nms_keyfile_reader_from_file_full (const char *full_filename,
+                                                 const char *profile_dir,
+                                                 GPtrArray *deferred_warnings,
+                                                 GError **error);
+
 #endif /* __NMS_KEYFILE_READER_H__ */
@@ -31,6 +31,7 @@
 
 #include "nm-core-internal.h"
 
+#include "settings/plugins/keyfile/nms-keyfile-cache.h"
 #include "settings/plugins/keyfile/nms-keyfile-reader.h"
 #include "settings/plugins/keyfile/nms-keyfile-writer.h"
 #include "settings/plugins/keyfile/nms-keyfile-utils.h"
@@ -2611,6 +2612,222 @@ test_loaded_uuid (void)
 
 /*****************************************************************************/
 
+#define CACHE_TEST_UUID "0b4bca1d-9d1a-4bd7-a1ef-5ac8e3e2b2d1"
+
+static void
+_cache_test_write_keyfile (const char *full_path, const char *id)
+{
+	gs_free_error GError *error = NULL;
+	gs_free char *contents = NULL;
+
+	contents = g_strdup_printf ("[connection]\n"
+	                            "id=%s\n"
+	                            "uuid=" CACHE_TEST_UUID "\n"
+	                            "type=ethernet\n",
+	                            id);
+	nmtst_assert_success (nm_utils_file_set_contents (full_path, contents, -1, 0600, &error), error);
+}
+
+static GVariant *
+_cache_test_entry_new (const char *full_path, NMSKeyfileFileStamp *out_stamp, NMConnection **out_connection)
+{
+	gs_free_error GError *error = NULL;
+	gs_unref_ptrarray GPtrArray *warnings = NULL;
+	NMSKeyfileReaderWarning *w;
+	NMConnection *connection;
+	GVariant *entry;
+
+	g_assert (nms_keyfile_file_stamp_get (full_path, out_stamp));
+
+	warnings = g_ptr_array_new_with_free_func (nms_keyfile_reader_warning_free);
+	connection = nms_keyfile_reader_from_file_full (full_path, TEST_SCRATCH_DIR, warnings, &error);
+	nmtst_assert_success (connection, error);
+
+	/* a warning from reading the file, that must be replayed on a cache hit. */
+	w = g_slice_new (NMSKeyfileReaderWarning);
+	w->level = LOGL_WARN;
+	w->uuid = g_strdup (CACHE_TEST_UUID);
+	w->message = g_strdup ("cache test warning");
+	g_ptr_array_add (warnings, w);
+
+	entry = nms_keyfile_cache_entry_new (full_path, out_stamp, connection, warnings);
+	*out_connection = connection;
+	return entry;
+}
+
+static void
+_cache_test_rewrite_header (const char *cache_file, guint32 version, const char *build_id)
+{
+	gs_free_error GError *error = NULL;
+	gs_free char *contents = NULL;
+	gsize len;
+	gs_unref_variant GVariant *cache = NULL;
+	gs_unref_variant GVariant *entries = NULL;
+	gs_unref_variant GVariant *rewritten = NULL;
+	const char *profile_dir;
+
+	nmtst_assert_success (g_file_get_contents (cache_file, &contents, &len, &error), error);
+	cache = g_variant_ref_sink (g_variant_new_from_data (G_VARIANT_TYPE (NMS_KEYFILE_CACHE_TYPE),
+	                                                     contents, len, FALSE, NULL, NULL));
+	g_variant_get (cache, "(u&s&s@a(sttttta{sa{sv}}a(uss)))", NULL, NULL, &profile_dir, &entries);
+
+	rewritten = g_variant_ref_sink (g_variant_new ("(uss@a(sttttta{sa{sv}}a(uss)))",
+	                                               version,
+	                                               build_id,
+	                                               profile_dir,
+	                                               entries));
+	nmtst_assert_success (nm_utils_file_set_contents (cache_file,
+	                                                  g_variant_get_data (rewritten),
+	                                                  g_variant_get_size (rewritten),
+	                                                  0600,
+	                                                  &error),
+	                      error);
+}
+
+static void
+test_cache_hit_miss (void)
+{
+	const char *full_path = TEST_SCRATCH_DIR "/cache-test-1.nmconnection";
+	const char *other_path = TEST_SCRATCH_DIR "/cache-test-other.nmconnection";
+	const char *cache_file = TEST_SCRATCH_DIR "/keyfile-cache-1";
+	gs_free_error GError *error = NULL;
+	gs_unref_object NMConnection *connection = NULL;
+	gs_unref_object NMConnection *cached = NULL;
+	gs_unref_variant GVariant *entry = NULL;
+	gs_unref_variant GVariant *cached_entry = NULL;
+	gs_unref_ptrarray GPtrArray *cached_warnings = NULL;
+	gs_unref_hashtable GHashTable *cache = NULL;
+	const NMSKeyfileReaderWarning *w;
+	NMSKeyfileFileStamp stamp;
+
+	_cache_test_write_keyfile (full_path, "cache-test");
+	entry = _cache_test_entry_new (full_path, &stamp, &connection);
+
+	nmtst_assert_success (nms_keyfile_cache_write (cache_file, TEST_SCRATCH_DIR, &entry, 1, &error), error);
+
+	cache = nms_keyfile_cache_load (cache_file, TEST_SCRATCH_DIR);
+	g_assert (cache);
+	g_assert_cmpint (g_hash_table_size (cache), ==, 1);
+
+	/* hit: same connection, and the warnings are replayed. */
+	cached = nms_keyfile_cache_lookup (cache, full_path, &stamp, &cached_entry, &cached_warnings);
+	g_assert (cached);
+	nmtst_assert_connection_equals (cached, FALSE, connection, FALSE);
+	g_assert (cached_entry);
+	g_assert (cached_warnings);
+	g_assert_cmpint (cached_warnings->len, ==, 1);
+	w = cached_warnings->pdata[0];
+	g_assert_cmpint (w->level, ==, LOGL_WARN);
+	g_assert_cmpstr (w->uuid, ==, CACHE_TEST_UUID);
+	g_assert_cmpstr (w->message, ==, "cache test warning");
+
+	/* miss: a file that is not in the cache. */
+	g_assert (!nms_keyfile_cache_lookup (cache, other_path, &stamp, NULL, NULL));
+	g_assert (!nms_keyfile_cache_lookup (NULL, full_path, &stamp, NULL, NULL));
+
+	/* the cache is only valid for the profile directory it was written for. */
+	g_assert (!nms_keyfile_cache_load (cache_file, "/etc/NetworkManager/other-connections"));
+
+	(void) unlink (full_path);
+	(void) unlink (cache_file);
+}
+
+static void
+test_cache_invalidate (void)
+{
+	const char *full_path = TEST_SCRATCH_DIR "/cache-test-2.nmconnection";
+	const char *cache_file = TEST_SCRATCH_DIR "/keyfile-cache-2";
+	gs_free_error GError *error = NULL;
+	gs_unref_object NMConnection *connection = NULL;
+	gs_unref_variant GVariant *entry = NULL;
+	gs_unref_hashtable GHashTable *cache = NULL;
+	NMSKeyfileFileStamp stamp;
+	NMSKeyfileFileStamp stamp2;
+
+	_cache_test_write_keyfile (full_path, "cache-test");
+	entry = _cache_test_entry_new (full_path, &stamp, &connection);
+	nmtst_assert_success (nms_keyfile_cache_write (cache_file, TEST_SCRATCH_DIR, &entry, 1, &error), error);
+
+	/* a modified file no longer matches its entry. */
+	_cache_test_write_keyfile (full_path, "cache-test-modified");
+	g_assert (nms_keyfile_file_stamp_get (full_path, &stamp2));
+	g_assert (memcmp (&stamp, &stamp2, sizeof (stamp)) != 0);
+
+	cache = nms_keyfile_cache_load (cache_file, TEST_SCRATCH_DIR);
+	g_assert (cache);
+	g_assert (nms_keyfile_cache_lookup (cache, full_path, &stamp, NULL, NULL));
+	g_assert (!nms_keyfile_cache_lookup (cache, full_path, &stamp2, NULL, NULL));
+	g_clear_pointer (&cache, g_hash_table_unref);
+
+	/* a cache written by a different build is ignored... */
+	_cache_test_rewrite_header (cache_file, NMS_KEYFILE_CACHE_VERSION, "0.0.0-other-build");
+	g_assert (!nms_keyfile_cache_load (cache_file, TEST_SCRATCH_DIR));
+
+	/* ... and so is one with another format version. */
+	_cache_test_rewrite_header (cache_file, NMS_KEYFILE_CACHE_VERSION + 1, nms_keyfile_cache_get_build_id ());
+	g_assert (!nms_keyfile_cache_load (cache_file, TEST_SCRATCH_DIR));
+
+	/* sanity check: the unmodified header is accepted again. */
+	_cache_test_rewrite_header (cache_file, NMS_KEYFILE_CACHE_VERSION, nms_keyfile_cache_get_build_id ());
+	cache = nms_keyfile_cache_load (cache_file, TEST_SCRATCH_DIR);
+	g_assert (cache);
+	g_assert_cmpint (g_hash_table_size (cache), ==, 1);
+
+	(void) unlink (full_path);
+	(void) unlink (cache_file);
+}
+
+static void
+test_cache_no_secrets (void)
+{
+	const char *full_path = TEST_SCRATCH_DIR "/cache-test-3.nmconnection";
+	const char *cache_file = TEST_SCRATCH_DIR "/keyfile-cache-3";
+	gs_free_error GError *error = NULL;
+	gs_unref_object NMConnection *connection = NULL;
+	gs_unref_object NMConnection *cached = NULL;
+	gs_unref_variant GVariant *entry = NULL;
+	gs_unref_hashtable GHashTable *cache = NULL;
+	gs_unref_bytes GBytes *ssid = NULL;
+	NMSettingWirelessSecurity *s_wsec;
+	NMSettingWireless *s_wifi;
+	NMSKeyfileFileStamp stamp = { .ino = 1, };
+
+	connection = nmtst_create_minimal_connection ("cache-test-secrets", CACHE_TEST_UUID,
+	                                              NM_SETTING_WIRELESS_SETTING_NAME, NULL);
+	s_wifi = (NMSettingWireless *) nm_setting_wireless_new ();
+	ssid = g_bytes_new ("cache-test", 10);
+	g_object_set (s_wifi,
+	              NM_SETTING_WIRELESS_SSID, ssid,
+	              NM_SETTING_WIRELESS_MODE, NM_SETTING_WIRELESS_MODE_INFRA,
+	              NULL);
+	nm_connection_add_setting (connection, NM_SETTING (s_wifi));
+	s_wsec = (NMSettingWirelessSecurity *) nm_setting_wireless_security_new ();
+	g_object_set (s_wsec,
+	              NM_SETTING_WIRELESS_SECURITY_KEY_MGMT, "wpa-psk",
+	              NM_SETTING_WIRELESS_SECURITY_PSK, "cache-test-psk",
+	              NULL);
+	nm_connection_add_setting (connection, NM_SETTING (s_wsec));
+	nmtst_connection_normalize (connection);
+
+	/* the cache never stores secrets. */
+	entry = nms_keyfile_cache_entry_new (full_path, &stamp, connection, NULL);
+	nmtst_assert_success (nms_keyfile_cache_write (cache_file, TEST_SCRATCH_DIR, &entry, 1, &error), error);
+
+	cache = nms_keyfile_cache_load (cache_file, TEST_SCRATCH_DIR);
+	g_assert (cache);
+	cached = nms_keyfile_cache_lookup (cache, full_path, &stamp, NULL, NULL);
+	g_assert (cached);
+	s_wsec = nm_connection_get_setting_wireless_security (cached);
+	g_assert (s_wsec);
+	g_assert_cmpstr (nm_setting_wireless_security_get_key_mgmt (s_wsec), ==, "wpa-psk");
+	g_assert_cmpstr (nm_setting_wireless_security_get_psk (s_wsec), ==, NULL);
+	g_assert (!_nm_connection_aggregate (cached, NM_CONNECTION_AGGREGATE_ANY_SECRETS, NULL));
+
+	(void) unlink (cache_file);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int main (int argc, char **argv)
@@ -2695,5 +2912,9 @@ int main (int argc, char **argv)
 
 	g_test_add_func ("/keyfile/test_loaded_uuid", test_loaded_uuid);
 
+	g_test_add_func ("/keyfile/cache/hit-miss", test_cache_hit_miss);
+	g_test_add_func ("/keyfile/cache/invalidate", test_cache_invalidate);
+	g_test_add_func ("/keyfile/cache/no-secrets", test_cache_no_secrets);
+
 	return g_test_run ();
 }
@@ -44,9 +44,16 @@
 
 /*****************************************************************************/
 
+/* BSS objects are tracked without a GDBusProxy each. The properties
+ * come from the BSSAdded signal or a GetAll call and are then kept up to
+ * date from a single PropertiesChanged subscription per interface. */
 typedef struct {
-	GDBusProxy *proxy;
-	gulong change_id;
+	/* NULL if the BSS was removed while the GetAll call is in flight.
+	 * The GetAll callback frees the data in that case. */
+	NMSupplicantInterface *self;
+	char *path;
+	GVariant *properties;
+	bool get_all_pending:1;
 } BssData;
 
 typedef struct {
@@ -90,6 +97,7 @@ enum {
 	PEER_UPDATED,            /* a new Peer appeared or an existing had properties changed */
 	PEER_REMOVED,            /* supplicant removed Peer from its scan list */
 	SCAN_DONE,               /* wifi scan is complete */
+	SCAN_REQUEST_FAILED,     /* the supplicant rejected a scan request */
 	CREDENTIALS_REQUEST,     /* 802.1x identity or password requested */
 	WPS_CREDENTIALS,         /* WPS credentials received */
 	GROUP_STARTED,           /* a new Group (interface) was created */
@@ -157,7 +165,9 @@ typedef struct {
 	AssocData *    assoc_data;
 
 	char *         net_path;
-	GHashTable *   bss_proxies;
+	GHashTable *   bsses;
+	GDBusConnection *bss_dbus_connection;
+	guint          bss_properties_changed_id;
 	char *         current_bss;
 
 	GHashTable *   peer_proxies;
@@ -222,126 +232,190 @@ NM_UTILS_LOOKUP_STR_DEFINE (nm_supplicant_interface_state_to_string, NMSupplican
 
 /*****************************************************************************/
 
+static void
+bss_data_free (BssData *bss_data)
+{
+	nm_g_variant_unref (bss_data->properties);
+	g_free (bss_data->path);
+	g_slice_free (BssData, bss_data);
+}
+
 static void
 bss_data_destroy (gpointer user_data)
 {
 	BssData *bss_data = user_data;
 
-	nm_clear_g_signal_handler (bss_data->proxy, &bss_data->change_id);
-	g_object_unref (bss_data->proxy);
-	g_slice_free (BssData, bss_data);
+	if (bss_data->get_all_pending) {
+		/* bss_get_all_cb() frees it. */
+		bss_data->self = NULL;
+		return;
+	}
+	bss_data_free (bss_data);
 }
 
 static void
-bss_proxy_properties_changed_cb (GDBusProxy *proxy,
-                                 GVariant *changed_properties,
-                                 char **invalidated_properties,
-                                 gpointer user_data)
+bss_data_set_properties (BssData *bss_data, GVariant *changed)
+{
+	GVariantDict dict;
+	GVariantIter iter;
+	const char *key;
+	GVariant *value;
+
+	g_variant_dict_init (&dict, bss_data->properties);
+	g_variant_iter_init (&iter, changed);
+	while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+		g_variant_dict_insert_value (&dict, key, value);
+		g_variant_unref (value);
+	}
+	nm_g_variant_unref (bss_data->properties);
+	bss_data->properties = g_variant_ref_sink (g_variant_dict_end (&dict));
+}
+
+static void
+bss_properties_changed_cb (GDBusConnection *connection,
+                           const char *sender_name,
+                           const char *object_path,
+                           const char *interface_name,
+                           const char *signal_name,
+                           GVariant *parameters,
+                           gpointer user_data)
 {
 	NMSupplicantInterface *self = NM_SUPPLICANT_INTERFACE (user_data);
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+	gs_unref_variant GVariant *changed = NULL;
+	BssData *bss_data;
+
+	/* the subscription matches the BSSs of all interfaces. */
+	bss_data = g_hash_table_lookup (priv->bsses, object_path);
+	if (!bss_data || !bss_data->properties)
+		return;
+
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(sa{sv}as)")))
+		return;
 
 	if (priv->scanning)
 		priv->last_scan = nm_utils_get_monotonic_timestamp_ms ();
 
+	changed = g_variant_get_child_value (parameters, 1);
+	bss_data_set_properties (bss_data, changed);
+
 	g_signal_emit (self, signals[BSS_UPDATED], 0,
-	               g_dbus_proxy_get_object_path (proxy),
-	               changed_properties);
+	               bss_data->path,
+	               changed);
 }
 
-static GVariant *
-bss_proxy_get_properties (NMSupplicantInterface *self, GDBusProxy *proxy)
+static void
+bss_tracking_start (NMSupplicantInterface *self)
 {
-	gs_strfreev char **properties = NULL;
-	GVariantBuilder builder;
-	char **iter;
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
-	iter = properties = g_dbus_proxy_get_cached_property_names (proxy);
+	nm_assert (!priv->bss_dbus_connection);
 
-	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
-	if (iter) {
-		while (*iter) {
-			GVariant *copy = g_dbus_proxy_get_cached_property (proxy, *iter);
+	priv->bss_dbus_connection = g_object_ref (g_dbus_proxy_get_connection (priv->iface_proxy));
+	priv->bss_properties_changed_id = g_dbus_connection_signal_subscribe (priv->bss_dbus_connection,
+	                                                                      WPAS_DBUS_SERVICE,
+	                                                                      DBUS_INTERFACE_PROPERTIES,
+	                                                                      "PropertiesChanged",
+	                                                                      NULL,
+	                                                                      WPAS_DBUS_IFACE_BSS,
+	                                                                      G_DBUS_SIGNAL_FLAGS_NONE,
+	                                                                      bss_properties_changed_cb,
+	                                                                      self,
+	                                                                      NULL);
+}
 
-			g_variant_builder_add (&builder, "{sv}", *iter++, copy);
-			g_variant_unref (copy);
-		}
+static void
+bss_tracking_stop (NMSupplicantInterface *self)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	if (priv->bss_dbus_connection) {
+		g_dbus_connection_signal_unsubscribe (priv->bss_dbus_connection,
+		                                      priv->bss_properties_changed_id);
+		priv->bss_properties_changed_id = 0;
+		g_clear_object (&priv->bss_dbus_connection);
 	}
-	return g_variant_builder_end (&builder);
 }
 
 static void
-bss_proxy_acquired_cb (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
+bss_get_all_cb (GObject *source, GAsyncResult *result, gpointer user_data)
 {
-	NMSupplicantInterface *self;
+	BssData *bss_data = user_data;
+	NMSupplicantInterface *self = bss_data->self;
 	NMSupplicantInterfacePrivate *priv;
+	gs_unref_variant GVariant *res = NULL;
 	gs_free_error GError *error = NULL;
-	GVariant *props = NULL;
-	const char *object_path;
-	BssData *bss_data;
-	gboolean success;
 
-	success = g_async_initable_init_finish (G_ASYNC_INITABLE (proxy), result, &error);
-	if (   !success
-	    && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	res = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), result, &error);
+
+	bss_data->get_all_pending = FALSE;
+	if (!self) {
+		bss_data_free (bss_data);
 		return;
+	}
 
-	self = NM_SUPPLICANT_INTERFACE (user_data);
 	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
-	if (!success) {
-		_LOGD ("failed to acquire BSS proxy: (%s)", error->message);
-		g_hash_table_remove (priv->bss_proxies,
-		                     g_dbus_proxy_get_object_path (proxy));
+	if (!res) {
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			_LOGD ("failed to get BSS properties: (%s)", error->message);
+		g_hash_table_remove (priv->bsses, bss_data->path);
 		return;
 	}
 
-	object_path = g_dbus_proxy_get_object_path (proxy);
-	bss_data = g_hash_table_lookup (priv->bss_proxies, object_path);
-	if (!bss_data)
-		return;
-
-	bss_data->change_id = g_signal_connect (proxy, "g-properties-changed", G_CALLBACK (bss_proxy_properties_changed_cb), self);
-
-	props = bss_proxy_get_properties (self, proxy);
+	g_variant_get (res, "(@a{sv})", &bss_data->properties);
 	g_signal_emit (self, signals[BSS_UPDATED], 0,
-	               g_dbus_proxy_get_object_path (proxy),
-	               g_variant_ref_sink (props));
-	g_variant_unref (props);
+	               bss_data->path,
+	               bss_data->properties);
 
 	if (priv->scan_done_pending)
 		scan_done_emit_signal (self);
 }
 
 static void
-bss_add_new (NMSupplicantInterface *self, const char *object_path)
+bss_add_new (NMSupplicantInterface *self, const char *object_path, GVariant *properties)
 {
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
-	GDBusProxy *bss_proxy;
 	BssData *bss_data;
 
 	g_return_if_fail (object_path != NULL);
 
-	if (g_hash_table_lookup (priv->bss_proxies, object_path))
+	if (g_hash_table_lookup (priv->bsses, object_path))
+		return;
+
+	if (!priv->bss_dbus_connection)
 		return;
 
-	bss_proxy = g_object_new (G_TYPE_DBUS_PROXY,
-	                          "g-bus-type", G_BUS_TYPE_SYSTEM,
-	                          "g-flags", G_DBUS_PROXY_FLAGS_NONE,
-	                          "g-name", WPAS_DBUS_SERVICE,
-	                          "g-object-path", object_path,
-	                          "g-interface-name", WPAS_DBUS_IFACE_BSS,
-	                          NULL);
 	bss_data = g_slice_new0 (BssData);
-	bss_data->proxy = bss_proxy;
-	g_hash_table_insert (priv->bss_proxies,
-	                     (char *) g_dbus_proxy_get_object_path (bss_proxy),
-	                     bss_data);
-	g_async_initable_init_async (G_ASYNC_INITABLE (bss_proxy),
-	                             G_PRIORITY_DEFAULT,
-	                             priv->other_cancellable,
-	                             (GAsyncReadyCallback) bss_proxy_acquired_cb,
-	                             self);
+	bss_data->self = self;
+	bss_data->path = g_strdup (object_path);
+	g_hash_table_insert (priv->bsses, bss_data->path, bss_data);
+
+	if (   properties
+	    && g_variant_n_children (properties) > 0) {
+		/* BSSAdded already carries all properties, no need to ask. */
+		bss_data->properties = g_variant_ref (properties);
+		g_signal_emit (self, signals[BSS_UPDATED], 0,
+		               bss_data->path,
+		               bss_data->properties);
+		return;
+	}
+
+	/* the calls for all new BSSs of a scan are issued right away, so they
+	 * are pipelined on the connection rather than done one by one. */
+	bss_data->get_all_pending = TRUE;
+	g_dbus_connection_call (priv->bss_dbus_connection,
+	                        WPAS_DBUS_SERVICE,
+	                        object_path,
+	                        DBUS_INTERFACE_PROPERTIES,
+	                        "GetAll",
+	                        g_variant_new ("(s)", WPAS_DBUS_IFACE_BSS),
+	                        G_VARIANT_TYPE ("(a{sv})"),
+	                        G_DBUS_CALL_FLAGS_NONE,
+	                        -1,
+	                        priv->other_cancellable,
+	                        bss_get_all_cb,
+	                        bss_data);
 }
 
 static void
@@ -487,6 +561,7 @@ set_state (NMSupplicantInterface *self, NMSupplicantInterfaceState new_state)
 
 		if (priv->iface_proxy)
 			g_signal_handlers_disconnect_by_data (priv->iface_proxy, self);
+		bss_tracking_stop (self);
 	}
 
 	priv->state = new_state;
@@ -1185,25 +1260,22 @@ scan_done_emit_signal (NMSupplicantInterface *self)
 	gboolean success;
 	GHashTableIter iter;
 
-	g_hash_table_iter_init (&iter, priv->bss_proxies);
+	g_hash_table_iter_init (&iter, priv->bsses);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &bss_data)) {
 		/* we have some BSS' that need to be initialized first. Delay
 		 * emitting signal. */
-		if (!bss_data->change_id) {
+		if (bss_data->get_all_pending) {
 			priv->scan_done_pending = TRUE;
 			return;
 		}
 	}
 
 	/* Emit BSS_UPDATED so that wifi device has the APs (in case it removed them) */
-	g_hash_table_iter_init (&iter, priv->bss_proxies);
+	g_hash_table_iter_init (&iter, priv->bsses);
 	while (g_hash_table_iter_next (&iter, (gpointer *) &object_path, (gpointer *) &bss_data)) {
-		gs_unref_variant GVariant *props = NULL;
-
-		props = bss_proxy_get_properties (self, bss_data->proxy);
 		g_signal_emit (self, signals[BSS_UPDATED], 0,
 		               object_path,
-		               g_variant_ref_sink (props));
+		               bss_data->properties);
 	}
 
 	success = priv->scan_done_success;
@@ -1238,7 +1310,7 @@ wpas_iface_bss_added (GDBusProxy *proxy,
 	if (priv->scanning)
 		priv->last_scan = nm_utils_get_monotonic_timestamp_ms ();
 
-	bss_add_new (self, path);
+	bss_add_new (self, path, props);
 }
 
 static void
@@ -1250,10 +1322,10 @@ wpas_iface_bss_removed (GDBusProxy *proxy,
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 	BssData *bss_data;
 
-	bss_data = g_hash_table_lookup (priv->bss_proxies, path);
+	bss_data = g_hash_table_lookup (priv->bsses, path);
 	if (!bss_data)
 		return;
-	g_hash_table_steal (priv->bss_proxies, path);
+	g_hash_table_steal (priv->bsses, path);
 	g_signal_emit (self, signals[BSS_REMOVED], 0, path);
 	bss_data_destroy (bss_data);
 }
@@ -1303,7 +1375,7 @@ props_changed_cb (GDBusProxy *proxy,
 	if (g_variant_lookup (changed_properties, "BSSs", "^a&o", &array)) {
 		iter = array;
 		while (*iter)
-			bss_add_new (self, *iter++);
+			bss_add_new (self, *iter++, NULL);
 		g_free (array);
 	}
 
@@ -1606,6 +1678,8 @@ on_iface_proxy_acquired (GDBusProxy *proxy, GAsyncResult *result, gpointer user_
 	self = NM_SUPPLICANT_INTERFACE (user_data);
 	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
+	bss_tracking_start (self);
+
 	_nm_dbus_signal_connect (priv->iface_proxy, "ScanDone", G_VARIANT_TYPE ("(b)"),
 	                         G_CALLBACK (wpas_iface_scan_done), self);
 	_nm_dbus_signal_connect (priv->iface_proxy, "BSSAdded", G_VARIANT_TYPE ("(oa{sv})"),
@@ -2392,6 +2466,12 @@ scan_request_cb (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
 			g_dbus_error_strip_remote_error (error);
 			_LOGW ("could not get scan request result: %s", error->message);
 		}
+
+		/* this scan request gets no ScanDone signal. That doesn't mean
+		 * that no scan is in progress, the supplicant also rejects the
+		 * request while it is already scanning. So, don't report the
+		 * scan as done. */
+		g_signal_emit (self, signals[SCAN_REQUEST_FAILED], 0);
 	}
 }
 
@@ -2511,8 +2591,8 @@ nm_supplicant_interface_p2p_stop_find (NMSupplicantInterface *self)
 	                   G_DBUS_CALL_FLAGS_NONE,
 	                   -1,
 	                   priv->other_cancellable,
-	                   (GAsyncReadyCallback) scan_request_cb,
-	                   self);
+	                   (GAsyncReadyCallback) log_result_cb,
+	                   "p2p stop find");
 }
 
 /*****************************************************************************/
@@ -2696,7 +2776,7 @@ nm_supplicant_interface_init (NMSupplicantInterface * self)
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
 	priv->state = NM_SUPPLICANT_INTERFACE_STATE_INIT;
-	priv->bss_proxies = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, bss_data_destroy);
+	priv->bsses = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, bss_data_destroy);
 	priv->peer_proxies = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, peer_data_destroy);
 }
 
@@ -2767,7 +2847,8 @@ dispose (GObject *object)
 	if (priv->wpas_proxy)
 		g_signal_handlers_disconnect_by_data (priv->wpas_proxy, object);
 	g_clear_object (&priv->wpas_proxy);
-	g_clear_pointer (&priv->bss_proxies, g_hash_table_destroy);
+	bss_tracking_stop (self);
+	g_clear_pointer (&priv->bsses, g_hash_table_destroy);
 	g_clear_pointer (&priv->peer_proxies, g_hash_table_destroy);
 
 	g_clear_pointer (&priv->net_path, g_free);
@@ -2942,6 +3023,14 @@ nm_supplicant_interface_class_init (NMSupplicantInterfaceClass *klass)
 	                  NULL, NULL, NULL,
 	                  G_TYPE_NONE, 1, G_TYPE_BOOLEAN);
 
+	signals[SCAN_REQUEST_FAILED] =
+	    g_signal_new (NM_SUPPLICANT_INTERFACE_SCAN_REQUEST_FAILED,
+	                  G_OBJECT_CLASS_TYPE (object_class),
+	                  G_SIGNAL_RUN_LAST,
+	                  0,
+	                  NULL, NULL, NULL,
+	                  G_TYPE_NONE, 0);
+
 	signals[CREDENTIALS_REQUEST] =
 	    g_signal_new (NM_SUPPLICANT_INTERFACE_CREDENTIALS_REQUEST,
 	                  G_OBJECT_CLASS_TYPE (object_class),
@@ -22,6 +22,7 @@
 
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 #include <net/if.h>
 #include <byteswap.h>
 
@@ -1998,6 +1999,109 @@ test_dns_create_resolv_conf (void)
 
 /*****************************************************************************/
 
+static void
+test_dns_output_state (void)
+{
+	NMDnsOutputState state = { };
+	guint8 hash1[NM_UTILS_CHECKSUM_LENGTH_SHA1];
+	guint8 hash2[NM_UTILS_CHECKSUM_LENGTH_SHA1];
+
+	memset (hash1, 1, sizeof (hash1));
+	memset (hash2, 2, sizeof (hash2));
+
+	/* the first update is always done. */
+	g_assert (_nm_dns_output_state_begin (&state, hash1));
+	_nm_dns_output_state_complete (&state, TRUE);
+
+	/* same input, nothing to do. */
+	g_assert (!_nm_dns_output_state_begin (&state, hash1));
+	_nm_dns_output_state_complete (&state, TRUE);
+
+	g_assert (_nm_dns_output_state_begin (&state, hash2));
+	_nm_dns_output_state_complete (&state, TRUE);
+	g_assert (!_nm_dns_output_state_begin (&state, hash2));
+	_nm_dns_output_state_complete (&state, TRUE);
+
+	/* a failed update is retried with the same input. */
+	g_assert (_nm_dns_output_state_begin (&state, hash1));
+	_nm_dns_output_state_complete (&state, FALSE);
+	g_assert (_nm_dns_output_state_begin (&state, hash1));
+	_nm_dns_output_state_complete (&state, TRUE);
+	g_assert (!_nm_dns_output_state_begin (&state, hash1));
+	_nm_dns_output_state_complete (&state, TRUE);
+
+	/* the plugin failed, or its child was restarted. */
+	_nm_dns_output_state_invalidate (&state);
+	g_assert (_nm_dns_output_state_begin (&state, hash1));
+	_nm_dns_output_state_complete (&state, TRUE);
+
+	/* the plugin failed while it was updated. Even if the update
+	 * itself reported success, the next one must not be skipped. */
+	g_assert (_nm_dns_output_state_begin (&state, hash2));
+	_nm_dns_output_state_invalidate (&state);
+	_nm_dns_output_state_complete (&state, TRUE);
+	g_assert (_nm_dns_output_state_begin (&state, hash2));
+	_nm_dns_output_state_complete (&state, TRUE);
+	g_assert (!_nm_dns_output_state_begin (&state, hash2));
+	_nm_dns_output_state_complete (&state, TRUE);
+}
+
+static void
+test_dns_resolv_conf_is_current (void)
+{
+	gs_free_error GError *error = NULL;
+	gs_free char *dir = NULL;
+	gs_free char *resconf = NULL;
+	gs_free char *my_resconf = NULL;
+	const char *content = "# Generated by NetworkManager\nnameserver 192.168.1.1\n";
+	const char *other = "nameserver 10.0.0.1\n";
+
+	dir = g_dir_make_tmp ("nm-test-dns-XXXXXX", &error);
+	nmtst_assert_success (dir, error);
+	resconf = g_build_filename (dir, "resolv.conf", NULL);
+	my_resconf = g_build_filename (dir, "nm-resolv.conf", NULL);
+
+	/* nothing was written yet */
+	g_assert (!nmtst_dns_resolv_conf_is_current (NM_DNS_MANAGER_RESOLV_CONF_MAN_FILE, resconf, my_resconf, NULL));
+
+	/* rc-manager=file: resolv.conf itself is checked. */
+	g_assert (!nmtst_dns_resolv_conf_is_current (NM_DNS_MANAGER_RESOLV_CONF_MAN_FILE, resconf, my_resconf, content));
+	nmtst_assert_success (g_file_set_contents (resconf, content, -1, &error), error);
+	nmtst_assert_success (g_file_set_contents (my_resconf, content, -1, &error), error);
+	g_assert (nmtst_dns_resolv_conf_is_current (NM_DNS_MANAGER_RESOLV_CONF_MAN_FILE, resconf, my_resconf, content));
+
+	/* somebody else overwrote resolv.conf. It must be repaired, even if the
+	 * internal copy is still fine. */
+	nmtst_assert_success (g_file_set_contents (resconf, other, -1, &error), error);
+	g_assert (!nmtst_dns_resolv_conf_is_current (NM_DNS_MANAGER_RESOLV_CONF_MAN_FILE, resconf, my_resconf, content));
+	g_assert (!nmtst_dns_resolv_conf_is_current (NM_DNS_MANAGER_RESOLV_CONF_MAN_SYMLINK, resconf, my_resconf, content));
+
+	/* with rc-manager=unmanaged, only the internal copy is ours. */
+	g_assert (nmtst_dns_resolv_conf_is_current (NM_DNS_MANAGER_RESOLV_CONF_MAN_UNMANAGED, resconf, my_resconf, content));
+	nmtst_assert_success (g_file_set_contents (my_resconf, other, -1, &error), error);
+	g_assert (!nmtst_dns_resolv_conf_is_current (NM_DNS_MANAGER_RESOLV_CONF_MAN_UNMANAGED, resconf, my_resconf, content));
+	nmtst_assert_success (g_file_set_contents (my_resconf, content, -1, &error), error);
+
+	/* rc-manager=symlink, with resolv.conf linking to the internal copy. */
+	g_assert (unlink (resconf) == 0);
+	g_assert (symlink (my_resconf, resconf) == 0);
+	g_assert (nmtst_dns_resolv_conf_is_current (NM_DNS_MANAGER_RESOLV_CONF_MAN_SYMLINK, resconf, my_resconf, content));
+
+	/* a foreign symlink is not touched, only the internal copy is checked. */
+	g_assert (unlink (resconf) == 0);
+	g_assert (symlink ("/nonexistent/resolv.conf", resconf) == 0);
+	g_assert (nmtst_dns_resolv_conf_is_current (NM_DNS_MANAGER_RESOLV_CONF_MAN_SYMLINK, resconf, my_resconf, content));
+
+	/* ... but with rc-manager=file, the dangling symlink is written. */
+	g_assert (!nmtst_dns_resolv_conf_is_current (NM_DNS_MANAGER_RESOLV_CONF_MAN_FILE, resconf, my_resconf, content));
+
+	g_assert (unlink (resconf) == 0);
+	g_assert (unlink (my_resconf) == 0);
+	g_assert (rmdir (dir) == 0);
+}
+
+/*****************************************************************************/
+
 static void
 test_machine_id_read (void)
 {
@@ -2226,6 +2330,8 @@ main (int argc, char **argv)
 	g_test_add_func ("/general/test_utils_file_is_in_path", test_utils_file_is_in_path);
 
 	g_test_add_func ("/general/test_dns_create_resolv_conf", test_dns_create_resolv_conf);
+	g_test_add_func ("/general/test_dns_output_state", test_dns_output_state);
+	g_test_add_func ("/general/test_dns_resolv_conf_is_current", test_dns_resolv_conf_is_current);
 
 	g_test_add_data_func ("/general/nm_utils_dhcp_client_id_systemd_node_specific/0", GINT_TO_POINTER (0), test_nm_utils_dhcp_client_id_systemd_node_specific);
 	g_test_add_data_func ("/general/nm_utils_dhcp_client_id_systemd_node_specific/1", GINT_TO_POINTER (1), test_nm_utils_dhcp_client_id_systemd_node_specific);
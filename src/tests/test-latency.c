@@ -0,0 +1,188 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ */
+
+#include "nm-default.h"
+
+#include "nm-latency.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+static void
+_assert_bucket (guint64 v)
+{
+	guint idx;
+	guint64 upper;
+
+	idx = _nm_latency_bucket_idx (v);
+	g_assert_cmpuint (idx, <, _NM_LATENCY_N_BUCKETS);
+
+	/* @v falls into the bucket, and not into the one below. */
+	upper = _nm_latency_bucket_upper (idx);
+	g_assert_cmpuint (v, <=, upper);
+	if (idx > 0)
+		g_assert_cmpuint (v, >, _nm_latency_bucket_upper (idx - 1));
+
+	/* the bucket is accurate to 12.5%. */
+	g_assert_cmpuint ((upper - v) * 8, <=, v);
+}
+
+static void
+test_bucket (void)
+{
+	guint64 v;
+	guint i;
+
+	for (v = 0; v < 10000; v++)
+		_assert_bucket (v);
+
+	for (i = 3; i <= 36; i++) {
+		v = ((guint64) 1) << i;
+		_assert_bucket (v - 1);
+		if (v <= _NM_LATENCY_MAX_USEC) {
+			_assert_bucket (v);
+			_assert_bucket (v + 1);
+		}
+	}
+
+	for (i = 0; i < 10000; i++) {
+		v = (((guint64) nmtst_get_rand_int ()) << 32 | nmtst_get_rand_int ()) & _NM_LATENCY_MAX_USEC;
+		_assert_bucket (v);
+	}
+
+	/* the buckets are contiguous and the last one ends at the maximum value. */
+	for (i = 0; i < _NM_LATENCY_N_BUCKETS; i++) {
+		g_assert_cmpuint (_nm_latency_bucket_idx (_nm_latency_bucket_upper (i)), ==, i);
+		if (i > 0)
+			g_assert_cmpuint (_nm_latency_bucket_idx (_nm_latency_bucket_upper (i - 1) + 1), ==, i);
+	}
+	g_assert_cmpuint (_nm_latency_bucket_upper (_NM_LATENCY_N_BUCKETS - 1), ==, _NM_LATENCY_MAX_USEC);
+}
+
+/*****************************************************************************/
+
+static GVariant *
+_stats_get (const char *name)
+{
+	gs_unref_variant GVariant *all = NULL;
+	GVariant *stats;
+
+	all = g_variant_ref_sink (nm_latency_to_variant ());
+	stats = g_variant_lookup_value (all, name, G_VARIANT_TYPE ("a{sv}"));
+	g_assert (stats);
+	return stats;
+}
+
+static guint64
+_stats_get_u64 (GVariant *stats, const char *key)
+{
+	guint64 v;
+
+	g_assert (g_variant_lookup (stats, key, "t", &v));
+	return v;
+}
+
+static void
+test_percentile (void)
+{
+	gs_unref_variant GVariant *stats = NULL;
+	gs_unref_variant GVariant *buckets = NULL;
+	guint64 upper, count, total;
+	GVariantIter iter;
+	guint i;
+
+	nmtst_latency_reset ();
+
+	stats = _stats_get ("route-sync");
+	g_assert_cmpuint (_stats_get_u64 (stats, "count"), ==, 0);
+	g_assert_cmpuint (_stats_get_u64 (stats, "p50-usec"), ==, 0);
+	g_assert_cmpuint (_stats_get_u64 (stats, "p99-usec"), ==, 0);
+	g_clear_pointer (&stats, g_variant_unref);
+
+	/* 1 to 100 microseconds. */
+	for (i = 1; i <= 100; i++)
+		nm_latency_record_ns (NM_LATENCY_ROUTE_SYNC, i * 1000 + 999);
+
+	stats = _stats_get ("route-sync");
+	g_assert_cmpuint (_stats_get_u64 (stats, "count"), ==, 100);
+	g_assert_cmpuint (_stats_get_u64 (stats, "sum-usec"), ==, 5050);
+	g_assert_cmpuint (_stats_get_u64 (stats, "max-usec"), ==, 100);
+
+	/* the percentiles are the upper bound of the bucket with the n-th
+	 * sample: [48, 51], [88, 95] and [96, 103], capped by the maximum. */
+	g_assert_cmpuint (_stats_get_u64 (stats, "p50-usec"), ==, 51);
+	g_assert_cmpuint (_stats_get_u64 (stats, "p90-usec"), ==, 95);
+	g_assert_cmpuint (_stats_get_u64 (stats, "p99-usec"), ==, 100);
+
+	buckets = g_variant_lookup_value (stats, "buckets", G_VARIANT_TYPE ("a(tt)"));
+	g_assert (buckets);
+	total = 0;
+	g_variant_iter_init (&iter, buckets);
+	while (g_variant_iter_next (&iter, "(tt)", &upper, &count)) {
+		g_assert_cmpuint (count, >, 0);
+		total += count;
+	}
+	g_assert_cmpuint (total, ==, 100);
+
+	/* the other operations are unaffected. */
+	g_clear_pointer (&stats, g_variant_unref);
+	stats = _stats_get ("dns-update");
+	g_assert_cmpuint (_stats_get_u64 (stats, "count"), ==, 0);
+
+	nmtst_latency_reset ();
+}
+
+static void
+test_clamp (void)
+{
+	gs_unref_variant GVariant *stats = NULL;
+
+	nmtst_latency_reset ();
+
+	/* negative durations count as 0, and large ones are clamped. */
+	nm_latency_record_ns (NM_LATENCY_DISPATCHER, -5000);
+	nm_latency_record_ns (NM_LATENCY_DISPATCHER, G_MAXINT64);
+
+	stats = _stats_get ("dispatcher");
+	g_assert_cmpuint (_stats_get_u64 (stats, "count"), ==, 2);
+	g_assert_cmpuint (_stats_get_u64 (stats, "sum-usec"), ==, _NM_LATENCY_MAX_USEC);
+	g_assert_cmpuint (_stats_get_u64 (stats, "max-usec"), ==, _NM_LATENCY_MAX_USEC);
+	g_assert_cmpuint (_stats_get_u64 (stats, "p50-usec"), ==, 0);
+	g_assert_cmpuint (_stats_get_u64 (stats, "p99-usec"), ==, _NM_LATENCY_MAX_USEC);
+
+	nmtst_latency_reset ();
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "ALL");
+
+	g_test_add_func ("/latency/bucket", test_bucket);
+	g_test_add_func ("/latency/percentile", test_percentile);
+	g_test_add_func ("/latency/clamp", test_clamp);
+
+	return g_test_run ();
+}
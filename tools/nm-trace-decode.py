@@ -0,0 +1,157 @@
+#!/usr/bin/env python
+# -*- Mode: python; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+#
+# Copyright (C) 2018 Red Hat, Inc.
+#
+# Decode a binary trace file written by NetworkManager when
+# "logging.trace-file" is configured. See src/nm-trace.h for the format.
+
+from __future__ import print_function
+
+import argparse
+import datetime
+import struct
+import sys
+
+HEADER_FMT = '8sIIIIQqqq8s'
+RECORD_FMT = 'qIIiIHBB4s'
+MAGIC = b'NMTRACE\0'
+VERSION = 1
+
+EVENTS = {
+    1: 'netlink-request',
+    2: 'netlink-response',
+    3: 'netlink-msg',
+    4: 'cache-update',
+    5: 'device-state',
+    6: 'device-link-changed',
+}
+
+OBJ_TYPES = {
+    1: 'link',
+    2: 'ip4-address',
+    3: 'ip6-address',
+    4: 'ip4-route',
+    5: 'ip6-route',
+    6: 'qdisc',
+    7: 'tfilter',
+}
+
+CACHE_OPS = {
+    1: 'add',
+    2: 'update',
+    3: 'remove',
+}
+
+NLMSG_TYPES = {
+    16: 'RTM_NEWLINK',
+    17: 'RTM_DELLINK',
+    20: 'RTM_NEWADDR',
+    21: 'RTM_DELADDR',
+    24: 'RTM_NEWROUTE',
+    25: 'RTM_DELROUTE',
+    36: 'RTM_NEWQDISC',
+    37: 'RTM_DELQDISC',
+    44: 'RTM_NEWTFILTER',
+    45: 'RTM_DELTFILTER',
+}
+
+DEVICE_STATES = {
+    0: 'unknown',
+    10: 'unmanaged',
+    20: 'unavailable',
+    30: 'disconnected',
+    40: 'prepare',
+    50: 'config',
+    60: 'need-auth',
+    70: 'ip-config',
+    80: 'ip-check',
+    90: 'secondaries',
+    100: 'activated',
+    110: 'deactivating',
+    120: 'failed',
+}
+
+
+def lookup(table, value):
+    return table.get(value, str(value))
+
+
+def detect_byte_order(data):
+    for order in ('<', '>'):
+        h = struct.unpack_from(order + HEADER_FMT, data, 0)
+        if h[1] == VERSION and h[2] == struct.calcsize(order + RECORD_FMT):
+            return order
+    return None
+
+
+def describe(event, ifindex, obj_type, arg, seq, value):
+    if event == 1:
+        return 'seq=%u' % (seq)
+    if event == 2:
+        return 'seq=%u result=%d' % (seq, struct.unpack('i', struct.pack('I', value))[0])
+    if event == 3:
+        return 'seq=%u type=%s' % (seq, lookup(NLMSG_TYPES, value))
+    if event == 4:
+        return 'ifindex=%d %s %s' % (ifindex, lookup(OBJ_TYPES, obj_type), lookup(CACHE_OPS, arg))
+    if event == 5:
+        return 'ifindex=%d %s -> %s reason=%u' % (ifindex,
+                                                  lookup(DEVICE_STATES, value & 0xFFFF),
+                                                  lookup(DEVICE_STATES, arg),
+                                                  value >> 16)
+    if event == 6:
+        return 'ifindex=%d' % (ifindex)
+    return 'ifindex=%d obj-type=%u arg=%u seq=%u value=%u' % (ifindex, obj_type, arg, seq, value)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode a NetworkManager binary trace file.')
+    parser.add_argument('file', help='the trace file ("logging.trace-file" with the PID appended)')
+    parser.add_argument('--event', action='append', default=[],
+                        help='only show the given event (can be repeated)')
+    parser.add_argument('--ifindex', type=int, help='only show events for this ifindex')
+    parser.add_argument('--min-duration', type=float, default=0,
+                        help='only show events that took at least this many milliseconds')
+    args = parser.parse_args()
+
+    with open(args.file, 'rb') as f:
+        data = f.read()
+
+    order = detect_byte_order(data)
+    if order is None or data[0:8] != MAGIC:
+        print('%s: not a NetworkManager trace file (version %d)' % (args.file, VERSION), file=sys.stderr)
+        return 1
+
+    (_, _, record_size, n_records, pid, head,
+     monotonic_start_ns, realtime_start_us, boottime_offset_ns, _) = struct.unpack_from(order + HEADER_FMT, data, 0)
+    header_size = struct.calcsize(order + HEADER_FMT)
+
+    print('# pid %u, %u events recorded, ring of %u records' % (pid, head, n_records))
+
+    # The oldest slot is the one that gets overwritten next. If the
+    # process is still running, it might be incomplete, so skip it.
+    first = max(0, head - n_records + 1)
+    for i in range(first, head):
+        offset = header_size + (i % n_records) * record_size
+        (timestamp_ns, duration_ns, seq, ifindex, value,
+         event, obj_type, arg, _) = struct.unpack_from(order + RECORD_FMT, data, offset)
+
+        if args.event and lookup(EVENTS, event) not in args.event:
+            continue
+        if args.ifindex is not None and ifindex != args.ifindex:
+            continue
+        if duration_ns < args.min_duration * 1000000:
+            continue
+
+        realtime = datetime.datetime.fromtimestamp((realtime_start_us + (timestamp_ns - monotonic_start_ns) // 1000) / 1e6)
+        print('%s [%d.%09d] %-20s %10.3f ms  %s' % (realtime.strftime('%H:%M:%S.%f'),
+                                                    (timestamp_ns + boottime_offset_ns) // 1000000000,
+                                                    (timestamp_ns + boottime_offset_ns) % 1000000000,
+                                                    lookup(EVENTS, event),
+                                                    duration_ns / 1e6,
+                                                    describe(event, ifindex, obj_type, arg, seq, value)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())